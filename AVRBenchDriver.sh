@@ -0,0 +1,82 @@
+#!/bin/sh
+
+# *************************************************************
+#
+# The OpenTRV project licenses this file to you
+# under the Apache Licence, Version 2.0 (the "Licence");
+# you may not use this file except in compliance
+# with the Licence. You may obtain a copy of the Licence at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the Licence is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied. See the Licence for the
+# specific language governing permissions and limitations
+# under the Licence.
+#
+# *************************************************************
+# Author(s) / Copyright (s): OpenTRV contributors 2026
+
+
+# Script to cross-compile the library for AVR and run the benchmarks
+# under the avrBenchmarks directory in the simavr simulator,
+# reporting exact cycle counts and stack high-water marks per primitive
+# without needing a board.
+#
+# Requires avr-gcc/avr-libc, and simavr with its headers and library
+# (eg the simavr and libsimavr-dev packages) plus libelf.
+#
+# The AVRCXX, HOSTCC, MCU and F_CPU environment variables can be used
+# to override the defaults (avr-g++, cc, atmega328p, 16000000).
+#
+# Intended to be run without arguments from top-level dir of project.
+#
+# Run as:
+#
+#     sh ./AVRBenchDriver.sh
+
+# Generates temporary executables at top level.
+ELFNAME=tmpavrbench.elf
+HOSTEXENAME=tmpsimavrbench
+
+MCU=${MCU:-atmega328p}
+F_CPU=${F_CPU:-16000000}
+
+# Project source root.
+PROJSRCROOT=content/OTAESGCM
+# Project source files; unused code is discarded at link time.
+PROJSRCS="`find ${PROJSRCROOT} -name '*.cpp' -type f -print`"
+
+# Benchmark source files dir.
+BENCHSRCDIR=avrBenchmarks
+
+# Source includes (paths).
+INCLUDES="-I${PROJSRCROOT} -I${PROJSRCROOT}/utility"
+
+# Build as the Arduino IDE would for the target.
+AVRFLAGS="-mmcu=${MCU} -DF_CPU=${F_CPU}UL -std=gnu++11 -Os -Wall -Werror \
+  -fno-exceptions -fno-rtti -fno-threadsafe-statics \
+  -ffunction-sections -fdata-sections -Wl,--gc-sections"
+
+rm -f ${ELFNAME} ${HOSTEXENAME}
+if ${AVRCXX:-avr-g++} -o ${ELFNAME} ${AVRFLAGS} ${INCLUDES} ${PROJSRCS} ${BENCHSRCDIR}/AVRBench.cpp ; then
+    echo Compiled firmware.
+else
+    echo Failed to compile firmware.
+    exit 2
+fi
+if ${HOSTCC:-cc} -o ${HOSTEXENAME} -O2 -Wall -Werror -I/usr/local/include ${BENCHSRCDIR}/simavrBench.c -L/usr/local/lib -lsimavr -lelf ; then
+    echo Compiled simulator host.
+else
+    echo Failed to compile simulator host.
+    exit 2
+fi
+
+avr-size ${ELFNAME} 2>/dev/null
+./${HOSTEXENAME} ${ELFNAME} ${MCU} ${F_CPU}
+STATUS=$?
+[ 0 -eq ${STATUS} ] && echo OK
+rm -f ${ELFNAME} ${HOSTEXENAME}
+exit ${STATUS}
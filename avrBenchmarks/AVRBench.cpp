@@ -0,0 +1,192 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/*
+ * AVR (ATmega328P) benchmark firmware, to be run under simavr by simavrBench.c.
+ *
+ * Bare avr-libc, no Arduino core.
+ * Each benchmark is bracketed by writes to the general purpose I/O registers,
+ * which the simulator host traps to read the cycle counter and track SP:
+ *   * GPIOR1: the benchmark name, one character per write;
+ *   * GPIOR0: BENCH_START, then BENCH_STOP, and finally BENCH_DONE.
+ * The workspace is static so the stack measured is that of the primitive;
+ * only one workspace is live at a time, so one buffer sized for the largest
+ * is shared by all the benchmarks, to leave as much of the 2KiB of RAM as possible for the stack.
+ * (The S-boxes and other tables are in flash via PROGMEM so take no RAM.)
+ * The first benchmark is empty, to measure the bracketing overhead.
+ * Results are checked, and the unused stack is painted and checked at the end,
+ * with BENCH_FAIL sent to the host if anything went wrong.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <avr/sleep.h>
+#include <OTAESGCM.h>
+
+// Markers written to GPIOR0; must match simavrBench.c.
+static constexpr uint8_t BENCH_START = 1;
+static constexpr uint8_t BENCH_STOP = 2;
+static constexpr uint8_t BENCH_DONE = 3;
+static constexpr uint8_t BENCH_FAIL = 4;
+
+// Needed for classes with pure virtual functions without the Arduino core.
+extern "C" void __cxa_pure_virtual() { for( ; ; ) { } }
+
+// Send the benchmark name to the host.
+static void benchName(const char *name)
+{
+    char c;
+    while('\0' != (c = pgm_read_byte(name++))) { GPIOR1 = c; }
+}
+
+// Run stmt once, bracketed by the start and stop markers.
+// The barriers stop the compiler moving work across the markers.
+#define BENCH(name, stmt) do { \
+    benchName(PSTR(name)); \
+    __asm__ __volatile__("" ::: "memory"); \
+    GPIOR0 = BENCH_START; \
+    __asm__ __volatile__("" ::: "memory"); \
+    stmt; \
+    __asm__ __volatile__("" ::: "memory"); \
+    GPIOR0 = BENCH_STOP; \
+    __asm__ __volatile__("" ::: "memory"); \
+    } while(false)
+
+// NIST GCMVS test vector (see portableUnitTests/main.cpp GCMVS1WithWorkspace).
+static const uint8_t key[16] = { 0x29, 0x8e, 0xfa, 0x1c, 0xcf, 0x29, 0xcf, 0x62, 0xae, 0x68, 0x24, 0xbf, 0xc1, 0x95, 0x57, 0xfc };
+static const uint8_t nonce[12] = { 0x6f, 0x58, 0xa9, 0x3f, 0xe1, 0xd2, 0x07, 0xfa, 0xe4, 0xed, 0x2f, 0x6d };
+static const uint8_t aad[16] = { 0x02, 0x1f, 0xaf, 0xd2, 0x38, 0x46, 0x39, 0x73, 0xff, 0xe8, 0x02, 0x56, 0xe5, 0xb1, 0xc6, 0xb1 };
+
+// Shared static workspace, big enough for every benchmark below;
+// the AES classes take a uint8_t size so are given exactly what they need.
+static constexpr size_t maxSize(const size_t a, const size_t b) { return((a > b) ? a : b); }
+static constexpr size_t workspaceSize = maxSize(maxSize(maxSize(
+    OTAESGCM::OTAES128DE_AVR::workspaceRequired, OTAESGCM::OTAES128DE_OTF::workspaceRequired),
+    maxSize(OTAESGCM::OTGHASH_Shoup4::workspaceRequired, OTAESGCM::OTGHASH_BitSerial::workspaceRequired)),
+    maxSize(OTAESGCM::OTAES128GCMGenericWithWorkspace<>::workspaceRequired, OTAESGCM::OTAES128GCMEngine<>::workspaceRequired));
+static uint8_t workspace[workspaceSize];
+static uint8_t block[16];
+static uint8_t Y[16];
+static uint8_t plain[32], cipher[32], tag[16];
+static volatile bool ok;
+static bool failed;
+
+// Stack painting: everything between the end of static data and the stack
+// is filled with a pattern at startup; the bottom of it must survive.
+extern uint8_t __heap_start;
+static constexpr uint8_t STACK_PAINT = 0xa5;
+static constexpr uint8_t STACK_GUARD = 16;
+static void paintStack()
+{
+    uint8_t *p = &__heap_start;
+    const uint8_t *const top = (const uint8_t *)(uintptr_t)SP - 32;
+    while(p < top) { *p++ = STACK_PAINT; }
+}
+static bool stackGuardIntact()
+{
+    for(uint8_t i = 0; i < STACK_GUARD; ++i) { if(STACK_PAINT != (&__heap_start)[i]) { return(false); } }
+    return(true);
+}
+
+// Record an unexpected result.
+static void check(const bool expected) { if(!expected) { failed = true; } }
+
+int main()
+{
+    cli();
+    paintStack();
+
+    BENCH("empty", (void)0);
+
+    {
+    OTAESGCM::OTAES128DE_AVR aes(workspace, OTAESGCM::OTAES128DE_AVR::workspaceRequired);
+    BENCH("OTAES128E_AVR::blockEncrypt", aes.blockEncrypt(block, key, block));
+    aes.retainKeySchedule(key);
+    BENCH("OTAES128E_AVR::blockEncrypt retained", aes.blockEncrypt(block, key, block));
+    aes.clearKeySchedule();
+    BENCH("OTAES128DE_AVR::blockDecrypt", aes.blockDecrypt(block, key, block));
+    }
+    {
+    OTAESGCM::OTAES128DE_OTF aes(workspace, OTAESGCM::OTAES128DE_OTF::workspaceRequired);
+    BENCH("OTAES128E_OTF::blockEncrypt", aes.blockEncrypt(block, key, block));
+    BENCH("OTAES128DE_OTF::blockDecrypt", aes.blockDecrypt(block, key, block));
+    aes.retainKeySchedule(key);
+    BENCH("OTAES128DE_OTF::blockDecrypt retained", aes.blockDecrypt(block, key, block));
+    aes.clearKeySchedule();
+    }
+
+    {
+    OTAESGCM::OTGHASH_BitSerial g(workspace, sizeof(workspace));
+    BENCH("OTGHASH_BitSerial::setAuthKey", g.setAuthKey(key));
+    BENCH("OTGHASH_BitSerial::ghashBlocks 1", g.ghashBlocks(Y, block, 1));
+    g.clearAuthKey();
+    }
+    {
+    OTAESGCM::OTGHASH_Shoup4 g(workspace, sizeof(workspace));
+    BENCH("OTGHASH_Shoup4::setAuthKey", g.setAuthKey(key));
+    BENCH("OTGHASH_Shoup4::ghashBlocks 1", g.ghashBlocks(Y, block, 1));
+    g.clearAuthKey();
+    }
+
+    BENCH("fixed32B...Enc_DEFAULT_WITH_LWORKSPACE aad 0",
+        ok = OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleEnc_DEFAULT_WITH_LWORKSPACE(workspace, sizeof(workspace),
+            key, nonce, NULL, 0, plain, cipher, tag));
+    check(ok);
+    BENCH("fixed32B...Dec_DEFAULT_WITH_LWORKSPACE aad 0",
+        ok = OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_WITH_LWORKSPACE(workspace, sizeof(workspace),
+            key, nonce, NULL, 0, cipher, tag, plain));
+    check(ok);
+    BENCH("fixed32B...Enc_DEFAULT_WITH_LWORKSPACE aad 16",
+        ok = OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleEnc_DEFAULT_WITH_LWORKSPACE(workspace, sizeof(workspace),
+            key, nonce, aad, sizeof(aad), plain, cipher, tag));
+    check(ok);
+    BENCH("fixed32B...Dec_DEFAULT_WITH_LWORKSPACE aad 16",
+        ok = OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_WITH_LWORKSPACE(workspace, sizeof(workspace),
+            key, nonce, aad, sizeof(aad), cipher, tag, plain));
+    check(ok);
+    // A forged frame, rejected before decryption.
+    tag[0] ^= 1;
+    BENCH("fixed32B...Dec_DEFAULT_WITH_LWORKSPACE aad 16 forged",
+        ok = OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_WITH_LWORKSPACE(workspace, sizeof(workspace),
+            key, nonce, aad, sizeof(aad), cipher, tag, plain));
+    check(!ok);
+
+    {
+    OTAESGCM::OTAES128GCMEngine<> e(workspace, sizeof(workspace));
+    BENCH("OTAES128GCMEngine<>::gcmEncryptPadded 32 aad 16",
+        ok = e.gcmEncryptPadded(key, nonce, plain, sizeof(plain), aad, sizeof(aad), cipher, tag));
+    check(ok);
+    BENCH("OTAES128GCMEngine<>::gcmDecrypt 32 aad 16",
+        ok = e.gcmDecrypt(key, nonce, cipher, sizeof(cipher), aad, sizeof(aad), tag, plain));
+    check(ok);
+    BENCH("OTAES128GCMEngine<>::gmacCompute aad 16",
+        ok = e.gmacCompute(key, nonce, aad, sizeof(aad), tag));
+    check(ok);
+    }
+
+    // Tell the host that all is done (or that something failed), then stop:
+    // simavr exits when sleeping with interrupts disabled.
+    check(stackGuardIntact());
+    GPIOR0 = failed ? BENCH_FAIL : BENCH_DONE;
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    sleep_enable();
+    for( ; ; ) { sleep_cpu(); }
+}
@@ -0,0 +1,140 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/*
+ * simavr host that runs the AVRBench.cpp firmware and reports,
+ * for each benchmark, the exact cycle count (less the bracketing overhead
+ * measured by the first, empty, benchmark) and the stack high-water mark
+ * (bytes below SP at the start marker).
+ *
+ * Usage: simavrBench firmware.elf [mcu [frequency]]
+ * Defaults to the ATmega328P at 16MHz; the frequency is used only to show times.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_io.h>
+
+// Data space addresses of the marker registers (I/O address + 0x20).
+#define GPIOR0_ADDR 0x3e
+#define GPIOR1_ADDR 0x4a
+
+// Markers written to GPIOR0; must match AVRBench.cpp.
+#define BENCH_START 1
+#define BENCH_STOP 2
+#define BENCH_DONE 3
+#define BENCH_FAIL 4
+
+static char name[64];
+static size_t nameLen;
+static int measuring;
+static int done;
+static int failed;
+static avr_cycle_count_t startCycle;
+static uint16_t startSP, minSP;
+// Overhead of the markers, from the first (empty) benchmark; 0 until measured.
+static avr_cycle_count_t overhead;
+static int haveOverhead;
+static uint32_t frequency = 16000000;
+
+static uint16_t getSP(const avr_t *const avr)
+{
+    return((uint16_t)(avr->data[R_SPL] | (avr->data[R_SPH] << 8)));
+}
+
+// Collects the benchmark name.
+static void nameWrite(avr_t *const avr, const avr_io_addr_t addr, const uint8_t v, void *const param)
+{
+    (void)avr; (void)addr; (void)param;
+    if(nameLen < sizeof(name) - 1) { name[nameLen++] = (char)v; name[nameLen] = '\0'; }
+}
+
+// Starts and stops a measurement.
+static void markerWrite(avr_t *const avr, const avr_io_addr_t addr, const uint8_t v, void *const param)
+{
+    (void)addr; (void)param;
+    switch(v)
+        {
+        case BENCH_START:
+            startCycle = avr->cycle;
+            startSP = minSP = getSP(avr);
+            measuring = 1;
+            break;
+        case BENCH_STOP:
+            {
+            const avr_cycle_count_t raw = avr->cycle - startCycle;
+            measuring = 0;
+            if(!haveOverhead) { overhead = raw; haveOverhead = 1; }
+            const avr_cycle_count_t net = (raw > overhead) ? raw - overhead : 0;
+            printf("%-52s %10llu cycles %9.1f us %5u bytes stack\n", name,
+                (unsigned long long)net, (1e6 * (double)net) / frequency, (unsigned)(startSP - minSP));
+            nameLen = 0;
+            name[0] = '\0';
+            break;
+            }
+        case BENCH_DONE:
+            done = 1;
+            break;
+        case BENCH_FAIL:
+            done = 1;
+            failed = 1;
+            break;
+        }
+}
+
+int main(const int argc, char *argv[])
+{
+    if(argc < 2) { fprintf(stderr, "usage: %s firmware.elf [mcu [frequency]]\n", argv[0]); return(2); }
+    const char *const mcu = (argc > 2) ? argv[2] : "atmega328p";
+    if(argc > 3) { frequency = (uint32_t)strtoul(argv[3], NULL, 10); }
+
+    elf_firmware_t f;
+    memset(&f, 0, sizeof(f));
+    if(0 != elf_read_firmware(argv[1], &f)) { fprintf(stderr, "cannot load %s\n", argv[1]); return(1); }
+    strncpy(f.mmcu, mcu, sizeof(f.mmcu) - 1);
+    f.frequency = frequency;
+
+    avr_t *const avr = avr_make_mcu_by_name(f.mmcu);
+    if(NULL == avr) { fprintf(stderr, "unknown MCU %s\n", f.mmcu); return(1); }
+    avr_init(avr);
+    avr_load_firmware(avr, &f);
+    avr_register_io_write(avr, GPIOR0_ADDR, markerWrite, NULL);
+    avr_register_io_write(avr, GPIOR1_ADDR, nameWrite, NULL);
+
+    printf("%s at %luHz\n", f.mmcu, (unsigned long)frequency);
+    // Run an instruction at a time to track the lowest SP while measuring.
+    int state = cpu_Running;
+    while(!done && (cpu_Done != state) && (cpu_Crashed != state))
+        {
+        state = avr_run(avr);
+        if(measuring)
+            {
+            const uint16_t sp = getSP(avr);
+            if(sp < minSP) { minSP = sp; }
+            }
+        }
+    if(!haveOverhead) { fprintf(stderr, "no benchmarks run\n"); return(1); }
+    printf("(marker overhead %llu cycles subtracted)\n", (unsigned long long)overhead);
+    // Results are only valid if the firmware ran to the end and its checks passed.
+    if(!done) { fprintf(stderr, "firmware stopped early (state %d)\n", state); return(1); }
+    if(failed) { fprintf(stderr, "firmware reported a wrong result or stack overflow\n"); return(1); }
+    return(0);
+}
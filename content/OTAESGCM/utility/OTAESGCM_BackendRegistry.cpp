@@ -0,0 +1,389 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* Runtime registry of the AES and GHASH implementations, for hosted (non-AVR) builds. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "OTAESGCM_BackendRegistry.h"
+
+#if defined(OTAESGCM_HAS_BACKEND_REGISTRY)
+
+#include <chrono>
+#include <new>
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+// For implementations that run on any host.
+static bool alwaysAvailable() { return(true); }
+
+// Construct an AES implementation in the registry storage.
+template<class OTAESImpl>
+static OTAES128E *constructAES(OTAES128EBackendStorage &storage, uint8_t *const workspace, const uint8_t workspaceLen)
+{
+    static_assert(sizeof(OTAESImpl) <= sizeof(storage.bytes), "storage too small");
+    return(new(storage.bytes) OTAESImpl(workspace, workspaceLen));
+}
+template<class OTAESImpl>
+static OTAES128D *constructAESDecrypt(OTAES128EBackendStorage &storage, uint8_t *const workspace, const uint8_t workspaceLen)
+{
+    static_assert(sizeof(OTAESImpl) <= sizeof(storage.bytes), "storage too small");
+    return(new(storage.bytes) OTAESImpl(workspace, workspaceLen));
+}
+
+// Construct a GHASH implementation in the registry storage.
+template<class OTGHASHImpl>
+static OTGHASH *constructGHASH(OTGHASHBackendStorage &storage, uint8_t *const workspace, const size_t workspaceLen)
+{
+    static_assert(sizeof(OTGHASHImpl) <= sizeof(storage.bytes), "storage too small");
+    return(new(storage.bytes) OTGHASHImpl(workspace, workspaceLen));
+}
+
+// Registered AES implementations, fastest first.
+// Cycle counts are as measured for each class (see their headers), for bulk data.
+static const OTAES128EBackend aesBackends[] =
+    {
+#if defined(OTAESGCM_HAS_AESNI_IMPL)
+    { "aesni", true, 6, OTAES128DE_AESNI::workspaceRequired, OTAES128DE_AESNI::isAvailable,
+        constructAES<OTAES128DE_AESNI>, constructAESDecrypt<OTAES128DE_AESNI> },
+#endif
+    { "ttable", false, 130, OTAES128E_TTable::workspaceRequired, alwaysAvailable,
+        constructAES<OTAES128E_TTable>, NULL },
+#if defined(OTAESGCM_HAS_SSSE3_IMPL)
+    { "ssse3scan", true, 250, OTAES128DE_SSSE3::workspaceRequired, OTAES128DE_SSSE3::isAvailable,
+        constructAES<OTAES128DE_SSSE3>, constructAESDecrypt<OTAES128DE_SSSE3> },
+#endif
+    { "bitsliced", true, 460, OTAES128E_BitSliced::workspaceRequired, alwaysAvailable,
+        constructAES<OTAES128E_BitSliced>, NULL },
+    { "otf", false, 1200, OTAES128E_OTF::workspaceRequired, alwaysAvailable,
+        constructAES<OTAES128E_OTF>, NULL },
+    { "avr", false, 1230, OTAES128DE_AVR::workspaceRequired, alwaysAvailable,
+        constructAES<OTAES128DE_AVR>, constructAESDecrypt<OTAES128DE_AVR> },
+    };
+static constexpr size_t aesBackendCount = sizeof(aesBackends) / sizeof(aesBackends[0]);
+
+// Registered GHASH implementations, fastest first.
+static const OTGHASHBackend ghashBackends[] =
+    {
+#if defined(OTAESGCM_HAS_PCLMUL_IMPL)
+    { "pclmul", true, 5, OTGHASH_PCLMUL::workspaceRequired, OTGHASH_PCLMUL::isAvailable,
+        constructGHASH<OTGHASH_PCLMUL> },
+#endif
+    { "shoup4", false, 165, OTGHASH_Shoup4::workspaceRequired, alwaysAvailable,
+        constructGHASH<OTGHASH_Shoup4> },
+    { "ctmul64", true, 190, OTGHASH_CtMul64::workspaceRequired, alwaysAvailable,
+        constructGHASH<OTGHASH_CtMul64> },
+    { "bitserial", false, 4300, OTGHASH_BitSerial::workspaceRequired, alwaysAvailable,
+        constructGHASH<OTGHASH_BitSerial> },
+    };
+static constexpr size_t ghashBackendCount = sizeof(ghashBackends) / sizeof(ghashBackends[0]);
+
+// Current overrides; NULL if none.
+static const OTAES128EBackend *aesOverride = NULL;
+static const OTGHASHBackend *ghashOverride = NULL;
+
+/**
+ * @brief   finds the entry of the given name in table
+ * @retval  the entry, or NULL if name is NULL or not found
+ */
+template<class Backend>
+static const Backend *find(const Backend *const table, const size_t n, const char *const name)
+{
+    if(NULL == name) { return(NULL); }
+    for(size_t i = 0; i < n; ++i) { if(0 == strcmp(name, table[i].name)) { return(&table[i]); } }
+    return(NULL);
+}
+
+/**
+ * @brief   sets override to the named entry of table, or clears it if name is NULL
+ * @retval  false, leaving override unchanged, if the name is unknown or not available
+ */
+template<class Backend>
+static bool setOverride(const Backend *&override, const Backend *const table, const size_t n, const char *const name)
+{
+    if(NULL == name) { override = NULL; return(true); }
+    const Backend *const b = find(table, n, name);
+    if((NULL == b) || !b->isAvailable()) { return(false); }
+    override = b;
+    return(true);
+}
+
+/**
+ * @brief   picks the available entry of table best suited to policy, or the override
+ *
+ * Each table has at least one constant-time entry that is always available,
+ * so there is always a choice.
+ */
+template<class Backend>
+static const Backend &select(const Backend *const table, const size_t n, const Backend *const override, const OTAESGCMBackendPolicy policy)
+{
+    const bool ctOnly = (OTAESGCMBackendPolicy::CONSTANT_TIME == policy);
+    if((NULL != override) && (!ctOnly || override->constantTime)) { return(*override); }
+    const Backend *best = NULL;
+    for(size_t i = 0; i < n; ++i)
+        {
+        const Backend &b = table[i];
+        if((ctOnly && !b.constantTime) || !b.isAvailable()) { continue; }
+        if(NULL == best) { best = &b; continue; }
+        const bool faster = (b.cyclesPerBlock < best->cyclesPerBlock);
+        if(OTAESGCMBackendPolicy::SMALLEST == policy)
+            {
+            if((b.workspaceRequired < best->workspaceRequired) ||
+               ((b.workspaceRequired == best->workspaceRequired) && faster)) { best = &b; }
+            }
+        else if(faster) { best = &b; }
+        }
+    return((NULL != best) ? *best : table[n - 1]);
+}
+
+// Apply any overrides from the environment, once, before any other use of them,
+// so that an explicit override*() call always takes precedence.
+static void readEnvironmentOnce()
+{
+    static const bool done = []()
+        {
+        setOverride(aesOverride, aesBackends, aesBackendCount, getenv("OTAESGCM_AES_BACKEND"));
+        setOverride(ghashOverride, ghashBackends, ghashBackendCount, getenv("OTAESGCM_GHASH_BACKEND"));
+        return(true);
+        }();
+    (void)done;
+}
+
+size_t OTAESGCMBackends::countAES() { return(aesBackendCount); }
+const OTAES128EBackend &OTAESGCMBackends::getAES(const size_t index) { return(aesBackends[index]); }
+const OTAES128EBackend *OTAESGCMBackends::findAES(const char *const name)
+    { return(find(aesBackends, aesBackendCount, name)); }
+const OTAES128EBackend &OTAESGCMBackends::selectAES(const OTAESGCMBackendPolicy policy)
+    { readEnvironmentOnce(); return(select(aesBackends, aesBackendCount, aesOverride, policy)); }
+bool OTAESGCMBackends::overrideAES(const char *const name)
+    { readEnvironmentOnce(); return(setOverride(aesOverride, aesBackends, aesBackendCount, name)); }
+
+size_t OTAESGCMBackends::countGHASH() { return(ghashBackendCount); }
+const OTGHASHBackend &OTAESGCMBackends::getGHASH(const size_t index) { return(ghashBackends[index]); }
+const OTGHASHBackend *OTAESGCMBackends::findGHASH(const char *const name)
+    { return(find(ghashBackends, ghashBackendCount, name)); }
+const OTGHASHBackend &OTAESGCMBackends::selectGHASH(const OTAESGCMBackendPolicy policy)
+    { readEnvironmentOnce(); return(select(ghashBackends, ghashBackendCount, ghashOverride, policy)); }
+bool OTAESGCMBackends::overrideGHASH(const char *const name)
+    { readEnvironmentOnce(); return(setOverride(ghashOverride, ghashBackends, ghashBackendCount, name)); }
+
+
+// Trials per measurement, the fastest being kept to discount interruptions.
+static constexpr uint8_t tuneTrials = 3;
+// Bytes of message processed per trial, so that short messages are repeated enough to time.
+static constexpr size_t tuneBytesPerTrial = 16384;
+// Largest message tuned for, plus room for the extra blocks timed with it.
+static constexpr size_t tuneMaxBytes = 4096 + 32;
+
+/**
+ * @brief   times op, run reps times per trial
+ * @retval  the fastest trial in nanoseconds
+ */
+template<class Op>
+static uint64_t timeFastest(Op op, const size_t reps)
+{
+    uint64_t best = UINT64_MAX;
+    for(uint8_t t = 0; t < tuneTrials; ++t)
+        {
+        const auto start = std::chrono::steady_clock::now();
+        for(size_t r = 0; r < reps; ++r) { op(); }
+        const uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        if(ns < best) { best = ns; }
+        }
+    return(best);
+}
+
+/**
+ * @brief   times the AES work of one GCM message of len bytes
+ *
+ * Expands the key once, then encrypts H and len/16 + 1 counter blocks
+ * (the text and the tag mask), as in a one-shot or keyed GCM message.
+ */
+static uint64_t timeAES(const OTAES128EBackend &b, const size_t len, uint8_t *const in, uint8_t *const out)
+{
+    static const uint8_t key[16] = { 0x29, 0x8e, 0xfa, 0x1c, 0xcf, 0x29, 0xcf, 0x62, 0xae, 0x68, 0x24, 0xbf, 0xc1, 0x95, 0x57, 0xfc };
+    uint8_t workspace[OTAESGCMBackends::maxWorkspaceRequiredAES];
+    OTAES128EBackendStorage storage;
+    OTAES128E *const e = b.construct(storage, workspace, b.workspaceRequired);
+    uint8_t ctr[16] = { };
+    const uint64_t ns = timeFastest([&]()
+        {
+        e->retainKeySchedule(key);
+        e->blockEncrypt(in, key, out);
+        e->ctrEncrypt(ctr, in, len / 16 + 1, key, out);
+        e->clearKeySchedule();
+        }, tuneBytesPerTrial / len);
+    memset(workspace, 0, sizeof(workspace));
+    return(ns);
+}
+
+/**
+ * @brief   times the GHASH work of one GCM message of len bytes
+ *
+ * Sets the hash subkey, then hashes len/16 + 1 blocks (the message and the lengths block).
+ */
+static uint64_t timeGHASH(const OTGHASHBackend &b, const size_t len, const uint8_t *const in)
+{
+    uint8_t workspace[OTAESGCMBackends::maxWorkspaceRequiredGHASH];
+    OTGHASHBackendStorage storage;
+    OTGHASH *const g = b.construct(storage, workspace, b.workspaceRequired);
+    uint8_t Y[16] = { };
+    const uint64_t ns = timeFastest([&]()
+        {
+        g->setAuthKey(in);
+        g->ghashBlocks(Y, in, len / 16 + 1);
+        g->clearAuthKey();
+        }, tuneBytesPerTrial / len);
+    memset(workspace, 0, sizeof(workspace));
+    return(ns);
+}
+
+// The current tuning, valid once tuned.
+static OTAESGCMTuning tuning;
+static bool tuned = false;
+
+// First line of a tuning cache file, followed by the constant-time flag.
+static const char cacheFileHeader[] = "OTAESGCM autotune 1";
+
+/**
+ * @brief   loads a tuning from a cache file written by saveTuning()
+ * @retval  false, leaving t unspecified, if missing, malformed, for other lengths,
+ *          or naming an implementation that is unknown, unavailable or not constant-time as required
+ */
+static bool loadTuning(const char *const path, const bool constantTimeOnly, OTAESGCMTuning &t)
+{
+    FILE *const f = fopen(path, "r");
+    if(NULL == f) { return(false); }
+    bool ok = true;
+    int ct = -1;
+    char header[sizeof(cacheFileHeader) + 16];
+    if((NULL == fgets(header, sizeof(header), f)) || (0 != strncmp(header, cacheFileHeader, sizeof(cacheFileHeader) - 1)) ||
+       (1 != sscanf(header + sizeof(cacheFileHeader) - 1, " ct=%d", &ct)) || (ct != (constantTimeOnly ? 1 : 0)))
+        { ok = false; }
+    for(uint8_t i = 0; ok && (i < OTAESGCMTuning::Lengths); ++i)
+        {
+        unsigned long len;
+        char aesName[32], ghashName[32];
+        if((3 != fscanf(f, "%lu %31s %31s", &len, aesName, ghashName)) || (len != OTAESGCMTuning::messageLength(i)))
+            { ok = false; break; }
+        t.aes[i] = OTAESGCMBackends::findAES(aesName);
+        t.ghash[i] = OTAESGCMBackends::findGHASH(ghashName);
+        ok = (NULL != t.aes[i]) && t.aes[i]->isAvailable() && (!constantTimeOnly || t.aes[i]->constantTime) &&
+             (NULL != t.ghash[i]) && t.ghash[i]->isAvailable() && (!constantTimeOnly || t.ghash[i]->constantTime);
+        }
+    fclose(f);
+    t.constantTimeOnly = constantTimeOnly;
+    t.fromCache = true;
+    return(ok);
+}
+
+// Saves a tuning to a cache file, one line per message length; failure is ignored.
+static void saveTuning(const char *const path, const OTAESGCMTuning &t)
+{
+    FILE *const f = fopen(path, "w");
+    if(NULL == f) { return; }
+    fprintf(f, "%s ct=%d\n", cacheFileHeader, t.constantTimeOnly ? 1 : 0);
+    for(uint8_t i = 0; i < OTAESGCMTuning::Lengths; ++i)
+        { fprintf(f, "%lu %s %s\n", (unsigned long)OTAESGCMTuning::messageLength(i), t.aes[i]->name, t.ghash[i]->name); }
+    fclose(f);
+}
+
+/**
+ * @brief   measures each available implementation at each length, keeping the fastest
+ */
+static void measureTuning(const bool constantTimeOnly, OTAESGCMTuning &t)
+{
+    static uint8_t in[tuneMaxBytes], out[tuneMaxBytes];
+    for(size_t i = 0; i < sizeof(in); ++i) { in[i] = (uint8_t)(i * 7 + 1); }
+    t.constantTimeOnly = constantTimeOnly;
+    t.fromCache = false;
+    for(uint8_t l = 0; l < OTAESGCMTuning::Lengths; ++l)
+        {
+        const size_t len = OTAESGCMTuning::messageLength(l);
+        uint64_t best = UINT64_MAX;
+        t.aes[l] = &OTAESGCMBackends::selectAES(OTAESGCMBackendPolicy::CONSTANT_TIME);
+        for(size_t i = 0; i < aesBackendCount; ++i)
+            {
+            const OTAES128EBackend &b = aesBackends[i];
+            if((constantTimeOnly && !b.constantTime) || !b.isAvailable()) { continue; }
+            const uint64_t ns = timeAES(b, len, in, out);
+            if(ns < best) { best = ns; t.aes[l] = &b; }
+            }
+        best = UINT64_MAX;
+        t.ghash[l] = &OTAESGCMBackends::selectGHASH(OTAESGCMBackendPolicy::CONSTANT_TIME);
+        for(size_t i = 0; i < ghashBackendCount; ++i)
+            {
+            const OTGHASHBackend &b = ghashBackends[i];
+            if((constantTimeOnly && !b.constantTime) || !b.isAvailable()) { continue; }
+            const uint64_t ns = timeGHASH(b, len, in);
+            if(ns < best) { best = ns; t.ghash[l] = &b; }
+            }
+        }
+    memset(out, 0, sizeof(out));
+}
+
+const OTAESGCMTuning &OTAESGCMAutotuner::autotune(const bool constantTimeOnly, const char *const cacheFile)
+{
+    if((NULL == cacheFile) || !loadTuning(cacheFile, constantTimeOnly, tuning))
+        {
+        measureTuning(constantTimeOnly, tuning);
+        if(NULL != cacheFile) { saveTuning(cacheFile, tuning); }
+        }
+    tuned = true;
+    return(tuning);
+}
+
+bool OTAESGCMAutotuner::isTuned() { return(tuned); }
+
+const OTAESGCMTuning &OTAESGCMAutotuner::getTuning()
+{
+    if(!tuned)
+        {
+        // Not measured: the constant-time choice, re-read in case of overrides.
+        tuning.constantTimeOnly = true;
+        tuning.fromCache = false;
+        for(uint8_t i = 0; i < OTAESGCMTuning::Lengths; ++i)
+            {
+            tuning.aes[i] = &OTAESGCMBackends::selectAES(OTAESGCMBackendPolicy::CONSTANT_TIME);
+            tuning.ghash[i] = &OTAESGCMBackends::selectGHASH(OTAESGCMBackendPolicy::CONSTANT_TIME);
+            }
+        }
+    return(tuning);
+}
+
+void OTAESGCMAutotuner::select(const size_t messageLength, const OTAES128EBackend *&aes, const OTGHASHBackend *&ghash)
+{
+    const OTAESGCMTuning &t = getTuning();
+    uint8_t i = 0;
+    while((i < OTAESGCMTuning::Lengths - 1) && (messageLength > OTAESGCMTuning::messageLength(i))) { ++i; }
+    aes = t.aes[i];
+    ghash = t.ghash[i];
+    readEnvironmentOnce();
+    if((NULL != aesOverride) && (!t.constantTimeOnly || aesOverride->constantTime)) { aes = aesOverride; }
+    if((NULL != ghashOverride) && (!t.constantTimeOnly || ghashOverride->constantTime)) { ghash = ghashOverride; }
+}
+
+
+    }
+
+#endif // defined(OTAESGCM_HAS_BACKEND_REGISTRY)
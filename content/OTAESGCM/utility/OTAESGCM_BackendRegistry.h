@@ -0,0 +1,228 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* Runtime registry of the AES and GHASH implementations, for hosted (non-AVR) builds. */
+
+#ifndef ARDUINO_LIB_OTAESGCM_BACKENDREGISTRY_H
+#define ARDUINO_LIB_OTAESGCM_BACKENDREGISTRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "OTAESGCM_OTAES128Impls.h"
+#include "OTAESGCM_GHASHImpls.h"
+
+#if !defined(__AVR_ARCH__) && !defined(ARDUINO_ARCH_AVR) // Not for Atmel AVR.
+#define OTAESGCM_HAS_BACKEND_REGISTRY // Can be used to enable features dependent on this registry.
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+
+    // The compile-time _fast_t/_small_t/_default_t typedefs fix the implementation per build;
+    // the registry instead lists every implementation compiled in,
+    // so that a host binary (eg a gateway) can pick one to suit the CPU it finds itself on,
+    // and so that they can be compared in the same run.
+    // Not for AVR, where the typedefs remain the only selection.
+
+    // How to choose an implementation from those available on this CPU.
+    enum class OTAESGCMBackendPolicy : uint8_t
+        {
+        FASTEST, // Fewest cycles per block for bulk data.
+        SMALLEST, // Least workspace, then fastest.
+        CONSTANT_TIME // Fastest with no secret-dependent branches or memory access.
+        };
+
+    namespace BackendRegistry
+        {
+        constexpr size_t maxOf(const size_t a) { return(a); }
+        template<class... Rest>
+        constexpr size_t maxOf(const size_t a, const size_t b, const Rest... rest) { return(maxOf((a > b) ? a : b, rest...)); }
+        }
+
+    // Suitably sized and aligned storage for any registered AES implementation instance.
+    struct OTAES128EBackendStorage final
+        {
+        static constexpr size_t Size = BackendRegistry::maxOf(sizeof(OTAES128DE_AVR), sizeof(OTAES128E_OTF),
+            sizeof(OTAES128E_TTable), sizeof(OTAES128E_BitSliced)
+#if defined(OTAESGCM_HAS_SSSE3_IMPL)
+            , sizeof(OTAES128DE_SSSE3)
+#endif
+#if defined(OTAESGCM_HAS_AESNI_IMPL)
+            , sizeof(OTAES128DE_AESNI)
+#endif
+            );
+        alignas(8) uint8_t bytes[Size];
+        };
+
+    // Suitably sized and aligned storage for any registered GHASH implementation instance.
+    struct OTGHASHBackendStorage final
+        {
+        static constexpr size_t Size = BackendRegistry::maxOf(sizeof(OTGHASH_BitSerial), sizeof(OTGHASH_Shoup4),
+            sizeof(OTGHASH_CtMul64)
+#if defined(OTAESGCM_HAS_PCLMUL_IMPL)
+            , sizeof(OTGHASH_PCLMUL)
+#endif
+            );
+        alignas(8) uint8_t bytes[Size];
+        };
+
+    // Description of one AES implementation in the registry.
+    // An instance is constructed in caller-supplied storage, with the usual workspace;
+    // none owns any resource, so the storage may simply be dropped
+    // once any retained or cached key schedule has been wiped.
+    struct OTAES128EBackend final
+        {
+        // Short unique name, eg for OTAESGCM_AES_BACKEND; never NULL.
+        const char *name;
+        // True if free of secret-dependent branches and memory access.
+        bool constantTime;
+        // Approximate cycles per block for bulk data (g++ -O2, x86-64, TSC), for ranking only.
+        uint16_t cyclesPerBlock;
+        // Workspace required by an instance.
+        uint8_t workspaceRequired;
+        // True if the CPU can run this implementation; probed once and cached.
+        bool (*isAvailable)();
+        // Construct an instance in storage, returning it as an encryptor.
+        OTAES128E *(*construct)(OTAES128EBackendStorage &storage, uint8_t *workspace, uint8_t workspaceLen);
+        // Construct an instance in storage, returning it as a decryptor;
+        // NULL if the implementation is encrypt-only.
+        OTAES128D *(*constructDecrypt)(OTAES128EBackendStorage &storage, uint8_t *workspace, uint8_t workspaceLen);
+        };
+
+    // Description of one GHASH implementation in the registry, as for OTAES128EBackend.
+    struct OTGHASHBackend final
+        {
+        // Short unique name, eg for OTAESGCM_GHASH_BACKEND; never NULL.
+        const char *name;
+        // True if free of secret-dependent branches and memory access.
+        bool constantTime;
+        // Approximate cycles per block for bulk data (g++ -O2, x86-64, TSC), for ranking only.
+        uint16_t cyclesPerBlock;
+        // Workspace required by an instance.
+        size_t workspaceRequired;
+        // True if the CPU can run this implementation; probed once and cached.
+        bool (*isAvailable)();
+        // Construct an instance in storage.
+        OTGHASH *(*construct)(OTGHASHBackendStorage &storage, uint8_t *workspace, size_t workspaceLen);
+        };
+
+    // The registry: enumeration, lookup by name, and selection by policy.
+    // The CPU is probed once, on first use.
+    // The implementation chosen by each policy can be overridden by name
+    // (eg for A/B benchmarking) with override*() or, read once on first selection,
+    // the OTAESGCM_AES_BACKEND and OTAESGCM_GHASH_BACKEND environment variables;
+    // CONSTANT_TIME only honours an override to a constant-time implementation.
+    // Neither re-entrant nor ISR-safe; override before selecting from other threads.
+    class OTAESGCMBackends final
+        {
+        public:
+            // Largest workspace required by any registered implementation.
+            static constexpr uint8_t maxWorkspaceRequiredAES = (uint8_t)BackendRegistry::maxOf(
+                OTAES128DE_AVR::workspaceRequired, OTAES128E_OTF::workspaceRequired,
+                OTAES128E_TTable::workspaceRequired, OTAES128E_BitSliced::workspaceRequired
+#if defined(OTAESGCM_HAS_SSSE3_IMPL)
+                , OTAES128DE_SSSE3::workspaceRequired
+#endif
+#if defined(OTAESGCM_HAS_AESNI_IMPL)
+                , OTAES128DE_AESNI::workspaceRequired
+#endif
+                );
+            static constexpr size_t maxWorkspaceRequiredGHASH = BackendRegistry::maxOf(
+                OTGHASH_BitSerial::workspaceRequired, OTGHASH_Shoup4::workspaceRequired,
+                OTGHASH_CtMul64::workspaceRequired
+#if defined(OTAESGCM_HAS_PCLMUL_IMPL)
+                , OTGHASH_PCLMUL::workspaceRequired
+#endif
+                );
+
+            // Registered AES implementations, available or not; index < countAES().
+            static size_t countAES();
+            static const OTAES128EBackend &getAES(size_t index);
+            // The registered AES implementation of the given name, else NULL.
+            static const OTAES128EBackend *findAES(const char *name);
+            // The available AES implementation best suited to the policy, or the override; never NULL.
+            static const OTAES128EBackend &selectAES(OTAESGCMBackendPolicy policy);
+            // Override selectAES() with the named implementation, or stop overriding if NULL.
+            // False (with no change) if the name is unknown or not available on this CPU.
+            static bool overrideAES(const char *name);
+
+            // As above, for GHASH.
+            static size_t countGHASH();
+            static const OTGHASHBackend &getGHASH(size_t index);
+            static const OTGHASHBackend *findGHASH(const char *name);
+            static const OTGHASHBackend &selectGHASH(OTAESGCMBackendPolicy policy);
+            static bool overrideGHASH(const char *name);
+        };
+
+    // Result of autotuning: the fastest available AES and GHASH implementations
+    // for each of a few message lengths, as measured on this CPU.
+    struct OTAESGCMTuning final
+        {
+        // Number of message lengths tuned for.
+        static constexpr uint8_t Lengths = 3;
+        // Message lengths (bytes) tuned for, ascending: one frame, a one-shot maximum, and a bulk blob.
+        static size_t messageLength(const uint8_t i) { return((0 == i) ? 32 : ((1 == i) ? 256 : 4096)); }
+
+        // True if only constant-time implementations were considered.
+        bool constantTimeOnly;
+        // True if loaded from a cache file rather than measured.
+        bool fromCache;
+        // Fastest for each message length; never NULL once tuned.
+        const OTAES128EBackend *aes[Lengths];
+        const OTGHASHBackend *ghash[Lengths];
+        };
+
+    // Startup autotuner: times each available AES and GHASH implementation
+    // at each of OTAESGCMTuning's message lengths,
+    // including the per-message key expansion and GHASH key setup,
+    // and keeps the fastest of each, as their costs within GCM simply add,
+    // so that an implementation with cheap key setup can win for single frames
+    // and one with the best bulk rate for large blobs.
+    // Takes a few tens of milliseconds, so the result can be kept in a small text file
+    // (one line per length naming the implementations) to make restarts instant;
+    // a missing, stale or unreadable file is simply re-measured and rewritten.
+    // Only constant-time implementations are considered unless explicitly allowed,
+    // as table implementations that are faster on some CPUs leak timing.
+    // Never runs implicitly: until autotune() is called, the CONSTANT_TIME policy's
+    // implementations are used for every length.
+    // Overrides set with OTAESGCMBackends take precedence over the tuning.
+    // Neither re-entrant nor ISR-safe; tune before use from other threads.
+    class OTAESGCMAutotuner final
+        {
+        public:
+            // Measure (or load from cacheFile, if not NULL and valid) and keep the tuning,
+            // saving it to cacheFile if measured.
+            // Passing constantTimeOnly false opts in to implementations that are not constant-time.
+            static const OTAESGCMTuning &autotune(bool constantTimeOnly = true, const char *cacheFile = NULL);
+            // True once autotune() has been called.
+            static bool isTuned();
+            // The current tuning; if not yet tuned,
+            // the CONSTANT_TIME policy's implementations for every length, without measuring.
+            static const OTAESGCMTuning &getTuning();
+            // The tuned implementations for a message of the given total length (text plus authenticated data):
+            // those for the smallest tuned length at least as long, else the longest.
+            static void select(size_t messageLength, const OTAES128EBackend *&aes, const OTGHASHBackend *&ghash);
+        };
+
+
+    }
+
+#endif // !defined(__AVR_ARCH__) && !defined(ARDUINO_ARCH_AVR)
+
+#endif
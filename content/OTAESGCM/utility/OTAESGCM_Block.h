@@ -0,0 +1,48 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* Block size and block helpers shared by the AES, GHASH and GCM implementations. */
+
+#ifndef ARDUINO_LIB_OTAESGCM_BLOCK_H
+#define ARDUINO_LIB_OTAESGCM_BLOCK_H
+
+#include <stdint.h>
+
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+static constexpr uint8_t AES128GCM_BLOCK_SIZE = 16; // GCM block size in bytes. This must be the same as the AES block size.
+
+/**
+ * @note    xor_block
+ * @brief    xor on 128bit block.
+ * @param    dest:    pointer to destination
+ * @param    src:    pointer to source
+ */
+inline void xorBlock(uint8_t *dest, const uint8_t *src)
+{
+    for(uint8_t i = 0; i < AES128GCM_BLOCK_SIZE; i++){
+        *dest++ ^= *src++;
+    }
+}
+
+    }
+
+#endif
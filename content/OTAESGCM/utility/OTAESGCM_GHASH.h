@@ -0,0 +1,92 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* OpenTRV OTAESGCM GHASH (GF(2^128) authentication hash) API. */
+
+#ifndef ARDUINO_LIB_OTAESGCM_GHASH_H
+#define ARDUINO_LIB_OTAESGCM_GHASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+
+    // Base class / interface for the GCM GHASH function, keyed by the hash subkey H.
+    // Implementations can be optimised for different characteristics
+    // such as speed or RAM or CPU, eg trading a per-key table for speed.
+    // Implementations may hold key-dependent state (such as H or tables derived from it)
+    // in their workspace between setAuthKey() and clearAuthKey(),
+    // which should be regarded as sensitive.
+    // Neither re-entrant nor ISR-safe except where stated.
+    class OTGHASH
+        {
+        protected:
+            // Only derived classes can construct an instance.
+            constexpr OTGHASH() { }
+
+        public:
+            /**
+             * @brief   sets the hash subkey H, precomputing any key-dependent state
+             * @param   H       pointer to the 16 byte hash subkey; never NULL;
+             *                  must remain valid and unchanged until clearAuthKey()
+             *                  as implementations may refer to it rather than copy it
+             */
+            virtual void setAuthKey(const uint8_t *H) = 0;
+
+            /**
+             * @brief   as setAuthKey(), when at most maxBlocks blocks will be hashed per ghashBlocks() call
+             * @param   maxBlocks   the most blocks passed to any ghashBlocks() call before clearAuthKey()
+             *
+             * Lets implementations that precompute key-dependent state (eg powers of H)
+             * compute only what such calls can use, eg when rekeying for each short message.
+             * Longer calls are still hashed correctly, if more slowly.
+             */
+            virtual void setAuthKeyForBlocks(const uint8_t *H, size_t maxBlocks) { (void)maxBlocks; setAuthKey(H); }
+
+            /**
+             * @brief   hashes whole blocks into the running GHASH value
+             * @param   Y       pointer to the 16 byte running hash value,
+             *                  updated in place; never NULL
+             * @param   X       pointer to nBlocks 16 byte input blocks;
+             *                  may be NULL if nBlocks is 0
+             * @param   nBlocks number of whole blocks to hash
+             *
+             * For each block X_i computes Y = (Y XOR X_i) . H in GF(2^128).
+             * Does nothing useful unless setAuthKey() has been called.
+             */
+            virtual void ghashBlocks(uint8_t *Y, const uint8_t *X, size_t nBlocks) = 0;
+
+            // Wipe any key-dependent state; safe to call when no key is set.
+            virtual void clearAuthKey() = 0;
+
+#if 0 // Defining the virtual destructor uses ~800+ bytes of Flash by forcing use of malloc()/free().
+            virtual ~OTGHASH() { }
+#else
+#define OTGHASH_NO_VIRT_DEST // Beware, no virtual destructor so be careful of use via base pointers.
+#endif
+        };
+
+
+    }
+
+
+#endif
@@ -0,0 +1,112 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): Deniz Erbilgin 2015--2017
+                           Damon Hart-Davis 2015--2017
+*/
+
+/* Bit-serial GHASH implementation: minimal RAM, for small MCUs. */
+
+#include <string.h>
+
+#include "OTAESGCM_Block.h"
+#include "OTAESGCM_GHASHBitSerial.h"
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+
+/**
+ * @brief    bitshifts 128bit block (16 byte array) right once
+ * @param    block:    pointer to block to shift
+ */
+static void shiftBlockRight(uint8_t *block)
+{
+    block += 15;
+
+    // bitshift LSB (last byte in array)
+    *block = *block >> 1;
+    block--;
+
+    // loop through remaining bytes
+    for (uint8_t i = 0; i < AES128GCM_BLOCK_SIZE-1; i++) {
+        // if lsb is set, set msb of next byte in array
+        if(*block & 0x01) *(block + 1) |= 0x80;
+        // bit shift byte
+        *block = *block >> 1;
+        block--;
+    }
+}
+
+/**
+ * @brief    Performs Y = Y . H in the 128 bit galois field
+ * @param    Y: pointer to 16 byte multiplicand, overwritten with the result
+ */
+void OTGHASH_BitSerial::multiplyH(uint8_t *const Y)
+{
+    uint8_t *const Z = Tmp;
+    uint8_t *const V = Tmp + AES128GCM_BLOCK_SIZE;
+    // init result to 0s and copy H to V
+    memcpy(V, H, AES128GCM_BLOCK_SIZE);
+    memset(Z, 0, AES128GCM_BLOCK_SIZE);
+
+    // multiplication algorithm
+    for (uint8_t i = 0; i < AES128GCM_BLOCK_SIZE; i++) {
+        for (uint8_t j = 0; j < 8; j++) {
+
+            if (Y[i] & (1 << (7 - j))) {
+                /* Z_(i + 1) = Z_i XOR V_i */
+                xorBlock(Z, V);
+            }
+            if (V[15] & 0x01) {
+                /* V_(i + 1) = (V_i >> 1) XOR R */
+                shiftBlockRight(V);
+                /* R = 11100001 || 0^120 */
+                V[0] ^= 0xe1;
+            } else {
+                /* V_(i + 1) = V_i >> 1 */
+                shiftBlockRight(V);
+            }
+        }
+    }
+
+    memcpy(Y, Z, AES128GCM_BLOCK_SIZE);
+}
+
+/**
+ * @brief   hashes whole blocks: Y = (Y XOR X_i) . H for each block X_i
+ * @param   Y           pointer to 16 byte running hash value
+ * @param   X           pointer to input blocks
+ * @param   nBlocks     number of 16 byte blocks
+ */
+void OTGHASH_BitSerial::ghashBlocks(uint8_t *const Y, const uint8_t *X, size_t nBlocks)
+{
+    // Abort if no workspace or key to avoid crashing..
+    if((NULL == Tmp) || (NULL == H)) { return; }
+
+    for( ; nBlocks > 0; --nBlocks) {
+        // Y_i = (Y^(i-1) XOR X_i) dot H
+        xorBlock(Y, X);
+        X += AES128GCM_BLOCK_SIZE; // move to next block
+        multiplyH(Y);
+    }
+
+    // Erase temporary workspace for security.
+    memset(Tmp, 0, TmpSize);
+}
+
+
+    }
@@ -0,0 +1,74 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): Deniz Erbilgin 2015--2017
+                           Damon Hart-Davis 2015--2017
+*/
+
+/* Bit-serial GHASH implementation: minimal RAM, for small MCUs. */
+
+#ifndef ARDUINO_LIB_OTAESGCM_GHASHBITSERIAL_H
+#define ARDUINO_LIB_OTAESGCM_GHASHBITSERIAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "OTAESGCM_GHASH.h"
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+
+    // Bit-serial GHASH, as per NIST SP 800-38D algorithm 1:
+    // 128 iterations of a 16-byte conditional XOR and 16-byte shift per block.
+    // Needs no per-key table (H is referred to, not copied) so is small but slow.
+    // Neither re-entrant nor ISR-safe except where stated.
+    // Carries workspace but logically no state is carried from one operation to the next,
+    // other than a pointer to H between setAuthKey() and clearAuthKey().
+    // Temporary workspace is wiped after each call.
+    class OTGHASH_BitSerial : public OTGHASH
+        {
+        protected:
+            // Size of the temporary workspace (bytes): Z and V blocks.
+            static constexpr uint8_t TmpSize = 32;
+
+            // The hash subkey H; NULL if none.
+            const uint8_t *H = NULL;
+            // Temporary workspace; NULL if insufficient workspace is passed in.
+            uint8_t * const Tmp;
+
+            void multiplyH(uint8_t *Y);
+
+        public:
+            // Minimum workspace required, unaligned; strictly positive.
+            // This constant, defined per class, is effectively part of the API.
+            static constexpr size_t workspaceRequired = TmpSize;
+
+            // Construct an instance: supplied workspace must be large enough.
+            // Only the initial 'workspaceRequired' bytes will be used.
+            OTGHASH_BitSerial(uint8_t *const workspace, const size_t workspaceLen)
+              : Tmp((workspaceLen >= workspaceRequired) ? workspace : NULL)
+                { }
+
+            virtual void setAuthKey(const uint8_t *authKey) override { H = authKey; }
+            virtual void ghashBlocks(uint8_t *Y, const uint8_t *X, size_t nBlocks) override;
+            virtual void clearAuthKey() override { H = NULL; }
+        };
+
+
+    }
+
+#endif
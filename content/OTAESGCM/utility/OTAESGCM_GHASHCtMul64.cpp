@@ -0,0 +1,154 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* Constant-time table-free GHASH using 64-bit integer multiplies. */
+
+#include <string.h>
+
+#include "OTAESGCM_Block.h"
+#include "OTAESGCM_GHASHCtMul64.h"
+
+#if defined(OTAESGCM_HAS_CTMUL64_IMPL)
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+
+// Big-endian load/store of 64-bit words.
+static inline uint64_t loadBE64(const uint8_t *p)
+{
+    uint64_t v = 0;
+    for(uint8_t i = 0; i < 8; ++i) { v = (v << 8) | p[i]; }
+    return(v);
+}
+static inline void storeBE64(uint8_t *p, uint64_t v)
+{
+    for(uint8_t i = 8; i-- > 0; ) { p[i] = (uint8_t)v; v >>= 8; }
+}
+
+/**
+ * @brief   carry-less multiply, low 64 bits of the product
+ *
+ * Splits each operand into 4 interleaved parts holding every fourth bit.
+ * Each integer product of two parts has at most 16 terms per bit position,
+ * so its carries stay within the 3-bit holes and can be masked off.
+ */
+static inline uint64_t bmul64(const uint64_t x, const uint64_t y)
+{
+    const uint64_t m0 = 0x1111111111111111ULL, m1 = m0 << 1, m2 = m0 << 2, m3 = m0 << 3;
+    const uint64_t x0 = x & m0, x1 = x & m1, x2 = x & m2, x3 = x & m3;
+    const uint64_t y0 = y & m0, y1 = y & m1, y2 = y & m2, y3 = y & m3;
+    const uint64_t z0 = (x0 * y0) ^ (x1 * y3) ^ (x2 * y2) ^ (x3 * y1);
+    const uint64_t z1 = (x0 * y1) ^ (x1 * y0) ^ (x2 * y3) ^ (x3 * y2);
+    const uint64_t z2 = (x0 * y2) ^ (x1 * y1) ^ (x2 * y0) ^ (x3 * y3);
+    const uint64_t z3 = (x0 * y3) ^ (x1 * y2) ^ (x2 * y1) ^ (x3 * y0);
+    return((z0 & m0) | (z1 & m1) | (z2 & m2) | (z3 & m3));
+}
+
+// Bit-reverse a 64-bit word.
+static inline uint64_t rev64(uint64_t x)
+{
+    x = ((x & 0x5555555555555555ULL) << 1) | ((x >> 1) & 0x5555555555555555ULL);
+    x = ((x & 0x3333333333333333ULL) << 2) | ((x >> 2) & 0x3333333333333333ULL);
+    x = ((x & 0x0F0F0F0F0F0F0F0FULL) << 4) | ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL);
+    x = ((x & 0x00FF00FF00FF00FFULL) << 8) | ((x >> 8) & 0x00FF00FF00FF00FFULL);
+    x = ((x & 0x0000FFFF0000FFFFULL) << 16) | ((x >> 16) & 0x0000FFFF0000FFFFULL);
+    return((x << 32) | (x >> 32));
+}
+
+/**
+ * @brief   stores H and the bit-reversals of its words
+ * @param   H       pointer to the 16 byte hash subkey
+ */
+void OTGHASH_CtMul64::setAuthKey(const uint8_t *const H)
+{
+    // Abort if no workspace to avoid crashing..
+    if(NULL == Key) { return; }
+
+    const uint64_t h[4] = { loadBE64(H), loadBE64(H + 8), rev64(loadBE64(H)), rev64(loadBE64(H + 8)) };
+    memcpy(Key, h, KeySize);
+    keyed = true;
+}
+
+/**
+ * @brief   hashes whole blocks: Y = (Y XOR X_i) . H for each block X_i
+ * @param   Y           pointer to 16 byte running hash value
+ * @param   X           pointer to input blocks
+ * @param   nBlocks     number of 16 byte blocks
+ *
+ * GCM's bit order is reflected, so the low half of each 128-bit product
+ * is made from the words as they stand, and the high half
+ * from the bit-reversed words, reversed back.
+ * The 256-bit product is then shifted left one bit
+ * and reduced modulo x^128 + x^7 + x^2 + x + 1.
+ */
+void OTGHASH_CtMul64::ghashBlocks(uint8_t *const Y, const uint8_t *X, size_t nBlocks)
+{
+    // Abort if no workspace or key to avoid crashing..
+    if(!keyed) { return; }
+
+    uint64_t h[4];
+    memcpy(h, Key, KeySize);
+    const uint64_t h1 = h[0], h0 = h[1], h1r = h[2], h0r = h[3];
+    const uint64_t h2 = h0 ^ h1, h2r = h0r ^ h1r;
+    uint64_t y1 = loadBE64(Y), y0 = loadBE64(Y + 8);
+    for( ; nBlocks > 0; --nBlocks, X += AES128GCM_BLOCK_SIZE)
+        {
+        y1 ^= loadBE64(X);
+        y0 ^= loadBE64(X + 8);
+        const uint64_t y0r = rev64(y0), y1r = rev64(y1);
+        const uint64_t y2 = y0 ^ y1, y2r = y0r ^ y1r;
+
+        // Karatsuba on the low and (reversed) high halves.
+        const uint64_t z0 = bmul64(y0, h0);
+        const uint64_t z1 = bmul64(y1, h1);
+        const uint64_t z2 = bmul64(y2, h2) ^ z0 ^ z1;
+        const uint64_t z0r = bmul64(y0r, h0r);
+        const uint64_t z1r = bmul64(y1r, h1r);
+        const uint64_t z2r = bmul64(y2r, h2r) ^ z0r ^ z1r;
+        const uint64_t z0h = rev64(z0r) >> 1;
+        const uint64_t z1h = rev64(z1r) >> 1;
+        const uint64_t z2h = rev64(z2r) >> 1;
+
+        // Assemble the 256-bit product and shift it left one bit.
+        uint64_t v0 = z0, v1 = z0h ^ z2, v2 = z1 ^ z2h, v3 = z1h;
+        v3 = (v3 << 1) | (v2 >> 63);
+        v2 = (v2 << 1) | (v1 >> 63);
+        v1 = (v1 << 1) | (v0 >> 63);
+        v0 = (v0 << 1);
+
+        // Reduce.
+        v2 ^= v0 ^ (v0 >> 1) ^ (v0 >> 2) ^ (v0 >> 7);
+        v1 ^= (v0 << 63) ^ (v0 << 62) ^ (v0 << 57);
+        v3 ^= v1 ^ (v1 >> 1) ^ (v1 >> 2) ^ (v1 >> 7);
+        v2 ^= (v1 << 63) ^ (v1 << 62) ^ (v1 << 57);
+        y0 = v2;
+        y1 = v3;
+        }
+    storeBE64(Y, y1);
+    storeBE64(Y + 8, y0);
+
+    // Erase temporary copy for security.
+    memset(h, 0, sizeof(h));
+}
+
+
+    }
+
+#endif // defined(OTAESGCM_HAS_CTMUL64_IMPL)
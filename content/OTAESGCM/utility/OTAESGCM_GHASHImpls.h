@@ -0,0 +1,58 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* OpenTRV OTAESGCM GHASH implementations. */
+
+#ifndef ARDUINO_LIB_OTAESGCM_GHASHIMPLS_H
+#define ARDUINO_LIB_OTAESGCM_GHASHIMPLS_H
+
+// Get available GHASH API.
+#include "OTAESGCM_GHASH.h"
+
+// Implementations.
+#include "OTAESGCM_GHASHBitSerial.h"
+#include "OTAESGCM_GHASHShoup4.h"
+// Constant-time table-free implementation for hosts.
+#include "OTAESGCM_GHASHCtMul64.h"
+// PCLMULQDQ implementation for x86 hosts, with runtime fallback.
+#include "OTAESGCM_GHASHPCLMUL.h"
+
+// Fast, small and default implementations for this architecture.
+// The default is the small one on AVR, as RAM is scarce on the MCUs this library targets;
+// elsewhere it is the constant-time OTGHASH_CtMul64 in the same 32 bytes of workspace.
+// Hosts and larger MCUs can select the fast one via the GCM template parameter.
+// On x86 the fast one pairs with the AES-NI OTAES128E_fast_t,
+// each checking the CPU at runtime, falling back to OTGHASH_CtMul64.
+namespace OTAESGCM
+    {
+#if defined(OTAESGCM_HAS_PCLMUL_IMPL)
+    typedef OTGHASH_PCLMUL OTGHASH_fast_t;
+#elif defined(OTAESGCM_HAS_CTMUL64_IMPL)
+    typedef OTGHASH_CtMul64 OTGHASH_fast_t;
+#else
+    typedef OTGHASH_Shoup4 OTGHASH_fast_t;
+#endif
+    typedef OTGHASH_BitSerial OTGHASH_small_t;
+#if defined(OTAESGCM_HAS_CTMUL64_IMPL)
+    typedef OTGHASH_CtMul64 OTGHASH_default_t;
+#else
+    typedef OTGHASH_BitSerial OTGHASH_default_t;
+#endif
+    }
+
+#endif
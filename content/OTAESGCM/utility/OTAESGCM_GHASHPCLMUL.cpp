@@ -0,0 +1,225 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* x86/x86-64 PCLMULQDQ GHASH implementation with runtime CPU detection. */
+
+#include <string.h>
+
+#include "OTAESGCM_Block.h"
+#include "OTAESGCM_GHASHPCLMUL.h"
+
+#if defined(OTAESGCM_HAS_PCLMUL_IMPL)
+
+#include <cpuid.h>
+#include <wmmintrin.h>
+#include <emmintrin.h>
+#include <tmmintrin.h>
+
+// Compile selected functions for PCLMULQDQ without needing -mpclmul globally;
+// they must only be called once CPUID has confirmed support.
+#define OTAESGCM_TARGET_PCLMUL __attribute__((target("pclmul,sse2,ssse3")))
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+
+/**
+ * @brief   reverses the bytes of a block
+ *
+ * With the bytes reversed the GCM bit order becomes a plain
+ * (shifted by one) polynomial product under PCLMULQDQ.
+ */
+OTAESGCM_TARGET_PCLMUL
+static inline __m128i bswap(const __m128i x)
+{
+    return(_mm_shuffle_epi8(x, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)));
+}
+
+/**
+ * @brief   accumulates the unreduced product a.b, Karatsuba style
+ * @param   lo, mid, hi     accumulators for the low, middle and high partial products
+ *
+ * Only 3 PCLMULQDQ are needed: the middle term is (a0^a1).(b0^b1)
+ * from which lo and hi are removed once, at reduction.
+ */
+OTAESGCM_TARGET_PCLMUL
+static inline void mulAcc(const __m128i a, const __m128i b, __m128i &lo, __m128i &mid, __m128i &hi)
+{
+    lo = _mm_xor_si128(lo, _mm_clmulepi64_si128(a, b, 0x00));
+    hi = _mm_xor_si128(hi, _mm_clmulepi64_si128(a, b, 0x11));
+    const __m128i af = _mm_xor_si128(a, _mm_shuffle_epi32(a, _MM_SHUFFLE(1,0,3,2)));
+    const __m128i bf = _mm_xor_si128(b, _mm_shuffle_epi32(b, _MM_SHUFFLE(1,0,3,2)));
+    mid = _mm_xor_si128(mid, _mm_clmulepi64_si128(af, bf, 0x00));
+}
+
+/**
+ * @brief   reduces a (sum of) unreduced 256-bit product(s) to 128 bits
+ * @param   lo, mid, hi     partial products as accumulated by mulAcc()
+ * @retval  the product modulo x^128 + x^7 + x^2 + x + 1, byte-reversed
+ *
+ * Shifts the 256-bit product left one bit (for the reflected bit order)
+ * then reduces, as per Intel's "Carry-Less Multiplication and Its Usage
+ * for Computing the GCM Mode" white paper, algorithm 5.
+ */
+OTAESGCM_TARGET_PCLMUL
+static inline __m128i reduce(__m128i lo, __m128i mid, __m128i hi)
+{
+    // Finish Karatsuba and fold the middle into the halves.
+    mid = _mm_xor_si128(mid, _mm_xor_si128(lo, hi));
+    lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+    hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+    // Shift the 256-bit hi:lo left by one bit.
+    __m128i t7 = _mm_srli_epi32(lo, 31);
+    __m128i t8 = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    const __m128i t9 = _mm_srli_si128(t7, 12);
+    t8 = _mm_slli_si128(t8, 4);
+    t7 = _mm_slli_si128(t7, 4);
+    lo = _mm_or_si128(lo, t7);
+    hi = _mm_or_si128(hi, _mm_or_si128(t8, t9));
+
+    // Reduce: first phase.
+    t7 = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30)), _mm_slli_epi32(lo, 25));
+    t8 = _mm_srli_si128(t7, 4);
+    t7 = _mm_slli_si128(t7, 12);
+    lo = _mm_xor_si128(lo, t7);
+    // Second phase.
+    __m128i t2 = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2)), _mm_srli_epi32(lo, 7));
+    t2 = _mm_xor_si128(t2, t8);
+    lo = _mm_xor_si128(lo, t2);
+    return(_mm_xor_si128(hi, lo));
+}
+
+/**
+ * @brief   fills powers with H^1..H^n, byte-reversed
+ */
+OTAESGCM_TARGET_PCLMUL
+static void computePowers(const uint8_t *const H, uint8_t *const powers, const uint8_t n)
+{
+    const __m128i h = bswap(_mm_loadu_si128((const __m128i *)H));
+    __m128i p = h;
+    _mm_storeu_si128((__m128i *)powers, p);
+    for(uint8_t i = 1; i < n; ++i)
+        {
+        __m128i lo = _mm_setzero_si128(), mid = lo, hi = lo;
+        mulAcc(p, h, lo, mid, hi);
+        p = reduce(lo, mid, hi);
+        _mm_storeu_si128((__m128i *)(powers + AES128GCM_BLOCK_SIZE*i), p);
+        }
+}
+
+/**
+ * @brief   hashes whole blocks with aggregated reduction
+ * @param   powers  H^1..H^maxPowers, byte-reversed
+ *
+ * Each chunk of k <= maxPowers blocks needs k multiplies but one reduction.
+ */
+OTAESGCM_TARGET_PCLMUL
+static void ghashPCLMUL(const uint8_t *const powers, const uint8_t maxPowers,
+                        uint8_t *const Y, const uint8_t *X, size_t nBlocks)
+{
+    __m128i y = bswap(_mm_loadu_si128((const __m128i *)Y));
+    while(nBlocks > 0)
+        {
+        const uint8_t k = (nBlocks > maxPowers) ? maxPowers : (uint8_t)nBlocks;
+        __m128i lo = _mm_setzero_si128(), mid = lo, hi = lo;
+        // The running hash is folded into the first block of the chunk.
+        __m128i x = _mm_xor_si128(y, bswap(_mm_loadu_si128((const __m128i *)X)));
+        mulAcc(x, _mm_loadu_si128((const __m128i *)(powers + AES128GCM_BLOCK_SIZE*(k-1))), lo, mid, hi);
+        for(uint8_t i = 1; i < k; ++i)
+            {
+            x = bswap(_mm_loadu_si128((const __m128i *)(X + AES128GCM_BLOCK_SIZE*i)));
+            mulAcc(x, _mm_loadu_si128((const __m128i *)(powers + AES128GCM_BLOCK_SIZE*(k-1-i))), lo, mid, hi);
+            }
+        y = reduce(lo, mid, hi);
+        X += AES128GCM_BLOCK_SIZE*k;
+        nBlocks -= k;
+        }
+    _mm_storeu_si128((__m128i *)Y, bswap(y));
+}
+
+// True if this CPU supports PCLMULQDQ and SSSE3; checked once and cached.
+bool OTGHASH_PCLMUL::isAvailable()
+{
+    static const bool available = []()
+        {
+        unsigned int eax, ebx, ecx, edx;
+        if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) { return(false); }
+        return((0 != (ecx & bit_PCLMUL)) && (0 != (ecx & bit_SSSE3)));
+        }();
+    return(available);
+}
+
+/**
+ * @brief   computes the powers of H, or passes H to the fallback
+ * @param   H       pointer to the 16 byte hash subkey
+ */
+void OTGHASH_PCLMUL::setAuthKey(const uint8_t *const H)
+{
+    setAuthKeyForBlocks(H, MaxPowers);
+}
+
+/**
+ * @brief   computes only the powers of H usable by calls of up to maxBlocks blocks
+ * @param   H           pointer to the 16 byte hash subkey
+ * @param   maxBlocks   most blocks per ghashBlocks() call
+ */
+void OTGHASH_PCLMUL::setAuthKeyForBlocks(const uint8_t *const H, const size_t maxBlocks)
+{
+    if(!usePCLMUL) { fallback.setAuthKeyForBlocks(H, maxBlocks); return; }
+
+    // Abort if no workspace to avoid crashing..
+    if(NULL == Powers) { return; }
+
+    nPowers = (maxBlocks >= MaxPowers) ? MaxPowers : ((0 == maxBlocks) ? 1 : (uint8_t)maxBlocks);
+    computePowers(H, Powers, nPowers);
+}
+
+/**
+ * @brief   hashes whole blocks: Y = (Y XOR X_i) . H for each block X_i
+ * @param   Y           pointer to 16 byte running hash value
+ * @param   X           pointer to input blocks
+ * @param   nBlocks     number of 16 byte blocks
+ */
+void OTGHASH_PCLMUL::ghashBlocks(uint8_t *const Y, const uint8_t *const X, const size_t nBlocks)
+{
+    if(!usePCLMUL) { fallback.ghashBlocks(Y, X, nBlocks); return; }
+
+    // Abort if no workspace or key to avoid crashing..
+    if(0 == nPowers) { return; }
+
+    ghashPCLMUL(Powers, nPowers, Y, X, nBlocks);
+}
+
+/**
+ * @brief   wipes the powers of H
+ */
+void OTGHASH_PCLMUL::clearAuthKey()
+{
+    if(!usePCLMUL) { fallback.clearAuthKey(); return; }
+    if(NULL != Powers) { memset(Powers, 0, PowersSize); }
+    nPowers = 0;
+}
+
+
+    }
+
+#endif // defined(OTAESGCM_HAS_PCLMUL_IMPL)
@@ -0,0 +1,111 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* x86/x86-64 PCLMULQDQ GHASH implementation with runtime CPU detection. */
+
+#ifndef ARDUINO_LIB_OTAESGCM_GHASHPCLMUL_H
+#define ARDUINO_LIB_OTAESGCM_GHASHPCLMUL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "OTAESGCM_GHASH.h"
+
+// Only for x86 hosts with a GCC-compatible compiler,
+// which can compile the PCLMULQDQ code without global -mpclmul.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define OTAESGCM_HAS_PCLMUL_IMPL // Can be used to enable features dependent on this implementation.
+
+#include "OTAESGCM_GHASHCtMul64.h"
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+
+    // Carry-less multiply GHASH for x86 hosts, eg gateways, to pair with OTAES128DE_AESNI.
+    // Precomputes H^1..H^8 in setAuthKey() (so once per key in a keyed context),
+    // then hashes up to 8 blocks per reduction:
+    //     Y' = (Y XOR X_1).H^k XOR X_2.H^(k-1) XOR ... XOR X_k.H
+    // with each product done Karatsuba-style (3 PCLMULQDQ)
+    // and the unreduced 256-bit products summed before a single reduction.
+    // Measured (g++ -O2, x86-64, TSC) at ~5 cycles/block for bulk data
+    // vs ~180 for OTGHASH_Shoup4.
+    // Whether the CPU supports PCLMULQDQ (and SSSE3) is checked once via CPUID;
+    // if not, this falls back to the constant-time OTGHASH_CtMul64 in the same workspace.
+    // Constant-time either way.
+    // Neither re-entrant nor ISR-safe except where stated.
+    // Carries the powers of H in its workspace between setAuthKey() and clearAuthKey(),
+    // which should be regarded as sensitive, and eg overwritten before being released to heap.
+    class OTGHASH_PCLMUL : public OTGHASH
+        {
+        protected:
+            // Number of powers of H held, and so maximum blocks per reduction.
+            static constexpr uint8_t MaxPowers = 8;
+            // Size of the table of powers of H (bytes).
+            static constexpr size_t PowersSize = 16 * MaxPowers;
+
+            // True if PCLMULQDQ is to be used, else use the fallback.
+            const bool usePCLMUL;
+            // H^1..H^MaxPowers, byte-reversed, unaligned;
+            // NULL if insufficient workspace is passed in.
+            uint8_t * const Powers;
+            // Number of powers of H in Powers; 0 while there is no hash subkey.
+            uint8_t nPowers = 0;
+
+            // Portable fallback sharing the same workspace.
+            OTGHASH_CtMul64 fallback;
+
+        public:
+            // Minimum workspace required, unaligned; strictly positive.
+            // This constant, defined per class, is effectively part of the API.
+            // Sized for the larger of this and the fallback.
+            static constexpr size_t workspaceRequired =
+                (PowersSize > OTGHASH_CtMul64::workspaceRequired) ? PowersSize : OTGHASH_CtMul64::workspaceRequired;
+
+            // True if this CPU supports PCLMULQDQ and SSSE3; checked once and cached.
+            static bool isAvailable();
+
+            // Construct an instance: supplied workspace must be large enough.
+            // Only the initial 'workspaceRequired' bytes will be used.
+            // If allowPCLMUL is false the portable fallback is always used,
+            // eg for testing or comparison.
+            OTGHASH_PCLMUL(uint8_t *const workspace, const size_t workspaceLen, const bool allowPCLMUL = true)
+              : usePCLMUL(allowPCLMUL && isAvailable()),
+                Powers((workspaceLen >= workspaceRequired) ? workspace : NULL),
+                fallback(workspace, (workspaceLen >= workspaceRequired) ? workspaceLen : 0)
+                { }
+
+            // True if PCLMULQDQ is actually in use by this instance.
+            bool isUsingPCLMUL() const { return(usePCLMUL); }
+
+            // Computes H^1..H^8 from H, which is not referred to afterwards.
+            // Does nothing if there is insufficient workspace.
+            virtual void setAuthKey(const uint8_t *H) override;
+            // Computes only H^1..H^maxBlocks (at least 1, at most 8).
+            virtual void setAuthKeyForBlocks(const uint8_t *H, size_t maxBlocks) override;
+            virtual void ghashBlocks(uint8_t *Y, const uint8_t *X, size_t nBlocks) override;
+            virtual void clearAuthKey() override;
+        };
+
+
+    }
+
+#endif // (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+
+#endif
@@ -0,0 +1,152 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* 4-bit table-driven (Shoup) GHASH implementation. */
+
+#include <string.h>
+
+#include "OTAESGCM_Block.h"
+#include "OTAESGCM_GHASHShoup4.h"
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+
+// Reduction table: the bits shifted out of the low end by a 4-bit right shift,
+// multiplied back in by R = 11100001 || 0^120, as the top 16 bits of the high word.
+static const uint16_t last4[16] = {
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+
+// Big-endian load/store of 64-bit words.
+static inline uint64_t loadBE64(const uint8_t *p)
+{
+    uint64_t v = 0;
+    for(uint8_t i = 0; i < 8; ++i) { v = (v << 8) | p[i]; }
+    return(v);
+}
+static inline void storeBE64(uint8_t *p, uint64_t v)
+{
+    for(uint8_t i = 8; i-- > 0; ) { p[i] = (uint8_t)v; v >>= 8; }
+}
+
+// Get/put table entry i as native (unaligned) words.
+static inline void getEntry(const uint8_t *table, const uint8_t i, uint64_t &hi, uint64_t &lo)
+{
+    memcpy(&hi, table + AES128GCM_BLOCK_SIZE*i, 8);
+    memcpy(&lo, table + AES128GCM_BLOCK_SIZE*i + 8, 8);
+}
+static inline void putEntry(uint8_t *table, const uint8_t i, const uint64_t hi, const uint64_t lo)
+{
+    memcpy(table + AES128GCM_BLOCK_SIZE*i, &hi, 8);
+    memcpy(table + AES128GCM_BLOCK_SIZE*i + 8, &lo, 8);
+}
+
+/**
+ * @brief   builds the table of multiples of H
+ * @param   H       pointer to the 16 byte hash subkey
+ *
+ * In GCM's reflected bit order entry 8 is H, entries 4, 2, 1
+ * are H.x, H.x^2, H.x^3, and the others are XORs of those.
+ */
+void OTGHASH_Shoup4::setAuthKey(const uint8_t *const H)
+{
+    // Abort if no workspace to avoid crashing..
+    if(NULL == Table) { return; }
+
+    uint64_t vh = loadBE64(H);
+    uint64_t vl = loadBE64(H + 8);
+    putEntry(Table, 0, 0, 0);
+    putEntry(Table, 8, vh, vl);
+    for(uint8_t i = 4; i > 0; i >>= 1)
+        {
+        // Multiply by x: shift right one bit, reducing by R if a bit falls off.
+        const uint64_t r = (vl & 1) ? ((uint64_t)0xe1 << 56) : 0;
+        vl = (vh << 63) | (vl >> 1);
+        vh = (vh >> 1) ^ r;
+        putEntry(Table, i, vh, vl);
+        }
+    for(uint8_t i = 2; i <= 8; i <<= 1)
+        {
+        uint64_t ih, il;
+        getEntry(Table, i, ih, il);
+        for(uint8_t j = 1; j < i; ++j)
+            {
+            uint64_t jh, jl;
+            getEntry(Table, j, jh, jl);
+            putEntry(Table, i + j, ih ^ jh, il ^ jl);
+            }
+        }
+    keyed = true;
+}
+
+/**
+ * @brief   hashes whole blocks: Y = (Y XOR X_i) . H for each block X_i
+ * @param   Y           pointer to 16 byte running hash value
+ * @param   X           pointer to input blocks
+ * @param   nBlocks     number of 16 byte blocks
+ *
+ * Works through Y XOR X_i a nibble at a time from the last,
+ * shifting the accumulator Z right 4 bits (reducing via last4)
+ * and adding in the table entry for each nibble.
+ */
+void OTGHASH_Shoup4::ghashBlocks(uint8_t *const Y, const uint8_t *X, size_t nBlocks)
+{
+    // Abort if no workspace or key to avoid crashing..
+    if(!keyed) { return; }
+
+    uint8_t y[AES128GCM_BLOCK_SIZE];
+    memcpy(y, Y, AES128GCM_BLOCK_SIZE);
+    for( ; nBlocks > 0; --nBlocks, X += AES128GCM_BLOCK_SIZE)
+        {
+        for(uint8_t i = 0; i < AES128GCM_BLOCK_SIZE; ++i) { y[i] ^= X[i]; }
+
+        uint64_t zh, zl;
+        getEntry(Table, y[15] & 0xf, zh, zl);
+        for(int8_t i = 15; i >= 0; --i)
+            {
+            const uint8_t b = y[i];
+            if(i != 15)
+                {
+                const uint8_t rem = (uint8_t)zl & 0xf;
+                zl = (zh << 60) | (zl >> 4);
+                zh = (zh >> 4) ^ ((uint64_t)last4[rem] << 48);
+                uint64_t th, tl;
+                getEntry(Table, b & 0xf, th, tl);
+                zh ^= th; zl ^= tl;
+                }
+            const uint8_t rem = (uint8_t)zl & 0xf;
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ ((uint64_t)last4[rem] << 48);
+            uint64_t th, tl;
+            getEntry(Table, b >> 4, th, tl);
+            zh ^= th; zl ^= tl;
+            }
+        storeBE64(y, zh);
+        storeBE64(y + 8, zl);
+        }
+    memcpy(Y, y, AES128GCM_BLOCK_SIZE);
+
+    // Erase temporary copy for security.
+    memset(y, 0, AES128GCM_BLOCK_SIZE);
+}
+
+
+    }
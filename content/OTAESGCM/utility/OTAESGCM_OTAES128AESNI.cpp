@@ -0,0 +1,602 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* x86/x86-64 AES-NI AES(128) implementation with runtime CPU detection. */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "OTAESGCM_OTAES128AESNI.h"
+
+#if defined(OTAESGCM_HAS_AESNI_IMPL)
+
+#include <cpuid.h>
+#include <wmmintrin.h>
+#include <emmintrin.h>
+
+// Compile selected functions for AES-NI without needing -maes globally;
+// they must only be called once CPUID has confirmed support.
+#define OTAESGCM_TARGET_AESNI __attribute__((target("aes,sse2")))
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+// The number of rounds in AES Cipher.
+static constexpr uint8_t Nr = 10;
+
+/**
+ * @brief   one step of the AES-128 key schedule
+ * @param   key         previous round key
+ * @param   keygened    result of AESKEYGENASSIST on the previous round key
+ * @retval  next round key
+ */
+OTAESGCM_TARGET_AESNI
+static inline __m128i expandStep(__m128i key, __m128i keygened)
+{
+    keygened = _mm_shuffle_epi32(keygened, _MM_SHUFFLE(3,3,3,3));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return(_mm_xor_si128(key, keygened));
+}
+
+/**
+ * @brief   fills rk with the Nr+1 round keys for key, in standard byte order
+ */
+OTAESGCM_TARGET_AESNI
+static void keyExpansionAESNI(const uint8_t *const key, uint8_t *const rk)
+{
+    __m128i k = _mm_loadu_si128((const __m128i *)key);
+    _mm_storeu_si128((__m128i *)rk, k);
+    // The round constant must be an immediate, so unroll.
+#define OTAESGCM_EXPAND_STEP(i, rcon) \
+    k = expandStep(k, _mm_aeskeygenassist_si128(k, rcon)); \
+    _mm_storeu_si128((__m128i *)(rk + 16*(i)), k);
+    OTAESGCM_EXPAND_STEP(1, 0x01)
+    OTAESGCM_EXPAND_STEP(2, 0x02)
+    OTAESGCM_EXPAND_STEP(3, 0x04)
+    OTAESGCM_EXPAND_STEP(4, 0x08)
+    OTAESGCM_EXPAND_STEP(5, 0x10)
+    OTAESGCM_EXPAND_STEP(6, 0x20)
+    OTAESGCM_EXPAND_STEP(7, 0x40)
+    OTAESGCM_EXPAND_STEP(8, 0x80)
+    OTAESGCM_EXPAND_STEP(9, 0x1b)
+    OTAESGCM_EXPAND_STEP(10, 0x36)
+#undef OTAESGCM_EXPAND_STEP
+    // Avoid leaving key material in registers.
+    k = _mm_setzero_si128();
+    (void)k;
+}
+
+/**
+ * @brief   encrypts one block with the expanded key rk
+ */
+OTAESGCM_TARGET_AESNI
+static void cipherAESNI(const uint8_t *const rk, const uint8_t *const input, uint8_t *const output)
+{
+    __m128i s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)input), _mm_loadu_si128((const __m128i *)rk));
+    for(uint8_t round = 1; round < Nr; ++round)
+        { s = _mm_aesenc_si128(s, _mm_loadu_si128((const __m128i *)(rk + 16*round))); }
+    s = _mm_aesenclast_si128(s, _mm_loadu_si128((const __m128i *)(rk + 16*Nr)));
+    _mm_storeu_si128((__m128i *)output, s);
+}
+
+/**
+ * @brief   encrypts 4 independent blocks with the expanded key rk
+ *
+ * Each round key is applied to all the blocks in turn,
+ * so that several AESENC (each with a latency of several cycles) are in flight at once.
+ * Written out explicitly so that the state stays in registers
+ * without relying on the optimiser to unroll.
+ */
+OTAESGCM_TARGET_AESNI
+static void cipherAESNI4(const uint8_t *const rk, const uint8_t *const input, uint8_t *const output)
+{
+    __m128i k = _mm_loadu_si128((const __m128i *)rk);
+    __m128i s0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input     )), k);
+    __m128i s1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input + 16)), k);
+    __m128i s2 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input + 32)), k);
+    __m128i s3 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input + 48)), k);
+    for(uint8_t round = 1; round < Nr; ++round)
+        {
+        k = _mm_loadu_si128((const __m128i *)(rk + 16*round));
+        s0 = _mm_aesenc_si128(s0, k);
+        s1 = _mm_aesenc_si128(s1, k);
+        s2 = _mm_aesenc_si128(s2, k);
+        s3 = _mm_aesenc_si128(s3, k);
+        }
+    k = _mm_loadu_si128((const __m128i *)(rk + 16*Nr));
+    _mm_storeu_si128((__m128i *)(output     ), _mm_aesenclast_si128(s0, k));
+    _mm_storeu_si128((__m128i *)(output + 16), _mm_aesenclast_si128(s1, k));
+    _mm_storeu_si128((__m128i *)(output + 32), _mm_aesenclast_si128(s2, k));
+    _mm_storeu_si128((__m128i *)(output + 48), _mm_aesenclast_si128(s3, k));
+}
+
+/**
+ * @brief   encrypts 8 independent blocks with the expanded key rk
+ *
+ * As for cipherAESNI4(), with enough blocks in flight
+ * to cover the AESENC latency on most cores.
+ */
+OTAESGCM_TARGET_AESNI
+static void cipherAESNI8(const uint8_t *const rk, const uint8_t *const input, uint8_t *const output)
+{
+    __m128i k = _mm_loadu_si128((const __m128i *)rk);
+    __m128i s0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input      )), k);
+    __m128i s1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input +  16)), k);
+    __m128i s2 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input +  32)), k);
+    __m128i s3 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input +  48)), k);
+    __m128i s4 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input +  64)), k);
+    __m128i s5 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input +  80)), k);
+    __m128i s6 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input +  96)), k);
+    __m128i s7 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input + 112)), k);
+    for(uint8_t round = 1; round < Nr; ++round)
+        {
+        k = _mm_loadu_si128((const __m128i *)(rk + 16*round));
+        s0 = _mm_aesenc_si128(s0, k);
+        s1 = _mm_aesenc_si128(s1, k);
+        s2 = _mm_aesenc_si128(s2, k);
+        s3 = _mm_aesenc_si128(s3, k);
+        s4 = _mm_aesenc_si128(s4, k);
+        s5 = _mm_aesenc_si128(s5, k);
+        s6 = _mm_aesenc_si128(s6, k);
+        s7 = _mm_aesenc_si128(s7, k);
+        }
+    k = _mm_loadu_si128((const __m128i *)(rk + 16*Nr));
+    _mm_storeu_si128((__m128i *)(output      ), _mm_aesenclast_si128(s0, k));
+    _mm_storeu_si128((__m128i *)(output +  16), _mm_aesenclast_si128(s1, k));
+    _mm_storeu_si128((__m128i *)(output +  32), _mm_aesenclast_si128(s2, k));
+    _mm_storeu_si128((__m128i *)(output +  48), _mm_aesenclast_si128(s3, k));
+    _mm_storeu_si128((__m128i *)(output +  64), _mm_aesenclast_si128(s4, k));
+    _mm_storeu_si128((__m128i *)(output +  80), _mm_aesenclast_si128(s5, k));
+    _mm_storeu_si128((__m128i *)(output +  96), _mm_aesenclast_si128(s6, k));
+    _mm_storeu_si128((__m128i *)(output + 112), _mm_aesenclast_si128(s7, k));
+}
+
+/**
+ * @brief   counter mode over nBlocks blocks with the expanded key rk
+ * @param   ctr         16 byte counter block, advanced by nBlocks
+ *
+ * Only the last (big-endian) word of the counter block changes,
+ * so each block is made from the three fixed words and the count,
+ * byte-swapped, without touching memory.
+ * 8 blocks at a time are encrypted with their rounds interleaved
+ * as for cipherAESNI8(), then any remaining one at a time.
+ */
+OTAESGCM_TARGET_AESNI
+static void ctrAESNI(const uint8_t *const rk, uint8_t *const ctr,
+                     const uint8_t *input, size_t nBlocks, uint8_t *output)
+{
+    int32_t w[3];
+    memcpy(w, ctr, sizeof(w));
+    uint32_t count = ((uint32_t)ctr[12] << 24) | ((uint32_t)ctr[13] << 16) | ((uint32_t)ctr[14] << 8) | ctr[15];
+#define OTAESGCM_CTR_BLOCK(i) _mm_set_epi32((int32_t)__builtin_bswap32(count + (i)), w[2], w[1], w[0])
+    for( ; nBlocks >= 8; nBlocks -= 8, count += 8, input += 8*16, output += 8*16)
+        {
+        __m128i k = _mm_loadu_si128((const __m128i *)rk);
+        __m128i s0 = _mm_xor_si128(OTAESGCM_CTR_BLOCK(0), k);
+        __m128i s1 = _mm_xor_si128(OTAESGCM_CTR_BLOCK(1), k);
+        __m128i s2 = _mm_xor_si128(OTAESGCM_CTR_BLOCK(2), k);
+        __m128i s3 = _mm_xor_si128(OTAESGCM_CTR_BLOCK(3), k);
+        __m128i s4 = _mm_xor_si128(OTAESGCM_CTR_BLOCK(4), k);
+        __m128i s5 = _mm_xor_si128(OTAESGCM_CTR_BLOCK(5), k);
+        __m128i s6 = _mm_xor_si128(OTAESGCM_CTR_BLOCK(6), k);
+        __m128i s7 = _mm_xor_si128(OTAESGCM_CTR_BLOCK(7), k);
+        for(uint8_t round = 1; round < Nr; ++round)
+            {
+            k = _mm_loadu_si128((const __m128i *)(rk + 16*round));
+            s0 = _mm_aesenc_si128(s0, k);
+            s1 = _mm_aesenc_si128(s1, k);
+            s2 = _mm_aesenc_si128(s2, k);
+            s3 = _mm_aesenc_si128(s3, k);
+            s4 = _mm_aesenc_si128(s4, k);
+            s5 = _mm_aesenc_si128(s5, k);
+            s6 = _mm_aesenc_si128(s6, k);
+            s7 = _mm_aesenc_si128(s7, k);
+            }
+        k = _mm_loadu_si128((const __m128i *)(rk + 16*Nr));
+        _mm_storeu_si128((__m128i *)(output      ), _mm_xor_si128(_mm_aesenclast_si128(s0, k), _mm_loadu_si128((const __m128i *)(input      ))));
+        _mm_storeu_si128((__m128i *)(output +  16), _mm_xor_si128(_mm_aesenclast_si128(s1, k), _mm_loadu_si128((const __m128i *)(input +  16))));
+        _mm_storeu_si128((__m128i *)(output +  32), _mm_xor_si128(_mm_aesenclast_si128(s2, k), _mm_loadu_si128((const __m128i *)(input +  32))));
+        _mm_storeu_si128((__m128i *)(output +  48), _mm_xor_si128(_mm_aesenclast_si128(s3, k), _mm_loadu_si128((const __m128i *)(input +  48))));
+        _mm_storeu_si128((__m128i *)(output +  64), _mm_xor_si128(_mm_aesenclast_si128(s4, k), _mm_loadu_si128((const __m128i *)(input +  64))));
+        _mm_storeu_si128((__m128i *)(output +  80), _mm_xor_si128(_mm_aesenclast_si128(s5, k), _mm_loadu_si128((const __m128i *)(input +  80))));
+        _mm_storeu_si128((__m128i *)(output +  96), _mm_xor_si128(_mm_aesenclast_si128(s6, k), _mm_loadu_si128((const __m128i *)(input +  96))));
+        _mm_storeu_si128((__m128i *)(output + 112), _mm_xor_si128(_mm_aesenclast_si128(s7, k), _mm_loadu_si128((const __m128i *)(input + 112))));
+        }
+    for( ; nBlocks > 0; --nBlocks, ++count, input += 16, output += 16)
+        {
+        __m128i s = _mm_xor_si128(OTAESGCM_CTR_BLOCK(0), _mm_loadu_si128((const __m128i *)rk));
+        for(uint8_t round = 1; round < Nr; ++round)
+            { s = _mm_aesenc_si128(s, _mm_loadu_si128((const __m128i *)(rk + 16*round))); }
+        s = _mm_aesenclast_si128(s, _mm_loadu_si128((const __m128i *)(rk + 16*Nr)));
+        _mm_storeu_si128((__m128i *)output, _mm_xor_si128(s, _mm_loadu_si128((const __m128i *)input)));
+        }
+#undef OTAESGCM_CTR_BLOCK
+    ctr[12] = (uint8_t)(count >> 24);
+    ctr[13] = (uint8_t)(count >> 16);
+    ctr[14] = (uint8_t)(count >> 8);
+    ctr[15] = (uint8_t)count;
+}
+
+/**
+ * @brief   decrypts one block with the expanded (encryption) key rk
+ *
+ * Uses the equivalent inverse cipher, applying AESIMC to the
+ * middle round keys on the fly rather than storing a second schedule.
+ */
+OTAESGCM_TARGET_AESNI
+static void invCipherAESNI(const uint8_t *const rk, const uint8_t *const input, uint8_t *const output)
+{
+    __m128i s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)input), _mm_loadu_si128((const __m128i *)(rk + 16*Nr)));
+    for(uint8_t round = Nr - 1; round > 0; --round)
+        { s = _mm_aesdec_si128(s, _mm_aesimc_si128(_mm_loadu_si128((const __m128i *)(rk + 16*round)))); }
+    s = _mm_aesdeclast_si128(s, _mm_loadu_si128((const __m128i *)rk));
+    _mm_storeu_si128((__m128i *)output, s);
+}
+
+// True if this CPU supports AES-NI; checked once and cached.
+bool OTAES128DE_AESNI::isAvailable()
+{
+    static const bool available = []()
+        {
+        unsigned int eax, ebx, ecx, edx;
+        if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) { return(false); }
+        return(0 != (ecx & bit_AES));
+        }();
+    return(available);
+}
+
+/**
+ * @brief    Fills RoundKey with key expansion of Key
+ */
+void OTAES128DE_AESNI::KeyExpansion()
+{
+    keyExpansionAESNI(Key, RoundKey);
+}
+
+/**
+ *    @brief    AES128 block encryption
+ *    @param    input takes a pointer to an array containing plaintext
+ *    @param    key takes a pointer to a 128bit secret key
+ *    @param    output takes a pointer to an array to fill with ciphertext
+ *
+ * Input and output may be the same buffer.
+ * Cleans up internal sensitive state when done
+ * unless the key schedule is being retained or cached.
+ */
+void OTAES128DE_AESNI::blockEncrypt(const uint8_t *const input, const uint8_t *const key, uint8_t *const output)
+{
+    if(!useAESNI) { fallback.blockEncrypt(input, key, output); return; }
+
+    // Abort if no workspace to avoid crashing..
+    if(NULL == RoundKey) { return; }
+
+    // Skip the expansion if the schedule for this key is being retained or cached.
+    if(!hasScheduleFor(key)) { Key = key; KeyExpansion(); }
+
+    cipherAESNI(RoundKey, input, output);
+
+    // Clean up private state unless retaining or caching it.
+    if(!retained && !caching) { cleanup(); }
+}
+
+/**
+ *    @brief    AES128 encryption of several independent blocks under one key
+ *    @param    input takes a pointer to nBlocks contiguous blocks of plaintext
+ *    @param    nBlocks number of blocks
+ *    @param    key takes a pointer to a 128bit secret key
+ *    @param    output takes a pointer to an array to fill with ciphertext
+ *
+ * Input and output may be the same buffer.
+ * Cleans up internal sensitive state when done
+ * unless the key schedule is being retained or cached.
+ */
+void OTAES128DE_AESNI::blocksEncrypt(const uint8_t *input, size_t nBlocks, const uint8_t *const key, uint8_t *output)
+{
+    if(!useAESNI) { fallback.blocksEncrypt(input, nBlocks, key, output); return; }
+
+    // Abort if no workspace to avoid crashing..
+    if(NULL == RoundKey) { return; }
+    if(0 == nBlocks) { return; }
+
+    // Skip the expansion if the schedule for this key is being retained or cached.
+    if(!hasScheduleFor(key)) { Key = key; KeyExpansion(); }
+
+    for( ; nBlocks >= 8; nBlocks -= 8, input += 8*16, output += 8*16)
+        { cipherAESNI8(RoundKey, input, output); }
+    if(nBlocks >= 4)
+        { cipherAESNI4(RoundKey, input, output); nBlocks -= 4; input += 4*16; output += 4*16; }
+    for( ; nBlocks > 0; --nBlocks, input += 16, output += 16)
+        { cipherAESNI(RoundKey, input, output); }
+
+    // Clean up private state unless retaining or caching it.
+    if(!retained && !caching) { cleanup(); }
+}
+
+/**
+ *    @brief    AES128 counter mode over whole blocks under one key
+ *    @param    ctrBlock takes a pointer to the 16-byte counter block, advanced by nBlocks
+ *    @param    input takes a pointer to nBlocks contiguous blocks of plaintext (or ciphertext)
+ *    @param    nBlocks number of blocks
+ *    @param    key takes a pointer to a 128bit secret key
+ *    @param    output takes a pointer to an array to fill with ciphertext (or plaintext)
+ *
+ * Cleans up internal sensitive state when done
+ * unless the key schedule is being retained or cached.
+ */
+void OTAES128DE_AESNI::ctrEncrypt(uint8_t *const ctrBlock, const uint8_t *const input, const size_t nBlocks, const uint8_t *const key, uint8_t *const output)
+{
+    if(!useAESNI) { fallback.ctrEncrypt(ctrBlock, input, nBlocks, key, output); return; }
+
+    // Abort if no workspace to avoid crashing..
+    if(NULL == RoundKey) { return; }
+    if(0 == nBlocks) { return; }
+
+    // Skip the expansion if the schedule for this key is being retained or cached.
+    if(!hasScheduleFor(key)) { Key = key; KeyExpansion(); }
+
+    ctrAESNI(RoundKey, ctrBlock, input, nBlocks, output);
+
+    // Clean up private state unless retaining or caching it.
+    if(!retained && !caching) { cleanup(); }
+}
+
+/**
+ *    @brief    AES128 block decryption
+ *    @param    input takes a pointer to an array containing ciphertext
+ *    @param    key takes a pointer to a 128bit secret key
+ *    @param    output takes a pointer to an array to fill with plaintext
+ *
+ * Cleans up internal sensitive state when done
+ * unless the key schedule is being retained or cached.
+ */
+void OTAES128DE_AESNI::blockDecrypt(const uint8_t *const input, const uint8_t *const key, uint8_t *const output)
+{
+    if(!useAESNI) { fallback.blockDecrypt(input, key, output); return; }
+
+    // Abort if no workspace to avoid crashing..
+    if(NULL == RoundKey) { return; }
+
+    // Skip the expansion if the schedule for this key is being retained or cached.
+    if(!hasScheduleFor(key)) { Key = key; KeyExpansion(); }
+
+    invCipherAESNI(RoundKey, input, output);
+
+    // Clean up private state unless retaining or caching it.
+    if(!retained && !caching) { cleanup(); }
+}
+
+/**
+ *    @brief    Expand and retain the key schedule between calls
+ *    @param    key takes a pointer to a 128bit secret key
+ *
+ * The schedule is kept until clearKeySchedule().
+ * While caching, the expansion is skipped if the key bytes are unchanged.
+ */
+void OTAES128DE_AESNI::retainKeySchedule(const uint8_t *const key)
+{
+    if(!useAESNI) { fallback.retainKeySchedule(key); return; }
+
+    // Abort if no workspace to avoid crashing..
+    if(NULL == RoundKey) { return; }
+
+    const bool cached = caching && (NULL != Key) && sameKey(key, RoundKey);
+    Key = key;
+    retained = true;
+    if(!cached) { KeyExpansion(); }
+}
+
+/**
+ *    @brief    Stop retaining the key schedule and wipe it unless caching
+ */
+void OTAES128DE_AESNI::clearKeySchedule()
+{
+    if(!useAESNI) { fallback.clearKeySchedule(); return; }
+    retained = false;
+    if(!caching) { cleanup(); }
+}
+
+/**
+ *    @brief    Keep the last schedule expanded until wipeKeySchedule()
+ */
+void OTAES128DE_AESNI::cacheKeySchedule()
+{
+    if(!useAESNI) { fallback.cacheKeySchedule(); return; }
+    caching = true;
+}
+
+/**
+ *    @brief    Stop caching and retaining, and wipe the schedule
+ */
+void OTAES128DE_AESNI::wipeKeySchedule()
+{
+    if(!useAESNI) { fallback.wipeKeySchedule(); return; }
+    retained = false;
+    caching = false;
+    cleanup();
+}
+
+
+/**
+ * @brief   encrypts block i of input under schedule i of rks for lanes [0,N)
+ *
+ * As for cipherAESNI4(), but with a separate round key per lane.
+ */
+template<uint8_t N>
+OTAESGCM_TARGET_AESNI
+static void lanesCipherAESNI(const uint8_t *const rks, const uint8_t *const input, uint8_t *const output)
+{
+    static_assert((4 == N) || (8 == N), "4 or 8 lanes");
+    __m128i s0, s1, s2, s3, s4, s5, s6, s7;
+    s4 = s5 = s6 = s7 = _mm_setzero_si128();
+    // Lane i, round r.
+#define OTAESGCM_RK(i, r) _mm_loadu_si128((const __m128i *)(rks + 176*(i) + 16*(r)))
+#define OTAESGCM_IN(i) _mm_loadu_si128((const __m128i *)(input + 16*(i)))
+    s0 = _mm_xor_si128(OTAESGCM_IN(0), OTAESGCM_RK(0, 0));
+    s1 = _mm_xor_si128(OTAESGCM_IN(1), OTAESGCM_RK(1, 0));
+    s2 = _mm_xor_si128(OTAESGCM_IN(2), OTAESGCM_RK(2, 0));
+    s3 = _mm_xor_si128(OTAESGCM_IN(3), OTAESGCM_RK(3, 0));
+    if(8 == N)
+        {
+        s4 = _mm_xor_si128(OTAESGCM_IN(4), OTAESGCM_RK(4, 0));
+        s5 = _mm_xor_si128(OTAESGCM_IN(5), OTAESGCM_RK(5, 0));
+        s6 = _mm_xor_si128(OTAESGCM_IN(6), OTAESGCM_RK(6, 0));
+        s7 = _mm_xor_si128(OTAESGCM_IN(7), OTAESGCM_RK(7, 0));
+        }
+    for(uint8_t round = 1; round < Nr; ++round)
+        {
+        s0 = _mm_aesenc_si128(s0, OTAESGCM_RK(0, round));
+        s1 = _mm_aesenc_si128(s1, OTAESGCM_RK(1, round));
+        s2 = _mm_aesenc_si128(s2, OTAESGCM_RK(2, round));
+        s3 = _mm_aesenc_si128(s3, OTAESGCM_RK(3, round));
+        if(8 == N)
+            {
+            s4 = _mm_aesenc_si128(s4, OTAESGCM_RK(4, round));
+            s5 = _mm_aesenc_si128(s5, OTAESGCM_RK(5, round));
+            s6 = _mm_aesenc_si128(s6, OTAESGCM_RK(6, round));
+            s7 = _mm_aesenc_si128(s7, OTAESGCM_RK(7, round));
+            }
+        }
+    _mm_storeu_si128((__m128i *)(output     ), _mm_aesenclast_si128(s0, OTAESGCM_RK(0, Nr)));
+    _mm_storeu_si128((__m128i *)(output + 16), _mm_aesenclast_si128(s1, OTAESGCM_RK(1, Nr)));
+    _mm_storeu_si128((__m128i *)(output + 32), _mm_aesenclast_si128(s2, OTAESGCM_RK(2, Nr)));
+    _mm_storeu_si128((__m128i *)(output + 48), _mm_aesenclast_si128(s3, OTAESGCM_RK(3, Nr)));
+    if(8 == N)
+        {
+        _mm_storeu_si128((__m128i *)(output +  64), _mm_aesenclast_si128(s4, OTAESGCM_RK(4, Nr)));
+        _mm_storeu_si128((__m128i *)(output +  80), _mm_aesenclast_si128(s5, OTAESGCM_RK(5, Nr)));
+        _mm_storeu_si128((__m128i *)(output +  96), _mm_aesenclast_si128(s6, OTAESGCM_RK(6, Nr)));
+        _mm_storeu_si128((__m128i *)(output + 112), _mm_aesenclast_si128(s7, OTAESGCM_RK(7, Nr)));
+        }
+#undef OTAESGCM_IN
+#undef OTAESGCM_RK
+}
+
+/**
+ * @brief   one step of the AES-128 key schedule without AESKEYGENASSIST
+ * @param   key         previous round key
+ * @param   rcon        round constant in each 32-bit word
+ * @retval  next round key
+ *
+ * SubWord(RotWord(w3)) XOR rcon is computed by broadcasting RotWord(w3)
+ * to all four columns, where ShiftRows has no effect, and applying AESENCLAST.
+ * AESKEYGENASSIST is microcoded on many cores, with a throughput of
+ * one per 10+ cycles however many independent schedules are interleaved;
+ * AESENCLAST is pipelined like AESENC.
+ */
+OTAESGCM_TARGET_AESNI
+static inline __m128i expandStepEncLast(__m128i key, const __m128i rcon)
+{
+    __m128i t = _mm_shuffle_epi32(key, _MM_SHUFFLE(3,3,3,3));
+    t = _mm_or_si128(_mm_srli_epi32(t, 8), _mm_slli_epi32(t, 24));
+    t = _mm_aesenclast_si128(t, rcon);
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return(_mm_xor_si128(key, t));
+}
+
+/**
+ * @brief   expands the schedules of lanes [0,N) from their first round keys (the keys)
+ *
+ * As for keyExpansionAESNI(), with the lanes' independent steps interleaved
+ * so that their latencies overlap.
+ */
+template<uint8_t N>
+OTAESGCM_TARGET_AESNI
+static void lanesKeyExpansionAESNI(uint8_t *const rks)
+{
+    static_assert((4 == N) || (8 == N), "4 or 8 lanes");
+    __m128i k[N];
+    for(uint8_t i = 0; i < N; ++i) { k[i] = _mm_loadu_si128((const __m128i *)(rks + 176*i)); }
+    static const uint8_t rcon[Nr] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36 };
+    for(uint8_t r = 1; r <= Nr; ++r)
+        {
+        const __m128i rc = _mm_set1_epi32(rcon[r-1]);
+        for(uint8_t i = 0; i < N; ++i)
+            {
+            k[i] = expandStepEncLast(k[i], rc);
+            _mm_storeu_si128((__m128i *)(rks + 176*i + 16*r), k[i]);
+            }
+        }
+    // Avoid leaving key material in registers.
+    for(uint8_t i = 0; i < N; ++i) { k[i] = _mm_setzero_si128(); }
+    (void)k;
+}
+
+/**
+ *    @brief    Set the key for one lane, its schedule being expanded on first use
+ *    @param    lane in the range [0,MaxLanes)
+ *    @param    key takes a pointer to a 128bit secret key
+ *
+ * The key is kept as the lane's first round key,
+ * so that the lanes' schedules can all be expanded together.
+ */
+void OTAES128EMultiKey_AESNI::setLaneKey(const uint8_t lane, const uint8_t *const key)
+{
+    if(!useAESNI) { fallback.setLaneKey(lane, key); return; }
+
+    // Abort if no workspace to avoid crashing..
+    if((NULL == RoundKeys) || (lane >= MaxLanes)) { return; }
+
+    memcpy(RoundKeys + RoundKeySize * lane, key, 16);
+    pending |= (uint8_t)(1U << lane);
+}
+
+/**
+ *    @brief    AES128 encryption of block i under the key of lane i
+ *    @param    input takes a pointer to MaxLanes blocks of plaintext
+ *    @param    laneMask lanes to encrypt
+ *    @param    output takes a pointer to MaxLanes blocks to fill with ciphertext
+ *
+ * Input and output may be the same buffer.
+ * All of lanes 0--3, or 0--7 if any of 4--7 are in laneMask, are processed,
+ * those not in laneMask with unspecified results.
+ */
+void OTAES128EMultiKey_AESNI::lanesEncrypt(const uint8_t *const input, const uint8_t laneMask, uint8_t *const output)
+{
+    if(!useAESNI) { fallback.lanesEncrypt(input, laneMask, output); return; }
+
+    // Abort if no workspace to avoid crashing..
+    if(NULL == RoundKeys) { return; }
+
+    // Expand any new keys first, all lanes up to the highest together.
+    if(0 != (pending & 0xf0)) { lanesKeyExpansionAESNI<8>(RoundKeys); }
+    else if(0 != pending) { lanesKeyExpansionAESNI<4>(RoundKeys); }
+    pending = 0;
+
+    if(0 != (laneMask & 0xf0)) { lanesCipherAESNI<8>(RoundKeys, input, output); }
+    else if(0 != laneMask) { lanesCipherAESNI<4>(RoundKeys, input, output); }
+}
+
+/**
+ *    @brief    Wipe all lane key schedules
+ */
+void OTAES128EMultiKey_AESNI::clearLaneKeys()
+{
+    if(!useAESNI) { fallback.clearLaneKeys(); return; }
+    if(NULL != RoundKeys) { memset(RoundKeys, 0, MaxLanes * (size_t)RoundKeySize); }
+    pending = 0;
+}
+
+
+    }
+
+#endif // defined(OTAESGCM_HAS_AESNI_IMPL)
@@ -0,0 +1,214 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* x86/x86-64 AES-NI AES(128) implementation with runtime CPU detection. */
+
+#ifndef ARDUINO_LIB_OTAESGCM_OTAES128AESNI_H
+#define ARDUINO_LIB_OTAESGCM_OTAES128AESNI_H
+
+#include <stdint.h>
+#include <string.h>
+#include "OTAESGCM_OTAES128.h"
+
+// Only for x86 hosts with a GCC-compatible compiler,
+// which can compile the AES-NI code without global -maes.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define OTAESGCM_HAS_AESNI_IMPL // Can be used to enable features dependent on this implementation.
+
+#include "OTAESGCM_OTAES128TTable.h"
+#include "OTAESGCM_OTAES128SSSE3.h"
+#include "OTAESGCM_OTAES128MultiKey.h"
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+
+    // AES-NI decrypt and encrypt implementation for x86 hosts, eg gateways.
+    // Uses AESENC/AESENCLAST with an AESKEYGENASSIST key schedule,
+    // and AESDEC/AESDECLAST with the AESIMC-transformed schedule computed on the fly.
+    // Whether the CPU supports AES-NI is checked once via CPUID;
+    // if not, this falls back to OTAES128DE_SSSE3 in the same workspace,
+    // which in turn falls back to the portable implementations without SSSE3,
+    // so a single binary runs everywhere, constant-time wherever SSSE3 is present.
+    // Measured (g++ -O2, x86-64, TSC) at ~145 cycles/block including key expansion
+    // and schedule wipe, and ~25 with a retained schedule.
+    // Constant-time when AES-NI or SSSE3 is used.
+    // Neither re-entrant nor ISR-safe except where stated.
+    // Carries workspace but logically no state is carried from one operation to the next,
+    // other than a key schedule explicitly retained with retainKeySchedule()
+    // or cached with cacheKeySchedule().
+    // Residual state should be regarded as sensitive, and eg overwritten before being released to heap.
+    class OTAES128DE_AESNI : public OTAES128D, public OTAES128E
+        {
+        protected:
+            // Size of the round key schedule (bytes), in standard byte order.
+            static constexpr uint8_t RoundKeySize = 176;
+
+            // True if AES-NI is to be used, else use the fallback.
+            const bool useAESNI;
+            // The key whose schedule is in RoundKey; NULL if none.
+            const uint8_t *Key = NULL;
+            // Nr+1 round keys; NULL if insufficient workspace is passed in.
+            uint8_t * const RoundKey;
+            // True while the schedule for Key is retained between calls.
+            bool retained = false;
+            // True while the last schedule expanded is cached between calls.
+            bool caching = false;
+
+            // Fallback sharing the same workspace and schedule layout.
+            OTAES128DE_SSSE3 fallback;
+
+            // True if RoundKey holds the schedule for key: the same pointer while retained,
+            // or the same bytes while caching (the first round key being the key itself).
+            bool hasScheduleFor(const uint8_t *key) const
+                { return((retained && (key == Key)) || (caching && (NULL != Key) && sameKey(key, RoundKey))); }
+
+            void KeyExpansion();
+
+        public:
+            // Minimum workspace required, unaligned; strictly positive.
+            // This constant, defined per class, is effectively part of the API.
+            static constexpr uint8_t workspaceRequired = RoundKeySize;
+
+            // True if this CPU supports AES-NI; checked once and cached.
+            static bool isAvailable();
+
+            // Construct an instance: supplied workspace must be large enough.
+            // Only the initial 'workspaceRequired' bytes will be used.
+            // If allowAESNI is false the fallback is always used,
+            // and if allowSSSE3 is also false so are the portable implementations,
+            // eg for testing or comparison.
+            OTAES128DE_AESNI(uint8_t *const workspace, uint8_t workspaceLen, const bool allowAESNI = true, const bool allowSSSE3 = true)
+              : useAESNI(allowAESNI && isAvailable()),
+                RoundKey((workspaceLen >= workspaceRequired) ? workspace : NULL),
+                fallback(workspace, workspaceLen, allowSSSE3)
+                { }
+
+            // True if AES-NI is actually in use by this instance.
+            bool isUsingAESNI() const { return(useAESNI); }
+
+            // Clean up sensitive state and remove pointers to external state.
+            void cleanup() { if((NULL != RoundKey) && (NULL != Key))
+                { memset(RoundKey, 0, RoundKeySize); Key=NULL; } }
+
+            /**
+             *    @brief    AES128 block encryption
+             *    @param    input takes a pointer to an array containing plaintext, of size 16 bytes; never NULL
+             *    @param    key takes a pointer to a 128-bit (16-byte) secret key; never NULL
+             *    @param    output takes a pointer to an array to fill with ciphertext, of size 16 bytes; never NULL
+             *
+             * Cleans up internal sensitive state when done
+             * unless the key schedule is being retained or cached.
+             */
+            virtual void blockEncrypt(const uint8_t* input, const uint8_t* key, uint8_t *output) override;
+
+            // Encrypts up to 8 independent blocks at a time with their rounds interleaved,
+            // so that several AESENC are in flight at once;
+            // the key is expanded at most once per call.
+            virtual void blocksEncrypt(const uint8_t *input, size_t nBlocks, const uint8_t *key, uint8_t *output) override;
+
+            // Counter mode with the counter blocks made in registers, 8 at a time with their rounds
+            // interleaved as for blocksEncrypt(), and the input XORed in before storing,
+            // so no counter or key stream block goes through memory.
+            virtual void ctrEncrypt(uint8_t *ctrBlock, const uint8_t *input, size_t nBlocks, const uint8_t *key, uint8_t *output) override;
+
+            /**
+             *    @brief    AES128 block decryption
+             *    @param    input takes a pointer to an array containing ciphertext, of size 16 bytes; never NULL
+             *    @param    key takes a pointer to a 128-bit (16-byte) secret key; never NULL
+             *    @param    output takes a pointer to an array to fill with plaintext, of size 16 bytes; never NULL
+             *
+             * Cleans up internal sensitive state when done
+             * unless the key schedule is being retained or cached.
+             */
+            virtual void blockDecrypt(const uint8_t* input, const uint8_t* key, uint8_t *output) override;
+
+            // Expand the key into RoundKey and keep it until clearKeySchedule(),
+            // skipping the expansion if already cached.
+            // Does nothing if there is insufficient workspace.
+            virtual void retainKeySchedule(const uint8_t *key) override;
+
+            // Stop retaining the key schedule and wipe it unless caching.
+            virtual void clearKeySchedule() override;
+
+            // Keep the last schedule expanded until wipeKeySchedule(),
+            // also in the fallback, whose shared schedule is checked by value.
+            virtual void cacheKeySchedule() override;
+
+            // Stop caching and retaining, and wipe the schedule.
+            virtual void wipeKeySchedule() override;
+        };
+
+    // AES-NI multi-key implementation for x86 hosts, eg gateways,
+    // with the rounds of all lanes interleaved so that up to 8 AESENC,
+    // each under a different key, are in flight at once.
+    // Whether the CPU supports AES-NI is checked once via CPUID;
+    // if not, this falls back to OTAES128EMultiKey_Lanes<OTAES128E_TTable> in the same workspace.
+    // Constant-time when AES-NI is used.
+    // Neither re-entrant nor ISR-safe except where stated.
+    // Carries the lanes' key schedules in its workspace between setLaneKey() and clearLaneKeys(),
+    // which should be regarded as sensitive, and eg overwritten before being released to heap.
+    class OTAES128EMultiKey_AESNI : public OTAES128EMultiKey
+        {
+        private:
+            typedef OTAES128EMultiKey_Lanes<OTAES128E_TTable> fallback_t;
+            // Size of each lane's round key schedule (bytes), in standard byte order.
+            static constexpr uint8_t RoundKeySize = 176;
+
+            // True if AES-NI is to be used, else use the fallback.
+            const bool useAESNI;
+            // MaxLanes schedules of Nr+1 round keys; NULL if insufficient workspace is passed in.
+            uint8_t * const RoundKeys;
+            // Lanes whose keys are set but schedules not yet expanded.
+            uint8_t pending = 0;
+
+            // Portable fallback sharing the same workspace.
+            fallback_t fallback;
+
+        public:
+            // Minimum workspace required, unaligned; strictly positive.
+            // Sized for the larger of this and the fallback.
+            static constexpr size_t workspaceRequired =
+                (MaxLanes * (size_t)RoundKeySize > fallback_t::workspaceRequired) ? MaxLanes * (size_t)RoundKeySize : fallback_t::workspaceRequired;
+
+            // Construct an instance: supplied workspace must be large enough.
+            // If allowAESNI is false the portable fallback is always used,
+            // eg for testing or comparison.
+            OTAES128EMultiKey_AESNI(uint8_t *const workspace, const size_t workspaceLen, const bool allowAESNI = true)
+              : useAESNI(allowAESNI && OTAES128DE_AESNI::isAvailable()),
+                RoundKeys(((NULL != workspace) && (workspaceLen >= workspaceRequired)) ? workspace : NULL),
+                fallback(workspace, (workspaceLen >= workspaceRequired) ? workspaceLen : 0)
+                { }
+
+            // True if AES-NI is actually in use by this instance.
+            bool isUsingAESNI() const { return(useAESNI); }
+
+            // Expansion is deferred to the next lanesEncrypt(), which expands all new keys together.
+            virtual void setLaneKey(uint8_t lane, const uint8_t *key) override;
+            // Lanes up to the highest in laneMask are all processed together.
+            virtual void lanesEncrypt(const uint8_t *input, uint8_t laneMask, uint8_t *output) override;
+            virtual void clearLaneKeys() override;
+        };
+
+
+    }
+
+#endif // (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+
+#endif
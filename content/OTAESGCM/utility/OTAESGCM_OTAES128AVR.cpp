@@ -23,13 +23,7 @@ Author(s) / Copyright (s): Deniz Erbilgin 2015--2017
 #include <stdint.h>
 #include <string.h>
 
-#if defined(__AVR_ARCH__) || defined(ARDUINO_ARCH_AVR) // Atmel AVR only.
-#include <avr/pgmspace.h>
-#else
-// Kludge code to treat PROGMEM as part of uniform memory space.
-#define PROGMEM
-inline uint8_t pgm_read_byte(const uint8_t *p) { return(*p); }
-#endif
+#include "OTAESGCM_OTAES128Tables.h"
 
 #include "OTAESGCM_OTAES128.h"
 #include "OTAESGCM_OTAES128AVR.h"
@@ -109,57 +103,10 @@ NOTE:   String length must be evenly divisible by 16byte (str_len % 16 == 0)
 
 
 
-// The lookup-tables are marked const so they can be placed in read-only storage instead of RAM
-// The numbers below can be computed dynamically trading ROM for RAM -
-// This can be useful in (embedded) bootloader applications, where ROM is often limited.
-// sbox
-static const uint8_t sbox[256] PROGMEM =   {
-  //0     1    2      3     4    5     6     7      8    9     A      B    C     D     E     F
-  0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
-  0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
-  0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
-  0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
-  0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
-  0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
-  0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
-  0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
-  0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
-  0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
-  0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
-  0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
-  0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
-  0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
-  0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
-  0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16 };
-
-//#ifndef NO_DECRYPT
-// reverse sbox
-static const uint8_t rsbox[256] PROGMEM =
-{ 0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
-  0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87, 0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb,
-  0x54, 0x7b, 0x94, 0x32, 0xa6, 0xc2, 0x23, 0x3d, 0xee, 0x4c, 0x95, 0x0b, 0x42, 0xfa, 0xc3, 0x4e,
-  0x08, 0x2e, 0xa1, 0x66, 0x28, 0xd9, 0x24, 0xb2, 0x76, 0x5b, 0xa2, 0x49, 0x6d, 0x8b, 0xd1, 0x25,
-  0x72, 0xf8, 0xf6, 0x64, 0x86, 0x68, 0x98, 0x16, 0xd4, 0xa4, 0x5c, 0xcc, 0x5d, 0x65, 0xb6, 0x92,
-  0x6c, 0x70, 0x48, 0x50, 0xfd, 0xed, 0xb9, 0xda, 0x5e, 0x15, 0x46, 0x57, 0xa7, 0x8d, 0x9d, 0x84,
-  0x90, 0xd8, 0xab, 0x00, 0x8c, 0xbc, 0xd3, 0x0a, 0xf7, 0xe4, 0x58, 0x05, 0xb8, 0xb3, 0x45, 0x06,
-  0xd0, 0x2c, 0x1e, 0x8f, 0xca, 0x3f, 0x0f, 0x02, 0xc1, 0xaf, 0xbd, 0x03, 0x01, 0x13, 0x8a, 0x6b,
-  0x3a, 0x91, 0x11, 0x41, 0x4f, 0x67, 0xdc, 0xea, 0x97, 0xf2, 0xcf, 0xce, 0xf0, 0xb4, 0xe6, 0x73,
-  0x96, 0xac, 0x74, 0x22, 0xe7, 0xad, 0x35, 0x85, 0xe2, 0xf9, 0x37, 0xe8, 0x1c, 0x75, 0xdf, 0x6e,
-  0x47, 0xf1, 0x1a, 0x71, 0x1d, 0x29, 0xc5, 0x89, 0x6f, 0xb7, 0x62, 0x0e, 0xaa, 0x18, 0xbe, 0x1b,
-  0xfc, 0x56, 0x3e, 0x4b, 0xc6, 0xd2, 0x79, 0x20, 0x9a, 0xdb, 0xc0, 0xfe, 0x78, 0xcd, 0x5a, 0xf4,
-  0x1f, 0xdd, 0xa8, 0x33, 0x88, 0x07, 0xc7, 0x31, 0xb1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xec, 0x5f,
-  0x60, 0x51, 0x7f, 0xa9, 0x19, 0xb5, 0x4a, 0x0d, 0x2d, 0xe5, 0x7a, 0x9f, 0x93, 0xc9, 0x9c, 0xef,
-  0xa0, 0xe0, 0x3b, 0x4d, 0xae, 0x2a, 0xf5, 0xb0, 0xc8, 0xeb, 0xbb, 0x3c, 0x83, 0x53, 0x99, 0x61,
-  0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d };
-//#endif // NO_DECRYPT
-
-/**
- * @brief    use reduced Rcon table for AES
- */
+// The sbox, reverse sbox and Rcon tables are shared with the other implementations (OTAESGCM_OTAES128Tables.h).
 // The round constant word array, Rcon[i], contains the values given by
-// x to th e power (i-1) being powers of x (x is denoted as {02}) in the field GF(2^8)
-// Note that i starts at 1, not 0).
-static const uint8_t Rcon[11] PROGMEM = { 0x8d, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36 };
+// x to the power (i-1) being powers of x (x is denoted as {02}) in the field GF(2^8);
+// i starts at 1, so is at index i-1 in the shared table.
 
 
 /*****************************************************************************/
@@ -173,7 +120,7 @@ static const uint8_t Rcon[11] PROGMEM = { 0x8d, 0x01, 0x02, 0x04, 0x08, 0x10, 0x
  */
 static uint8_t getSBoxValue(uint8_t num)
 {
-  return pgm_read_byte(&sbox[num]);
+  return pgm_read_byte(&aes128SBox[num]);
 }
 
 /**
@@ -226,7 +173,7 @@ void OTAES128E_AVR::KeyExpansion(void)
         tempa[3] = getSBoxValue(tempa[3]);
       }
 
-      tempa[0] =  tempa[0] ^ pgm_read_byte(&Rcon[i/Nk]);
+      tempa[0] =  tempa[0] ^ pgm_read_byte(&aes128Rcon[i/Nk - 1]);
     }
 
 #ifndef AES_128_ONLY
@@ -404,7 +351,7 @@ void OTAES128E_AVR::Cipher(void)
  */
 static uint8_t getSBoxInvert(uint8_t num)
 {
-  return pgm_read_byte(&rsbox[num]);
+  return pgm_read_byte(&aes128InvSBox[num]);
 }
 
 
@@ -527,19 +474,37 @@ void OTAES128E_AVR::blockEncrypt(const uint8_t* input, const uint8_t* key, uint8
   // TODO: find a way of signalling the problem.
   if(NULL == RoundKey) { return; }
 
-  // Copy input to output, and work in-memory on output.
+  // Copy input to output (unless they are the same block), and work in-memory on output.
   //BlockCopy(output, input);
-  memcpy(output, input, AES_BLOCK_SIZE);
+  if(output != input) { memcpy(output, input, AES_BLOCK_SIZE); }
   state = (state_t*)output;
 
-  Key = key;
-  KeyExpansion();
+  // Skip the expansion if the schedule for this key is being retained or cached.
+  if(!hasScheduleFor(key)) { Key = key; KeyExpansion(); }
 
   // Encrypt the plaintext with the Key using the AES algorithm.
   Cipher();
 
-  // Clean up private state.
-  cleanup();
+  // Clean up private state unless retaining or caching it.
+  if(!retained && !caching) { cleanup(); }
+}
+
+/**
+ *    @brief    Expand and retain the key schedule between calls
+ *    @param    key takes a pointer to a 128bit secret key
+ *
+ * The schedule is kept until clearKeySchedule().
+ * While caching, the expansion is skipped if the key bytes are unchanged.
+ */
+void OTAES128E_AVR::retainKeySchedule(const uint8_t *key)
+{
+  // Abort if no workspace to avoid crashing..
+  if(NULL == RoundKey) { return; }
+
+  const bool cached = caching && (NULL != Key) && sameKey(key, RoundKey);
+  Key = key;
+  if(!cached) { KeyExpansion(); }
+  retained = true;
 }
 
 
@@ -557,19 +522,19 @@ void OTAES128DE_AVR::blockDecrypt(const uint8_t* input, const uint8_t* key, uint
   // TODO: find a way of signalling the problem.
   if(NULL == RoundKey) { return; }
 
-  // Copy input to output, and work in-memory on output.
+  // Copy input to output (unless they are the same block), and work in-memory on output.
   //BlockCopy(output, input);
-  memcpy(output, input, AES_BLOCK_SIZE);
+  if(output != input) { memcpy(output, input, AES_BLOCK_SIZE); }
   state = (state_t*)output;
 
-  // The KeyExpansion routine must be called before encryption.
-  Key = key;
-  KeyExpansion();
+  // The KeyExpansion routine must be called before encryption,
+  // unless the schedule for this key is being retained or cached.
+  if(!hasScheduleFor(key)) { Key = key; KeyExpansion(); }
 
   InvCipher();
 
-  // Clean up private state.
-  cleanup();
+  // Clean up private state unless retaining or caching it.
+  if(!retained && !caching) { cleanup(); }
 }
 
 
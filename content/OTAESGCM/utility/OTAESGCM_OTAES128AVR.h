@@ -35,7 +35,9 @@ namespace OTAESGCM
 
     // AVR (8-bit MCU optimised) encrypt-only implementation.
     // Neither re-entrant nor ISR-safe except where stated.
-    // Carries workspace but logically no state is carried from one operation to the next.
+    // Carries workspace but logically no state is carried from one operation to the next,
+    // other than a key schedule explicitly retained with retainKeySchedule()
+    // or cached with cacheKeySchedule().
     // Residual state should be regarded as sensitive, and eg overwritten before being released to heap.
     class OTAES128E_AVR : public OTAES128E
         {
@@ -54,6 +56,15 @@ namespace OTAESGCM
             // Should be cleared before releasing space to (say) heap.
             //uint8_t RoundKey[RoundKeySize];
             uint8_t * const RoundKey;
+            // True while the schedule for Key is retained between calls.
+            bool retained = false;
+            // True while the last schedule expanded is cached between calls.
+            bool caching = false;
+
+            // True if RoundKey holds the schedule for key: the same pointer while retained,
+            // or the same bytes while caching (the first round key being the key itself).
+            bool hasScheduleFor(const uint8_t *key) const
+                { return((retained && (key == Key)) || (caching && (NULL != Key) && sameKey(key, RoundKey))); }
 
             void KeyExpansion();
             void AddRoundKey(uint8_t round);
@@ -87,15 +98,31 @@ namespace OTAESGCM
              *    @param    key takes a pointer to a 128-bit (16-byte) secret key; never NULL
              *    @param    output takes a pointer to an array to fill with ciphertext, of size 16 bytes; never NULL
              *
-             * Cleans up internal sensitive state when done.
+             * Cleans up internal sensitive state when done
+             * unless the key schedule is being retained or cached.
              */
             virtual void blockEncrypt(const uint8_t* input, const uint8_t* key, uint8_t *output);
 
+            // Expand the key into RoundKey and keep it until clearKeySchedule(),
+            // skipping the expansion if already cached.
+            // Does nothing if there is insufficient workspace.
+            virtual void retainKeySchedule(const uint8_t *key) override;
+
+            // Stop retaining the key schedule and wipe it unless caching.
+            virtual void clearKeySchedule() override { retained = false; if(!caching) { cleanup(); } }
+
+            // Keep the last schedule expanded until wipeKeySchedule().
+            virtual void cacheKeySchedule() override { caching = true; }
+
+            // Stop caching and retaining, and wipe the schedule.
+            virtual void wipeKeySchedule() override { retained = false; caching = false; cleanup(); }
         };
 
     // AVR decrypt and encrypt implementation.
     // Neither re-entrant nor ISR-safe except where stated.
-    // Carries workspace but logically no state is carried from one operation to the next.
+    // Carries workspace but logically no state is carried from one operation to the next,
+    // other than a key schedule explicitly retained with retainKeySchedule()
+    // or cached with cacheKeySchedule().
     // Residual state should be regarded as sensitive, and eg overwritten before being released to heap.
     class OTAES128DE_AVR final : public OTAES128D, public OTAES128E_AVR
         {
@@ -121,7 +148,8 @@ namespace OTAESGCM
              *    @param    key takes a pointer to a 128-bit (16-byte) secret key; never NULL
              *    @param    output takes a pointer to an array to fill with plaintext, of size 16 bytes; never NULL
              *
-             * Cleans up internal sensitive state when done.
+             * Cleans up internal sensitive state when done
+             * unless the key schedule is being retained or cached.
              */
             virtual void blockDecrypt(const uint8_t* input, const uint8_t* key, uint8_t *output);
         };
@@ -0,0 +1,463 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* Constant-time 64-bit bitsliced AES(128) implementation for hosted (non-AVR) builds. */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "OTAESGCM_Block.h"
+#include "OTAESGCM_OTAES128BitSliced.h"
+#include "OTAESGCM_OTAES128Tables.h"
+
+#if defined(OTAESGCM_HAS_BITSLICED_IMPL)
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+// The number of rounds in AES Cipher.
+static constexpr uint8_t Nr = 10;
+
+// Load/store little-endian words from/to possibly unaligned byte arrays.
+static inline uint32_t loadLE(const uint8_t *p)
+    { return((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24)); }
+static inline void storeLE(uint8_t *p, const uint32_t w)
+    { p[0] = (uint8_t)w; p[1] = (uint8_t)(w >> 8); p[2] = (uint8_t)(w >> 16); p[3] = (uint8_t)(w >> 24); }
+
+/**
+ * @brief   applies the S-box to every byte of the bitsliced state
+ * @param   q   8 words, q[i] holding bit i of every byte
+ *
+ * The Boyar-Peralta circuit: a linear layer, 32 ANDs over GF(2^4),
+ * and a linear layer back, 113 gates in all.
+ */
+static void sbox(uint64_t *const q)
+{
+    const uint64_t x0 = q[7], x1 = q[6], x2 = q[5], x3 = q[4];
+    const uint64_t x4 = q[3], x5 = q[2], x6 = q[1], x7 = q[0];
+
+    // Top linear transformation.
+    const uint64_t y14 = x3 ^ x5;
+    const uint64_t y13 = x0 ^ x6;
+    const uint64_t y9 = x0 ^ x3;
+    const uint64_t y8 = x0 ^ x5;
+    const uint64_t t0 = x1 ^ x2;
+    const uint64_t y1 = t0 ^ x7;
+    const uint64_t y4 = y1 ^ x3;
+    const uint64_t y12 = y13 ^ y14;
+    const uint64_t y2 = y1 ^ x0;
+    const uint64_t y5 = y1 ^ x6;
+    const uint64_t y3 = y5 ^ y8;
+    const uint64_t t1 = x4 ^ y12;
+    const uint64_t y15 = t1 ^ x5;
+    const uint64_t y20 = t1 ^ x1;
+    const uint64_t y6 = y15 ^ x7;
+    const uint64_t y10 = y15 ^ t0;
+    const uint64_t y11 = y20 ^ y9;
+    const uint64_t y7 = x7 ^ y11;
+    const uint64_t y17 = y10 ^ y11;
+    const uint64_t y19 = y10 ^ y8;
+    const uint64_t y16 = t0 ^ y11;
+    const uint64_t y21 = y13 ^ y16;
+    const uint64_t y18 = x0 ^ y16;
+
+    // Non-linear section.
+    const uint64_t t2 = y12 & y15;
+    const uint64_t t3 = y3 & y6;
+    const uint64_t t4 = t3 ^ t2;
+    const uint64_t t5 = y4 & x7;
+    const uint64_t t6 = t5 ^ t2;
+    const uint64_t t7 = y13 & y16;
+    const uint64_t t8 = y5 & y1;
+    const uint64_t t9 = t8 ^ t7;
+    const uint64_t t10 = y2 & y7;
+    const uint64_t t11 = t10 ^ t7;
+    const uint64_t t12 = y9 & y11;
+    const uint64_t t13 = y14 & y17;
+    const uint64_t t14 = t13 ^ t12;
+    const uint64_t t15 = y8 & y10;
+    const uint64_t t16 = t15 ^ t12;
+    const uint64_t t17 = t4 ^ t14;
+    const uint64_t t18 = t6 ^ t16;
+    const uint64_t t19 = t9 ^ t14;
+    const uint64_t t20 = t11 ^ t16;
+    const uint64_t t21 = t17 ^ y20;
+    const uint64_t t22 = t18 ^ y19;
+    const uint64_t t23 = t19 ^ y21;
+    const uint64_t t24 = t20 ^ y18;
+
+    const uint64_t t25 = t21 ^ t22;
+    const uint64_t t26 = t21 & t23;
+    const uint64_t t27 = t24 ^ t26;
+    const uint64_t t28 = t25 & t27;
+    const uint64_t t29 = t28 ^ t22;
+    const uint64_t t30 = t23 ^ t24;
+    const uint64_t t31 = t22 ^ t26;
+    const uint64_t t32 = t31 & t30;
+    const uint64_t t33 = t32 ^ t24;
+    const uint64_t t34 = t23 ^ t33;
+    const uint64_t t35 = t27 ^ t33;
+    const uint64_t t36 = t24 & t35;
+    const uint64_t t37 = t36 ^ t34;
+    const uint64_t t38 = t27 ^ t36;
+    const uint64_t t39 = t29 & t38;
+    const uint64_t t40 = t25 ^ t39;
+
+    const uint64_t t41 = t40 ^ t37;
+    const uint64_t t42 = t29 ^ t33;
+    const uint64_t t43 = t29 ^ t40;
+    const uint64_t t44 = t33 ^ t37;
+    const uint64_t t45 = t42 ^ t41;
+    const uint64_t z0 = t44 & y15;
+    const uint64_t z1 = t37 & y6;
+    const uint64_t z2 = t33 & x7;
+    const uint64_t z3 = t43 & y16;
+    const uint64_t z4 = t40 & y1;
+    const uint64_t z5 = t29 & y7;
+    const uint64_t z6 = t42 & y11;
+    const uint64_t z7 = t45 & y17;
+    const uint64_t z8 = t41 & y10;
+    const uint64_t z9 = t44 & y12;
+    const uint64_t z10 = t37 & y3;
+    const uint64_t z11 = t33 & y4;
+    const uint64_t z12 = t43 & y13;
+    const uint64_t z13 = t40 & y5;
+    const uint64_t z14 = t29 & y2;
+    const uint64_t z15 = t42 & y9;
+    const uint64_t z16 = t45 & y14;
+    const uint64_t z17 = t41 & y8;
+
+    // Bottom linear transformation.
+    const uint64_t t46 = z15 ^ z16;
+    const uint64_t t47 = z10 ^ z11;
+    const uint64_t t48 = z5 ^ z13;
+    const uint64_t t49 = z9 ^ z10;
+    const uint64_t t50 = z2 ^ z12;
+    const uint64_t t51 = z2 ^ z5;
+    const uint64_t t52 = z7 ^ z8;
+    const uint64_t t53 = z0 ^ z3;
+    const uint64_t t54 = z6 ^ z7;
+    const uint64_t t55 = z16 ^ z17;
+    const uint64_t t56 = z12 ^ t48;
+    const uint64_t t57 = t50 ^ t53;
+    const uint64_t t58 = z4 ^ t46;
+    const uint64_t t59 = z3 ^ t54;
+    const uint64_t t60 = t46 ^ t57;
+    const uint64_t t61 = z14 ^ t57;
+    const uint64_t t62 = t52 ^ t58;
+    const uint64_t t63 = t49 ^ t58;
+    const uint64_t t64 = z4 ^ t59;
+    const uint64_t t65 = t61 ^ t62;
+    const uint64_t t66 = z1 ^ t63;
+    const uint64_t s0 = t59 ^ t63;
+    const uint64_t s6 = t56 ^ ~t62;
+    const uint64_t s7 = t48 ^ ~t60;
+    const uint64_t t67 = t64 ^ t65;
+    const uint64_t s3 = t53 ^ t66;
+    const uint64_t s4 = t51 ^ t66;
+    const uint64_t s5 = t47 ^ t65;
+    const uint64_t s1 = t64 ^ ~s3;
+    const uint64_t s2 = t55 ^ ~t67;
+
+    q[7] = s0; q[6] = s1; q[5] = s2; q[4] = s3;
+    q[3] = s4; q[2] = s5; q[1] = s6; q[0] = s7;
+}
+
+// Swap the bits selected by cl in y with those selected by ch in x, s places apart.
+static inline void swapBits(uint64_t &x, uint64_t &y, const uint64_t cl, const uint64_t ch, const uint8_t s)
+{
+    const uint64_t a = x, b = y;
+    x = (a & cl) | ((b & cl) << s);
+    y = ((a & ch) >> s) | (b & ch);
+}
+
+/**
+ * @brief   converts between interleaved and bitsliced form; its own inverse
+ * @param   q   8 words of state
+ */
+static void ortho(uint64_t *const q)
+{
+    for(uint8_t i = 0; i < 8; i += 2) { swapBits(q[i], q[i + 1], 0x5555555555555555ULL, 0xAAAAAAAAAAAAAAAAULL, 1); }
+    for(uint8_t i = 0; i < 8; i += 4)
+        {
+        swapBits(q[i], q[i + 2], 0x3333333333333333ULL, 0xCCCCCCCCCCCCCCCCULL, 2);
+        swapBits(q[i + 1], q[i + 3], 0x3333333333333333ULL, 0xCCCCCCCCCCCCCCCCULL, 2);
+        }
+    for(uint8_t i = 0; i < 4; ++i) { swapBits(q[i], q[i + 4], 0x0F0F0F0F0F0F0F0FULL, 0xF0F0F0F0F0F0F0F0ULL, 4); }
+}
+
+// Spread a block's 4 little-endian words across 2 state words, a byte in every 2.
+static void interleaveIn(uint64_t &q0, uint64_t &q1, const uint32_t *const w)
+{
+    uint64_t x[4];
+    for(uint8_t i = 0; i < 4; ++i)
+        {
+        x[i] = w[i];
+        x[i] |= (x[i] << 16);
+        x[i] &= 0x0000FFFF0000FFFFULL;
+        x[i] |= (x[i] << 8);
+        x[i] &= 0x00FF00FF00FF00FFULL;
+        }
+    q0 = x[0] | (x[2] << 8);
+    q1 = x[1] | (x[3] << 8);
+}
+
+// Inverse of interleaveIn().
+static void interleaveOut(uint32_t *const w, const uint64_t q0, const uint64_t q1)
+{
+    uint64_t x[4] = { q0 & 0x00FF00FF00FF00FFULL, q1 & 0x00FF00FF00FF00FFULL,
+                      (q0 >> 8) & 0x00FF00FF00FF00FFULL, (q1 >> 8) & 0x00FF00FF00FF00FFULL };
+    for(uint8_t i = 0; i < 4; ++i)
+        {
+        x[i] |= (x[i] >> 8);
+        x[i] &= 0x0000FFFF0000FFFFULL;
+        w[i] = (uint32_t)x[i] | (uint32_t)(x[i] >> 16);
+        }
+}
+
+// S-box of each byte of a word, for the key schedule.
+static uint32_t subWord(const uint32_t x)
+{
+    uint64_t q[8] = { x };
+    ortho(q);
+    sbox(q);
+    ortho(q);
+    return((uint32_t)q[0]);
+}
+
+// Bitsliced ShiftRows, rows being held in 16-bit lanes of each word.
+static inline void shiftRows(uint64_t *const q)
+{
+    for(uint8_t i = 0; i < 8; ++i)
+        {
+        const uint64_t x = q[i];
+        q[i] = (x & 0x000000000000FFFFULL)
+             | ((x & 0x00000000FFF00000ULL) >> 4)
+             | ((x & 0x00000000000F0000ULL) << 12)
+             | ((x & 0x0000FF0000000000ULL) >> 8)
+             | ((x & 0x000000FF00000000ULL) << 8)
+             | ((x & 0xF000000000000000ULL) >> 12)
+             | ((x & 0x0FFF000000000000ULL) << 4);
+        }
+}
+
+static inline uint64_t rotr16(const uint64_t x) { return((x >> 16) | (x << 48)); }
+static inline uint64_t rotr32(const uint64_t x) { return((x << 32) | (x >> 32)); }
+
+// Bitsliced MixColumns.
+static inline void mixColumns(uint64_t *const q)
+{
+    const uint64_t q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3], q4 = q[4], q5 = q[5], q6 = q[6], q7 = q[7];
+    const uint64_t r0 = rotr16(q0), r1 = rotr16(q1), r2 = rotr16(q2), r3 = rotr16(q3);
+    const uint64_t r4 = rotr16(q4), r5 = rotr16(q5), r6 = rotr16(q6), r7 = rotr16(q7);
+    q[0] = q7 ^ r7 ^ r0 ^ rotr32(q0 ^ r0);
+    q[1] = q0 ^ r0 ^ q7 ^ r7 ^ r1 ^ rotr32(q1 ^ r1);
+    q[2] = q1 ^ r1 ^ r2 ^ rotr32(q2 ^ r2);
+    q[3] = q2 ^ r2 ^ q7 ^ r7 ^ r3 ^ rotr32(q3 ^ r3);
+    q[4] = q3 ^ r3 ^ q7 ^ r7 ^ r4 ^ rotr32(q4 ^ r4);
+    q[5] = q4 ^ r4 ^ r5 ^ rotr32(q5 ^ r5);
+    q[6] = q5 ^ r5 ^ r6 ^ rotr32(q6 ^ r6);
+    q[7] = q6 ^ r6 ^ r7 ^ rotr32(q7 ^ r7);
+}
+
+// Expand round key r from its 2 compressed words and add it to the state.
+static inline void addRoundKey(uint64_t *const q, const uint8_t *const roundKey, const uint8_t r)
+{
+    uint64_t c[2];
+    memcpy(c, roundKey + AES128GCM_BLOCK_SIZE * r, sizeof(c));
+    for(uint8_t h = 0; h < 2; ++h)
+        {
+        for(uint8_t b = 0; b < 4; ++b)
+            {
+            // Smear each selected bit across its 4-bit group.
+            const uint64_t x = (c[h] >> b) & 0x1111111111111111ULL;
+            q[4*h + b] ^= (x << 4) - x;
+            }
+        }
+}
+
+// Bitslices one round key (replicated as for 4 blocks) from 4 little-endian words
+// and stores it to out (16 bytes) as 2 words keeping one bit of each 4-bit group,
+// the rest being copies.
+static void compressRoundKey(uint8_t *const out, const uint32_t *const w)
+{
+    uint64_t q[8];
+    interleaveIn(q[0], q[4], w);
+    q[1] = q[2] = q[3] = q[0];
+    q[5] = q[6] = q[7] = q[4];
+    ortho(q);
+    const uint64_t c[2] = {
+        (q[0] & 0x1111111111111111ULL) | (q[1] & 0x2222222222222222ULL) |
+        (q[2] & 0x4444444444444444ULL) | (q[3] & 0x8888888888888888ULL),
+        (q[4] & 0x1111111111111111ULL) | (q[5] & 0x2222222222222222ULL) |
+        (q[6] & 0x4444444444444444ULL) | (q[7] & 0x8888888888888888ULL) };
+    memcpy(out, c, sizeof(c));
+}
+
+/**
+ * @brief    Fills RoundKey with the compressed bitsliced key expansion of Key
+ *
+ * Expands as per FIPS-197 on little-endian words,
+ * then bitslices and compresses each round key.
+ */
+void OTAES128E_BitSliced::KeyExpansion()
+{
+    uint32_t w[4 * (Nr + 1)];
+    for(uint8_t i = 0; i < 4; ++i) { w[i] = loadLE(Key + 4*i); }
+    for(uint8_t i = 4; i < 4 * (Nr + 1); ++i)
+        {
+        uint32_t t = w[i - 1];
+        if(0 == (i & 3)) { t = subWord((t << 24) | (t >> 8)) ^ aes128Rcon[(i >> 2) - 1]; }
+        w[i] = t ^ w[i - 4];
+        }
+    for(uint8_t r = 0; r <= Nr; ++r) { compressRoundKey(RoundKey + AES128GCM_BLOCK_SIZE * r, w + 4*r); }
+
+    // Erase temporary copy for security.
+    memset(w, 0, sizeof(w));
+}
+
+/**
+ * @brief    true if RoundKey holds the schedule for key
+ *
+ * While caching, compares the compressed first round key
+ * made from key with that in RoundKey, in constant time;
+ * the compression is a bit permutation, so equal only for equal keys.
+ */
+bool OTAES128E_BitSliced::hasScheduleFor(const uint8_t *const key) const
+{
+    if(retained && (key == Key)) { return(true); }
+    if(!caching || (NULL == Key)) { return(false); }
+    uint32_t w[4];
+    for(uint8_t i = 0; i < 4; ++i) { w[i] = loadLE(key + 4*i); }
+    uint8_t c[AES128GCM_BLOCK_SIZE];
+    compressRoundKey(c, w);
+    const bool same = sameKey(c, RoundKey);
+
+    // Erase temporary copies for security.
+    memset(w, 0, sizeof(w));
+    memset(c, 0, sizeof(c));
+    return(same);
+}
+
+/**
+ * @brief    encrypts 1 to ParallelBlocks blocks with the expanded key
+ *
+ * Unused slots are zero-filled and their results discarded.
+ */
+void OTAES128E_BitSliced::Cipher4(const uint8_t *const input, const uint8_t nBlocks, uint8_t *const output) const
+{
+    uint32_t w[4 * ParallelBlocks];
+    memset(w, 0, sizeof(w));
+    for(uint8_t i = 0; i < 4 * nBlocks; ++i) { w[i] = loadLE(input + 4*i); }
+
+    uint64_t q[8];
+    for(uint8_t i = 0; i < ParallelBlocks; ++i) { interleaveIn(q[i], q[i + 4], w + 4*i); }
+    ortho(q);
+    addRoundKey(q, RoundKey, 0);
+    for(uint8_t round = 1; round < Nr; ++round)
+        {
+        sbox(q);
+        shiftRows(q);
+        mixColumns(q);
+        addRoundKey(q, RoundKey, round);
+        }
+    // The last round has no MixColumns.
+    sbox(q);
+    shiftRows(q);
+    addRoundKey(q, RoundKey, Nr);
+    ortho(q);
+    for(uint8_t i = 0; i < ParallelBlocks; ++i) { interleaveOut(w + 4*i, q[i], q[i + 4]); }
+
+    for(uint8_t i = 0; i < 4 * nBlocks; ++i) { storeLE(output + 4*i, w[i]); }
+
+    // Erase temporary copies for security.
+    memset(w, 0, sizeof(w));
+    memset(q, 0, sizeof(q));
+}
+
+/**
+ *    @brief    AES128 block encryption
+ *    @param    input takes a pointer to an array containing plaintext
+ *    @param    key takes a pointer to a 128bit secret key
+ *    @param    output takes a pointer to an array to fill with ciphertext
+ *
+ * Input and output may be the same buffer.
+ * Cleans up internal sensitive state when done
+ * unless the key schedule is being retained or cached.
+ */
+void OTAES128E_BitSliced::blockEncrypt(const uint8_t *const input, const uint8_t *const key, uint8_t *const output)
+{
+    blocksEncrypt(input, 1, key, output);
+}
+
+/**
+ *    @brief    AES128 encryption of several independent blocks under one key
+ *    @param    input takes a pointer to nBlocks contiguous 16-byte blocks
+ *    @param    nBlocks number of blocks, can be zero
+ *    @param    key takes a pointer to a 128bit secret key
+ *    @param    output takes a pointer to an array to fill with ciphertext
+ *
+ * Input and output may be the same buffer.
+ * Cleans up internal sensitive state when done
+ * unless the key schedule is being retained or cached.
+ */
+void OTAES128E_BitSliced::blocksEncrypt(const uint8_t *input, size_t nBlocks, const uint8_t *const key, uint8_t *output)
+{
+    // Abort if no workspace to avoid crashing..
+    if(NULL == RoundKey) { return; }
+    if(0 == nBlocks) { return; }
+
+    // Skip the expansion if the schedule for this key is being retained or cached.
+    if(!hasScheduleFor(key)) { Key = key; KeyExpansion(); }
+
+    while(nBlocks > 0)
+        {
+        const uint8_t n = (nBlocks > ParallelBlocks) ? ParallelBlocks : (uint8_t)nBlocks;
+        Cipher4(input, n, output);
+        input += AES128GCM_BLOCK_SIZE * n;
+        output += AES128GCM_BLOCK_SIZE * n;
+        nBlocks -= n;
+        }
+
+    // Clean up private state unless retaining or caching it.
+    if(!retained && !caching) { cleanup(); }
+}
+
+/**
+ *    @brief    Expand and retain the key schedule between calls
+ *    @param    key takes a pointer to a 128bit secret key
+ *
+ * The schedule is kept until clearKeySchedule().
+ * While caching, the expansion is skipped if the key bytes are unchanged.
+ */
+void OTAES128E_BitSliced::retainKeySchedule(const uint8_t *const key)
+{
+    // Abort if no workspace to avoid crashing..
+    if(NULL == RoundKey) { return; }
+
+    const bool cached = caching && hasScheduleFor(key);
+    Key = key;
+    if(!cached) { KeyExpansion(); }
+    retained = true;
+}
+
+
+    }
+
+#endif // defined(OTAESGCM_HAS_BITSLICED_IMPL)
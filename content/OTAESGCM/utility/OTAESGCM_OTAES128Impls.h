@@ -28,31 +28,73 @@ Author(s) / Copyright (s): Deniz Erbilgin 2015--2017
 // Implementations.
 #if defined(__AVR_ARCH__) || defined(ARDUINO_ARCH_AVR) // Atmel AVR only.
 #include "OTAESGCM_OTAES128AVR.h"
+// On-the-fly key schedule implementation, for minimum RAM.
+#include "OTAESGCM_OTAES128OTF.h"
 // Fast, small and default implementations, enc and enc+dec, for this architecture.
 namespace OTAESGCM
     {
     typedef OTAES128E_AVR OTAES128E_fast_t;
-    typedef OTAES128E_AVR OTAES128E_small_t;
+    typedef OTAES128E_OTF OTAES128E_small_t;
     typedef OTAES128E_AVR OTAES128E_default_t;
     typedef OTAES128DE_AVR OTAES128DE_fast_t;
-    typedef OTAES128DE_AVR OTAES128DE_small_t;
+    typedef OTAES128DE_OTF OTAES128DE_small_t;
     typedef OTAES128DE_AVR OTAES128DE_default_t;
     }
+#include "OTAESGCM_OTAES128MultiKey.h"
+// Fast and default multi-key implementations for this architecture.
+namespace OTAESGCM
+    {
+    typedef OTAES128EMultiKey_Lanes<OTAES128E_AVR> OTAES128EMultiKey_fast_t;
+    typedef OTAES128EMultiKey_Lanes<OTAES128E_AVR> OTAES128EMultiKey_default_t;
+    }
 #else
 
 // Take this as a generic impl for MCUs.
 #include "OTAESGCM_OTAES128AVR.h"
+// On-the-fly key schedule implementation, for minimum RAM.
+#include "OTAESGCM_OTAES128OTF.h"
+// 32-bit T-table implementation for hosts.
+#include "OTAESGCM_OTAES128TTable.h"
+// Constant-time 64-bit bitsliced implementation for hosts.
+#include "OTAESGCM_OTAES128BitSliced.h"
+// SSSE3 constant-time PSHUFB table-scan implementation for x86 hosts, with runtime fallback.
+#include "OTAESGCM_OTAES128SSSE3.h"
+// AES-NI implementation for x86 hosts, with runtime fallback.
+#include "OTAESGCM_OTAES128AESNI.h"
 // Fast, small and default implementations, enc and enc+dec, for this architecture.
 namespace OTAESGCM
     {
-    typedef OTAES128E_AVR OTAES128E_fast_t;
-    typedef OTAES128E_AVR OTAES128E_small_t;
+#if defined(OTAESGCM_HAS_AESNI_IMPL)
+    typedef OTAES128DE_AESNI OTAES128E_fast_t;
+#else
+    typedef OTAES128E_TTable OTAES128E_fast_t;
+#endif
+    typedef OTAES128E_OTF OTAES128E_small_t;
     typedef OTAES128E_AVR OTAES128E_default_t;
+#if defined(OTAESGCM_HAS_AESNI_IMPL)
+    typedef OTAES128DE_AESNI OTAES128DE_fast_t;
+#else
     typedef OTAES128DE_AVR OTAES128DE_fast_t;
-    typedef OTAES128DE_AVR OTAES128DE_small_t;
+#endif
+    typedef OTAES128DE_OTF OTAES128DE_small_t;
     typedef OTAES128DE_AVR OTAES128DE_default_t;
     }
+// Multi-key API and generic implementation.
+#include "OTAESGCM_OTAES128MultiKey.h"
+// Fast and default multi-key implementations for this architecture.
+namespace OTAESGCM
+    {
+#if defined(OTAESGCM_HAS_AESNI_IMPL)
+    typedef OTAES128EMultiKey_AESNI OTAES128EMultiKey_fast_t;
+#else
+    typedef OTAES128EMultiKey_Lanes<OTAES128E_TTable> OTAES128EMultiKey_fast_t;
+#endif
+    typedef OTAES128EMultiKey_Lanes<OTAES128E_default_t> OTAES128EMultiKey_default_t;
+    }
 
+// Runtime registry of all the above (and the GHASH implementations),
+// to choose between them on the CPU actually found rather than at compile time.
+#include "OTAESGCM_BackendRegistry.h"
 
 #endif
 
@@ -0,0 +1,159 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* Multi-key (multi-lane) AES128 encryption API and generic implementation. */
+
+#ifndef ARDUINO_LIB_OTAESGCM_OTAES128MULTIKEY_H
+#define ARDUINO_LIB_OTAESGCM_OTAES128MULTIKEY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "OTAESGCM_OTAES128.h"
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+
+    // Base class / interface for AES128 block encryption of one block under
+    // each of several independent keys at once, eg for a gateway handling
+    // frames from many nodes each with its own key.
+    // Each lane has its own key schedule, retained from setLaneKey() until clearLaneKeys().
+    // Implementations may process the lanes in parallel, eg interleaved on AES-NI.
+    // Neither re-entrant nor ISR-safe except where stated.
+    class OTAES128EMultiKey
+        {
+        protected:
+            // Only derived classes can construct an instance.
+            constexpr OTAES128EMultiKey() { }
+
+        public:
+            // Number of lanes, ie of independent keys.
+            // Lane masks are one bit per lane, lane 0 in the least significant bit.
+            static constexpr uint8_t MaxLanes = 8;
+
+            /**
+             *    @brief    Expand and retain the key schedule for one lane
+             *    @param    lane in the range [0,MaxLanes)
+             *    @param    key takes a pointer to a 128-bit (16-byte) secret key; never NULL;
+             *              need not outlive this call
+             */
+            virtual void setLaneKey(uint8_t lane, const uint8_t *key) = 0;
+
+            /**
+             *    @brief    AES128 encryption of block i under the key of lane i
+             *    @param    input takes a pointer to MaxLanes contiguous 16-byte blocks; never NULL
+             *    @param    laneMask lanes to encrypt, each with a key set
+             *    @param    output takes a pointer to MaxLanes contiguous 16-byte blocks;
+             *              may be the same as input; never NULL
+             *
+             * Output blocks for lanes not in laneMask are unspecified.
+             */
+            virtual void lanesEncrypt(const uint8_t *input, uint8_t laneMask, uint8_t *output) = 0;
+
+            // Wipe all lane key schedules; safe to call when none are set.
+            virtual void clearLaneKeys() = 0;
+
+#if 0 // Defining the virtual destructor uses ~800+ bytes of Flash by forcing use of malloc()/free().
+            // Ensure safe instance destruction when derived from.
+            virtual ~OTAES128EMultiKey() { }
+#else
+#define OTAES128EMultiKey_NO_VIRT_DEST // Beware, no virtual destructor so be careful of use via base pointers.
+#endif
+        };
+
+    // Generic multi-key implementation: one instance of any single-key
+    // OTAES128E implementation per lane, each retaining its own schedule,
+    // with the lanes processed in turn.
+    // Workspace is laid out as the per-lane AES workspaces,
+    // then the lanes' private copies of their keys.
+    // Residual state should be regarded as sensitive, and eg overwritten before being released to heap.
+    template<class OTAESImpl>
+    class OTAES128EMultiKey_Lanes : public OTAES128EMultiKey
+        {
+        public:
+            // Workspace used by each lane's AES implementation.
+            static constexpr uint8_t laneWorkspaceRequired = OTAESImpl::workspaceRequired;
+            // Minimum workspace required, unaligned; strictly positive.
+            static constexpr size_t workspaceRequired = MaxLanes * (laneWorkspaceRequired + 16);
+            // Verify that the workspace is adequate.
+            static constexpr bool isWorkspaceSufficient(uint8_t *const workspace, const size_t workspaceLen)
+                { return((NULL != workspace) && (workspaceLen >= workspaceRequired)); }
+
+        private:
+            // Lanes' private copies of their keys, as each AES implementation
+            // refers to the key it retains the schedule for;
+            // NULL if insufficient workspace is passed in.
+            uint8_t * const Keys;
+            // Lanes with keys set.
+            uint8_t keyed = 0;
+            // One AES implementation per lane.
+            static_assert(8 == MaxLanes, "lanes initialiser below must match MaxLanes");
+            OTAESImpl lanes[MaxLanes];
+
+            // Workspace for lane i, or NULL/0 if insufficient workspace is passed in.
+            static constexpr uint8_t *laneWS(uint8_t *const workspace, const size_t workspaceLen, const uint8_t i)
+                { return(isWorkspaceSufficient(workspace, workspaceLen) ? workspace + i * laneWorkspaceRequired : NULL); }
+            static constexpr uint8_t laneLen(uint8_t *const workspace, const size_t workspaceLen)
+                { return(isWorkspaceSufficient(workspace, workspaceLen) ? laneWorkspaceRequired : 0); }
+
+        public:
+            // Construct an instance: supplied workspace must be large enough.
+            OTAES128EMultiKey_Lanes(uint8_t *const workspace, const size_t workspaceLen)
+              : Keys(isWorkspaceSufficient(workspace, workspaceLen) ? workspace + MaxLanes * laneWorkspaceRequired : NULL),
+                lanes{ { laneWS(workspace, workspaceLen, 0), laneLen(workspace, workspaceLen) },
+                       { laneWS(workspace, workspaceLen, 1), laneLen(workspace, workspaceLen) },
+                       { laneWS(workspace, workspaceLen, 2), laneLen(workspace, workspaceLen) },
+                       { laneWS(workspace, workspaceLen, 3), laneLen(workspace, workspaceLen) },
+                       { laneWS(workspace, workspaceLen, 4), laneLen(workspace, workspaceLen) },
+                       { laneWS(workspace, workspaceLen, 5), laneLen(workspace, workspaceLen) },
+                       { laneWS(workspace, workspaceLen, 6), laneLen(workspace, workspaceLen) },
+                       { laneWS(workspace, workspaceLen, 7), laneLen(workspace, workspaceLen) } }
+                { }
+
+            virtual void setLaneKey(const uint8_t lane, const uint8_t *const key) override
+                {
+                if((NULL == Keys) || (lane >= MaxLanes)) { return; }
+                uint8_t *const k = Keys + 16 * lane;
+                memcpy(k, key, 16);
+                lanes[lane].retainKeySchedule(k);
+                keyed |= (uint8_t)(1U << lane);
+                }
+            virtual void lanesEncrypt(const uint8_t *const input, uint8_t laneMask, uint8_t *const output) override
+                {
+                laneMask &= keyed;
+                for(uint8_t i = 0; i < MaxLanes; ++i)
+                    {
+                    if(0 == (laneMask & (1U << i))) { continue; }
+                    lanes[i].blockEncrypt(input + 16 * i, Keys + 16 * i, output + 16 * i);
+                    }
+                }
+            virtual void clearLaneKeys() override
+                {
+                if(NULL == Keys) { return; }
+                for(uint8_t i = 0; i < MaxLanes; ++i) { lanes[i].clearKeySchedule(); }
+                memset(Keys, 0, 16 * MaxLanes);
+                keyed = 0;
+                }
+        };
+
+
+    }
+
+#endif
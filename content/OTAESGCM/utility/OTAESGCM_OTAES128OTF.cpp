@@ -0,0 +1,241 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* AES(128) implementation with an on-the-fly key schedule, for minimum RAM. */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "OTAESGCM_OTAES128Tables.h"
+
+#include "OTAESGCM_OTAES128OTF.h"
+
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+// The number of rounds in AES Cipher.
+static constexpr uint8_t Nr = 10;
+// The first and last round constants for the key schedule.
+static constexpr uint8_t RconFirst = 0x01;
+static constexpr uint8_t RconLast = 0x36;
+
+// S-box lookups from the shared tables.
+static inline uint8_t getSBoxValue(const uint8_t num) { return(pgm_read_byte(&aes128SBox[num])); }
+static inline uint8_t getSBoxInvert(const uint8_t num) { return(pgm_read_byte(&aes128InvSBox[num])); }
+
+// Multiply by x in GF(2^8), without branches.
+static inline uint8_t xtime(const uint8_t x)
+{
+    return(uint8_t((x << 1) ^ ((uint8_t)(-(x >> 7)) & 0x1b)));
+}
+
+// Step the running round key rk forward from round i-1 to round i,
+// where rcon is the round constant for round i.
+static void nextRoundKey(uint8_t *const rk, const uint8_t rcon)
+{
+    // SubWord(RotWord(w[3])) ^ Rcon into w[0], then each word into the next.
+    rk[0] ^= getSBoxValue(rk[13]) ^ rcon;
+    rk[1] ^= getSBoxValue(rk[14]);
+    rk[2] ^= getSBoxValue(rk[15]);
+    rk[3] ^= getSBoxValue(rk[12]);
+    for(uint8_t i = 4; i < 16; ++i) { rk[i] ^= rk[i - 4]; }
+}
+
+// Step the running round key rk back from round i to round i-1,
+// where rcon is the round constant for round i; the inverse of nextRoundKey().
+static void prevRoundKey(uint8_t *const rk, const uint8_t rcon)
+{
+    for(uint8_t i = 16; --i >= 4; ) { rk[i] ^= rk[i - 4]; }
+    rk[0] ^= getSBoxValue(rk[13]) ^ rcon;
+    rk[1] ^= getSBoxValue(rk[14]);
+    rk[2] ^= getSBoxValue(rk[15]);
+    rk[3] ^= getSBoxValue(rk[12]);
+}
+
+// XOR the round key into the state.
+static inline void addRoundKey(uint8_t *const state, const uint8_t *const rk)
+{
+    for(uint8_t i = 0; i < 16; ++i) { state[i] ^= rk[i]; }
+}
+
+// SubBytes() and ShiftRows() together, on the column-major state.
+static void subBytesShiftRows(uint8_t *const s)
+{
+    uint8_t t;
+    // Row 0 is not shifted.
+    s[0] = getSBoxValue(s[0]); s[4] = getSBoxValue(s[4]); s[8] = getSBoxValue(s[8]); s[12] = getSBoxValue(s[12]);
+    // Row 1 rotates left by 1.
+    t = s[1]; s[1] = getSBoxValue(s[5]); s[5] = getSBoxValue(s[9]); s[9] = getSBoxValue(s[13]); s[13] = getSBoxValue(t);
+    // Row 2 rotates left by 2.
+    t = s[2]; s[2] = getSBoxValue(s[10]); s[10] = getSBoxValue(t);
+    t = s[6]; s[6] = getSBoxValue(s[14]); s[14] = getSBoxValue(t);
+    // Row 3 rotates left by 3, ie right by 1.
+    t = s[15]; s[15] = getSBoxValue(s[11]); s[11] = getSBoxValue(s[7]); s[7] = getSBoxValue(s[3]); s[3] = getSBoxValue(t);
+}
+
+// InvShiftRows() and InvSubBytes() together, on the column-major state.
+static void invShiftRowsSubBytes(uint8_t *const s)
+{
+    uint8_t t;
+    s[0] = getSBoxInvert(s[0]); s[4] = getSBoxInvert(s[4]); s[8] = getSBoxInvert(s[8]); s[12] = getSBoxInvert(s[12]);
+    t = s[13]; s[13] = getSBoxInvert(s[9]); s[9] = getSBoxInvert(s[5]); s[5] = getSBoxInvert(s[1]); s[1] = getSBoxInvert(t);
+    t = s[2]; s[2] = getSBoxInvert(s[10]); s[10] = getSBoxInvert(t);
+    t = s[6]; s[6] = getSBoxInvert(s[14]); s[14] = getSBoxInvert(t);
+    t = s[3]; s[3] = getSBoxInvert(s[7]); s[7] = getSBoxInvert(s[11]); s[11] = getSBoxInvert(s[15]); s[15] = getSBoxInvert(t);
+}
+
+// MixColumns() on the column-major state.
+static void mixColumns(uint8_t *const s)
+{
+    for(uint8_t c = 0; c < 16; c += 4)
+        {
+        const uint8_t a0 = s[c], a1 = s[c+1], a2 = s[c+2], a3 = s[c+3];
+        const uint8_t all = a0 ^ a1 ^ a2 ^ a3;
+        s[c  ] ^= all ^ xtime(a0 ^ a1);
+        s[c+1] ^= all ^ xtime(a1 ^ a2);
+        s[c+2] ^= all ^ xtime(a2 ^ a3);
+        s[c+3] ^= all ^ xtime(a3 ^ a0);
+        }
+}
+
+// InvMixColumns() on the column-major state,
+// as a multiplication by {04}x^2+{05} followed by MixColumns().
+static void invMixColumns(uint8_t *const s)
+{
+    for(uint8_t c = 0; c < 16; c += 4)
+        {
+        const uint8_t u = xtime(xtime(s[c] ^ s[c+2]));
+        const uint8_t v = xtime(xtime(s[c+1] ^ s[c+3]));
+        s[c] ^= u; s[c+1] ^= v; s[c+2] ^= u; s[c+3] ^= v;
+        }
+    mixColumns(s);
+}
+
+/**
+ * @brief    encrypts one 128 bit block in place, with RoundKey starting as the key
+ */
+void OTAES128E_OTF::Cipher(uint8_t *const state)
+{
+    uint8_t rcon = RconFirst;
+    addRoundKey(state, RoundKey);
+    for(uint8_t round = 1; round <= Nr; ++round)
+        {
+        subBytesShiftRows(state);
+        // The last round has no MixColumns.
+        if(round != Nr) { mixColumns(state); }
+        nextRoundKey(RoundKey, rcon);
+        rcon = xtime(rcon);
+        addRoundKey(state, RoundKey);
+        }
+}
+
+/**
+ * @brief    decrypts one 128 bit block in place, with RoundKey starting as the last round key
+ */
+void OTAES128DE_OTF::InvCipher(uint8_t *const state)
+{
+    uint8_t rcon = RconLast;
+    addRoundKey(state, RoundKey);
+    for(uint8_t round = Nr; round > 0; --round)
+        {
+        invShiftRowsSubBytes(state);
+        prevRoundKey(RoundKey, rcon);
+        // Divide by x in GF(2^8): the round constant for the previous round.
+        rcon = uint8_t((rcon >> 1) ^ ((uint8_t)(-(rcon & 1)) & 0x8d));
+        addRoundKey(state, RoundKey);
+        // The first round has no MixColumns.
+        if(round != 1) { invMixColumns(state); }
+        }
+}
+
+/**
+ *    @brief    AES128 block encryption
+ *    @param    input takes a pointer to an array containing plaintext
+ *    @param    key takes a pointer to a 128bit secret key
+ *    @param    output takes a pointer to an array to fill with ciphertext
+ *
+ * Input and output may be the same buffer.
+ * Cleans up internal sensitive state when done.
+ */
+void OTAES128E_OTF::blockEncrypt(const uint8_t *const input, const uint8_t *const key, uint8_t *const output)
+{
+    // Abort if no workspace to avoid crashing..
+    if(NULL == RoundKey) { return; }
+
+    memmove(output, input, 16);
+    memcpy(RoundKey, key, RoundKeySize);
+    Cipher(output);
+
+    // Clean up private state.
+    memset(RoundKey, 0, RoundKeySize);
+}
+
+/**
+ *    @brief    Compute and retain the last round key between calls
+ *    @param    key takes a pointer to a 128bit secret key
+ *
+ * The last round key is kept until clearKeySchedule().
+ */
+void OTAES128DE_OTF::retainKeySchedule(const uint8_t *const key)
+{
+    // Abort if no workspace to avoid crashing..
+    if(NULL == RoundKey) { return; }
+
+    memcpy(LastRoundKey(), key, RoundKeySize);
+    uint8_t rcon = RconFirst;
+    for(uint8_t round = 1; round <= Nr; ++round, rcon = xtime(rcon)) { nextRoundKey(LastRoundKey(), rcon); }
+    Key = key;
+    retained = true;
+}
+
+/**
+ *    @brief    AES128 block decryption
+ *    @param    input takes a pointer to an array containing ciphertext
+ *    @param    key takes a pointer to a 128bit secret key
+ *    @param    output takes a pointer to an array to fill with plaintext
+ *
+ * Input and output may be the same buffer.
+ * Cleans up internal sensitive state when done
+ * unless the last round key is being retained.
+ */
+void OTAES128DE_OTF::blockDecrypt(const uint8_t *const input, const uint8_t *const key, uint8_t *const output)
+{
+    // Abort if no workspace to avoid crashing..
+    if(NULL == RoundKey) { return; }
+
+    // Find the last round key unless it is being retained for this key.
+    if(!retained || (key != Key))
+        {
+        const bool wasRetained = retained;
+        retainKeySchedule(key);
+        retained = wasRetained;
+        }
+
+    memmove(output, input, 16);
+    memcpy(RoundKey, LastRoundKey(), RoundKeySize);
+    InvCipher(output);
+
+    // Clean up private state unless retaining it.
+    if(!retained) { cleanup(); }
+    else { memset(RoundKey, 0, RoundKeySize); }
+}
+
+
+    }
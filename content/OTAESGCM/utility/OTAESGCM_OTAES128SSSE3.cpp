@@ -0,0 +1,379 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* x86/x86-64 SSSE3 constant-time PSHUFB table-scan AES(128) implementation with runtime CPU detection. */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "OTAESGCM_OTAES128SSSE3.h"
+#include "OTAESGCM_OTAES128Tables.h"
+
+#if defined(OTAESGCM_HAS_SSSE3_IMPL)
+
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <tmmintrin.h>
+
+// Compile selected functions for SSSE3 without needing -mssse3 globally;
+// they must only be called once CPUID has confirmed support.
+#define OTAESGCM_TARGET_SSSE3 __attribute__((target("ssse3")))
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+// The number of rounds in AES Cipher.
+static constexpr uint8_t Nr = 10;
+
+// PSHUFB masks: ShiftRows and its inverse on the column-major state,
+// and rotations of the bytes within each column (32-bit word) by 1 and 2 rows.
+alignas(16) static const uint8_t shiftRowsMask[16] = { 0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12, 1, 6, 11 };
+alignas(16) static const uint8_t invShiftRowsMask[16] = { 0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3 };
+alignas(16) static const uint8_t rot1Mask[16] = { 1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12 };
+alignas(16) static const uint8_t rot2Mask[16] = { 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13 };
+// Broadcasts RotWord() of the last word of a round key to all 4 words.
+alignas(16) static const uint8_t rotWordMask[16] = { 13, 14, 15, 12, 13, 14, 15, 12, 13, 14, 15, 12, 13, 14, 15, 12 };
+
+OTAESGCM_TARGET_SSSE3
+static inline __m128i loadMask(const uint8_t *const m) { return(_mm_load_si128((const __m128i *)m)); }
+
+/**
+ * @brief   substitutes each byte of N states through the 256-byte table
+ * @param   table       aes128SBox or aes128InvSBox, each row of 16 used as a PSHUFB table
+ *
+ * For each row h of the table, the high nibble of each byte has h subtracted,
+ * and a saturating add of 0x70 then leaves bit 7 clear (and the low nibble intact)
+ * only where it became zero, ie where the byte is in row h;
+ * PSHUFB gives zero for the other bytes, so ORing the 16 results
+ * gives the substitution with every row always used.
+ */
+template<uint8_t N>
+OTAESGCM_TARGET_SSSE3
+static inline void subBytes(const uint8_t *const table, __m128i *const s)
+{
+    const __m128i bias = _mm_set1_epi8(0x70);
+    const __m128i step = _mm_set1_epi8(0x10);
+    __m128i t[N], r[N];
+    for(uint8_t i = 0; i < N; ++i) { t[i] = s[i]; r[i] = _mm_setzero_si128(); }
+    for(uint8_t h = 0; h < 16; ++h)
+        {
+        const __m128i row = _mm_load_si128((const __m128i *)(table + 16*h));
+        for(uint8_t i = 0; i < N; ++i)
+            {
+            r[i] = _mm_or_si128(r[i], _mm_shuffle_epi8(row, _mm_adds_epu8(t[i], bias)));
+            t[i] = _mm_sub_epi8(t[i], step);
+            }
+        }
+    for(uint8_t i = 0; i < N; ++i) { s[i] = r[i]; }
+}
+
+// Multiply each byte by x (ie {02}) in GF(2^8), without branches.
+OTAESGCM_TARGET_SSSE3
+static inline __m128i xtime(const __m128i a)
+{
+    const __m128i carry = _mm_cmplt_epi8(a, _mm_setzero_si128());
+    return(_mm_xor_si128(_mm_add_epi8(a, a), _mm_and_si128(carry, _mm_set1_epi8(0x1b))));
+}
+
+// MixColumns: b[r] = 2a[r] ^ 3a[r+1] ^ a[r+2] ^ a[r+3] = xtime(a[r] ^ a[r+1]) ^ a[r+1] ^ (a[r+2] ^ a[r+3]).
+OTAESGCM_TARGET_SSSE3
+static inline __m128i mixColumns(const __m128i a)
+{
+    const __m128i r1 = _mm_shuffle_epi8(a, loadMask(rot1Mask));
+    const __m128i t = _mm_xor_si128(a, r1);
+    return(_mm_xor_si128(_mm_xor_si128(xtime(t), r1), _mm_shuffle_epi8(t, loadMask(rot2Mask))));
+}
+
+// InvMixColumns as MixColumns after a[r] ^= 4(a[r] ^ a[r+2]).
+OTAESGCM_TARGET_SSSE3
+static inline __m128i invMixColumns(const __m128i a)
+{
+    const __m128i u = xtime(xtime(_mm_xor_si128(a, _mm_shuffle_epi8(a, loadMask(rot2Mask)))));
+    return(mixColumns(_mm_xor_si128(a, u)));
+}
+
+/**
+ * @brief   fills rk with the Nr+1 round keys for key, in standard byte order
+ *
+ * As for AES-NI's AESKEYGENASSIST, SubWord(RotWord()) of the last word
+ * is broadcast to all 4 words, which then fold into the running XOR.
+ */
+OTAESGCM_TARGET_SSSE3
+static void keyExpansionSSSE3(const uint8_t *const key, uint8_t *const rk)
+{
+    __m128i k = _mm_loadu_si128((const __m128i *)key);
+    _mm_storeu_si128((__m128i *)rk, k);
+    for(uint8_t i = 1; i <= Nr; ++i)
+        {
+        __m128i g = _mm_shuffle_epi8(k, loadMask(rotWordMask));
+        subBytes<1>(aes128SBox, &g);
+        g = _mm_xor_si128(g, _mm_set1_epi32(aes128Rcon[i - 1]));
+        k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+        k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+        k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+        k = _mm_xor_si128(k, g);
+        _mm_storeu_si128((__m128i *)(rk + 16*i), k);
+        }
+    // Avoid leaving key material in registers.
+    k = _mm_setzero_si128();
+    (void)k;
+}
+
+/**
+ * @brief   encrypts N independent blocks with the expanded key rk
+ *
+ * Each round is applied to all the blocks in turn,
+ * so that each S-box row and round key is loaded once per round.
+ */
+template<uint8_t N>
+OTAESGCM_TARGET_SSSE3
+static void cipherSSSE3(const uint8_t *const rk, const uint8_t *const input, uint8_t *const output)
+{
+    __m128i s[N];
+    __m128i k = _mm_loadu_si128((const __m128i *)rk);
+    for(uint8_t i = 0; i < N; ++i) { s[i] = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input + 16*i)), k); }
+    for(uint8_t round = 1; round <= Nr; ++round)
+        {
+        // SubBytes and ShiftRows commute.
+        for(uint8_t i = 0; i < N; ++i) { s[i] = _mm_shuffle_epi8(s[i], loadMask(shiftRowsMask)); }
+        subBytes<N>(aes128SBox, s);
+        // The last round has no MixColumns.
+        if(round < Nr) { for(uint8_t i = 0; i < N; ++i) { s[i] = mixColumns(s[i]); } }
+        k = _mm_loadu_si128((const __m128i *)(rk + 16*round));
+        for(uint8_t i = 0; i < N; ++i) { s[i] = _mm_xor_si128(s[i], k); }
+        }
+    for(uint8_t i = 0; i < N; ++i) { _mm_storeu_si128((__m128i *)(output + 16*i), s[i]); }
+}
+
+/**
+ * @brief   decrypts one block with the expanded (encryption) key rk
+ *
+ * The straightforward inverse cipher, using the round keys in reverse order.
+ */
+OTAESGCM_TARGET_SSSE3
+static void invCipherSSSE3(const uint8_t *const rk, const uint8_t *const input, uint8_t *const output)
+{
+    __m128i s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)input), _mm_loadu_si128((const __m128i *)(rk + 16*Nr)));
+    for(uint8_t round = Nr; round-- > 0; )
+        {
+        s = _mm_shuffle_epi8(s, loadMask(invShiftRowsMask));
+        subBytes<1>(aes128InvSBox, &s);
+        s = _mm_xor_si128(s, _mm_loadu_si128((const __m128i *)(rk + 16*round)));
+        // The last round has no InvMixColumns.
+        if(round > 0) { s = invMixColumns(s); }
+        }
+    _mm_storeu_si128((__m128i *)output, s);
+}
+
+// True if this CPU supports SSSE3; checked once and cached.
+bool OTAES128DE_SSSE3::isAvailable()
+{
+    static const bool available = []()
+        {
+        unsigned int eax, ebx, ecx, edx;
+        if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) { return(false); }
+        return(0 != (ecx & bit_SSSE3));
+        }();
+    return(available);
+}
+
+/**
+ * @brief    Fills RoundKey with key expansion of Key
+ */
+void OTAES128DE_SSSE3::KeyExpansion()
+{
+    keyExpansionSSSE3(Key, RoundKey);
+}
+
+/**
+ *    @brief    AES128 block encryption
+ *    @param    input takes a pointer to an array containing plaintext
+ *    @param    key takes a pointer to a 128bit secret key
+ *    @param    output takes a pointer to an array to fill with ciphertext
+ *
+ * Input and output may be the same buffer.
+ * Cleans up internal sensitive state when done
+ * unless the key schedule is being retained or cached.
+ */
+void OTAES128DE_SSSE3::blockEncrypt(const uint8_t *const input, const uint8_t *const key, uint8_t *const output)
+{
+    if(!useSSSE3) { syncFallbacks(key); fallbackE.blockEncrypt(input, key, output); return; }
+
+    // Abort if no workspace to avoid crashing..
+    if(NULL == RoundKey) { return; }
+
+    // Skip the expansion if the schedule for this key is being retained or cached.
+    if(!hasScheduleFor(key)) { Key = key; KeyExpansion(); }
+
+    cipherSSSE3<1>(RoundKey, input, output);
+
+    // Clean up private state unless retaining or caching it.
+    if(!retained && !caching) { cleanup(); }
+}
+
+/**
+ *    @brief    AES128 encryption of several independent blocks under one key
+ *    @param    input takes a pointer to nBlocks contiguous blocks of plaintext
+ *    @param    nBlocks number of blocks
+ *    @param    key takes a pointer to a 128bit secret key
+ *    @param    output takes a pointer to an array to fill with ciphertext
+ *
+ * Input and output may be the same buffer.
+ * Cleans up internal sensitive state when done
+ * unless the key schedule is being retained or cached.
+ */
+void OTAES128DE_SSSE3::blocksEncrypt(const uint8_t *input, size_t nBlocks, const uint8_t *const key, uint8_t *output)
+{
+    if(!useSSSE3) { syncFallbacks(key); fallbackE.blocksEncrypt(input, nBlocks, key, output); return; }
+
+    // Abort if no workspace to avoid crashing..
+    if(NULL == RoundKey) { return; }
+    if(0 == nBlocks) { return; }
+
+    // Skip the expansion if the schedule for this key is being retained or cached.
+    if(!hasScheduleFor(key)) { Key = key; KeyExpansion(); }
+
+    // More than 2 blocks at a time runs out of XMM registers.
+    for( ; nBlocks >= 2; nBlocks -= 2, input += 2*16, output += 2*16)
+        { cipherSSSE3<2>(RoundKey, input, output); }
+    if(nBlocks > 0)
+        { cipherSSSE3<1>(RoundKey, input, output); }
+
+    // Clean up private state unless retaining or caching it.
+    if(!retained && !caching) { cleanup(); }
+}
+
+/**
+ *    @brief    AES128 block decryption
+ *    @param    input takes a pointer to an array containing ciphertext
+ *    @param    key takes a pointer to a 128bit secret key
+ *    @param    output takes a pointer to an array to fill with plaintext
+ *
+ * Cleans up internal sensitive state when done
+ * unless the key schedule is being retained or cached.
+ */
+void OTAES128DE_SSSE3::blockDecrypt(const uint8_t *const input, const uint8_t *const key, uint8_t *const output)
+{
+    if(!useSSSE3) { syncFallbacks(key); fallbackDE.blockDecrypt(input, key, output); return; }
+
+    // Abort if no workspace to avoid crashing..
+    if(NULL == RoundKey) { return; }
+
+    // Skip the expansion if the schedule for this key is being retained or cached.
+    if(!hasScheduleFor(key)) { Key = key; KeyExpansion(); }
+
+    invCipherSSSE3(RoundKey, input, output);
+
+    // Clean up private state unless retaining or caching it.
+    if(!retained && !caching) { cleanup(); }
+}
+
+/**
+ *    @brief    Expand and retain the key schedule between calls
+ *    @param    key takes a pointer to a 128bit secret key
+ *
+ * The schedule is kept until clearKeySchedule().
+ * While caching, the expansion is skipped if the key bytes are unchanged.
+ */
+void OTAES128DE_SSSE3::retainKeySchedule(const uint8_t *const key)
+{
+    // Abort if no workspace to avoid crashing..
+    if(NULL == RoundKey) { return; }
+
+    const bool cached = caching && (NULL != Key) && sameKey(key, RoundKey);
+    Key = key;
+    retained = true;
+    if(!useSSSE3)
+        {
+        fallbackE.retainKeySchedule(key);
+        fallbackDE.retainKeySchedule(key);
+        return;
+        }
+    if(!cached) { KeyExpansion(); }
+}
+
+/**
+ * @brief   keeps the fallbacks' shared retained schedule consistent
+ *
+ * The fallbacks share the workspace and schedule layout, so while retaining
+ * both must hold the schedule for the same key, else one could skip
+ * expansion over a schedule that the other has replaced.
+ * A no-op when not retaining: then each fallback expands per call.
+ */
+void OTAES128DE_SSSE3::syncFallbacks(const uint8_t *const key)
+{
+    if(!retained || (key == Key)) { return; }
+    Key = key;
+    fallbackE.retainKeySchedule(key);
+    fallbackDE.retainKeySchedule(key);
+}
+
+/**
+ *    @brief    Stop retaining the key schedule and wipe it unless caching
+ */
+void OTAES128DE_SSSE3::clearKeySchedule()
+{
+    retained = false;
+    if(!useSSSE3)
+        {
+        fallbackE.clearKeySchedule();
+        fallbackDE.clearKeySchedule();
+        Key = NULL;
+        return;
+        }
+    if(!caching) { cleanup(); }
+}
+
+/**
+ *    @brief    Keep the last schedule expanded until wipeKeySchedule()
+ *
+ * The fallbacks cache too: each compares the key with the first round key
+ * in the shared workspace, so neither can use a schedule the other replaced.
+ */
+void OTAES128DE_SSSE3::cacheKeySchedule()
+{
+    caching = true;
+    if(!useSSSE3)
+        {
+        fallbackE.cacheKeySchedule();
+        fallbackDE.cacheKeySchedule();
+        }
+}
+
+/**
+ *    @brief    Stop caching and retaining, and wipe the schedule
+ */
+void OTAES128DE_SSSE3::wipeKeySchedule()
+{
+    retained = false;
+    caching = false;
+    if(!useSSSE3)
+        {
+        fallbackE.wipeKeySchedule();
+        fallbackDE.wipeKeySchedule();
+        Key = NULL;
+        return;
+        }
+    cleanup();
+}
+
+
+    }
+
+#endif // defined(OTAESGCM_HAS_SSSE3_IMPL)
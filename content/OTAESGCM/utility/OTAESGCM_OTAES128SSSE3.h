@@ -0,0 +1,165 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* x86/x86-64 SSSE3 constant-time PSHUFB table-scan AES(128) implementation with runtime CPU detection. */
+
+#ifndef ARDUINO_LIB_OTAESGCM_OTAES128SSSE3_H
+#define ARDUINO_LIB_OTAESGCM_OTAES128SSSE3_H
+
+#include <stdint.h>
+#include <string.h>
+#include "OTAESGCM_OTAES128.h"
+
+// Only for x86 hosts with a GCC-compatible compiler,
+// which can compile the SSSE3 code without global -mssse3.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define OTAESGCM_HAS_SSSE3_IMPL // Can be used to enable features dependent on this implementation.
+
+#include "OTAESGCM_OTAES128AVR.h"
+#include "OTAESGCM_OTAES128TTable.h"
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+
+    // SSSE3 constant-time PSHUFB table-scan decrypt and encrypt implementation
+    // for x86 hosts without AES-NI, eg gateway VMs where the hypervisor masks it off.
+    // SubBytes is computed for all 16 bytes of the state at once by scanning the whole S-box:
+    // each of its 16 rows is a 16-byte PSHUFB table indexed by the low nibble,
+    // and the row is selected by the high nibble by masking, so every row is always used:
+    // no data-dependent memory access or branches, so constant-time
+    // with respect to cache-timing attacks, unlike OTAES128E_TTable.
+    // This is not Hamburg's vector-permute AES (vpaes), which instead splits the S-box
+    // over GF(2^4) to need a few PSHUFBs per round rather than 16 per S-box pass.
+    // ShiftRows is a PSHUFB and MixColumns byte rotates and SSE2 xtime.
+    // Whether the CPU supports SSSE3 is checked once via CPUID;
+    // if not, this falls back to the portable implementations
+    // (OTAES128E_TTable to encrypt, OTAES128DE_AVR to decrypt) in the same workspace.
+    // Measured (g++ -O2, x86-64, TSC) at ~330 cycles/block with a retained schedule,
+    // ~250/block 2 at a time, ~270 more to expand a key, and ~670 to decrypt a block;
+    // slower than OTAES128E_TTable (~150) but without its secret-dependent lookups.
+    // Neither re-entrant nor ISR-safe except where stated.
+    // Carries workspace but logically no state is carried from one operation to the next,
+    // other than a key schedule explicitly retained with retainKeySchedule()
+    // or cached with cacheKeySchedule().
+    // Residual state should be regarded as sensitive, and eg overwritten before being released to heap.
+    class OTAES128DE_SSSE3 : public OTAES128D, public OTAES128E
+        {
+        protected:
+            // Size of the round key schedule (bytes), in standard byte order.
+            static constexpr uint8_t RoundKeySize = 176;
+
+            // True if SSSE3 is to be used, else use the fallbacks.
+            const bool useSSSE3;
+            // The key whose schedule is in RoundKey; NULL if none.
+            const uint8_t *Key = NULL;
+            // Nr+1 round keys; NULL if insufficient workspace is passed in.
+            uint8_t * const RoundKey;
+            // True while the schedule for Key is retained between calls.
+            bool retained = false;
+            // True while the last schedule expanded is cached between calls.
+            bool caching = false;
+
+            // Portable fallbacks sharing the same workspace and schedule layout.
+            OTAES128E_TTable fallbackE;
+            OTAES128DE_AVR fallbackDE;
+
+            // True if RoundKey holds the schedule for key: the same pointer while retained,
+            // or the same bytes while caching (the first round key being the key itself).
+            bool hasScheduleFor(const uint8_t *key) const
+                { return((retained && (key == Key)) || (caching && (NULL != Key) && sameKey(key, RoundKey))); }
+
+            void KeyExpansion();
+            void syncFallbacks(const uint8_t *key);
+
+        public:
+            // Minimum workspace required, unaligned; strictly positive.
+            // This constant, defined per class, is effectively part of the API.
+            static constexpr uint8_t workspaceRequired = RoundKeySize;
+
+            // True if this CPU supports SSSE3; checked once and cached.
+            static bool isAvailable();
+
+            // Construct an instance: supplied workspace must be large enough.
+            // Only the initial 'workspaceRequired' bytes will be used.
+            // If allowSSSE3 is false the portable fallbacks are always used,
+            // eg for testing or comparison.
+            OTAES128DE_SSSE3(uint8_t *const workspace, uint8_t workspaceLen, const bool allowSSSE3 = true)
+              : useSSSE3(allowSSSE3 && isAvailable()),
+                RoundKey((workspaceLen >= workspaceRequired) ? workspace : NULL),
+                fallbackE(workspace, workspaceLen),
+                fallbackDE(workspace, workspaceLen)
+                { }
+
+            // True if SSSE3 is actually in use by this instance.
+            bool isUsingSSSE3() const { return(useSSSE3); }
+
+            // Clean up sensitive state and remove pointers to external state.
+            void cleanup() { if((NULL != RoundKey) && (NULL != Key))
+                { memset(RoundKey, 0, RoundKeySize); Key=NULL; } }
+
+            /**
+             *    @brief    AES128 block encryption
+             *    @param    input takes a pointer to an array containing plaintext, of size 16 bytes; never NULL
+             *    @param    key takes a pointer to a 128-bit (16-byte) secret key; never NULL
+             *    @param    output takes a pointer to an array to fill with ciphertext, of size 16 bytes; never NULL
+             *
+             * Cleans up internal sensitive state when done
+             * unless the key schedule is being retained or cached.
+             */
+            virtual void blockEncrypt(const uint8_t* input, const uint8_t* key, uint8_t *output) override;
+
+            // Encrypts 2 independent blocks at a time with their rounds interleaved,
+            // so that each S-box row is loaded once for both;
+            // the key is expanded at most once per call.
+            virtual void blocksEncrypt(const uint8_t *input, size_t nBlocks, const uint8_t *key, uint8_t *output) override;
+
+            /**
+             *    @brief    AES128 block decryption
+             *    @param    input takes a pointer to an array containing ciphertext, of size 16 bytes; never NULL
+             *    @param    key takes a pointer to a 128-bit (16-byte) secret key; never NULL
+             *    @param    output takes a pointer to an array to fill with plaintext, of size 16 bytes; never NULL
+             *
+             * Cleans up internal sensitive state when done
+             * unless the key schedule is being retained or cached.
+             */
+            virtual void blockDecrypt(const uint8_t* input, const uint8_t* key, uint8_t *output) override;
+
+            // Expand the key into RoundKey and keep it until clearKeySchedule(),
+            // skipping the expansion if already cached.
+            // Does nothing if there is insufficient workspace.
+            virtual void retainKeySchedule(const uint8_t *key) override;
+
+            // Stop retaining the key schedule and wipe it unless caching.
+            virtual void clearKeySchedule() override;
+
+            // Keep the last schedule expanded until wipeKeySchedule(),
+            // also in the fallbacks, whose shared schedule is checked by value.
+            virtual void cacheKeySchedule() override;
+
+            // Stop caching and retaining, and wipe the schedule.
+            virtual void wipeKeySchedule() override;
+        };
+
+
+    }
+
+#endif // (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+
+#endif
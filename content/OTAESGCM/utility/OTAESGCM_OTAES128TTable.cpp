@@ -0,0 +1,185 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* 32-bit T-table AES(128) implementation for hosted (non-AVR) builds. */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "OTAESGCM_OTAES128TTable.h"
+#include "OTAESGCM_OTAES128Tables.h"
+
+#if !defined(__AVR_ARCH__) && !defined(ARDUINO_ARCH_AVR) // Not for Atmel AVR.
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+// The number of rounds in AES Cipher.
+static constexpr uint8_t Nr = 10;
+
+// Combined SubBytes()+MixColumns() table:
+// Te0[x] = (2.S[x], S[x], S[x], 3.S[x]) as a big-endian word.
+// The other three column tables are byte rotations of this one,
+// and S[x] itself is byte 1 (bits 16--23), so no separate S-box is needed.
+static const uint32_t Te0[256] = {
+    0xc66363a5U, 0xf87c7c84U, 0xee777799U, 0xf67b7b8dU, 0xfff2f20dU, 0xd66b6bbdU, 0xde6f6fb1U, 0x91c5c554U,
+    0x60303050U, 0x02010103U, 0xce6767a9U, 0x562b2b7dU, 0xe7fefe19U, 0xb5d7d762U, 0x4dababe6U, 0xec76769aU,
+    0x8fcaca45U, 0x1f82829dU, 0x89c9c940U, 0xfa7d7d87U, 0xeffafa15U, 0xb25959ebU, 0x8e4747c9U, 0xfbf0f00bU,
+    0x41adadecU, 0xb3d4d467U, 0x5fa2a2fdU, 0x45afafeaU, 0x239c9cbfU, 0x53a4a4f7U, 0xe4727296U, 0x9bc0c05bU,
+    0x75b7b7c2U, 0xe1fdfd1cU, 0x3d9393aeU, 0x4c26266aU, 0x6c36365aU, 0x7e3f3f41U, 0xf5f7f702U, 0x83cccc4fU,
+    0x6834345cU, 0x51a5a5f4U, 0xd1e5e534U, 0xf9f1f108U, 0xe2717193U, 0xabd8d873U, 0x62313153U, 0x2a15153fU,
+    0x0804040cU, 0x95c7c752U, 0x46232365U, 0x9dc3c35eU, 0x30181828U, 0x379696a1U, 0x0a05050fU, 0x2f9a9ab5U,
+    0x0e070709U, 0x24121236U, 0x1b80809bU, 0xdfe2e23dU, 0xcdebeb26U, 0x4e272769U, 0x7fb2b2cdU, 0xea75759fU,
+    0x1209091bU, 0x1d83839eU, 0x582c2c74U, 0x341a1a2eU, 0x361b1b2dU, 0xdc6e6eb2U, 0xb45a5aeeU, 0x5ba0a0fbU,
+    0xa45252f6U, 0x763b3b4dU, 0xb7d6d661U, 0x7db3b3ceU, 0x5229297bU, 0xdde3e33eU, 0x5e2f2f71U, 0x13848497U,
+    0xa65353f5U, 0xb9d1d168U, 0x00000000U, 0xc1eded2cU, 0x40202060U, 0xe3fcfc1fU, 0x79b1b1c8U, 0xb65b5bedU,
+    0xd46a6abeU, 0x8dcbcb46U, 0x67bebed9U, 0x7239394bU, 0x944a4adeU, 0x984c4cd4U, 0xb05858e8U, 0x85cfcf4aU,
+    0xbbd0d06bU, 0xc5efef2aU, 0x4faaaae5U, 0xedfbfb16U, 0x864343c5U, 0x9a4d4dd7U, 0x66333355U, 0x11858594U,
+    0x8a4545cfU, 0xe9f9f910U, 0x04020206U, 0xfe7f7f81U, 0xa05050f0U, 0x783c3c44U, 0x259f9fbaU, 0x4ba8a8e3U,
+    0xa25151f3U, 0x5da3a3feU, 0x804040c0U, 0x058f8f8aU, 0x3f9292adU, 0x219d9dbcU, 0x70383848U, 0xf1f5f504U,
+    0x63bcbcdfU, 0x77b6b6c1U, 0xafdada75U, 0x42212163U, 0x20101030U, 0xe5ffff1aU, 0xfdf3f30eU, 0xbfd2d26dU,
+    0x81cdcd4cU, 0x180c0c14U, 0x26131335U, 0xc3ecec2fU, 0xbe5f5fe1U, 0x359797a2U, 0x884444ccU, 0x2e171739U,
+    0x93c4c457U, 0x55a7a7f2U, 0xfc7e7e82U, 0x7a3d3d47U, 0xc86464acU, 0xba5d5de7U, 0x3219192bU, 0xe6737395U,
+    0xc06060a0U, 0x19818198U, 0x9e4f4fd1U, 0xa3dcdc7fU, 0x44222266U, 0x542a2a7eU, 0x3b9090abU, 0x0b888883U,
+    0x8c4646caU, 0xc7eeee29U, 0x6bb8b8d3U, 0x2814143cU, 0xa7dede79U, 0xbc5e5ee2U, 0x160b0b1dU, 0xaddbdb76U,
+    0xdbe0e03bU, 0x64323256U, 0x743a3a4eU, 0x140a0a1eU, 0x924949dbU, 0x0c06060aU, 0x4824246cU, 0xb85c5ce4U,
+    0x9fc2c25dU, 0xbdd3d36eU, 0x43acacefU, 0xc46262a6U, 0x399191a8U, 0x319595a4U, 0xd3e4e437U, 0xf279798bU,
+    0xd5e7e732U, 0x8bc8c843U, 0x6e373759U, 0xda6d6db7U, 0x018d8d8cU, 0xb1d5d564U, 0x9c4e4ed2U, 0x49a9a9e0U,
+    0xd86c6cb4U, 0xac5656faU, 0xf3f4f407U, 0xcfeaea25U, 0xca6565afU, 0xf47a7a8eU, 0x47aeaee9U, 0x10080818U,
+    0x6fbabad5U, 0xf0787888U, 0x4a25256fU, 0x5c2e2e72U, 0x381c1c24U, 0x57a6a6f1U, 0x73b4b4c7U, 0x97c6c651U,
+    0xcbe8e823U, 0xa1dddd7cU, 0xe874749cU, 0x3e1f1f21U, 0x964b4bddU, 0x61bdbddcU, 0x0d8b8b86U, 0x0f8a8a85U,
+    0xe0707090U, 0x7c3e3e42U, 0x71b5b5c4U, 0xcc6666aaU, 0x904848d8U, 0x06030305U, 0xf7f6f601U, 0x1c0e0e12U,
+    0xc26161a3U, 0x6a35355fU, 0xae5757f9U, 0x69b9b9d0U, 0x17868691U, 0x99c1c158U, 0x3a1d1d27U, 0x279e9eb9U,
+    0xd9e1e138U, 0xebf8f813U, 0x2b9898b3U, 0x22111133U, 0xd26969bbU, 0xa9d9d970U, 0x078e8e89U, 0x339494a7U,
+    0x2d9b9bb6U, 0x3c1e1e22U, 0x15878792U, 0xc9e9e920U, 0x87cece49U, 0xaa5555ffU, 0x50282878U, 0xa5dfdf7aU,
+    0x038c8c8fU, 0x59a1a1f8U, 0x09898980U, 0x1a0d0d17U, 0x65bfbfdaU, 0xd7e6e631U, 0x844242c6U, 0xd06868b8U,
+    0x824141c3U, 0x299999b0U, 0x5a2d2d77U, 0x1e0f0f11U, 0x7bb0b0cbU, 0xa85454fcU, 0x6dbbbbd6U, 0x2c16163aU
+};
+
+// Rotate a 32-bit word right by n bits (0 < n < 32).
+static inline uint32_t rotr(const uint32_t x, const uint8_t n) { return((x >> n) | (x << (32 - n))); }
+
+// S-box lookup via the combined table.
+static inline uint32_t sbox(const uint8_t x) { return((Te0[x] >> 16) & 0xff); }
+
+// Load/store big-endian words from/to possibly unaligned byte arrays.
+static inline uint32_t loadBE(const uint8_t *p)
+    { return(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3]); }
+static inline void storeBE(uint8_t *p, const uint32_t w)
+    { p[0] = (uint8_t)(w >> 24); p[1] = (uint8_t)(w >> 16); p[2] = (uint8_t)(w >> 8); p[3] = (uint8_t)w; }
+
+// Load/store round-key words from/to the workspace.
+// The schedule is kept in standard (FIPS-197) byte order,
+// the same layout as OTAES128E_AVR and other implementations use.
+static inline uint32_t loadRK(const uint8_t *rk, const uint8_t i) { return(loadBE(rk + 4*i)); }
+static inline void storeRK(uint8_t *rk, const uint8_t i, const uint32_t w) { storeBE(rk + 4*i, w); }
+
+/**
+ * @brief    Fills RoundKey with key expansion of Key
+ */
+void OTAES128E_TTable::KeyExpansion()
+{
+    uint32_t w[4];
+    for(uint8_t i = 0; i < 4; ++i) { w[i] = loadBE(Key + 4*i); storeRK(RoundKey, i, w[i]); }
+    for(uint8_t r = 0; r < Nr; ++r)
+        {
+        // SubWord(RotWord(w[3])) ^ Rcon.
+        const uint32_t t = w[3];
+        w[0] ^= (sbox((uint8_t)(t >> 16)) << 24) ^ (sbox((uint8_t)(t >> 8)) << 16) ^
+                (sbox((uint8_t)t) << 8) ^ sbox((uint8_t)(t >> 24)) ^ ((uint32_t)aes128Rcon[r] << 24);
+        w[1] ^= w[0];
+        w[2] ^= w[1];
+        w[3] ^= w[2];
+        for(uint8_t i = 0; i < 4; ++i) { storeRK(RoundKey, (uint8_t)(4*(r+1) + i), w[i]); }
+        }
+}
+
+/**
+ * @brief    encrypts one 128 bit block with the expanded key
+ */
+void OTAES128E_TTable::Cipher(const uint8_t *const input, uint8_t *const output) const
+{
+    uint32_t s0 = loadBE(input     ) ^ loadRK(RoundKey, 0);
+    uint32_t s1 = loadBE(input +  4) ^ loadRK(RoundKey, 1);
+    uint32_t s2 = loadBE(input +  8) ^ loadRK(RoundKey, 2);
+    uint32_t s3 = loadBE(input + 12) ^ loadRK(RoundKey, 3);
+
+    // Nr-1 full rounds: SubBytes, ShiftRows, MixColumns and AddRoundKey combined.
+    for(uint8_t round = 1; round < Nr; ++round)
+        {
+        const uint32_t t0 = Te0[s0 >> 24] ^ rotr(Te0[(s1 >> 16) & 0xff], 8) ^ rotr(Te0[(s2 >> 8) & 0xff], 16) ^ rotr(Te0[s3 & 0xff], 24) ^ loadRK(RoundKey, (uint8_t)(4*round    ));
+        const uint32_t t1 = Te0[s1 >> 24] ^ rotr(Te0[(s2 >> 16) & 0xff], 8) ^ rotr(Te0[(s3 >> 8) & 0xff], 16) ^ rotr(Te0[s0 & 0xff], 24) ^ loadRK(RoundKey, (uint8_t)(4*round + 1));
+        const uint32_t t2 = Te0[s2 >> 24] ^ rotr(Te0[(s3 >> 16) & 0xff], 8) ^ rotr(Te0[(s0 >> 8) & 0xff], 16) ^ rotr(Te0[s1 & 0xff], 24) ^ loadRK(RoundKey, (uint8_t)(4*round + 2));
+        const uint32_t t3 = Te0[s3 >> 24] ^ rotr(Te0[(s0 >> 16) & 0xff], 8) ^ rotr(Te0[(s1 >> 8) & 0xff], 16) ^ rotr(Te0[s2 & 0xff], 24) ^ loadRK(RoundKey, (uint8_t)(4*round + 3));
+        s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+        }
+
+    // The last round has no MixColumns.
+    storeBE(output     , ((sbox((uint8_t)(s0 >> 24)) << 24) | (sbox((uint8_t)(s1 >> 16)) << 16) | (sbox((uint8_t)(s2 >> 8)) << 8) | sbox((uint8_t)s3)) ^ loadRK(RoundKey, 4*Nr    ));
+    storeBE(output +  4, ((sbox((uint8_t)(s1 >> 24)) << 24) | (sbox((uint8_t)(s2 >> 16)) << 16) | (sbox((uint8_t)(s3 >> 8)) << 8) | sbox((uint8_t)s0)) ^ loadRK(RoundKey, 4*Nr + 1));
+    storeBE(output +  8, ((sbox((uint8_t)(s2 >> 24)) << 24) | (sbox((uint8_t)(s3 >> 16)) << 16) | (sbox((uint8_t)(s0 >> 8)) << 8) | sbox((uint8_t)s1)) ^ loadRK(RoundKey, 4*Nr + 2));
+    storeBE(output + 12, ((sbox((uint8_t)(s3 >> 24)) << 24) | (sbox((uint8_t)(s0 >> 16)) << 16) | (sbox((uint8_t)(s1 >> 8)) << 8) | sbox((uint8_t)s2)) ^ loadRK(RoundKey, 4*Nr + 3));
+}
+
+/**
+ *    @brief    AES128 block encryption
+ *    @param    input takes a pointer to an array containing plaintext
+ *    @param    key takes a pointer to a 128bit secret key
+ *    @param    output takes a pointer to an array to fill with ciphertext
+ *
+ * Input and output may be the same buffer.
+ * Cleans up internal sensitive state when done
+ * unless the key schedule is being retained or cached.
+ */
+void OTAES128E_TTable::blockEncrypt(const uint8_t *const input, const uint8_t *const key, uint8_t *const output)
+{
+    // Abort if no workspace to avoid crashing..
+    if(NULL == RoundKey) { return; }
+
+    // Skip the expansion if the schedule for this key is being retained or cached.
+    if(!hasScheduleFor(key)) { Key = key; KeyExpansion(); }
+
+    Cipher(input, output);
+
+    // Clean up private state unless retaining or caching it.
+    if(!retained && !caching) { cleanup(); }
+}
+
+/**
+ *    @brief    Expand and retain the key schedule between calls
+ *    @param    key takes a pointer to a 128bit secret key
+ *
+ * The schedule is kept until clearKeySchedule().
+ * While caching, the expansion is skipped if the key bytes are unchanged.
+ */
+void OTAES128E_TTable::retainKeySchedule(const uint8_t *const key)
+{
+    // Abort if no workspace to avoid crashing..
+    if(NULL == RoundKey) { return; }
+
+    const bool cached = caching && (NULL != Key) && sameKey(key, RoundKey);
+    Key = key;
+    if(!cached) { KeyExpansion(); }
+    retained = true;
+}
+
+
+    }
+
+#endif // !defined(__AVR_ARCH__) && !defined(ARDUINO_ARCH_AVR)
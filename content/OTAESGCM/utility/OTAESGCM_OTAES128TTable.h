@@ -0,0 +1,118 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* 32-bit T-table AES(128) implementation for hosted (non-AVR) builds. */
+
+#ifndef ARDUINO_LIB_OTAESGCM_OTAES128TTABLE_H
+#define ARDUINO_LIB_OTAESGCM_OTAES128TTABLE_H
+
+#include <stdint.h>
+#include <string.h>
+#include "OTAESGCM_OTAES128.h"
+
+#if !defined(__AVR_ARCH__) && !defined(ARDUINO_ARCH_AVR) // Not for Atmel AVR.
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+
+    // 32-bit word-oriented encrypt-only implementation for hosts, eg gateways.
+    // Each round is 16 lookups into a single 1kB table (with rotates)
+    // rather than byte-wise SubBytes()/ShiftRows()/MixColumns().
+    // Measured (g++ -O2, x86-64, TSC) at ~250 cycles/block including key expansion
+    // and ~130 with a retained schedule, vs ~1650 and ~950 for OTAES128E_AVR.
+    // NOTE: table lookups are key/data dependent, so this is NOT constant-time
+    // with respect to cache-timing attacks.
+    // Neither re-entrant nor ISR-safe except where stated.
+    // Carries workspace but logically no state is carried from one operation to the next,
+    // other than a key schedule explicitly retained with retainKeySchedule()
+    // or cached with cacheKeySchedule().
+    // Residual state should be regarded as sensitive, and eg overwritten before being released to heap.
+    class OTAES128E_TTable : public OTAES128E
+        {
+        protected:
+            // Size of the round key schedule (bytes), 44 32-bit words.
+            static constexpr uint8_t RoundKeySize = 176;
+
+            // The key whose schedule is in RoundKey; NULL if none.
+            const uint8_t *Key = NULL;
+            // Nr+1 round keys in standard byte order (as for OTAES128E_AVR), unaligned;
+            // NULL if insufficient workspace is passed in.
+            // Should be cleared before releasing space to (say) heap.
+            uint8_t * const RoundKey;
+            // True while the schedule for Key is retained between calls.
+            bool retained = false;
+            // True while the last schedule expanded is cached between calls.
+            bool caching = false;
+
+            // True if RoundKey holds the schedule for key: the same pointer while retained,
+            // or the same bytes while caching (the first round key being the key itself).
+            bool hasScheduleFor(const uint8_t *key) const
+                { return((retained && (key == Key)) || (caching && (NULL != Key) && sameKey(key, RoundKey))); }
+
+            void KeyExpansion();
+            void Cipher(const uint8_t *input, uint8_t *output) const;
+
+        public:
+            // Minimum workspace required, unaligned; strictly positive.
+            // This constant, defined per class, is effectively part of the API.
+            static constexpr uint8_t workspaceRequired = RoundKeySize;
+
+            // Construct an instance: supplied workspace must be large enough.
+            // Only the initial 'workspaceRequired' bytes will be used.
+            OTAES128E_TTable(uint8_t *const workspace, uint8_t workspaceLen)
+              : RoundKey((workspaceLen >= workspaceRequired) ? workspace : NULL)
+                { }
+
+            // Clean up sensitive state and remove pointers to external state.
+            void cleanup() { if((NULL != RoundKey) && (NULL != Key))
+                { memset(RoundKey, 0, RoundKeySize); Key=NULL; } }
+
+            /**
+             *    @brief    AES128 block encryption
+             *    @param    input takes a pointer to an array containing plaintext, of size 16 bytes; never NULL
+             *    @param    key takes a pointer to a 128-bit (16-byte) secret key; never NULL
+             *    @param    output takes a pointer to an array to fill with ciphertext, of size 16 bytes; never NULL
+             *
+             * Cleans up internal sensitive state when done
+             * unless the key schedule is being retained or cached.
+             */
+            virtual void blockEncrypt(const uint8_t* input, const uint8_t* key, uint8_t *output) override;
+
+            // Expand the key into RoundKey and keep it until clearKeySchedule(),
+            // skipping the expansion if already cached.
+            // Does nothing if there is insufficient workspace.
+            virtual void retainKeySchedule(const uint8_t *key) override;
+
+            // Stop retaining the key schedule and wipe it unless caching.
+            virtual void clearKeySchedule() override { retained = false; if(!caching) { cleanup(); } }
+
+            // Keep the last schedule expanded until wipeKeySchedule().
+            virtual void cacheKeySchedule() override { caching = true; }
+
+            // Stop caching and retaining, and wipe the schedule.
+            virtual void wipeKeySchedule() override { retained = false; caching = false; cleanup(); }
+        };
+
+
+    }
+
+#endif // !defined(__AVR_ARCH__) && !defined(ARDUINO_ARCH_AVR)
+
+#endif
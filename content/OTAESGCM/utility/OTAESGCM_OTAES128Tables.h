@@ -0,0 +1,47 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/* AES S-box and round constant tables shared by the AES implementations, stored once in flash on AVR. */
+
+#ifndef ARDUINO_LIB_OTAESGCM_OTAES128TABLES_H
+#define ARDUINO_LIB_OTAESGCM_OTAES128TABLES_H
+
+#include <stdint.h>
+
+#if defined(__AVR_ARCH__) || defined(ARDUINO_ARCH_AVR) // Atmel AVR only.
+#include <avr/pgmspace.h>
+#else
+// Kludge code to treat PROGMEM as part of uniform memory space.
+#define PROGMEM
+inline uint8_t pgm_read_byte(const uint8_t *p) { return(*p); }
+#endif
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+    // The S-box and its inverse, in PROGMEM so read with pgm_read_byte().
+    // 16-byte aligned on hosts, so that each row of 16 can be loaded as a vector.
+    extern const uint8_t aes128SBox[256] PROGMEM;
+    extern const uint8_t aes128InvSBox[256] PROGMEM;
+    // The key schedule round constants Rcon[1] to Rcon[10], ie x^0 to x^9 in GF(2^8).
+    extern const uint8_t aes128Rcon[10] PROGMEM;
+
+    }
+
+#endif
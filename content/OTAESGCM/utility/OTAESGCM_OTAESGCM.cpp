@@ -33,403 +33,9 @@ Author(s) / Copyright (s): Deniz Erbilgin 2015--2017
 namespace OTAESGCM
     {
 
-/*********************************************************
- * @todo    description of GCM Algorithm here
- *********************************************************
- *
- *
- *********************************************************/
-
-/********************** Includes *************************/
-/******************* Global Variables ********************/
-//
-/******************* Private Variables *******************/
-
-/******************* Private Functions *******************/
-/**
- * @note    xor_block
- * @brief    xor on 128bit block.
- * @param    dest:    pointer to destination
- * @param    src:    pointer to source
- */
-static void xorBlock(uint8_t *dest, const uint8_t *src)
-{
-    for(uint8_t i = 0; i < AES128GCM_BLOCK_SIZE; i++){
-        *dest++ ^= *src++;
-    }
-}
-
-/**
- * @note    shift_block_right
- * @brief    bitshifts 128bit block (16 byte array) right once
- * @param    block:    pointer to block to shift
- * @note    I separated the pointer decrement from the bit shift as it was
- *             mangling the first byte
- */
-static void shiftBlockRight(uint8_t *block)
-{
-    block += 15;
-
-    // bitshift LSB (last byte in array)
-    *block = *block >> 1;
-    block--;
-
-    // loop through remaining bytes
-    for (uint8_t i = 0; i < AES128GCM_BLOCK_SIZE-1; i++) {
-        // if lsb is set, set msb of next byte in array
-        if(*block & 0x01) *(block + 1) |= 0x80;
-        // bit shift byte
-        *block = *block >> 1;
-        block--;
-    }
-}
-
-/**
- * @brief   checks if tags match
- * @param   tag1        pointer to array containing tag1
- * @param   tag2        pointer to array containing tag2
- * @retval  returns 0 if tags match. All other values are a fail.
- */
-static uint8_t checkTag(const uint8_t *tag1, const uint8_t *tag2)
-{
-    uint8_t result = 0;
-
-    // Compare tags: f any byte pair fails to match this will set bits in result.
-    // This method runtime does not depend on where the match is,
-    // which will help avoid some side-channel attacks based on timing.
-    for (uint8_t i = 0; i < AES128GCM_TAG_SIZE; i++) {
-        result |= *tag1 ^ *tag2;
-        tag1++;
-        tag2++;
-    }
-    return result;
-}
-
-/**
- * @note    gf_mult
- * @brief    Performs multiplications in 128 bit galois bit field
- * @todo    learn how multiplication algorithm works
- * @param    x: pointer to input 1
- * @param    y: pointer to input 2
- * @param    result:    pointer to array to put result in
- * @note    output straight to *x and save on a memcpy loop?
- */
-static void gFieldMultiply(GGBWS::GHASHWorkspace * const workspace, const uint8_t *x, const uint8_t *y)
-{
-    // init result to 0s and copy y to temp
-    memcpy(workspace->gFieldMultiplyTmp, y, AES128GCM_BLOCK_SIZE);
-    memset(workspace->ghashTmp, 0, AES128GCM_BLOCK_SIZE);
-    
-        // multiplication algorithm
-    for (uint8_t i = 0; i < AES128GCM_BLOCK_SIZE; i++) {
-        for (uint8_t j = 0; j < 8; j++) {
-
-            if (x[i] & (1 << (7 - j))) {
-                /* Z_(i + 1) = Z_i XOR V_i */
-                xorBlock(workspace->ghashTmp, workspace->gFieldMultiplyTmp);
-            }
-            // if temp is odd, do something?
-            if (workspace->gFieldMultiplyTmp[15] & 0x01) {
-                /* V_(i + 1) = (V_i >> 1) XOR R */
-                shiftBlockRight(workspace->gFieldMultiplyTmp);
-                /* R = 11100001 || 0^120 */
-                workspace->gFieldMultiplyTmp[0] ^= 0xe1;
-            } else {
-                /* V_(i + 1) = V_i >> 1 */
-                shiftBlockRight(workspace->gFieldMultiplyTmp);
-            }
-        }
-    }
-}
-
-/**
- * @note    inc32
- * @brief    increments the rightmost 32 bits (4 bytes) of block, %(2^32)
- * @param    pBlock      16 byte array to perform operation on
- */
-static void incr32(uint8_t *pBlock)
-{
-    // go to end of array
-    pBlock += 15;
-
-    // loop through last 4 elements
-    for (uint8_t i = 0; i < 4; i++) {
-        // increment current byte
-        *pBlock = *pBlock + 1;
-        // return if no overflow, otherwise move to next byte
-        if(*pBlock) return;
-        else pBlock--;
-    }
-}
-
-#if defined(OTAESGCM_ALLOW_UNPADDED)
-//**************** MAIN ENCRYPTION FUNCTIONS *************
-/**
- * @note    aes_gctr
- * @brief   performs gcntr operation for encryption
- * @param   pInput          pointer to input data (need not be block multiple)
- * @param   inputLength     length of input array
- * @param   pKey            pointer to 128 bit AES key
- * @param   pICB            initial counter block J0
- * @param   pOutput         pointer to output data. length inputLength rounded up to 16.
- */
-static void GCTR(OTAES128E * const ap, GGBWS::GCTRWorkspace * const workspace,
-                    const uint8_t *pInput, const uint8_t inputLength, const uint8_t *pKey,
-                    const uint8_t *pCtrBlock, uint8_t *pOutput)
-{
-    const uint8_t *xpos = pInput;
-    uint8_t *ypos = pOutput;
-
-    // exit function if no input data
-    if (inputLength == 0) return;
-
-    // calculate number of full blocks to cipher
-    const uint8_t n = inputLength / 16;
-
-    // copy ICB to ctrBlock
-    memcpy(workspace->ctrBlock, pCtrBlock, AES128GCM_BLOCK_SIZE);
-
-    // for full blocks
-    for (uint8_t i = 0; i < n; i++) {
-        // cipher counterblock and combine with input
-        ap->blockEncrypt(workspace->ctrBlock, pKey, ypos);
-        xorBlock(ypos, xpos);
-
-        // increment pointers to next block
-        xpos += AES128GCM_BLOCK_SIZE;
-        ypos += AES128GCM_BLOCK_SIZE;
-
-        // increment counter
-        incr32(workspace->ctrBlock);
-    }
-
-    // check if there is a partial block at end.
-    const uint8_t last = uint8_t(pInput + inputLength - xpos);
-    if (last) {
-        // encrypt into tmp and combine with last block of input
-        ap->blockEncrypt(workspace->ctrBlock, pKey, workspace->tmp);
-        for (uint8_t i = 0; i < last; i++)
-            *ypos++ = *xpos++ ^ workspace->tmp[i];
-    }
-}
-#endif
-/**
- * @note    aes_gctr
- * @brief   performs gcntr operation for encryption
- * @param   pInput          pointer to input data (MUST BE be block multiple)
- * @param   inputLength     length of input array
- * @param   pKey            pointer to 128 bit AES key
- * @param   pICB            initial counter block J0
- * @param   pOutput         pointer to output data. length inputLength rounded up to 16.
- */
-static void GCTRPadded(OTAES128E * const ap, GGBWS::GCTRPaddedWorkspace * const workspace,
-                    const uint8_t *pInput, const uint8_t inputLength, const uint8_t *pKey,
-                    const uint8_t *pCtrBlock, uint8_t *pOutput)
-{
-    const uint8_t *xpos = pInput;
-    uint8_t *ypos = pOutput;
-
-    // exit function if no input data
-    if (inputLength == 0) return;
-
-    // calculate number of full blocks to cipher
-    const uint8_t n = inputLength / 16;
-
-    // copy ICB to ctrBlock
-    memcpy(workspace->ctrBlock, pCtrBlock, AES128GCM_BLOCK_SIZE);
-
-    // for full blocks
-    for (uint8_t i = 0; i < n; i++) {
-        // cipher counterblock and combine with input
-        ap->blockEncrypt(workspace->ctrBlock, pKey, ypos);
-        xorBlock(ypos, xpos);
-
-        // increment pointers to next block
-        xpos += AES128GCM_BLOCK_SIZE;
-        ypos += AES128GCM_BLOCK_SIZE;
-
-        // increment counter
-        incr32(workspace->ctrBlock);
-    }
-
-//    // check if there is a partial block at end.
-//    const uint8_t last = uint8_t(pInput + inputLength - xpos);
-//    if (last) {
-//        // encrypt into tmp and combine with last block of input
-//        ap->blockEncrypt(workspace->ctrBlock, pKey, workspace->tmp);
-//        for (uint8_t i = 0; i < last; i++)
-//            *ypos++ = *xpos++ ^ workspace->tmp[i];
-//    }
-}
-
-/**
- * @note    ghash
- * @brief   performs authentication hashing
- * @todo    is final memcpy always persistent?
- * @param   pInput          pointer to input data
- * @param   inputLength     length of input array
- * @param   pAuthKey        pointer to 128 bit authentication subkey H
- * @param   pOutput         pointer to 16 byte output array
- */
-static void GHASH(  GGBWS::GHASHWorkspace * const workspace,
-                    const uint8_t *pInput, uint8_t inputLength,
-                    const uint8_t *pAuthKey, uint8_t *pOutput )
-{
-    const uint8_t *xpos = pInput;
-    // Calculate number of full blocks to hash.
-    const uint8_t m = inputLength / AES128GCM_BLOCK_SIZE;
-
-    // Hash full blocks.
-    for (uint8_t i = 0; i < m; i++) {
-        // Y_i = (Y^(i-1) XOR X_i) dot H
-        xorBlock(pOutput, xpos);
-        xpos += 16; // move to next block
-
-        gFieldMultiply(workspace, pOutput, pAuthKey);
-
-        // copy tmp to output
-        memcpy(pOutput, workspace->ghashTmp, AES128GCM_BLOCK_SIZE);
-    }
-
-    // Check if final partial block.
-    // Can be omitted if we use full blocks.
-    if (pInput + inputLength > xpos) {
-        // zero pad
-        const uint8_t last = uint8_t(pInput + inputLength - xpos);
-        memcpy(workspace->ghashTmp, xpos, last);
-        memset(workspace->ghashTmp + last, 0, sizeof(workspace->ghashTmp) - last);
-
-        // Y_i = (Y^(i-1) XOR X_i) dot H
-        xorBlock(pOutput, workspace->ghashTmp);
-        gFieldMultiply(workspace, pOutput, pAuthKey);
-        memcpy(pOutput, workspace->ghashTmp, AES128GCM_BLOCK_SIZE);
-    }
-}
-
-/**
- * @note    aes_gcm_prepare_j0
- * @brief   generates initial counter block from IV
- * @param   pIV             pointer to 12 byte initial vector nonce
- * @param   pOutput         pointer to 16 byte output array
- */
-static void generateICB(const uint8_t *pIV, uint8_t *pOutput)
-{
-    // Prepare block J0 = IV || 0^31 || 1 [len(IV) = 96]
-    memcpy(pOutput, pIV, AES128GCM_IV_SIZE);
-    memset(pOutput + AES128GCM_IV_SIZE, 0, AES128GCM_BLOCK_SIZE - AES128GCM_IV_SIZE);
-    pOutput[AES128GCM_BLOCK_SIZE - 1] = 0x01;
-}
-
-#if defined(OTAESGCM_ALLOW_UNPADDED)
-/**
- * @note    aes_gcm_ctr
- * @brief   encrypt PDATA to get CDATA
- * @param   pICB        pointer to initial counter block
- * @param   pPDATA      pointer to plain text
- * @param   PDATALength length of plain text (need not be block-size multiple)
- * @param   pCDATA      pointer to array for cipher text. Length PDATALength rounded up to next 16 bytes
- */
-static void generateCDATA(OTAES128E * const ap, GGBWS::GenCDATAWorkspace * const workspace,
-                            const uint8_t *pICB, const uint8_t *pPDATA, uint8_t PDATALength,
-                            uint8_t *pCDATA, const uint8_t *pKey )
-{
-    // Exit if no data to encrypt.
-    if(PDATALength == 0) return;
-    // Generate counter block J.
-    memcpy(workspace->ctrBlock, pICB, AES128GCM_BLOCK_SIZE);
-    incr32(workspace->ctrBlock);
-
-    // Encrypt.
-    GCTR(ap, &workspace->gctrSpace, pPDATA, PDATALength, pKey, workspace->ctrBlock, pCDATA);
-}
-#endif
-/**
- * @note    aes_gcm_ctr
- * @brief   encrypt PDATA to get CDATA
- * @param   pICB        pointer to initial counter block
- * @param   pPDATA      pointer to plain text
- * @param   PDATALength length of plain text (MUST BE block-size multiple)
- * @param   pCDATA      pointer to array for cipher text. Length PDATALength rounded up to next 16 bytes
- */
-static void generateCDATAPadded(OTAES128E * const ap, GGBWS::GenCDATAPaddedWorkspace * const cdataSpace,
-                            const uint8_t *pICB, const uint8_t *pPDATAPadded, uint8_t PDATALength,
-                            uint8_t *pCDATA, const uint8_t *pKey )
-{
-    // Exit if no data to encrypt.
-    if(PDATALength == 0) return;
-
-    // Generate counter block J.
-    memcpy(cdataSpace->ctrBlock, pICB, AES128GCM_BLOCK_SIZE);
-    incr32(cdataSpace->ctrBlock);
-
-    // Encrypt.
-    GCTRPadded(ap, &cdataSpace->gctrSpace, pPDATAPadded, PDATALength, pKey, cdataSpace->ctrBlock, pCDATA);
-}
-
-/**
- * @note    aes_gcm_ghash
- * @brief   makes message S from ADATA and CDATA
- * @param   pADATA          pointer to array containing authentication data
- * @param   ADATALength     length of ADATA array
- * @param   pCDATA          pointer to array containing encrypted data
- * @param   CDATALength     length of CDATA array
- * @param   pAuthKey        pointer to 128 bit authentication subkey H
- * @param   pTag            pointer to array to store tag
- */
-static void generateTag(OTAES128E * const ap,
-                            GGBWS::GenerateTagWorkspace * const workspace,
-                            const uint8_t *pKey, const uint8_t *pAuthKey,
-                            const uint8_t *pADATA, uint8_t ADATALength,
-                            const uint8_t *pCDATA, uint8_t CDATALength,
-                            uint8_t * pTag, const uint8_t *pICB)
-{
-    uint16_t temp;
-    memset(workspace->lengthBuffer, 0, sizeof(workspace->lengthBuffer));
-    memset(workspace->S, 0, sizeof(workspace->S));
-    /*
-     * u = 128 * ceil[len(C)/128] - len(C)
-     * v = 128 * ceil[len(A)/128] - len(A)
-     * S = GHASH_H(A || 0^v || C || 0^u || [len(A)]64 || [len(C)]64)
-     * (i.e., zero padded to block size A || C and lengths of each in bits)
-     */
-
-    // function to put [len(A)]64 || [len(C)]64 in temp. could be saved as using fixed method length
-    temp = (uint16_t) ADATALength * 8;
-    //lengthBuffer[4] = (temp >> 24) & 0xff;    // these two are not needed as only using 16 bit values
-    //lengthBuffer[5] = (temp >> 16) & 0xff;
-    workspace->lengthBuffer[6] = (temp >> 8) & 0xff;
-    workspace->lengthBuffer[7] = temp & 0xff;
-
-    temp = (uint16_t) CDATALength * 8;
-    //lengthBuffer[12] = (temp >> 24) & 0xff;
-    //lengthBuffer[13] = (temp >> 16) & 0xff;
-    workspace->lengthBuffer[14] = (temp >> 8) & 0xff;
-    workspace->lengthBuffer[15] = temp & 0xff;
-
-    GHASH(&workspace->ghashSpace, pADATA, ADATALength, pAuthKey, workspace->S);
-    GHASH(&workspace->ghashSpace, pCDATA, CDATALength, pAuthKey, workspace->S);
-    GHASH(&workspace->ghashSpace, workspace->lengthBuffer, sizeof(workspace->lengthBuffer), pAuthKey, workspace->S);
-
-//    GCTR(ap, &workspace->gctrSpace, workspace->S, sizeof(workspace->S), pKey, pICB, pTag);
-    GCTRPadded(ap, &workspace->gctrSpace, workspace->S, sizeof(workspace->S), pKey, pICB, pTag);
-}
-
-/**
- * @note    aes_gcm_init_hash_subkey
- * @brief   generates authentication subkey H
- * @param   pKey            pointer to 128 bit AES key
- * @param   pOutput         pointer to 16 byte array put to subkey H in
- * @note    tested arduino 1.6.5
- */
-static void generateAuthKey(OTAES128E * const ap, const uint8_t *pKey, uint8_t *pAuthKey)
-{
-    // original has if(aes == NULL) return NULL;
-
-    // Encrypt 128 bit block of 0s to generate authentication sub-key.
-    memset(pAuthKey, 0, AES128GCM_BLOCK_SIZE);
-    ap->blockEncrypt(pAuthKey, pKey, pAuthKey);
-}
-
+// The GCM steps, templated on the AES and GHASH types,
+// here instantiated to call through the OTAES128E and OTGHASH interfaces.
+using namespace GCMEngine;
 
 /******************* Public Functions ********************/
 #if defined(OTAESGCM_ALLOW_UNPADDED)
@@ -452,31 +58,8 @@ bool OTAES128GCMGenericBase::gcmEncrypt(
                         const uint8_t* ADATA, uint8_t ADATALength,
                         uint8_t* CDATA, uint8_t *tag)
 {
-    if(NULL == CDATA) { return(false); } // DHD20161107: NULL CDATA causes crashes in subroutines.
-
-    // Check if there is input data.
-    // Fail if there is nothing to encrypt and/or authenticate.
-    if((PDATALength == 0) && (ADATALength == 0)) { return(false); }
-
-    // Compute implicit CDATA length (ie rounded up to the next block size if necessary).
-    if(PDATALength >= (uint8_t)(256U - (uint16_t)AES128GCM_BLOCK_SIZE)) { return(false); } // Too big.
-    const uint8_t CDATALength = (PDATALength + AES128GCM_BLOCK_SIZE-1) & ~(AES128GCM_BLOCK_SIZE-1);
-
-    GGBWS::GCMEncryptWorkspace workspace = getGCMEncryptWorkspace();
-
-    // Encrypt data.
-    generateAuthKey(ap, key, workspace.authKey);
-    generateICB(IV, workspace.ICB);
-    // ICB is hashed with the key then XORed with PDATA to encrypt plain text.
-    generateCDATA(ap, &workspace.cdataWorkspace, workspace.ICB, PDATA, PDATALength, CDATA, key);
-
-    // Generate authentication tag.
-    generateTag(ap, &workspace.tagWorkspace, key, workspace.authKey, ADATA, ADATALength, CDATA, CDATALength, tag, workspace.ICB);
-
-    // Erase workspace for security.
-    memset(&workspace, 0, sizeof(workspace));
-
-    return(true);
+    return(encrypt(ap, gp, getGCMEncryptWorkspace(),
+        key, IV, PDATA, PDATALength, ADATA, ADATALength, CDATA, tag));
 }
 #endif
 /**
@@ -517,25 +100,149 @@ bool OTAES128GCMGenericBase::gcmEncryptPadded(
                         const uint8_t* ADATA, uint8_t ADATALength,
                         uint8_t* CDATA, uint8_t *tag)
 {
+    return(encryptPadded(ap, gp, getGCMEncryptPaddedWorkspace(),
+        key, IV, PDATAPadded, PDATALength, ADATA, ADATALength, CDATA, tag));
+}
+
+/**
+ * @brief   performs AES-GCM decryption and authentication
+ * @param   key             pointer to 16 byte (128 bit) key
+ * @param   IV              pointer to 12 byte (96 bit) IV
+ * @param   CDATA           pointer to ciphertext array (multiple of block size, 16 bytes)
+ * @param   CDATALength     length of ciphertext array
+ * @param   ADATA           pointer to additional data array
+ * @param   ADATALength     length of additional data
+ * @param   PDATA           buffer to output plaintext to; must be same length as CDATA
+ * @retval  true if decryption and authentication successful, else false
+ *
+ * The tag is checked before any decryption, and PDATA is only written
+ * if it matches, so a rejected message of n blocks costs 2 block encryptions
+ * (H and E(K, J0)) rather than n+2, eg 2 rather than 4 for a 32 byte frame.
+ */
+bool OTAES128GCMGenericBase::gcmDecrypt(
+                        const uint8_t* key, const uint8_t* IV,
+                        const uint8_t* CDATA, uint8_t CDATALength,
+                        const uint8_t* ADATA, uint8_t ADATALength,
+                        const uint8_t* messageTag, uint8_t *PDATA)
+{
+    return(decrypt(ap, gp, getGCMDecryptWorkspace(),
+        key, IV, CDATA, CDATALength, ADATA, ADATALength, messageTag, PDATA));
+}
+
+/**
+ * @brief   sets the key, computing and retaining all key-dependent state
+ * @param   key             pointer to 16 byte (128 bit) key; copied
+ * @retval  true if successful, false if key NULL or workspace too small
+ */
+bool OTAES128GCMKeyedBase::setKey(const uint8_t *key)
+{
+    clearKey();
+    if((NULL == key) || !isWorkspaceOK()) { return(false); }
+
+    GGBWS::GCMKeyState &keyState = getGCMKeyState();
+
+    // Keep a private copy of the key so the caller's may be discarded,
+    // and have the AES implementation retain its schedule for it.
+    memcpy(keyState.key, key, AES128GCM_BLOCK_SIZE);
+    ap->retainKeySchedule(keyState.key);
+
+    // Compute H (and any GHASH tables) once for all messages under this key.
+    generateAuthKey(ap, keyState.key, keyState.authKey);
+    gp->setAuthKey(keyState.authKey);
+
+    keySet = true;
+    return(true);
+}
+
+/**
+ * @brief   wipes all key-dependent state
+ */
+void OTAES128GCMKeyedBase::clearKey()
+{
+    if(!isWorkspaceOK()) { return; }
+    ap->clearKeySchedule();
+    gp->clearAuthKey();
+    memset(&getGCMKeyState(), 0, sizeof(GGBWS::GCMKeyState));
+    keySet = false;
+}
+
+/**
+ * @brief   performs AES-GCM encryption on padded data under the retained key.
+ * @param   IV              pointer to 12 byte (96 bit) IV; never NULL
+ * @param   PDATAPadded     pointer to plaintext input array,
+ *                          MUST BE a multiple of the blocksize;
+ *                          NULL if length 0.
+ * @param   PDATALength     length of plaintext array in bytes,
+ *                          can be zero, MUST BE blocksize multiple.
+ * @param   ADATA           pointer to additional input data array;
+ *                          NULL if length 0.
+ * @param   ADATALength     length of additional data in bytes, can be zero
+ * @param   CDATA           buffer to output ciphertext to, same size as PDATA;
+ *                          never NULL
+ * @param   tag             pointer to 16 byte tag output buffer; never NULL
+ * @retval  true if encryption is successful, else false
+ */
+bool OTAES128GCMKeyedBase::gcmEncryptPadded(
+                        const uint8_t* IV,
+                        const uint8_t* PDATAPadded, const size_t PDATALength,
+                        const uint8_t* ADATA, const size_t ADATALength,
+                        uint8_t* CDATA, uint8_t *tag)
+{
+    return(encryptPaddedWithPrefix(NULL, IV, PDATAPadded, PDATALength, ADATA, ADATALength, CDATA, tag));
+}
+
+/**
+ * @brief   performs AES-GCM encryption on padded data under the retained key,
+ *          with ADATA of a precomputed prefix followed by ADATASuffix.
+ * @param   prefix          from computeADATAPrefix() under the current key
+ * @retval  true if encryption is successful, else false
+ *
+ * Other parameters as for gcmEncryptPadded(), with the ADATA suffix for ADATA.
+ */
+bool OTAES128GCMKeyedBase::gcmEncryptPadded(
+                        const GCMADATAPrefix &prefix,
+                        const uint8_t* IV,
+                        const uint8_t* PDATAPadded, const size_t PDATALength,
+                        const uint8_t* ADATASuffix, const size_t ADATASuffixLength,
+                        uint8_t* CDATA, uint8_t *tag)
+{
+    return(encryptPaddedWithPrefix(&prefix, IV, PDATAPadded, PDATALength, ADATASuffix, ADATASuffixLength, CDATA, tag));
+}
+
+// As for gcmEncryptPadded(), with an optional ADATA prefix; NULL if none.
+bool OTAES128GCMKeyedBase::encryptPaddedWithPrefix(
+                        const GCMADATAPrefix *const prefix,
+                        const uint8_t* IV,
+                        const uint8_t* PDATAPadded, const size_t PDATALength,
+                        const uint8_t* ADATA, const size_t ADATASuffixLength,
+                        uint8_t* CDATA, uint8_t *tag)
+{
+    if(!keySet) { return(false); }
+    // Whole ADATA length, including any prefix.
+    const size_t ADATALength = ADATASuffixLength + ((NULL == prefix) ? 0 : prefix->length);
+    if(ADATALength < ADATASuffixLength) { return(false); } // Too big.
     if(NULL == CDATA) { return(false); } // DHD20161107: NULL CDATA causes crashes in subroutines.
     if(0 != (PDATALength & (AES128GCM_BLOCK_SIZE-1))) { return(false); } // Reject non-padded data.
+    if((uint64_t)PDATALength > GCM_MAX_TEXT_LENGTH) { return(false); } // Too big.
 
     // Check if there is input data.
     // Fail if there is nothing to encrypt and/or authenticate.
     if((PDATALength == 0) && (ADATALength == 0)) { return(false); }
 
-    const uint8_t CDATALength = PDATALength;
+    const size_t CDATALength = PDATALength;
 
-    GGBWS::GCMEncryptPaddedWorkspace &workspace = getGCMEncryptPaddedWorkspace();
+    const GGBWS::GCMKeyState &keyState = getGCMKeyState();
+    GGBWS::GCMKeyedWorkspace &workspace = getGCMKeyedWorkspace();
 
     // Encrypt data.
-    generateAuthKey(ap, key, workspace.authKey);
     generateICB(IV, workspace.ICB);
-    // ICB is hashed with the key then XORed with PDATA to encrypt plain text.
-    generateCDATAPadded(ap, &workspace.cdataWorkspace, workspace.ICB, PDATAPadded, PDATALength, CDATA, key);
+    // Encrypt and hash the cipher text in one pass.
+    if(NULL == prefix) { startTag(gp, &workspace.tagWorkspace, ADATA, ADATALength); }
+    else { startTagWithPrefix(gp, &workspace.tagWorkspace, *prefix, ADATA, ADATASuffixLength); }
+    generateCDATAAndHashPadded(ap, gp, &workspace.tagWorkspace, workspace.ICB, PDATAPadded, PDATALength, CDATA, keyState.key);
 
     // Generate authentication tag.
-    generateTag(ap, &workspace.tagWorkspace, key, workspace.authKey, ADATA, ADATALength, CDATA, CDATALength, tag, workspace.ICB);
+    finishTag(ap, gp, &workspace.tagWorkspace, keyState.key, ADATALength, CDATALength, tag, workspace.ICB);
 
     // Erase workspace for security.
     memset(&workspace, 0, sizeof(workspace));
@@ -544,8 +251,7 @@ bool OTAES128GCMGenericBase::gcmEncryptPadded(
 }
 
 /**
- * @brief   performs AES-GCM decryption and authentication
- * @param   key             pointer to 16 byte (128 bit) key
+ * @brief   performs AES-GCM decryption and authentication under the retained key.
  * @param   IV              pointer to 12 byte (96 bit) IV
  * @param   CDATA           pointer to ciphertext array (multiple of block size, 16 bytes)
  * @param   CDATALength     length of ciphertext array
@@ -553,30 +259,124 @@ bool OTAES128GCMGenericBase::gcmEncryptPadded(
  * @param   ADATALength     length of additional data
  * @param   PDATA           buffer to output plaintext to; must be same length as CDATA
  * @retval  true if decryption and authentication successful, else false
+ *
+ * The tag is checked before any decryption, and PDATA is only written
+ * if it matches, so a rejected message of n blocks costs 1 block encryption
+ * (E(K, J0)) rather than n+1.
  */
-bool OTAES128GCMGenericBase::gcmDecrypt(
-                        const uint8_t* key, const uint8_t* IV,
-                        const uint8_t* CDATA, uint8_t CDATALength,
-                        const uint8_t* ADATA, uint8_t ADATALength,
+bool OTAES128GCMKeyedBase::gcmDecrypt(
+                        const uint8_t* IV,
+                        const uint8_t* CDATA, const size_t CDATALength,
+                        const uint8_t* ADATA, const size_t ADATALength,
+                        const uint8_t* messageTag, uint8_t *PDATA)
+{
+    return(decryptWithPrefix(NULL, IV, CDATA, CDATALength, ADATA, ADATALength, messageTag, PDATA));
+}
+
+/**
+ * @brief   performs AES-GCM decryption and authentication under the retained key,
+ *          with ADATA of a precomputed prefix followed by ADATASuffix.
+ * @param   prefix          from computeADATAPrefix() under the current key
+ * @retval  true if decryption and authentication successful, else false
+ *
+ * Other parameters as for gcmDecrypt(), with the ADATA suffix for ADATA.
+ */
+bool OTAES128GCMKeyedBase::gcmDecrypt(
+                        const GCMADATAPrefix &prefix,
+                        const uint8_t* IV,
+                        const uint8_t* CDATA, const size_t CDATALength,
+                        const uint8_t* ADATASuffix, const size_t ADATASuffixLength,
                         const uint8_t* messageTag, uint8_t *PDATA)
 {
+    return(decryptWithPrefix(&prefix, IV, CDATA, CDATALength, ADATASuffix, ADATASuffixLength, messageTag, PDATA));
+}
+
+// As for gcmDecrypt(), with an optional ADATA prefix; NULL if none.
+bool OTAES128GCMKeyedBase::decryptWithPrefix(
+                        const GCMADATAPrefix *const prefix,
+                        const uint8_t* IV,
+                        const uint8_t* CDATA, const size_t CDATALength,
+                        const uint8_t* ADATA, const size_t ADATASuffixLength,
+                        const uint8_t* messageTag, uint8_t *PDATA)
+{
+    if(!keySet) { return(false); }
+    // Whole ADATA length, including any prefix.
+    const size_t ADATALength = ADATASuffixLength + ((NULL == prefix) ? 0 : prefix->length);
+    if(ADATALength < ADATASuffixLength) { return(false); } // Too big.
+    if((uint64_t)CDATALength > GCM_MAX_TEXT_LENGTH) { return(false); } // Too big.
+
     // Check if there is input data.
     // Fail if there is nothing to decrypt and/or authenticate.
     if((CDATALength == 0) && (ADATALength == 0)) { return(false); }
 
     // Fail if the CDATA length is not a multiple of the block size.
     if(0 != (CDATALength & (AES128GCM_BLOCK_SIZE-1))) { return(false); }
-    GGBWS::GCMDecryptWorkspace &workspace = getGCMDecryptWorkspace();
 
-    // Decrypt CDATA.
-    generateAuthKey(ap, key, workspace.authKey);
+    const GGBWS::GCMKeyState &keyState = getGCMKeyState();
+    GGBWS::GCMKeyedWorkspace &workspace = getGCMKeyedWorkspace();
+
     generateICB(IV, workspace.ICB);
 
-    // ICB is hashed with the key then XORed with CDATA to decrypt cipher text.
-    generateCDATAPadded(ap, &workspace.cdataWorkspace, workspace.ICB, CDATA, CDATALength, PDATA, key);
+    // Authenticate first, from the cipher text.
+    if(NULL == prefix) { startTag(gp, &workspace.tagWorkspace, ADATA, ADATALength); }
+    else { startTagWithPrefix(gp, &workspace.tagWorkspace, *prefix, ADATA, ADATASuffixLength); }
+    GHASH(gp, workspace.tagWorkspace.lengthBuffer, CDATA, CDATALength, workspace.tagWorkspace.S);
+    finishTag(ap, gp, &workspace.tagWorkspace, keyState.key, ADATALength, CDATALength, workspace.calculatedTag, workspace.ICB);
+    const bool success = (0 == checkTag(workspace.calculatedTag, messageTag));
+
+    // Decrypt CDATA only if authentic.
+    if(success) { generateCDATAPadded(ap, &workspace.cdataWorkspace, workspace.ICB, CDATA, CDATALength, PDATA, keyState.key); }
+
+    // Erase workspace for security.
+    memset(&workspace, 0, sizeof(workspace));
+
+    return(success);
+}
+
+/**
+ * @brief   computes a GMAC (authentication-only) tag under the retained key.
+ * @param   IV              pointer to 12 byte (96 bit) IV; never NULL
+ * @param   ADATA           pointer to additional data array; never NULL
+ * @param   ADATALength     length of additional data in bytes, non-zero
+ * @param   tag             pointer to 16 byte tag output buffer; never NULL
+ * @retval  true if successful, else false
+ */
+bool OTAES128GCMKeyedBase::gmacCompute(const uint8_t *const IV,
+                        const uint8_t *const ADATA, const size_t ADATALength,
+                        uint8_t *const tag)
+{
+    if(!keySet) { return(false); }
+    if(0 == ADATALength) { return(false); } // Nothing to authenticate.
+    if((uint64_t)ADATALength > GCM_MAX_ADATA_LENGTH) { return(false); } // Too big.
 
-    // Authenticate and return true if tag matches.
-    generateTag(ap, &workspace.tagWorkspace, key, workspace.authKey, ADATA, ADATALength, CDATA, CDATALength, workspace.calculatedTag, workspace.ICB);
+    const GGBWS::GCMKeyState &keyState = getGCMKeyState();
+    GGBWS::GCMKeyedWorkspace &workspace = getGCMKeyedWorkspace();
+    gmacTag(ap, gp, workspace.tagWorkspace.S, workspace.tagWorkspace.lengthBuffer, keyState.key, IV, ADATA, ADATALength, tag);
+
+    // Erase workspace for security.
+    memset(&workspace, 0, sizeof(workspace));
+
+    return(true);
+}
+
+/**
+ * @brief   verifies a GMAC (authentication-only) tag under the retained key.
+ * @param   messageTag      pointer to 16 byte received tag; never NULL
+ * @retval  true iff ADATA is authentic
+ *
+ * Other parameters as for gmacCompute().
+ */
+bool OTAES128GCMKeyedBase::gmacVerify(const uint8_t *const IV,
+                        const uint8_t *const ADATA, const size_t ADATALength,
+                        const uint8_t *const messageTag)
+{
+    if(!keySet) { return(false); }
+    if(0 == ADATALength) { return(false); } // Nothing to authenticate.
+    if((uint64_t)ADATALength > GCM_MAX_ADATA_LENGTH) { return(false); } // Too big.
+
+    const GGBWS::GCMKeyState &keyState = getGCMKeyState();
+    GGBWS::GCMKeyedWorkspace &workspace = getGCMKeyedWorkspace();
+    gmacTag(ap, gp, workspace.tagWorkspace.S, workspace.tagWorkspace.lengthBuffer, keyState.key, IV, ADATA, ADATALength, workspace.calculatedTag);
     const bool success = (0 == checkTag(workspace.calculatedTag, messageTag));
 
     // Erase workspace for security.
@@ -585,6 +385,464 @@ bool OTAES128GCMGenericBase::gcmDecrypt(
     return(success);
 }
 
+/**
+ * @brief   hashes a constant ADATA prefix once under the retained key
+ * @param   ADATAPrefix     pointer to the leading part of ADATA shared by many messages;
+ *                          NULL if length 0
+ * @param   length          prefix length in bytes, can be zero
+ * @param   prefix          filled in with the GHASH state after the prefix
+ * @retval  true if successful, false if no key is set or the prefix is too long
+ */
+bool OTAES128GCMKeyedBase::computeADATAPrefix(const uint8_t *const ADATAPrefix, const size_t length, GCMADATAPrefix &prefix)
+{
+    if(!keySet) { return(false); }
+    if((uint64_t)length > GCM_MAX_ADATA_LENGTH) { return(false); } // Too big.
+    absorbADATAPrefix(gp, ADATAPrefix, length, prefix);
+    return(true);
+}
+
+/**
+ * @brief   performs AES-GCM encryption on a batch of padded messages under the retained key.
+ * @param   frames          array of nFrames message descriptors
+ * @param   nFrames         number of messages, can be zero
+ * @retval  true if all were encrypted, else false (and none are)
+ *
+ * Each message in flight has a lane in the batch workspace.
+ * Each step encrypts the next counter block of every lane in one
+ * blocksEncrypt() call, and each lane's cipher text is hashed
+ * FUSED_CHUNK_BLOCKS at a time.
+ * As a message completes its tag is finished and the last lane moved down
+ * into its place, then free lanes are refilled from the batch.
+ */
+bool OTAES128GCMKeyedBase::gcmEncryptPaddedBatch(const GCMEncryptPaddedFrame *const frames, const size_t nFrames)
+{
+    if(!keySet) { return(false); }
+    GGBWS::GCMBatchWorkspace *const ws = getGCMBatchWorkspace();
+    if(NULL == ws) { return(false); }
+    if((0 != nFrames) && (NULL == frames)) { return(false); }
+
+    // Check every frame before starting so that a bad batch does nothing.
+    for(size_t i = 0; i < nFrames; ++i)
+        {
+        const GCMEncryptPaddedFrame &f = frames[i];
+        if((NULL == f.IV) || (NULL == f.CDATA) || (NULL == f.tag)) { return(false); }
+        if(0 != (f.PDATALength & (AES128GCM_BLOCK_SIZE-1))) { return(false); } // Reject non-padded data.
+        if((uint64_t)f.PDATALength > GCM_MAX_TEXT_LENGTH) { return(false); } // Too big.
+        if((0 != f.PDATALength) && (NULL == f.PDATAPadded)) { return(false); }
+        if((0 != f.ADATALength) && (NULL == f.ADATA)) { return(false); }
+        // Fail if there is nothing to encrypt and/or authenticate.
+        if((f.PDATALength == 0) && (f.ADATALength == 0)) { return(false); }
+        }
+
+    const uint8_t *const key = getGCMKeyState().key;
+    constexpr uint8_t lanes = GGBWS::GCM_BATCH_LANES;
+    // Message index, and blocks encrypted and hashed so far, for each lane.
+    size_t laneFrame[lanes], laneDone[lanes], laneHashed[lanes];
+    uint8_t active = 0;
+    size_t next = 0;
+    for( ; ; )
+        {
+        // Fill free lanes from the batch.
+        for( ; (active < lanes) && (next < nFrames); ++active, ++next)
+            {
+            const GCMEncryptPaddedFrame &f = frames[next];
+            startTag(gp, &ws->lanes[active], f.ADATA, f.ADATALength);
+            generateICB(f.IV, ws->lanes[active].ctrBlock);
+            incr32(ws->lanes[active].ctrBlock);
+            laneFrame[active] = next;
+            laneDone[active] = 0;
+            laneHashed[active] = 0;
+            }
+
+        // Finish any messages with all their text encrypted.
+        bool retired = false;
+        for(uint8_t i = 0; i < active; )
+            {
+            const GCMEncryptPaddedFrame &f = frames[laneFrame[i]];
+            if(laneDone[i] < f.PDATALength / AES128GCM_BLOCK_SIZE) { ++i; continue; }
+            gp->ghashBlocks(ws->lanes[i].S, f.CDATA + AES128GCM_BLOCK_SIZE * laneHashed[i], laneDone[i] - laneHashed[i]);
+            generateICB(f.IV, ws->ICB);
+            finishTag(ap, gp, &ws->lanes[i], key, f.ADATALength, f.PDATALength, f.tag, ws->ICB);
+            // Move the last lane down into the gap.
+            if(i != --active)
+                {
+                memcpy(&ws->lanes[i], &ws->lanes[active], sizeof(ws->lanes[i]));
+                laneFrame[i] = laneFrame[active];
+                laneDone[i] = laneDone[active];
+                laneHashed[i] = laneHashed[active];
+                }
+            retired = true;
+            }
+        if(retired) { continue; }
+        if(0 == active) { break; }
+
+        // Encrypt the next counter block of each lane together.
+        for(uint8_t i = 0; i < active; ++i)
+            {
+            memcpy(ws->keyStream + AES128GCM_BLOCK_SIZE * i, ws->lanes[i].ctrBlock, AES128GCM_BLOCK_SIZE);
+            incr32(ws->lanes[i].ctrBlock);
+            }
+        ap->blocksEncrypt(ws->keyStream, active, key, ws->keyStream);
+        for(uint8_t i = 0; i < active; ++i)
+            {
+            const GCMEncryptPaddedFrame &f = frames[laneFrame[i]];
+            const size_t offset = AES128GCM_BLOCK_SIZE * laneDone[i];
+            const uint8_t *const ks = ws->keyStream + AES128GCM_BLOCK_SIZE * i;
+            for(uint8_t j = 0; j < AES128GCM_BLOCK_SIZE; ++j)
+                { f.CDATA[offset + j] = f.PDATAPadded[offset + j] ^ ks[j]; }
+            // Hash a whole chunk of cipher text while still in cache.
+            if(++laneDone[i] - laneHashed[i] == FUSED_CHUNK_BLOCKS)
+                {
+                gp->ghashBlocks(ws->lanes[i].S, f.CDATA + AES128GCM_BLOCK_SIZE * laneHashed[i], FUSED_CHUNK_BLOCKS);
+                laneHashed[i] = laneDone[i];
+                }
+            }
+        }
+
+    // Erase workspace for security.
+    memset(ws, 0, sizeof(GGBWS::GCMBatchWorkspace));
+    return(true);
+}
+
+/**
+ * @brief   authenticates and decrypts up to MaxFrames messages, each under its own key
+ * @param   frames          array of nFrames message descriptors
+ * @param   nFrames         number of messages, at most MaxFrames
+ * @retval  bitmap of the messages successfully authenticated and decrypted
+ *
+ * Message i is in lane i of the multi-key AES implementation:
+ *   * H and E(K, J0) for all lanes take one lanesEncrypt() call each.
+ *   * Each message is then authenticated in turn, rekeying the GHASH.
+ *   * The authentic messages are decrypted together,
+ *     one counter block per lane per lanesEncrypt() call.
+ */
+uint8_t OTAES128GCMMultiKeyDecryptBase::gcmDecryptMultiKey(const GCMDecryptFrame *const frames, const uint8_t nFrames)
+{
+    if(!isWorkspaceOK()) { return(0); }
+    if((NULL == frames) || (nFrames > MaxFrames)) { return(0); }
+    GGBWS::GCMMultiKeyWorkspace &ws = getGCMMultiKeyWorkspace();
+
+    // Find the valid messages and set up their lanes.
+    uint8_t valid = 0;
+    for(uint8_t i = 0; i < nFrames; ++i)
+        {
+        const GCMDecryptFrame &f = frames[i];
+        if((NULL == f.key) || (NULL == f.IV) || (NULL == f.messageTag)) { continue; }
+        if(0 != (f.CDATALength & (AES128GCM_BLOCK_SIZE-1))) { continue; }
+        if((uint64_t)f.CDATALength > GCM_MAX_TEXT_LENGTH) { continue; } // Too big.
+        if((0 != f.CDATALength) && ((NULL == f.CDATA) || (NULL == f.PDATA))) { continue; }
+        if((0 != f.ADATALength) && (NULL == f.ADATA)) { continue; }
+        // Fail if there is nothing to decrypt and/or authenticate.
+        if((f.CDATALength == 0) && (f.ADATALength == 0)) { continue; }
+        mp->setLaneKey(i, f.key);
+        valid |= (uint8_t)(1U << i);
+        }
+    if(0 == valid) { return(0); }
+
+    // H = E(K, 0^128) for all lanes together, then E(K, J0).
+    memset(ws.blocks, 0, sizeof(ws.blocks));
+    mp->lanesEncrypt(ws.blocks, valid, ws.authKeys);
+    for(uint8_t i = 0; i < nFrames; ++i)
+        { if(0 != (valid & (1U << i))) { generateICB(frames[i].IV, ws.blocks + AES128GCM_BLOCK_SIZE * i); } }
+    mp->lanesEncrypt(ws.blocks, valid, ws.ctrBlocks);
+
+    // Authenticate every message before decrypting any.
+    uint8_t authentic = 0;
+    size_t maxBlocks = 0;
+    for(uint8_t i = 0; i < nFrames; ++i)
+        {
+        if(0 == (valid & (1U << i))) { continue; }
+        const GCMDecryptFrame &f = frames[i];
+        GGBWS::GenerateTagWorkspace *const tws = &ws.tagWorkspace;
+        // Short messages need few powers of H, if the GHASH precomputes them.
+        const size_t aBlocks = f.ADATALength / AES128GCM_BLOCK_SIZE, cBlocks = f.CDATALength / AES128GCM_BLOCK_SIZE;
+        gp->setAuthKeyForBlocks(ws.authKeys + AES128GCM_BLOCK_SIZE * i, (aBlocks > cBlocks) ? aBlocks : cBlocks);
+        startTag(gp, tws, f.ADATA, f.ADATALength);
+        GHASH(gp, tws->lengthBuffer, f.CDATA, f.CDATALength, tws->S);
+        putBitLength(tws->lengthBuffer, f.ADATALength);
+        putBitLength(tws->lengthBuffer + 8, f.CDATALength);
+        gp->ghashBlocks(tws->S, tws->lengthBuffer, 1);
+        // T = E(K, J0) XOR S.
+        xorBlock(tws->S, ws.ctrBlocks + AES128GCM_BLOCK_SIZE * i);
+        if(0 != checkTag(tws->S, f.messageTag)) { continue; }
+        authentic |= (uint8_t)(1U << i);
+        const size_t n = f.CDATALength / AES128GCM_BLOCK_SIZE;
+        if(n > maxBlocks) { maxBlocks = n; }
+        }
+
+    // Decrypt the authentic messages together.
+    for(uint8_t i = 0; i < nFrames; ++i)
+        {
+        if(0 == (authentic & (1U << i))) { continue; }
+        uint8_t *const ctr = ws.ctrBlocks + AES128GCM_BLOCK_SIZE * i;
+        generateICB(frames[i].IV, ctr);
+        incr32(ctr);
+        }
+    for(size_t b = 0; b < maxBlocks; ++b)
+        {
+        // Lanes with text still to decrypt.
+        uint8_t active = 0;
+        for(uint8_t i = 0; i < nFrames; ++i)
+            {
+            if((0 != (authentic & (1U << i))) && (b < frames[i].CDATALength / AES128GCM_BLOCK_SIZE))
+                { active |= (uint8_t)(1U << i); }
+            }
+        mp->lanesEncrypt(ws.ctrBlocks, active, ws.blocks);
+        for(uint8_t i = 0; i < nFrames; ++i)
+            {
+            if(0 == (active & (1U << i))) { continue; }
+            const GCMDecryptFrame &f = frames[i];
+            const size_t offset = AES128GCM_BLOCK_SIZE * b;
+            const uint8_t *const ks = ws.blocks + AES128GCM_BLOCK_SIZE * i;
+            for(uint8_t j = 0; j < AES128GCM_BLOCK_SIZE; ++j)
+                { f.PDATA[offset + j] = f.CDATA[offset + j] ^ ks[j]; }
+            incr32(ws.ctrBlocks + AES128GCM_BLOCK_SIZE * i);
+            }
+        }
+
+    // Erase workspace for security.
+    mp->clearLaneKeys();
+    gp->clearAuthKey();
+    memset(&ws, 0, sizeof(ws));
+    return(authentic);
+}
+
+// Phases of a streamed message, ie which calls are allowed next.
+static constexpr uint8_t STREAM_IDLE = 0; // Only init().
+static constexpr uint8_t STREAM_ADATA = 1; // aad(), either update, finalize() or verify().
+static constexpr uint8_t STREAM_ENCRYPT = 2; // encryptUpdate() or finalize().
+static constexpr uint8_t STREAM_DECRYPT = 3; // decryptUpdate() or verify().
+
+/**
+ * @brief   starts a streamed message, retaining the key schedule and H
+ * @param   key             pointer to 16 byte (128 bit) key; copied
+ * @param   IV              pointer to 12 byte (96 bit) IV
+ * @retval  true if successful, false if an argument is NULL or workspace too small
+ */
+bool OTAES128GCMStreamBase::init(const uint8_t *key, const uint8_t *IV)
+{
+    clear();
+    if((NULL == key) || (NULL == IV) || !isWorkspaceOK()) { return(false); }
+
+    GGBWS::GCMStreamState &state = getGCMStreamState();
+
+    // Keep a private copy of the key so the caller's may be discarded,
+    // and have the AES implementation retain its schedule for it.
+    memcpy(state.key, key, AES128GCM_BLOCK_SIZE);
+    ap->retainKeySchedule(state.key);
+    generateAuthKey(ap, state.key, state.authKey);
+    gp->setAuthKey(state.authKey);
+
+    generateICB(IV, state.ICB);
+    memcpy(state.ctrBlock, state.ICB, AES128GCM_BLOCK_SIZE);
+    incr32(state.ctrBlock);
+
+    phase = STREAM_ADATA;
+    return(true);
+}
+
+/**
+ * @brief   hashes the next chunk of additional data
+ * @param   ADATA           pointer to additional data; NULL only if length 0
+ * @param   ADATALength     length of additional data chunk, can be zero
+ * @retval  true if successful, false if out of order or too long in total
+ */
+bool OTAES128GCMStreamBase::aad(const uint8_t *ADATA, size_t ADATALength)
+{
+    if(!isWorkspaceOK()) { return(false); }
+    GGBWS::GCMStreamState &state = getGCMStreamState();
+    if((STREAM_ADATA != phase) ||
+       ((0 != ADATALength) && (NULL == ADATA)) ||
+       ((uint64_t)ADATALength > GCM_MAX_ADATA_LENGTH - totalADATALength))
+        { clear(); return(false); }
+
+    uint8_t used = (uint8_t)(totalADATALength & (AES128GCM_BLOCK_SIZE-1));
+    totalADATALength += ADATALength;
+    // Fill any partial block first.
+    if(0 != used)
+        {
+        while((ADATALength > 0) && (used < AES128GCM_BLOCK_SIZE))
+            { state.partial[used++] = *ADATA++; --ADATALength; }
+        if(used < AES128GCM_BLOCK_SIZE) { return(true); }
+        gp->ghashBlocks(state.S, state.partial, 1);
+        }
+    // Hash whole blocks straight from the input.
+    const size_t m = ADATALength / AES128GCM_BLOCK_SIZE;
+    gp->ghashBlocks(state.S, ADATA, m);
+    ADATA += m * AES128GCM_BLOCK_SIZE;
+    ADATALength -= m * AES128GCM_BLOCK_SIZE;
+    // Keep any tail for next time.
+    memcpy(state.partial, ADATA, ADATALength);
+    return(true);
+}
+
+/**
+ * @brief   hashes any partial additional data block, zero padded
+ */
+void OTAES128GCMStreamBase::finishADATA(GGBWS::GCMStreamState &state)
+{
+    const uint8_t used = (uint8_t)(totalADATALength & (AES128GCM_BLOCK_SIZE-1));
+    if(0 != used)
+        {
+        memset(state.partial + used, 0, AES128GCM_BLOCK_SIZE - used);
+        gp->ghashBlocks(state.S, state.partial, 1);
+        }
+}
+
+/**
+ * @brief   encrypts or decrypts the next chunk of text, hashing the cipher text
+ * @param   in              pointer to input text; NULL only if length 0
+ * @param   length          length of input chunk, can be zero
+ * @param   out             pointer to output, same length as input;
+ *                          may be the same as in
+ * @param   decrypting      true if in is cipher text, else plain text
+ * @retval  true if successful, false if out of order or too long in total
+ *
+ * Whole blocks are processed in chunks so that the cipher text
+ * is hashed while still in cache,
+ * each chunk with a single ctrEncrypt() call unless working in place.
+ */
+bool OTAES128GCMStreamBase::update(const uint8_t *in, size_t length, uint8_t *out, const bool decrypting)
+{
+    if(!isWorkspaceOK()) { return(false); }
+    GGBWS::GCMStreamState &state = getGCMStreamState();
+    const uint8_t textPhase = decrypting ? STREAM_DECRYPT : STREAM_ENCRYPT;
+    if(((STREAM_ADATA != phase) && (textPhase != phase)) ||
+       ((0 != length) && ((NULL == in) || (NULL == out))) ||
+       ((uint64_t)length > GCM_MAX_TEXT_LENGTH - totalTextLength))
+        { clear(); return(false); }
+    if(STREAM_ADATA == phase) { finishADATA(state); phase = textPhase; }
+
+    uint8_t used = (uint8_t)(totalTextLength & (AES128GCM_BLOCK_SIZE-1));
+    totalTextLength += length;
+    // Use up the key stream of any partial block first.
+    if(0 != used)
+        {
+        while((length > 0) && (used < AES128GCM_BLOCK_SIZE))
+            {
+            const uint8_t c = *in++;
+            const uint8_t r = c ^ state.keyStream[used];
+            state.partial[used++] = decrypting ? c : r;
+            *out++ = r;
+            --length;
+            }
+        if(used < AES128GCM_BLOCK_SIZE) { return(true); }
+        gp->ghashBlocks(state.S, state.partial, 1);
+        }
+    // Whole blocks.
+    while(length >= AES128GCM_BLOCK_SIZE)
+        {
+        size_t n = length / AES128GCM_BLOCK_SIZE;
+        if(n > FUSED_CHUNK_BLOCKS) { n = FUSED_CHUNK_BLOCKS; }
+        // Hash cipher text input before it may be overwritten.
+        if(decrypting) { gp->ghashBlocks(state.S, in, n); }
+        const size_t chunkLength = n * AES128GCM_BLOCK_SIZE;
+        if(in != out)
+            {
+            // One CTR call for the chunk, so that multi-block AES paths are used.
+            ap->ctrEncrypt(state.ctrBlock, in, n, state.key, out);
+            }
+        else
+            {
+            // In place: ctrEncrypt() may not overlap, so use one key stream block at a time.
+            for(size_t i = 0; i < chunkLength; i += AES128GCM_BLOCK_SIZE)
+                {
+                ap->blockEncrypt(state.ctrBlock, state.key, state.keyStream);
+                incr32(state.ctrBlock);
+                xorBlock(out + i, state.keyStream);
+                }
+            }
+        if(!decrypting) { gp->ghashBlocks(state.S, out, n); }
+        in += chunkLength;
+        out += chunkLength;
+        length -= chunkLength;
+        }
+    // Start a partial block with any tail.
+    if(length > 0)
+        {
+        ap->blockEncrypt(state.ctrBlock, state.key, state.keyStream);
+        incr32(state.ctrBlock);
+        for(uint8_t j = 0; j < length; ++j)
+            {
+            const uint8_t c = *in++;
+            const uint8_t r = c ^ state.keyStream[j];
+            state.partial[j] = decrypting ? c : r;
+            *out++ = r;
+            }
+        }
+    return(true);
+}
+
+/**
+ * @brief   finishes the hash and computes the tag into keyStream
+ * @param   expectedPhase   STREAM_ENCRYPT or STREAM_DECRYPT, as expected by the caller
+ * @retval  true if successful, false if out of order
+ */
+bool OTAES128GCMStreamBase::computeTag(const uint8_t expectedPhase)
+{
+    if(!isWorkspaceOK()) { return(false); }
+    GGBWS::GCMStreamState &state = getGCMStreamState();
+    if((STREAM_ADATA != phase) && (expectedPhase != phase)) { return(false); }
+    if(STREAM_ADATA == phase) { finishADATA(state); }
+
+    // Hash any partial cipher text block, zero padded.
+    const uint8_t used = (uint8_t)(totalTextLength & (AES128GCM_BLOCK_SIZE-1));
+    if(0 != used)
+        {
+        memset(state.partial + used, 0, AES128GCM_BLOCK_SIZE - used);
+        gp->ghashBlocks(state.S, state.partial, 1);
+        }
+    // Hash [len(A)]64 || [len(C)]64.
+    putBitLength(state.partial, totalADATALength);
+    putBitLength(state.partial + 8, totalTextLength);
+    gp->ghashBlocks(state.S, state.partial, 1);
+
+    // T = E(K, J0) XOR S.
+    ap->blockEncrypt(state.ICB, state.key, state.keyStream);
+    xorBlock(state.keyStream, state.S);
+    return(true);
+}
+
+/**
+ * @brief   finishes an encryption, writing the tag and wiping state
+ * @param   tag             pointer to 16 byte tag output buffer; never NULL
+ * @retval  true if successful, false if out of order
+ */
+bool OTAES128GCMStreamBase::finalize(uint8_t *tag)
+{
+    const bool success = (NULL != tag) && computeTag(STREAM_ENCRYPT);
+    if(success) { memcpy(tag, getGCMStreamState().keyStream, AES128GCM_TAG_SIZE); }
+    clear();
+    return(success);
+}
+
+/**
+ * @brief   finishes a decryption, checking the tag and wiping state
+ * @param   messageTag      pointer to 16 byte received tag; never NULL
+ * @retval  true iff the message is authentic
+ */
+bool OTAES128GCMStreamBase::verify(const uint8_t *messageTag)
+{
+    const bool success = (NULL != messageTag) && computeTag(STREAM_DECRYPT) &&
+        (0 == checkTag(getGCMStreamState().keyStream, messageTag));
+    clear();
+    return(success);
+}
+
+/**
+ * @brief   wipes all message and key state
+ */
+void OTAES128GCMStreamBase::clear()
+{
+    if(!isWorkspaceOK()) { return; }
+    ap->clearKeySchedule();
+    gp->clearAuthKey();
+    memset(&getGCMStreamState(), 0, sizeof(GGBWS::GCMStreamState));
+    totalADATALength = 0;
+    totalTextLength = 0;
+    phase = STREAM_IDLE;
+}
+
 #if defined(OTAESGCM_ALLOW_NON_WORKSPACE)
 // AES-GCM 128-bit-key fixed-size text (256-bit/32-byte) encryption/authentication function.
 // This is an adaptor/bridge function to ease outside use in simple cases
@@ -670,7 +928,7 @@ bool fixed32BTextSize12BNonce16BTagSimpleEnc_DEFAULT_WITH_LWORKSPACE(
         uint8_t *const ciphertextOut, uint8_t *const tagOut)
     {
     if((NULL == key) || (NULL == iv) || (NULL == ciphertextOut) || (NULL == tagOut)) { return(false); } // ERROR
-    typedef OTAES128GCMGenericWithWorkspace<> t;
+    typedef OTAES128GCMEngine<> t;
     if(!t::isWorkspaceSufficientEncPadded(workspace, workspaceSize))
         {
 #if 1 && !defined(ARDUINO_ARCH_AVR)
@@ -686,11 +944,10 @@ bool fixed32BTextSize12BNonce16BTagSimpleEnc_DEFAULT_WITH_LWORKSPACE(
         }
 #endif
     t i(workspace, workspaceSize);
-#if !defined(OTAESGCM_ALLOW_UNPADDED)
-    return(i.gcmEncryptPadded(key, iv, plaintext, (NULL == plaintext) ? 0 : 32, (0 == authtextSize) ? NULL : authtext, authtextSize, ciphertextOut, tagOut));
-#else
-    return(i.gcmEncrypt(key, iv, plaintext, (NULL == plaintext) ? 0 : 32, (0 == authtextSize) ? NULL : authtext, authtextSize, ciphertextOut, tagOut));
-#endif
+    // Both sizes of text take the specialised path.
+    const uint8_t *const a = (0 == authtextSize) ? NULL : authtext;
+    if(NULL == plaintext) { return(i.gcmEncryptFixed<0>(key, iv, NULL, a, authtextSize, ciphertextOut, tagOut)); }
+    return(i.gcmEncryptFixed<32>(key, iv, plaintext, a, authtextSize, ciphertextOut, tagOut));
     }
 
 // AES-GCM 128-bit-key fixed-size text (256-bit/32-byte) decryption/authentication function using work space passed in.
@@ -718,7 +975,7 @@ bool fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_WITH_LWORKSPACE(
         uint8_t *const plaintextOut)
     {
     if((NULL == key) || (NULL == iv) || (NULL == tag) || (NULL == plaintextOut)) { return(false); } // ERROR
-    typedef OTAES128GCMGenericWithWorkspace<> t;
+    typedef OTAES128GCMEngine<> t;
     if(!t::isWorkspaceSufficientDec(workspace, workspaceSize))
         {
 #if 1 && !defined(ARDUINO_ARCH_AVR)
@@ -734,7 +991,10 @@ bool fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_WITH_LWORKSPACE(
 #endif
 
     t i(workspace, workspaceSize);
-    return(i.gcmDecrypt(key, iv, ciphertext, (NULL == ciphertext) ? 0 : 32, (0 == authtextSize) ? NULL : authtext, authtextSize, tag, plaintextOut));
+    // Both sizes of text take the specialised path.
+    const uint8_t *const a = (0 == authtextSize) ? NULL : authtext;
+    if(NULL == ciphertext) { return(i.gcmDecryptFixed<0>(key, iv, NULL, a, authtextSize, tag, plaintextOut)); }
+    return(i.gcmDecryptFixed<32>(key, iv, ciphertext, a, authtextSize, tag, plaintextOut));
     }
 
 
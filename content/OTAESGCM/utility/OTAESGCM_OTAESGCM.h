@@ -25,9 +25,14 @@ Author(s) / Copyright (s): Deniz Erbilgin 2015--2017
 #include <stddef.h>
 #include <stdint.h>
 
+// Get the block size and helpers.
+#include "OTAESGCM_Block.h"
 // Get available AES API and cipher implementations.
 #include "OTAESGCM_OTAES128.h"
 #include "OTAESGCM_OTAES128Impls.h"
+// Get available GHASH API and implementations.
+#include "OTAESGCM_GHASH.h"
+#include "OTAESGCM_GHASHImpls.h"
 
 // IF DEFINED: Allow encryption/decryption functions to take unpadded input.
 // These are disabled by default as original implementation was incorrect,
@@ -45,7 +50,6 @@ Author(s) / Copyright (s): Deniz Erbilgin 2015--2017
 namespace OTAESGCM
     {
 
-static constexpr uint8_t AES128GCM_BLOCK_SIZE = 16; // GCM block size in bytes. This must be the same as the AES block size.
 static constexpr uint8_t AES128GCM_IV_SIZE    = 12; // GCM initialisation size in bytes.
 static constexpr uint8_t AES128GCM_TAG_SIZE   = 16; // GCM authentication tag size in bytes.
 
@@ -148,7 +152,8 @@ static constexpr uint8_t AES128GCM_TAG_SIZE   = 16; // GCM authentication tag si
              * @param    ADATA           pointer to additional data array
              * @param    ADATALength     length of additional data
              * @param    PDATA           buffer to output plaintext to;
-             *                           must be same length as CDATA
+             *                           must be same length as CDATA;
+             *                           not written to unless authentication succeeds
              * @retval   true if decryption and authentication successful,
              *           else false
              */
@@ -174,16 +179,6 @@ static constexpr uint8_t AES128GCM_TAG_SIZE   = 16; // GCM authentication tag si
     // allows more visibility and (potentially) control.
     namespace GGBWS
     {
-        /**
-         * @struct  Bulk of GHASH() workspace.
-         * @note    32 bytes for AES128.
-         * */
-        struct GHASHWorkspace final
-        {
-            uint8_t ghashTmp[AES128GCM_BLOCK_SIZE]; // If using full blocks, no need for tmp.
-            uint8_t gFieldMultiplyTmp[AES128GCM_BLOCK_SIZE]; // If using full blocks, no need for tmp.
-        };
-
         /**
          * @struct  Bulk of GCTR() workspace.
          * @note    32 bytes for AES128.
@@ -223,23 +218,26 @@ static constexpr uint8_t AES128GCM_TAG_SIZE   = 16; // GCM authentication tag si
         };
         /**
          * @struct  Bulk of generateTag() workspace.
-         * @note    64 = 16 + 32 + 16 bytes.
+         * @note    32 = 16 + 16 bytes.
+         * The GHASH implementation carries its own workspace.
          */
         struct GenerateTagWorkspace final
         {
             uint8_t S[AES128GCM_BLOCK_SIZE];
-            GHASHWorkspace ghashSpace;
-            // lengthBuffer and gctrSpace are/contain 16 byte uint8_t arrays
+            // lengthBuffer (also used to pad partial blocks for GHASH),
+            // ctrBlock (for fused encryption and hashing)
+            // and gctrSpace are/contain 16 byte uint8_t arrays
             // and are not used simultaneously.
             union
             {
                 uint8_t lengthBuffer[16];
+                uint8_t ctrBlock[AES128GCM_BLOCK_SIZE];
                 GCTRPaddedWorkspace gctrSpace;
             };
         };
         /**
          * @struct  Bulk of gcmEncrypt() workspace
-         * @note    96 = 16 + 16 + 64 bytes.
+         * @note    80 = 16 + 16 + 48 bytes.
          */
         struct GCMEncryptWorkspace final
         {
@@ -254,7 +252,7 @@ static constexpr uint8_t AES128GCM_TAG_SIZE   = 16; // GCM authentication tag si
         };
         /**
          * @struct  Bulk of generateCDATA() workspace
-         * @note    96 = 16 + 16 + 64 bytes.
+         * @note    64 = 16 + 16 + 32 bytes.
          */
         struct GCMEncryptPaddedWorkspace final
         {
@@ -269,7 +267,7 @@ static constexpr uint8_t AES128GCM_TAG_SIZE   = 16; // GCM authentication tag si
         };
         /**
          * @struct  Bulk of generateCDATA() workspace
-         * @note    112 = 16 + 16 + 16 + 64 bytes.
+         * @note    80 = 16 + 16 + 16 + 32 bytes.
          */
         struct GCMDecryptWorkspace final
         {
@@ -284,33 +282,147 @@ static constexpr uint8_t AES128GCM_TAG_SIZE   = 16; // GCM authentication tag si
             };
         };
 
+        /**
+         * @struct  Key-dependent state retained by OTAES128GCMKeyedBase.
+         * @note    32 = 16 + 16 bytes.
+         */
+        struct GCMKeyState final
+        {
+            uint8_t key[AES128GCM_BLOCK_SIZE]; // Private copy of the AES key.
+            uint8_t authKey[AES128GCM_BLOCK_SIZE]; // Hash subkey H.
+        };
+        /**
+         * @struct  Bulk of OTAES128GCMKeyedBase per-message workspace.
+         * @note    64 = 16 + 16 + 32 bytes.
+         */
+        struct GCMKeyedWorkspace final
+        {
+            uint8_t ICB[AES128GCM_BLOCK_SIZE];
+            uint8_t calculatedTag[AES128GCM_TAG_SIZE];
+            // generateCDATA and generateTag are called separately
+            // and so their workspaces can be a union.
+            union {
+                GenCDATAPaddedWorkspace cdataWorkspace;
+                GenerateTagWorkspace tagWorkspace;
+            };
+        };
+
+        // Number of messages encrypted together by OTAES128GCMKeyedBase::gcmEncryptPaddedBatch().
+        static constexpr uint8_t GCM_BATCH_LANES = 8;
+        /**
+         * @struct  Bulk of OTAES128GCMKeyedBase::gcmEncryptPaddedBatch() workspace.
+         * @note    400 = 8 * 32 + 8 * 16 + 16 bytes.
+         */
+        struct GCMBatchWorkspace final
+        {
+            // Running hash S and next counter block for each message in flight.
+            GenerateTagWorkspace lanes[GCM_BATCH_LANES];
+            // One counter block, then key stream block, per lane.
+            uint8_t keyStream[GCM_BATCH_LANES * AES128GCM_BLOCK_SIZE];
+            uint8_t ICB[AES128GCM_BLOCK_SIZE];
+        };
+
+        /**
+         * @struct  Bulk of OTAES128GCMMultiKeyDecryptBase workspace.
+         * @note    416 = 3 * 8 * 16 + 32 bytes.
+         */
+        struct GCMMultiKeyWorkspace final
+        {
+            // Hash subkey H for each lane.
+            uint8_t authKeys[OTAES128EMultiKey::MaxLanes * AES128GCM_BLOCK_SIZE];
+            // E(K, J0) for each lane, to make the tag,
+            // then the counter block for each lane.
+            uint8_t ctrBlocks[OTAES128EMultiKey::MaxLanes * AES128GCM_BLOCK_SIZE];
+            // Input, then output, block of each lane.
+            uint8_t blocks[OTAES128EMultiKey::MaxLanes * AES128GCM_BLOCK_SIZE];
+            // Running hash S and partial block space for the lane being authenticated.
+            GenerateTagWorkspace tagWorkspace;
+        };
+
+        /**
+         * @struct  State carried between calls by OTAES128GCMStreamBase.
+         * @note    112 = 7 * 16 bytes.
+         */
+        struct GCMStreamState final
+        {
+            uint8_t key[AES128GCM_BLOCK_SIZE]; // Private copy of the AES key.
+            uint8_t authKey[AES128GCM_BLOCK_SIZE]; // Hash subkey H.
+            uint8_t ICB[AES128GCM_BLOCK_SIZE]; // Initial counter block J0, for the tag.
+            uint8_t ctrBlock[AES128GCM_BLOCK_SIZE]; // Next counter block.
+            uint8_t S[AES128GCM_BLOCK_SIZE]; // Running GHASH value.
+            // Partial block of AAD or cipher text not yet hashed,
+            // then the lengths block.
+            uint8_t partial[AES128GCM_BLOCK_SIZE];
+            // Key stream for the current partial block, then the computed tag.
+            uint8_t keyStream[AES128GCM_BLOCK_SIZE];
+        };
+
+        /**
+         * @struct  Bulk of GMAC (authentication-only) workspace.
+         * @note    48 = 16 + 16 + 16 bytes.
+         */
+        struct GMACWorkspace final
+        {
+            uint8_t authKey[AES128GCM_BLOCK_SIZE];
+            uint8_t S[AES128GCM_BLOCK_SIZE];
+            // Pads a partial final block of ADATA for GHASH,
+            // then holds the lengths block, then J0 and E(K, J0).
+            uint8_t block[AES128GCM_BLOCK_SIZE];
+        };
+
         // Workspace required for OTAES128GCMGenericBase functions.
         // All expected to be < 256.
         constexpr static uint8_t gcmEncryptWorkspaceRequired = sizeof(GGBWS::GCMEncryptWorkspace);
         constexpr static uint8_t gcmEncryptPaddedWorkspaceRequired = sizeof(GGBWS::GCMEncryptPaddedWorkspace);
         constexpr static uint8_t gcmDecryptWorkspaceRequired = sizeof(GGBWS::GCMDecryptWorkspace);
+        constexpr static uint8_t gmacWorkspaceRequired = sizeof(GGBWS::GMACWorkspace);
 
         // Compute the minimum and maximum workspace sizes
-        // required or the GCM functions (excluding the underlying AES).
+        // required or the GCM functions (excluding the underlying AES and GHASH).
         constexpr static uint8_t minEncWS =
             (gcmEncryptWorkspaceRequired < gcmEncryptPaddedWorkspaceRequired) ? gcmEncryptWorkspaceRequired : gcmEncryptPaddedWorkspaceRequired;
-        constexpr static uint8_t minWS =
+        constexpr static uint8_t minGCMWS =
             (minEncWS < gcmDecryptWorkspaceRequired) ? minEncWS : gcmDecryptWorkspaceRequired;
+        constexpr static uint8_t minWS =
+            (minGCMWS < gmacWorkspaceRequired) ? minGCMWS : gmacWorkspaceRequired;
         constexpr static uint8_t maxEncWS =
             (gcmEncryptWorkspaceRequired > gcmEncryptPaddedWorkspaceRequired) ? gcmEncryptWorkspaceRequired : gcmEncryptPaddedWorkspaceRequired;
         constexpr static uint8_t maxWS =
             (maxEncWS > gcmDecryptWorkspaceRequired) ? maxEncWS : gcmDecryptWorkspaceRequired;
     }
 
-    // Generic implementation, parameterised with type of underlying AES implementation.
-    // The default AES implementation for the architecture is used unless otherwise specified.
+    // GHASH state after a constant ADATA prefix, computed once per key and prefix
+    // by OTAES128GCMKeyedBase::computeADATAPrefix(), so that each message
+    // need only hash the rest of its ADATA.
+    // Only valid under the key it was computed with: recompute after setKey().
+    // Key-dependent, so should be treated as sensitive, and eg wiped when done.
+    struct GCMADATAPrefix final
+        {
+        uint8_t S[AES128GCM_BLOCK_SIZE]; // Hash of the whole blocks of the prefix.
+        uint8_t tail[AES128GCM_BLOCK_SIZE]; // Any trailing partial block, not yet hashed.
+        size_t length; // Prefix length in bytes.
+        };
+
+    }
+
+// The GCM steps and the devirtualised OTAES128GCMEngine, over the workspaces above.
+#include "OTAESGCM_OTAESGCMEngine.h"
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+
+    // Generic implementation, parameterised with type of underlying AES and GHASH implementations.
+    // The default AES and GHASH implementations for the architecture are used unless otherwise specified.
     // This implementation is not specialised for a particular CPU/MCU for example.
-    // This implementation carries no state beyond that of the AES128 implementation.
+    // This implementation carries no state beyond that of the AES128 and GHASH implementations.
     class OTAES128GCMGenericBase : public OTAES128GCM
         {
         private:
             // Pointer to an AES block encryption implementation instance; never NULL.
             OTAES128E * const ap;
+            // Pointer to a GHASH implementation instance; never NULL.
+            OTGHASH * const gp;
             // Only one is ever needed for any one call,
             // and calls cannot be made concurrently on any one instance.
             // Return appropriate temporary workspace.
@@ -321,10 +433,10 @@ static constexpr uint8_t AES128GCM_TAG_SIZE   = 16; // GCM authentication tag si
             virtual GGBWS::GCMDecryptWorkspace &getGCMDecryptWorkspace() = 0;
 
         public:
-            // Create an instance pointing at a suitable AES block enc/dec implementation.
-            // The AES impl should not carry logical state between operations,
+            // Create an instance pointing at suitable AES block enc/dec and GHASH implementations.
+            // The AES and GHASH impls should not carry logical state between operations,
             // but may hold temporary workspace or non-key/data-dependent state.
-            constexpr OTAES128GCMGenericBase(OTAES128E *aptr) : ap(aptr) { }
+            constexpr OTAES128GCMGenericBase(OTAES128E *aptr, OTGHASH *gptr) : ap(aptr), gp(gptr) { }
 
             // Encrypt; true iff successful.
             // Plain text need not be padded to a block-size multiple.
@@ -361,18 +473,20 @@ static constexpr uint8_t AES128GCM_TAG_SIZE   = 16; // GCM authentication tag si
     // For security, as far as is reasonably possible:
     //   * the OTAESImpl methods should erase private state before returning.
     //   * the gcm function methods should erase private state before returning.
-    template<class OTAESImpl = OTAESGCM::OTAES128E_default_t>
-    class OTAES128GCMGeneric final : OTAESImpl, public OTAES128GCMGenericBase
+    template<class OTAESImpl = OTAESGCM::OTAES128E_default_t, class OTGHASHImpl = OTAESGCM::OTGHASH_default_t>
+    class OTAES128GCMGeneric final : OTAESImpl, OTGHASHImpl, public OTAES128GCMGenericBase
         {
         private:
             // Minimum size of workspace required.
             constexpr static uint8_t workspaceRequiredAES = OTAESImpl::workspaceRequired;
+            constexpr static size_t workspaceRequiredGHASH = OTGHASHImpl::workspaceRequired;
             // Workspace is laid out starting with AES space
             // and followed by the GCM function workspace.
             // Note that we validate at compile time that at least the
             // minimum requirement is met.
             // The other non-minimal functions will need a runtime check.
             uint8_t workspaceAES[workspaceRequiredAES];
+            uint8_t workspaceGHASH[workspaceRequiredGHASH];
 
             // Union of temporary workspaces for the GCM functions.
             // Only one is ever needed for any one call,
@@ -394,82 +508,753 @@ static constexpr uint8_t AES128GCM_TAG_SIZE   = 16; // GCM authentication tag si
 
         public:
             // Construct an instance.
-            constexpr OTAES128GCMGeneric() : OTAESImpl(workspaceAES, workspaceRequiredAES), OTAES128GCMGenericBase(this) { }
+            constexpr OTAES128GCMGeneric()
+              : OTAESImpl(workspaceAES, workspaceRequiredAES),
+                OTGHASHImpl(workspaceGHASH, workspaceRequiredGHASH),
+                OTAES128GCMGenericBase(this, this) { }
         };
 #endif
-    // Generic implementation, parameterised with type of underlying AES implementation.
-    // Carries the AES working state with it.
+    // Generic implementation, parameterised with type of underlying AES and GHASH implementations.
+    // Carries the AES and GHASH working state with it, in the workspace passed in,
+    // laid out as the AES workspace, then the GHASH workspace, then the GCM function workspace.
+    // Eg OTGHASH_fast_t trades more workspace for much faster tag computation.
+    // A thin adaptor presenting OTAES128GCMEngine through the virtual OTAES128GCM interface;
+    // use OTAES128GCMEngine directly where the types are known, to avoid the vtables.
     //
     // For security, as far as is reasonably possible:
     //   * the OTAESImpl methods should erase private state before returning.
-    //   * the gcm function methods should erase private state before returning.
-    template<class OTAESImpl = OTAESGCM::OTAES128E_default_t>
-    class OTAES128GCMGenericWithWorkspace final : OTAESImpl, public OTAES128GCMGenericBase
+    //   * the gcm function methods should erase private state
+    //     (including any GHASH tables) before returning.
+    template<class OTAESImpl = OTAESGCM::OTAES128E_default_t, class OTGHASHImpl = OTAESGCM::OTGHASH_default_t>
+    class OTAES128GCMGenericWithWorkspace final : public OTAES128GCM, private OTAES128GCMEngine<OTAESImpl, OTGHASHImpl>
         {
         private:
-            // GCM workspace part of that passed into to constructor.
+            typedef OTAES128GCMEngine<OTAESImpl, OTGHASHImpl> engine_t;
+
+        public:
+            using engine_t::workspaceRequiredAES;
+            using engine_t::workspaceRequiredGHASH;
+            using typename engine_t::workspacesize_t;
+            using engine_t::workspaceRequiredMin;
+            using engine_t::workspaceRequiredMax;
+            using engine_t::workspaceRequired;
+            using engine_t::isWorkspaceSufficientMin;
+            using engine_t::isWorkspaceSufficient;
+            using engine_t::workspaceRequiredEnc;
+            using engine_t::isWorkspaceSufficientEnc;
+            using engine_t::workspaceRequiredEncPadded;
+            using engine_t::isWorkspaceSufficientEncPadded;
+            using engine_t::workspaceRequiredDec;
+            using engine_t::isWorkspaceSufficientDec;
+            using engine_t::cacheKeySchedule;
+            using engine_t::wipeKeySchedule;
+
+            // Construct an instance, supplied with workspace.
+            // Pass the AES and GHASH support classes the leading parts of the workspace.
+            OTAES128GCMGenericWithWorkspace(uint8_t *const workspace, const workspacesize_t workspaceSize)
+                : engine_t(workspace, workspaceSize) { }
+
+#if defined(OTAESGCM_ALLOW_UNPADDED)
+            virtual bool gcmEncrypt(
+                const uint8_t* key, const uint8_t* IV,
+                const uint8_t* PDATA, uint8_t PDATALength,
+                const uint8_t* ADATA, uint8_t ADATALength,
+                uint8_t* CDATA, uint8_t *tag) override
+                { return(engine_t::gcmEncrypt(key, IV, PDATA, PDATALength, ADATA, ADATALength, CDATA, tag)); }
+#endif
+            virtual bool gcmEncryptPadded(
+                const uint8_t* key, const uint8_t* IV,
+                const uint8_t* PDATAPadded, uint8_t PDATALength,
+                const uint8_t* ADATA, uint8_t ADATALength,
+                uint8_t* CDATA, uint8_t *tag) override
+                { return(engine_t::gcmEncryptPadded(key, IV, PDATAPadded, PDATALength, ADATA, ADATALength, CDATA, tag)); }
+            virtual bool gcmDecrypt(
+                 const uint8_t* key, const uint8_t* IV,
+                 const uint8_t* CDATA, uint8_t CDATALength,
+                 const uint8_t* ADATA, uint8_t ADATALength,
+                 const uint8_t* messageTag, uint8_t *PDATA) override
+                { return(engine_t::gcmDecrypt(key, IV, CDATA, CDATALength, ADATA, ADATALength, messageTag, PDATA)); }
+        };
+
+#if defined(OTAESGCM_HAS_BACKEND_REGISTRY)
+    // AES and GHASH instances constructed from registry entries;
+    // a base of OTAES128GCMRuntimeWithWorkspace so that they exist before OTAES128GCMGenericBase.
+    class OTAES128GCMRuntimeInstances
+        {
+        private:
+            OTAES128EBackendStorage aesStorage;
+            OTGHASHBackendStorage ghashStorage;
+
+        protected:
+            OTAES128E *const aesInstance;
+            OTGHASH *const ghashInstance;
+
+            OTAES128GCMRuntimeInstances(const OTAES128EBackend &aes, const OTGHASHBackend &ghash,
+                    uint8_t *const workspace, const bool workspaceOK)
+              : aesInstance(aes.construct(aesStorage, workspace, workspaceOK ? OTAESGCMBackends::maxWorkspaceRequiredAES : 0)),
+                ghashInstance(ghash.construct(ghashStorage, workspace + OTAESGCMBackends::maxWorkspaceRequiredAES,
+                    workspaceOK ? OTAESGCMBackends::maxWorkspaceRequiredGHASH : 0))
+                { }
+        };
+
+    // AES128-GCM with the AES and GHASH implementations chosen at runtime from the registry,
+    // eg by policy to suit the CPU, or by name to compare them.
+    // Workspace is laid out as for OTAES128GCMGenericWithWorkspace,
+    // with room for the largest AES and GHASH workspace of any registered implementation.
+    // Each call goes through the implementations' vtables;
+    // use OTAES128GCMGenericWithWorkspace where the types are known at compile time.
+    //
+    // For security, as far as is reasonably possible:
+    //   * the AES and GHASH methods erase private state before returning.
+    //   * the gcm function methods erase private state before returning.
+    class OTAES128GCMRuntimeWithWorkspace final : private OTAES128GCMRuntimeInstances, public OTAES128GCMGenericBase
+        {
+        public:
+            // Suitable type to hold size of workspace required.
+            typedef size_t workspacesize_t;
+
+            // Size of workspace required, whichever implementations are chosen.
+            constexpr static workspacesize_t workspaceRequired =
+                OTAESGCMBackends::maxWorkspaceRequiredAES + OTAESGCMBackends::maxWorkspaceRequiredGHASH + GGBWS::maxWS;
+            // Verify that the workspace is adequate.
+            static constexpr bool isWorkspaceSufficient(uint8_t *const workspace, const workspacesize_t workspaceSize)
+                { return((NULL != workspace) && (workspaceSize >= workspaceRequired)); }
+
+        private:
+            // GCM function part of the workspace passed into the constructor.
             uint8_t *const gcmWorkspace;
+            const bool workspaceOK;
+            // The registry entries in use.
+            const OTAES128EBackend &aesBackend;
+            const OTGHASHBackend &ghashBackend;
 
-            // Return appropriate temporary workspace.
 #if defined(OTAESGCM_ALLOW_UNPADDED)
-            virtual GGBWS::GCMEncryptWorkspace &getGCMEncryptWorkspace() override { return(*(GGBWS::GCMEncryptWorkspace *)(gcmWorkspace)); }
+            virtual GGBWS::GCMEncryptWorkspace &getGCMEncryptWorkspace() override { return(*(GGBWS::GCMEncryptWorkspace *)gcmWorkspace); }
 #endif
-            virtual GGBWS::GCMEncryptPaddedWorkspace &getGCMEncryptPaddedWorkspace() override { return(*(GGBWS::GCMEncryptPaddedWorkspace *)(gcmWorkspace)); }
-            virtual GGBWS::GCMDecryptWorkspace &getGCMDecryptWorkspace() override { return(*(GGBWS::GCMDecryptWorkspace *)(gcmWorkspace)); }
+            virtual GGBWS::GCMEncryptPaddedWorkspace &getGCMEncryptPaddedWorkspace() override { return(*(GGBWS::GCMEncryptPaddedWorkspace *)gcmWorkspace); }
+            virtual GGBWS::GCMDecryptWorkspace &getGCMDecryptWorkspace() override { return(*(GGBWS::GCMDecryptWorkspace *)gcmWorkspace); }
 
         public:
-            constexpr static uint8_t workspaceRequiredAES = OTAESImpl::workspaceRequired;
+            // Construct an instance with the given implementations, supplied with workspace.
+            OTAES128GCMRuntimeWithWorkspace(const OTAES128EBackend &aes, const OTGHASHBackend &ghash,
+                    uint8_t *const workspace, const workspacesize_t workspaceSize)
+              : OTAES128GCMRuntimeInstances(aes, ghash, workspace, isWorkspaceSufficient(workspace, workspaceSize)),
+                OTAES128GCMGenericBase(aesInstance, ghashInstance),
+                gcmWorkspace(workspace + OTAESGCMBackends::maxWorkspaceRequiredAES + OTAESGCMBackends::maxWorkspaceRequiredGHASH),
+                workspaceOK(isWorkspaceSufficient(workspace, workspaceSize)),
+                aesBackend(aes), ghashBackend(ghash)
+                { }
+            // Construct an instance with the implementations the registry selects for the policy.
+            OTAES128GCMRuntimeWithWorkspace(const OTAESGCMBackendPolicy policy,
+                    uint8_t *const workspace, const workspacesize_t workspaceSize)
+              : OTAES128GCMRuntimeWithWorkspace(OTAESGCMBackends::selectAES(policy), OTAESGCMBackends::selectGHASH(policy),
+                    workspace, workspaceSize)
+                { }
 
-//            // on top of AES requirement.
-//            // Implicitly this ensures total size can fit in a uint8_t also.
-//            static_assert(GGBWS::gcmEncryptWorkspaceRequired + workspaceRequiredAES < 256U, "too big");
-//            static_assert(GGBWS::gcmEncryptPaddedWorkspaceRequired + workspaceRequiredAES < 256U, "too big");
-//            static_assert(GGBWS::gcmDecryptWorkspaceRequired + workspaceRequiredAES < 256U, "too big");
+            // The registry entries in use.
+            const OTAES128EBackend &getAESBackend() const { return(aesBackend); }
+            const OTGHASHBackend &getGHASHBackend() const { return(ghashBackend); }
+
+            // As for OTAES128GCMGenericBase, but false if the workspace is too small.
+#if defined(OTAESGCM_ALLOW_UNPADDED)
+            virtual bool gcmEncrypt(
+                const uint8_t* key, const uint8_t* IV,
+                const uint8_t* PDATA, uint8_t PDATALength,
+                const uint8_t* ADATA, uint8_t ADATALength,
+                uint8_t* CDATA, uint8_t *tag) override
+                { return(workspaceOK && OTAES128GCMGenericBase::gcmEncrypt(key, IV, PDATA, PDATALength, ADATA, ADATALength, CDATA, tag)); }
+#endif
+            virtual bool gcmEncryptPadded(
+                const uint8_t* key, const uint8_t* IV,
+                const uint8_t* PDATAPadded, uint8_t PDATALength,
+                const uint8_t* ADATA, uint8_t ADATALength,
+                uint8_t* CDATA, uint8_t *tag) override
+                { return(workspaceOK && OTAES128GCMGenericBase::gcmEncryptPadded(key, IV, PDATAPadded, PDATALength, ADATA, ADATALength, CDATA, tag)); }
+            virtual bool gcmDecrypt(
+                 const uint8_t* key, const uint8_t* IV,
+                 const uint8_t* CDATA, uint8_t CDATALength,
+                 const uint8_t* ADATA, uint8_t ADATALength,
+                 const uint8_t* messageTag, uint8_t *PDATA) override
+                { return(workspaceOK && OTAES128GCMGenericBase::gcmDecrypt(key, IV, CDATA, CDATALength, ADATA, ADATALength, messageTag, PDATA)); }
+        };
 
+    // AES128-GCM with the AES and GHASH implementations chosen per message
+    // by OTAESGCMAutotuner for its total length (text plus authenticated data),
+    // eg one with cheap key setup for short frames and the best bulk rate for long ones.
+    // Never autotunes itself: until OTAESGCMAutotuner::autotune() has been called
+    // the CONSTANT_TIME policy's implementations are used.
+    // Workspace is as for OTAES128GCMRuntimeWithWorkspace, which each call uses.
+    class OTAES128GCMTunedWithWorkspace final : public OTAES128GCM
+        {
+        public:
             // Suitable type to hold size of workspace required.
             typedef size_t workspacesize_t;
 
-            // Minimum and maximum size of workspace required
-            // (dependent on which function is to be called).
-            constexpr static workspacesize_t workspaceRequiredMin =
-                workspaceRequiredAES + GGBWS::minWS;
-            constexpr static workspacesize_t workspaceRequiredMax =
-                workspaceRequiredAES + GGBWS::maxWS;
-            // Conservatively/statically request the maximum workspace needed.
-            constexpr static workspacesize_t workspaceRequired = workspaceRequiredMax;
+            // Size of workspace required, whichever implementations are chosen.
+            constexpr static workspacesize_t workspaceRequired = OTAES128GCMRuntimeWithWorkspace::workspaceRequired;
+
+        private:
+            uint8_t *const workspace;
+            const workspacesize_t workspaceSize;
+
+        public:
             // Construct an instance, supplied with workspace.
-            // Pass the AES support class the leading part of the workspace.
-            constexpr OTAES128GCMGenericWithWorkspace(uint8_t *const workspace, const workspacesize_t workspaceSize)
-                : OTAESImpl(workspace, isWorkspaceSufficientMin(workspace, workspaceSize) ? workspaceRequiredAES : 0),
-                  OTAES128GCMGenericBase(this),
-                  gcmWorkspace(workspace + workspaceRequiredAES)
+            OTAES128GCMTunedWithWorkspace(uint8_t *const workspace_, const workspacesize_t workspaceSize_)
+              : workspace(workspace_), workspaceSize(workspaceSize_)
                 { }
-            // Verify that the workspace is adequate
-            // at least for the least-demanding function.
+
+            // As for OTAES128GCMRuntimeWithWorkspace, with the tuned implementations.
+#if defined(OTAESGCM_ALLOW_UNPADDED)
+            virtual bool gcmEncrypt(
+                const uint8_t* key, const uint8_t* IV,
+                const uint8_t* PDATA, uint8_t PDATALength,
+                const uint8_t* ADATA, uint8_t ADATALength,
+                uint8_t* CDATA, uint8_t *tag) override
+                {
+                const OTAES128EBackend *aes; const OTGHASHBackend *ghash;
+                OTAESGCMAutotuner::select((size_t)PDATALength + ADATALength, aes, ghash);
+                OTAES128GCMRuntimeWithWorkspace gen(*aes, *ghash, workspace, workspaceSize);
+                return(gen.gcmEncrypt(key, IV, PDATA, PDATALength, ADATA, ADATALength, CDATA, tag));
+                }
+#endif
+            virtual bool gcmEncryptPadded(
+                const uint8_t* key, const uint8_t* IV,
+                const uint8_t* PDATAPadded, uint8_t PDATALength,
+                const uint8_t* ADATA, uint8_t ADATALength,
+                uint8_t* CDATA, uint8_t *tag) override
+                {
+                const OTAES128EBackend *aes; const OTGHASHBackend *ghash;
+                OTAESGCMAutotuner::select((size_t)PDATALength + ADATALength, aes, ghash);
+                OTAES128GCMRuntimeWithWorkspace gen(*aes, *ghash, workspace, workspaceSize);
+                return(gen.gcmEncryptPadded(key, IV, PDATAPadded, PDATALength, ADATA, ADATALength, CDATA, tag));
+                }
+            virtual bool gcmDecrypt(
+                 const uint8_t* key, const uint8_t* IV,
+                 const uint8_t* CDATA, uint8_t CDATALength,
+                 const uint8_t* ADATA, uint8_t ADATALength,
+                 const uint8_t* messageTag, uint8_t *PDATA) override
+                {
+                const OTAES128EBackend *aes; const OTGHASHBackend *ghash;
+                OTAESGCMAutotuner::select((size_t)CDATALength + ADATALength, aes, ghash);
+                OTAES128GCMRuntimeWithWorkspace gen(*aes, *ghash, workspace, workspaceSize);
+                return(gen.gcmDecrypt(key, IV, CDATA, CDATALength, ADATA, ADATALength, messageTag, PDATA));
+                }
+        };
+#endif
+
+    // One message for OTAES128GCMKeyedBase::gcmEncryptPaddedBatch(),
+    // with the arguments as for OTAES128GCMKeyedBase::gcmEncryptPadded().
+    struct GCMEncryptPaddedFrame final
+        {
+        const uint8_t *IV; // 12 byte (96 bit) IV; never NULL.
+        const uint8_t *PDATAPadded; // NULL if length 0.
+        size_t PDATALength; // MUST BE blocksize multiple, can be zero.
+        const uint8_t *ADATA; // NULL if length 0.
+        size_t ADATALength; // Can be zero.
+        uint8_t *CDATA; // Same size as PDATA; must not overlap it; never NULL.
+        uint8_t *tag; // 16 byte tag output buffer; never NULL.
+        };
+
+    // Keyed AES128-GCM encryption/decryption.
+    // The key is set once with setKey(), which expands and retains the AES
+    // key schedule and computes the hash subkey H (and any GHASH tables), so that each subsequent
+    // message needs only an IV; eg for a gateway handling many frames under one key.
+    // The key-dependent state is kept until explicitly wiped with clearKey().
+    // Neither re-entrant nor ISR-safe except where stated.
+    class OTAES128GCMKeyedBase
+        {
+        private:
+            // Pointer to an AES block encryption implementation instance; never NULL.
+            OTAES128E * const ap;
+            // Pointer to a GHASH implementation instance; never NULL.
+            OTGHASH * const gp;
+            // True once setKey() has succeeded, until clearKey().
+            bool keySet = false;
+            // Return the retained key state and the per-message workspace.
+            virtual GGBWS::GCMKeyState &getGCMKeyState() = 0;
+            virtual GGBWS::GCMKeyedWorkspace &getGCMKeyedWorkspace() = 0;
+            // Return the batch workspace, or NULL if the workspace passed in is too small for it.
+            virtual GGBWS::GCMBatchWorkspace *getGCMBatchWorkspace() = 0;
+            // True if the workspace passed in was large enough.
+            virtual bool isWorkspaceOK() const = 0;
+            // Encrypt or decrypt with an optional ADATA prefix; NULL if none.
+            bool encryptPaddedWithPrefix(const GCMADATAPrefix *prefix, const uint8_t* IV,
+                const uint8_t* PDATAPadded, size_t PDATALength,
+                const uint8_t* ADATA, size_t ADATALength,
+                uint8_t* CDATA, uint8_t *tag);
+            bool decryptWithPrefix(const GCMADATAPrefix *prefix, const uint8_t* IV,
+                const uint8_t* CDATA, size_t CDATALength,
+                const uint8_t* ADATA, size_t ADATALength,
+                const uint8_t* messageTag, uint8_t *PDATA);
+
+        public:
+            // Create an instance pointing at suitable AES block enc/dec and GHASH implementations.
+            constexpr OTAES128GCMKeyedBase(OTAES128E *aptr, OTGHASH *gptr) : ap(aptr), gp(gptr) { }
+
+            /**
+             * @brief   sets the key, computing and retaining all key-dependent state
+             * @param   key     pointer to 16 byte (128 bit) key; never NULL;
+             *                  copied, so need not outlive this call
+             * @retval  true if successful, false if the key is NULL
+             *          or the workspace is too small
+             *
+             * Any previous key state is wiped first.
+             */
+            bool setKey(const uint8_t *key);
+
+            // Wipe all key-dependent state; safe to call if no key is set.
+            void clearKey();
+
+            // True if a key has been set (and not since cleared).
+            bool isKeySet() const { return(keySet); }
+
+            // Encrypt under the retained key; true if successful.
+            // As for OTAES128GCM::gcmEncryptPadded() with the key omitted,
+            // but not limited to 255-byte texts (up to the GCM limit of 2^36-32 bytes);
+            // fails if no key is set.
+            // Encrypts and hashes in a single pass over the data.
+            bool gcmEncryptPadded(
+                const uint8_t* IV,
+                const uint8_t* PDATAPadded, size_t PDATALength,
+                const uint8_t* ADATA, size_t ADATALength,
+                uint8_t* CDATA, uint8_t *tag);
+
+            // Decrypt under the retained key; true iff successful.
+            // As for OTAES128GCM::gcmDecrypt() with the key omitted,
+            // but not limited to 255-byte texts;
+            // fails if no key is set.
+            bool gcmDecrypt(
+                 const uint8_t* IV,
+                 const uint8_t* CDATA, size_t CDATALength,
+                 const uint8_t* ADATA, size_t ADATALength,
+                 const uint8_t* messageTag, uint8_t *PDATA);
+
+            // Compute the GMAC tag of ADATA alone under the retained key; true if successful.
+            // Same tag as gcmEncryptPadded() with no plain text,
+            // reusing the retained H and key schedule, with no counter mode at all.
+            // Fails if no key is set or ADATA is empty.
+            bool gmacCompute(const uint8_t* IV, const uint8_t* ADATA, size_t ADATALength, uint8_t *tag);
+
+            // Verify the GMAC tag of ADATA under the retained key; true iff authentic.
+            bool gmacVerify(const uint8_t* IV, const uint8_t* ADATA, size_t ADATALength, const uint8_t *messageTag);
+
+            /**
+             * @brief   hashes a constant ADATA prefix once under the retained key
+             * @param   ADATAPrefix     pointer to the leading part of ADATA shared by many messages;
+             *                          NULL if length 0
+             * @param   length          prefix length in bytes, can be zero
+             * @param   prefix          filled in with the GHASH state after the prefix
+             * @retval  true if successful, false if no key is set
+             *
+             * The prefix need not be a whole number of blocks,
+             * but then its last partial block is hashed with each message.
+             */
+            bool computeADATAPrefix(const uint8_t *ADATAPrefix, size_t length, GCMADATAPrefix &prefix);
+
+            // Encrypt under the retained key with ADATA of prefix followed by ADATASuffix; true if successful.
+            // As for gcmEncryptPadded() with the whole ADATA, but only the suffix is hashed.
+            bool gcmEncryptPadded(
+                const GCMADATAPrefix &prefix,
+                const uint8_t* IV,
+                const uint8_t* PDATAPadded, size_t PDATALength,
+                const uint8_t* ADATASuffix, size_t ADATASuffixLength,
+                uint8_t* CDATA, uint8_t *tag);
+
+            // Decrypt under the retained key with ADATA of prefix followed by ADATASuffix; true iff successful.
+            // As for gcmDecrypt() with the whole ADATA, but only the suffix is hashed.
+            bool gcmDecrypt(
+                 const GCMADATAPrefix &prefix,
+                 const uint8_t* IV,
+                 const uint8_t* CDATA, size_t CDATALength,
+                 const uint8_t* ADATASuffix, size_t ADATASuffixLength,
+                 const uint8_t* messageTag, uint8_t *PDATA);
+
+            /**
+             * @brief   encrypts a batch of messages under the retained key
+             * @param   frames          array of nFrames message descriptors
+             * @param   nFrames         number of messages, can be zero
+             * @retval  true if all were encrypted, false if no key is set,
+             *          the workspace is too small for batches,
+             *          or any frame is invalid (in which case none are encrypted)
+             *
+             * Up to GGBWS::GCM_BATCH_LANES messages are in flight at once,
+             * with one counter block from each encrypted per step
+             * so that the AES implementation can pipeline them
+             * (see OTAES128E::blocksEncrypt()),
+             * and each message's cipher text hashed in chunks as it is produced.
+             * Messages may be of different lengths.
+             */
+            bool gcmEncryptPaddedBatch(const GCMEncryptPaddedFrame *frames, size_t nFrames);
+        };
+    // Keyed implementation, parameterised with type of underlying AES and GHASH implementations.
+    // Carries the AES and GHASH working state with it, in the workspace passed in,
+    // laid out as the AES workspace, then the GHASH workspace, then the retained key state,
+    // then the per-message workspace.
+    // With OTGHASH_fast_t the GHASH table is computed once per key in setKey().
+    // Batch encryption additionally needs workspaceRequiredBatch bytes of workspace.
+    //
+    // For security, as far as is reasonably possible:
+    //   * clearKey() wipes the retained key state, AES schedule and GHASH state.
+    //   * the gcm function methods erase per-message private state before returning.
+    //   * the key state is wiped when the instance is destroyed.
+    template<class OTAESImpl = OTAESGCM::OTAES128E_default_t, class OTGHASHImpl = OTAESGCM::OTGHASH_default_t>
+    class OTAES128GCMKeyedWithWorkspace final : OTAESImpl, OTGHASHImpl, public OTAES128GCMKeyedBase
+        {
+        public:
+            constexpr static uint8_t workspaceRequiredAES = OTAESImpl::workspaceRequired;
+            constexpr static size_t workspaceRequiredGHASH = OTGHASHImpl::workspaceRequired;
+
+            // Suitable type to hold size of workspace required.
+            typedef size_t workspacesize_t;
+
+            // Size of workspace required.
+            constexpr static workspacesize_t workspaceRequired =
+                workspaceRequiredAES + workspaceRequiredGHASH + sizeof(GGBWS::GCMKeyState) + sizeof(GGBWS::GCMKeyedWorkspace);
+            // Verify that the workspace is adequate.
+            // This check may be made at compile time in common cases.
+            static constexpr bool isWorkspaceSufficient(uint8_t *const workspace, const workspacesize_t workspaceSize)
+                { return((NULL != workspace) && (workspaceSize >= workspaceRequired)); }
+            // Workspace sufficient for gcmEncryptPaddedBatch() also.
+            constexpr static workspacesize_t workspaceRequiredBatch =
+                workspaceRequired + sizeof(GGBWS::GCMBatchWorkspace);
+            // True if workspace sufficient for gcmEncryptPaddedBatch().
+            static constexpr bool isWorkspaceSufficientBatch(uint8_t *const workspace, const workspacesize_t workspaceSize)
+                { return((NULL != workspace) && (workspaceSize >= workspaceRequiredBatch)); }
+
+        private:
+            // Key state, per-message and batch parts of the workspace passed into the constructor.
+            uint8_t *const keyState;
+            uint8_t *const gcmWorkspace;
+            uint8_t *const batchWorkspace;
+            const bool workspaceOK;
+
+            virtual GGBWS::GCMKeyState &getGCMKeyState() override { return(*(GGBWS::GCMKeyState *)(keyState)); }
+            virtual GGBWS::GCMKeyedWorkspace &getGCMKeyedWorkspace() override { return(*(GGBWS::GCMKeyedWorkspace *)(gcmWorkspace)); }
+            virtual GGBWS::GCMBatchWorkspace *getGCMBatchWorkspace() override { return((GGBWS::GCMBatchWorkspace *)(batchWorkspace)); }
+            virtual bool isWorkspaceOK() const override { return(workspaceOK); }
+
+        public:
+            // Construct an instance, supplied with workspace.
+            // Pass the AES and GHASH support classes the leading parts of the workspace.
+            constexpr OTAES128GCMKeyedWithWorkspace(uint8_t *const workspace, const workspacesize_t workspaceSize)
+                : OTAESImpl(workspace, isWorkspaceSufficient(workspace, workspaceSize) ? workspaceRequiredAES : 0),
+                  OTGHASHImpl(workspace + workspaceRequiredAES, isWorkspaceSufficient(workspace, workspaceSize) ? workspaceRequiredGHASH : 0),
+                  OTAES128GCMKeyedBase(this, this),
+                  keyState(workspace + workspaceRequiredAES + workspaceRequiredGHASH),
+                  gcmWorkspace(workspace + workspaceRequiredAES + workspaceRequiredGHASH + sizeof(GGBWS::GCMKeyState)),
+                  batchWorkspace(isWorkspaceSufficientBatch(workspace, workspaceSize) ? workspace + workspaceRequired : NULL),
+                  workspaceOK(isWorkspaceSufficient(workspace, workspaceSize))
+                { }
+
+            // Wipe the key state on the way out.
+            ~OTAES128GCMKeyedWithWorkspace() { clearKey(); }
+        };
+
+#if defined(OTAESGCM_HAS_BACKEND_REGISTRY)
+    // Keyed AES128-GCM with the AES and GHASH implementations chosen at runtime from the registry,
+    // either explicitly or by OTAESGCMAutotuner for the expected message length,
+    // eg so that a gateway's batches of short frames and its bulk transfers each get their fastest.
+    // The choice is fixed per instance since the key state belongs to the implementations.
+    // Workspace is laid out as for OTAES128GCMKeyedWithWorkspace,
+    // with room for the largest AES and GHASH workspace of any registered implementation.
+    //
+    // For security, as far as is reasonably possible:
+    //   * clearKey() wipes the retained key state, AES schedule and GHASH state.
+    //   * the gcm function methods erase per-message private state before returning.
+    //   * the key state is wiped when the instance is destroyed.
+    class OTAES128GCMKeyedRuntimeWithWorkspace final : private OTAES128GCMRuntimeInstances, public OTAES128GCMKeyedBase
+        {
+        public:
+            // Suitable type to hold size of workspace required.
+            typedef size_t workspacesize_t;
+
+            // Size of workspace required, whichever implementations are chosen.
+            constexpr static workspacesize_t workspaceRequired =
+                OTAESGCMBackends::maxWorkspaceRequiredAES + OTAESGCMBackends::maxWorkspaceRequiredGHASH +
+                sizeof(GGBWS::GCMKeyState) + sizeof(GGBWS::GCMKeyedWorkspace);
+            // Verify that the workspace is adequate.
+            static constexpr bool isWorkspaceSufficient(uint8_t *const workspace, const workspacesize_t workspaceSize)
+                { return((NULL != workspace) && (workspaceSize >= workspaceRequired)); }
+            // Workspace sufficient for gcmEncryptPaddedBatch() also.
+            constexpr static workspacesize_t workspaceRequiredBatch =
+                workspaceRequired + sizeof(GGBWS::GCMBatchWorkspace);
+            // True if workspace sufficient for gcmEncryptPaddedBatch().
+            static constexpr bool isWorkspaceSufficientBatch(uint8_t *const workspace, const workspacesize_t workspaceSize)
+                { return((NULL != workspace) && (workspaceSize >= workspaceRequiredBatch)); }
+
+        private:
+            // Key state, per-message and batch parts of the workspace passed into the constructor.
+            uint8_t *const keyState;
+            uint8_t *const gcmWorkspace;
+            uint8_t *const batchWorkspace;
+            const bool workspaceOK;
+            // The registry entries in use.
+            const OTAES128EBackend &aesBackend;
+            const OTGHASHBackend &ghashBackend;
+
+            virtual GGBWS::GCMKeyState &getGCMKeyState() override { return(*(GGBWS::GCMKeyState *)(keyState)); }
+            virtual GGBWS::GCMKeyedWorkspace &getGCMKeyedWorkspace() override { return(*(GGBWS::GCMKeyedWorkspace *)(gcmWorkspace)); }
+            virtual GGBWS::GCMBatchWorkspace *getGCMBatchWorkspace() override { return((GGBWS::GCMBatchWorkspace *)(batchWorkspace)); }
+            virtual bool isWorkspaceOK() const override { return(workspaceOK); }
+
+            // The tuned implementations for the given message length.
+            static const OTAES128EBackend &tunedAES(const size_t messageLength)
+                { const OTAES128EBackend *aes; const OTGHASHBackend *ghash; OTAESGCMAutotuner::select(messageLength, aes, ghash); return(*aes); }
+            static const OTGHASHBackend &tunedGHASH(const size_t messageLength)
+                { const OTAES128EBackend *aes; const OTGHASHBackend *ghash; OTAESGCMAutotuner::select(messageLength, aes, ghash); return(*ghash); }
+
+        public:
+            // Construct an instance with the given implementations, supplied with workspace.
+            OTAES128GCMKeyedRuntimeWithWorkspace(const OTAES128EBackend &aes, const OTGHASHBackend &ghash,
+                    uint8_t *const workspace, const workspacesize_t workspaceSize)
+              : OTAES128GCMRuntimeInstances(aes, ghash, workspace, isWorkspaceSufficient(workspace, workspaceSize)),
+                OTAES128GCMKeyedBase(aesInstance, ghashInstance),
+                keyState(workspace + OTAESGCMBackends::maxWorkspaceRequiredAES + OTAESGCMBackends::maxWorkspaceRequiredGHASH),
+                gcmWorkspace(workspace + OTAESGCMBackends::maxWorkspaceRequiredAES + OTAESGCMBackends::maxWorkspaceRequiredGHASH + sizeof(GGBWS::GCMKeyState)),
+                batchWorkspace(isWorkspaceSufficientBatch(workspace, workspaceSize) ? workspace + workspaceRequired : NULL),
+                workspaceOK(isWorkspaceSufficient(workspace, workspaceSize)),
+                aesBackend(aes), ghashBackend(ghash)
+                { }
+            // Construct an instance with the implementations tuned for messages
+            // of about the given total length (text plus authenticated data);
+            // the CONSTANT_TIME policy's implementations if not yet tuned.
+            OTAES128GCMKeyedRuntimeWithWorkspace(const size_t expectedMessageLength,
+                    uint8_t *const workspace, const workspacesize_t workspaceSize)
+              : OTAES128GCMKeyedRuntimeWithWorkspace(tunedAES(expectedMessageLength), tunedGHASH(expectedMessageLength),
+                    workspace, workspaceSize)
+                { }
+
+            // Wipe the key state on the way out.
+            ~OTAES128GCMKeyedRuntimeWithWorkspace() { clearKey(); }
+
+            // The registry entries in use.
+            const OTAES128EBackend &getAESBackend() const { return(aesBackend); }
+            const OTGHASHBackend &getGHASHBackend() const { return(ghashBackend); }
+        };
+#endif
+
+    // One message for OTAES128GCMMultiKeyDecryptBase::gcmDecryptMultiKey(),
+    // with the arguments as for OTAES128GCM::gcmDecrypt().
+    struct GCMDecryptFrame final
+        {
+        const uint8_t *key; // 16 byte (128 bit) key; never NULL.
+        const uint8_t *IV; // 12 byte (96 bit) IV; never NULL.
+        const uint8_t *CDATA; // NULL if length 0.
+        size_t CDATALength; // MUST BE blocksize multiple, can be zero.
+        const uint8_t *ADATA; // NULL if length 0.
+        size_t ADATALength; // Can be zero.
+        const uint8_t *messageTag; // 16 byte received tag; never NULL.
+        uint8_t *PDATA; // Same size as CDATA; NULL if length 0.
+        };
+
+    // Multi-key AES128-GCM decryption of a batch of messages each under its own key,
+    // eg for a gateway receiving frames from many nodes.
+    // Each message is a lane of an OTAES128EMultiKey implementation,
+    // so that the AES work for all of them is done together,
+    // eg up to 8 blocks in flight at once with AES-NI.
+    // All the messages are authenticated before any are decrypted,
+    // and plain text is only written for authentic messages.
+    // Neither re-entrant nor ISR-safe except where stated.
+    class OTAES128GCMMultiKeyDecryptBase
+        {
+        private:
+            // Pointer to a multi-key AES implementation instance; never NULL.
+            OTAES128EMultiKey * const mp;
+            // Pointer to a GHASH implementation instance, rekeyed per message; never NULL.
+            OTGHASH * const gp;
+            // Return the workspace.
+            virtual GGBWS::GCMMultiKeyWorkspace &getGCMMultiKeyWorkspace() = 0;
+            // True if the workspace passed in was large enough.
+            virtual bool isWorkspaceOK() const = 0;
+
+        public:
+            // Maximum messages per batch, one per lane.
+            static constexpr uint8_t MaxFrames = OTAES128EMultiKey::MaxLanes;
+
+            // Create an instance pointing at suitable multi-key AES and GHASH implementations.
+            constexpr OTAES128GCMMultiKeyDecryptBase(OTAES128EMultiKey *mptr, OTGHASH *gptr) : mp(mptr), gp(gptr) { }
+
+            /**
+             * @brief   authenticates and decrypts up to MaxFrames messages, each under its own key
+             * @param   frames          array of nFrames message descriptors
+             * @param   nFrames         number of messages, at most MaxFrames
+             * @retval  bitmap of the messages successfully authenticated and decrypted,
+             *          bit i (value 1<<i) for frames[i];
+             *          0 if none were, eg if nFrames is too large or the workspace too small
+             *
+             * Invalid frames (eg NULL key, unpadded text) fail without affecting the others.
+             * Wipes all key-dependent state before returning.
+             */
+            uint8_t gcmDecryptMultiKey(const GCMDecryptFrame *frames, uint8_t nFrames);
+        };
+    // Multi-key decryption implementation, parameterised with type of underlying
+    // multi-key AES and GHASH implementations.
+    // Carries the AES and GHASH working state with it, in the workspace passed in,
+    // laid out as the multi-key AES workspace, then the GHASH workspace,
+    // then the GCM function workspace.
+    // Eg OTAES128EMultiKey_fast_t with OTGHASH_fast_t for x86 gateways.
+    template<class OTAESMultiKeyImpl = OTAESGCM::OTAES128EMultiKey_default_t, class OTGHASHImpl = OTAESGCM::OTGHASH_default_t>
+    class OTAES128GCMMultiKeyDecryptWithWorkspace final : OTAESMultiKeyImpl, OTGHASHImpl, public OTAES128GCMMultiKeyDecryptBase
+        {
+        public:
+            constexpr static size_t workspaceRequiredAES = OTAESMultiKeyImpl::workspaceRequired;
+            constexpr static size_t workspaceRequiredGHASH = OTGHASHImpl::workspaceRequired;
+
+            // Suitable type to hold size of workspace required.
+            typedef size_t workspacesize_t;
+
+            // Size of workspace required.
+            constexpr static workspacesize_t workspaceRequired =
+                workspaceRequiredAES + workspaceRequiredGHASH + sizeof(GGBWS::GCMMultiKeyWorkspace);
+            // Verify that the workspace is adequate.
             // This check may be made at compile time in common cases.
-            static constexpr bool isWorkspaceSufficientMin(uint8_t *const workspace, const workspacesize_t workspaceSize)
-                { return((NULL != workspace) && (workspaceSize >= workspaceRequiredMin)); }
-            // Verify that the workspace is adequate
-            // for the most-demanding function.
+            static constexpr bool isWorkspaceSufficient(uint8_t *const workspace, const workspacesize_t workspaceSize)
+                { return((NULL != workspace) && (workspaceSize >= workspaceRequired)); }
+
+        private:
+            // GCM part of the workspace passed into the constructor.
+            uint8_t *const gcmWorkspace;
+            const bool workspaceOK;
+
+            virtual GGBWS::GCMMultiKeyWorkspace &getGCMMultiKeyWorkspace() override { return(*(GGBWS::GCMMultiKeyWorkspace *)(gcmWorkspace)); }
+            virtual bool isWorkspaceOK() const override { return(workspaceOK); }
+
+        public:
+            // Construct an instance, supplied with workspace.
+            // Pass the AES and GHASH support classes the leading parts of the workspace.
+            OTAES128GCMMultiKeyDecryptWithWorkspace(uint8_t *const workspace, const workspacesize_t workspaceSize)
+                : OTAESMultiKeyImpl(workspace, isWorkspaceSufficient(workspace, workspaceSize) ? workspaceRequiredAES : 0),
+                  OTGHASHImpl(workspace + workspaceRequiredAES, isWorkspaceSufficient(workspace, workspaceSize) ? workspaceRequiredGHASH : 0),
+                  OTAES128GCMMultiKeyDecryptBase(this, this),
+                  gcmWorkspace(workspace + workspaceRequiredAES + workspaceRequiredGHASH),
+                  workspaceOK(isWorkspaceSufficient(workspace, workspaceSize))
+                { }
+        };
+
+    // Incremental (streaming) AES128-GCM encryption/decryption,
+    // for messages too big to hold in memory at once, eg firmware images or logs.
+    // For each message call:
+    //   * init() with the key and IV,
+    //   * aad() zero or more times with successive chunks of additional data,
+    //   * encryptUpdate() or decryptUpdate() zero or more times
+    //     with successive chunks of text (of any length, not just whole blocks),
+    //   * finalize() after encryption to get the tag,
+    //     or verify() after decryption to check it.
+    // Partial blocks are carried between calls; total lengths are 64-bit
+    // up to the GCM limits (2^36-32 bytes of text).
+    // Out-of-order calls fail (returning false) and wipe the message state.
+    // NOTE: decryptUpdate() releases plain text before it is authenticated,
+    // so it must not be acted upon until verify() returns true.
+    // Neither re-entrant nor ISR-safe except where stated.
+    class OTAES128GCMStreamBase
+        {
+        private:
+            // Pointer to an AES block encryption implementation instance; never NULL.
+            OTAES128E * const ap;
+            // Pointer to a GHASH implementation instance; never NULL.
+            OTGHASH * const gp;
+            // Lengths so far of the additional data and text, in bytes.
+            // Held here rather than in the (unaligned) workspace.
+            uint64_t totalADATALength = 0;
+            uint64_t totalTextLength = 0;
+            // Which calls are allowed next.
+            uint8_t phase = 0;
+            // Return the state carried between calls.
+            virtual GGBWS::GCMStreamState &getGCMStreamState() = 0;
+            // True if the workspace passed in was large enough.
+            virtual bool isWorkspaceOK() const = 0;
+
+            // Hash any partial AAD block, moving on to the text.
+            void finishADATA(GGBWS::GCMStreamState &state);
+            // Common part of encryptUpdate() and decryptUpdate().
+            bool update(const uint8_t *in, size_t length, uint8_t *out, bool decrypting);
+            // Computes the tag into the state's keyStream.
+            bool computeTag(uint8_t expectedPhase);
+
+        public:
+            // Create an instance pointing at suitable AES block enc/dec and GHASH implementations.
+            constexpr OTAES128GCMStreamBase(OTAES128E *aptr, OTGHASH *gptr) : ap(aptr), gp(gptr) { }
+
+            /**
+             * @brief   starts a message, discarding any previous one
+             * @param   key     pointer to 16 byte (128 bit) key; never NULL;
+             *                  copied, so need not outlive this call
+             * @param   IV      pointer to 12 byte (96 bit) IV; never NULL
+             * @retval  true if successful, false if an argument is NULL
+             *          or the workspace is too small
+             */
+            bool init(const uint8_t *key, const uint8_t *IV);
+
+            // Add the next chunk of additional data; true if successful.
+            // Only valid after init() and before any text.
+            bool aad(const uint8_t *ADATA, size_t ADATALength);
+
+            // Encrypt the next chunk of plain text into out; true if successful.
+            // out may be the same as in, but must not otherwise overlap it.
+            bool encryptUpdate(const uint8_t *in, size_t length, uint8_t *out)
+                { return(update(in, length, out, false)); }
+            // Decrypt the next chunk of cipher text into out; true if successful.
+            // out may be the same as in, but must not otherwise overlap it.
+            bool decryptUpdate(const uint8_t *in, size_t length, uint8_t *out)
+                { return(update(in, length, out, true)); }
+
+            // Finish an encryption, writing the 16 byte tag; true if successful.
+            // Wipes the message state.
+            bool finalize(uint8_t *tag);
+            // Finish a decryption, checking the 16 byte tag in constant time;
+            // true iff the message is authentic.
+            // Wipes the message state.
+            bool verify(const uint8_t *messageTag);
+
+            // Wipe all message and key state; safe to call at any time.
+            void clear();
+        };
+    // Streaming implementation, parameterised with type of underlying AES and GHASH implementations.
+    // Carries the AES and GHASH working state with it, in the workspace passed in,
+    // laid out as the AES workspace, then the GHASH workspace, then the stream state.
+    //
+    // For security, as far as is reasonably possible:
+    //   * finalize(), verify() and clear() wipe the key, AES schedule and GHASH state.
+    //   * the state is wiped when the instance is destroyed.
+    template<class OTAESImpl = OTAESGCM::OTAES128E_default_t, class OTGHASHImpl = OTAESGCM::OTGHASH_default_t>
+    class OTAES128GCMStreamWithWorkspace final : OTAESImpl, OTGHASHImpl, public OTAES128GCMStreamBase
+        {
+        public:
+            constexpr static uint8_t workspaceRequiredAES = OTAESImpl::workspaceRequired;
+            constexpr static size_t workspaceRequiredGHASH = OTGHASHImpl::workspaceRequired;
+
+            // Suitable type to hold size of workspace required.
+            typedef size_t workspacesize_t;
+
+            // Size of workspace required.
+            constexpr static workspacesize_t workspaceRequired =
+                workspaceRequiredAES + workspaceRequiredGHASH + sizeof(GGBWS::GCMStreamState);
+            // Verify that the workspace is adequate.
             // This check may be made at compile time in common cases.
             static constexpr bool isWorkspaceSufficient(uint8_t *const workspace, const workspacesize_t workspaceSize)
-                { return((NULL != workspace) && (workspaceSize >= workspaceRequiredMax)); }
-
-            // Workspace sufficient for gcmEncrypt().
-            static constexpr workspacesize_t workspaceRequiredEnc = workspaceRequiredAES + (workspacesize_t) GGBWS::gcmEncryptWorkspaceRequired;
-            // True if workspace sufficient for gcmEncrypt().
-            static constexpr bool isWorkspaceSufficientEnc(uint8_t *const workspace, const workspacesize_t workspaceSize)
-                { return((NULL != workspace) && (workspaceSize >= workspaceRequiredEnc)); }
-            // Workspace sufficient for gcmEncryptPadded().
-            static constexpr workspacesize_t workspaceRequiredEncPadded = workspaceRequiredAES + (workspacesize_t) GGBWS::gcmEncryptPaddedWorkspaceRequired;
-            // True if workspace sufficient for gcmEncryptPadded().
-            static constexpr bool isWorkspaceSufficientEncPadded(uint8_t *const workspace, const workspacesize_t workspaceSize)
-                { return((NULL != workspace) && (workspaceSize >= workspaceRequiredEncPadded)); }
-            // Workspace sufficient for gcmDecrypt().
-            static constexpr workspacesize_t workspaceRequiredDec = workspaceRequiredAES + (workspacesize_t) GGBWS::gcmDecryptWorkspaceRequired;
-            // True if workspace sufficient for gcmDecrypt().
-            static constexpr bool isWorkspaceSufficientDec(uint8_t *const workspace, const workspacesize_t workspaceSize)
-                { return((NULL != workspace) && (workspaceSize >= workspaceRequiredDec)); }
+                { return((NULL != workspace) && (workspaceSize >= workspaceRequired)); }
+
+        private:
+            // Stream state part of the workspace passed into the constructor.
+            uint8_t *const streamState;
+            const bool workspaceOK;
+
+            virtual GGBWS::GCMStreamState &getGCMStreamState() override { return(*(GGBWS::GCMStreamState *)(streamState)); }
+            virtual bool isWorkspaceOK() const override { return(workspaceOK); }
+
+        public:
+            // Construct an instance, supplied with workspace.
+            // Pass the AES and GHASH support classes the leading parts of the workspace.
+            constexpr OTAES128GCMStreamWithWorkspace(uint8_t *const workspace, const workspacesize_t workspaceSize)
+                : OTAESImpl(workspace, isWorkspaceSufficient(workspace, workspaceSize) ? workspaceRequiredAES : 0),
+                  OTGHASHImpl(workspace + workspaceRequiredAES, isWorkspaceSufficient(workspace, workspaceSize) ? workspaceRequiredGHASH : 0),
+                  OTAES128GCMStreamBase(this, this),
+                  streamState(workspace + workspaceRequiredAES + workspaceRequiredGHASH),
+                  workspaceOK(isWorkspaceSufficient(workspace, workspaceSize))
+                { }
+
+            // Wipe the state on the way out.
+            ~OTAES128GCMStreamWithWorkspace() { clear(); }
         };
 
     // AES-GCM 128-bit-key fixed-size text (256-bit/32-byte) encryption/authentication function using work space passed in.
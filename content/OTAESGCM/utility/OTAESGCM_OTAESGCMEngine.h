@@ -0,0 +1,1105 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/*
+ * Header-only AES(128)-GCM engine, templated on the AES and GHASH implementations.
+ *
+ * The GCM steps are templates on the types they call through,
+ * so that instantiated with OTAES128E and OTGHASH they make virtual calls
+ * (as for OTAES128GCMGenericBase and the keyed and stream classes)
+ * and instantiated with the Direct binders below every call is bound
+ * at compile time and can be inlined across AES, CTR and GHASH.
+ *
+ * Included by OTAESGCM_OTAESGCM.h after the workspace definitions;
+ * include that rather than this.
+ */
+
+#ifndef ARDUINO_LIB_OTAESGCM_OTAESGCMENGINE_H
+#define ARDUINO_LIB_OTAESGCM_OTAESGCMENGINE_H
+
+#ifndef ARDUINO_LIB_OTAESGCM_OTAESGCM_H
+#error include OTAESGCM_OTAESGCM.h instead
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+
+// Use namespaces to help avoid collisions.
+namespace OTAESGCM
+    {
+    namespace GCMEngine
+    {
+
+// Maximum plain/cipher text length in bytes for 96-bit IVs: 2^39 - 256 bits.
+static constexpr uint64_t GCM_MAX_TEXT_LENGTH = ((uint64_t)1 << 36) - 32;
+
+// Maximum additional data length in bytes: 2^64 - 1 bits.
+static constexpr uint64_t GCM_MAX_ADATA_LENGTH = ((uint64_t)1 << 61) - 1;
+
+// Blocks per chunk for the fused CTR+GHASH pass:
+// small enough to stay in L1 cache, and a multiple of the
+// blocks per reduction of the aggregating GHASH implementations.
+static constexpr uint8_t FUSED_CHUNK_BLOCKS = 8;
+
+    // Binds calls to an AES implementation at compile time rather than through its vtable.
+    // Holds only a reference, so is free to construct around an existing instance.
+    template<class OTAESImpl>
+    class OTAES128EDirect final
+        {
+        private:
+            OTAESImpl &impl;
+
+        public:
+            explicit constexpr OTAES128EDirect(OTAESImpl &i) : impl(i) { }
+            void blockEncrypt(const uint8_t *input, const uint8_t *key, uint8_t *output)
+                { impl.OTAESImpl::blockEncrypt(input, key, output); }
+            void blocksEncrypt(const uint8_t *input, size_t nBlocks, const uint8_t *key, uint8_t *output)
+                { impl.OTAESImpl::blocksEncrypt(input, nBlocks, key, output); }
+            void ctrEncrypt(uint8_t *ctrBlock, const uint8_t *input, size_t nBlocks, const uint8_t *key, uint8_t *output)
+                { impl.OTAESImpl::ctrEncrypt(ctrBlock, input, nBlocks, key, output); }
+            void retainKeySchedule(const uint8_t *key) { impl.OTAESImpl::retainKeySchedule(key); }
+            void clearKeySchedule() { impl.OTAESImpl::clearKeySchedule(); }
+        };
+
+    // Binds calls to a GHASH implementation at compile time rather than through its vtable.
+    template<class OTGHASHImpl>
+    class OTGHASHDirect final
+        {
+        private:
+            OTGHASHImpl &impl;
+
+        public:
+            explicit constexpr OTGHASHDirect(OTGHASHImpl &i) : impl(i) { }
+            void setAuthKey(const uint8_t *H) { impl.OTGHASHImpl::setAuthKey(H); }
+            void ghashBlocks(uint8_t *Y, const uint8_t *X, size_t nBlocks) { impl.OTGHASHImpl::ghashBlocks(Y, X, nBlocks); }
+            void clearAuthKey() { impl.OTGHASHImpl::clearAuthKey(); }
+        };
+
+/**
+ * @brief   checks if tags match
+ * @param   tag1        pointer to array containing tag1
+ * @param   tag2        pointer to array containing tag2
+ * @retval  returns 0 if tags match. All other values are a fail.
+ */
+inline uint8_t checkTag(const uint8_t *tag1, const uint8_t *tag2)
+{
+    uint8_t result = 0;
+
+    // Compare tags: f any byte pair fails to match this will set bits in result.
+    // This method runtime does not depend on where the match is,
+    // which will help avoid some side-channel attacks based on timing.
+    for (uint8_t i = 0; i < AES128GCM_TAG_SIZE; i++) {
+        result |= *tag1 ^ *tag2;
+        tag1++;
+        tag2++;
+    }
+    return result;
+}
+
+/**
+ * @note    inc32
+ * @brief    increments the rightmost 32 bits (4 bytes) of block, %(2^32)
+ * @param    pBlock      16 byte array to perform operation on
+ */
+inline void incr32(uint8_t *pBlock)
+{
+    // go to end of array
+    pBlock += 15;
+
+    // loop through last 4 elements
+    for (uint8_t i = 0; i < 4; i++) {
+        // increment current byte
+        *pBlock = *pBlock + 1;
+        // return if no overflow, otherwise move to next byte
+        if(*pBlock) return;
+        else pBlock--;
+    }
+}
+
+/**
+ * @brief   puts a byte length as a 64-bit big-endian bit length
+ * @param   p       pointer to 8 byte output
+ * @param   len     length in bytes
+ */
+inline void putBitLength(uint8_t *p, uint64_t len)
+{
+    p[7] = (uint8_t)(len << 3);
+    len >>= 5;
+    for (int8_t i = 6; i >= 0; --i) {
+        p[i] = (uint8_t)len;
+        len >>= 8;
+    }
+}
+
+/**
+ * @note    aes_gcm_prepare_j0
+ * @brief   generates initial counter block from IV
+ * @param   pIV             pointer to 12 byte initial vector nonce
+ * @param   pOutput         pointer to 16 byte output array
+ */
+inline void generateICB(const uint8_t *pIV, uint8_t *pOutput)
+{
+    // Prepare block J0 = IV || 0^31 || 1 [len(IV) = 96]
+    memcpy(pOutput, pIV, AES128GCM_IV_SIZE);
+    memset(pOutput + AES128GCM_IV_SIZE, 0, AES128GCM_BLOCK_SIZE - AES128GCM_IV_SIZE);
+    pOutput[AES128GCM_BLOCK_SIZE - 1] = 0x01;
+}
+
+#if defined(OTAESGCM_ALLOW_UNPADDED)
+/**
+ * @note    aes_gctr
+ * @brief   performs gcntr operation for encryption
+ * @param   pInput          pointer to input data (need not be block multiple)
+ * @param   inputLength     length of input array
+ * @param   pKey            pointer to 128 bit AES key
+ * @param   pICB            initial counter block J0
+ * @param   pOutput         pointer to output data. length inputLength rounded up to 16.
+ */
+template<class OTAESImpl>
+void GCTR(OTAESImpl * const ap, GGBWS::GCTRWorkspace * const workspace,
+                    const uint8_t *pInput, const uint8_t inputLength, const uint8_t *pKey,
+                    const uint8_t *pCtrBlock, uint8_t *pOutput)
+{
+    const uint8_t *xpos = pInput;
+    uint8_t *ypos = pOutput;
+
+    // exit function if no input data
+    if (inputLength == 0) return;
+
+    // calculate number of full blocks to cipher
+    const uint8_t n = inputLength / 16;
+
+    // copy ICB to ctrBlock
+    memcpy(workspace->ctrBlock, pCtrBlock, AES128GCM_BLOCK_SIZE);
+
+    // for full blocks
+    for (uint8_t i = 0; i < n; i++) {
+        // cipher counterblock and combine with input
+        ap->blockEncrypt(workspace->ctrBlock, pKey, ypos);
+        xorBlock(ypos, xpos);
+
+        // increment pointers to next block
+        xpos += AES128GCM_BLOCK_SIZE;
+        ypos += AES128GCM_BLOCK_SIZE;
+
+        // increment counter
+        incr32(workspace->ctrBlock);
+    }
+
+    // check if there is a partial block at end.
+    const uint8_t last = uint8_t(pInput + inputLength - xpos);
+    if (last) {
+        // encrypt into tmp and combine with last block of input
+        ap->blockEncrypt(workspace->ctrBlock, pKey, workspace->tmp);
+        for (uint8_t i = 0; i < last; i++)
+            *ypos++ = *xpos++ ^ workspace->tmp[i];
+    }
+}
+#endif
+/**
+ * @note    aes_gctr
+ * @brief   performs gcntr operation for encryption
+ * @param   pInput          pointer to input data (MUST BE be block multiple)
+ * @param   inputLength     length of input array
+ * @param   pKey            pointer to 128 bit AES key
+ * @param   pICB            initial counter block J0
+ * @param   pOutput         pointer to output data. length inputLength rounded up to 16.
+ */
+template<class OTAESImpl>
+void GCTRPadded(OTAESImpl * const ap, GGBWS::GCTRPaddedWorkspace * const workspace,
+                    const uint8_t *pInput, const size_t inputLength, const uint8_t *pKey,
+                    const uint8_t *pCtrBlock, uint8_t *pOutput)
+{
+    // exit function if no input data
+    if (inputLength == 0) return;
+
+    // copy ICB to ctrBlock
+    memcpy(workspace->ctrBlock, pCtrBlock, AES128GCM_BLOCK_SIZE);
+
+    // for full blocks
+    ap->ctrEncrypt(workspace->ctrBlock, pInput, inputLength / AES128GCM_BLOCK_SIZE, pKey, pOutput);
+}
+
+/**
+ * @note    ghash
+ * @brief   performs authentication hashing
+ * @param   gp              GHASH implementation, keyed with subkey H
+ * @param   tmp             16 byte temporary block to zero-pad a partial final block
+ * @param   pInput          pointer to input data
+ * @param   inputLength     length of input array
+ * @param   pOutput         pointer to 16 byte running hash value
+ */
+template<class OTGHASHImpl>
+void GHASH(  OTGHASHImpl * const gp, uint8_t * const tmp,
+                    const uint8_t *pInput, size_t inputLength,
+                    uint8_t *pOutput )
+{
+    // Calculate number of full blocks to hash.
+    const size_t m = inputLength / AES128GCM_BLOCK_SIZE;
+
+    // Hash full blocks.
+    // Y_i = (Y^(i-1) XOR X_i) dot H
+    gp->ghashBlocks(pOutput, pInput, m);
+
+    // Check if final partial block.
+    // Can be omitted if we use full blocks.
+    const uint8_t last = inputLength & (AES128GCM_BLOCK_SIZE-1);
+    if (last) {
+        // zero pad
+        memcpy(tmp, pInput + m*AES128GCM_BLOCK_SIZE, last);
+        memset(tmp + last, 0, AES128GCM_BLOCK_SIZE - last);
+        gp->ghashBlocks(pOutput, tmp, 1);
+    }
+}
+
+#if defined(OTAESGCM_ALLOW_UNPADDED)
+/**
+ * @note    aes_gcm_ctr
+ * @brief   encrypt PDATA to get CDATA
+ * @param   pICB        pointer to initial counter block
+ * @param   pPDATA      pointer to plain text
+ * @param   PDATALength length of plain text (need not be block-size multiple)
+ * @param   pCDATA      pointer to array for cipher text. Length PDATALength rounded up to next 16 bytes
+ */
+template<class OTAESImpl>
+void generateCDATA(OTAESImpl * const ap, GGBWS::GenCDATAWorkspace * const workspace,
+                            const uint8_t *pICB, const uint8_t *pPDATA, uint8_t PDATALength,
+                            uint8_t *pCDATA, const uint8_t *pKey )
+{
+    // Exit if no data to encrypt.
+    if(PDATALength == 0) return;
+    // Generate counter block J.
+    memcpy(workspace->ctrBlock, pICB, AES128GCM_BLOCK_SIZE);
+    incr32(workspace->ctrBlock);
+
+    // Encrypt.
+    GCTR(ap, &workspace->gctrSpace, pPDATA, PDATALength, pKey, workspace->ctrBlock, pCDATA);
+}
+#endif
+/**
+ * @note    aes_gcm_ctr
+ * @brief   encrypt PDATA to get CDATA
+ * @param   pICB        pointer to initial counter block
+ * @param   pPDATA      pointer to plain text
+ * @param   PDATALength length of plain text (MUST BE block-size multiple)
+ * @param   pCDATA      pointer to array for cipher text. Length PDATALength rounded up to next 16 bytes
+ */
+template<class OTAESImpl>
+void generateCDATAPadded(OTAESImpl * const ap, GGBWS::GenCDATAPaddedWorkspace * const cdataSpace,
+                            const uint8_t *pICB, const uint8_t *pPDATAPadded, size_t PDATALength,
+                            uint8_t *pCDATA, const uint8_t *pKey )
+{
+    // Exit if no data to encrypt.
+    if(PDATALength == 0) return;
+
+    // Generate counter block J.
+    memcpy(cdataSpace->ctrBlock, pICB, AES128GCM_BLOCK_SIZE);
+    incr32(cdataSpace->ctrBlock);
+
+    // Encrypt.
+    GCTRPadded(ap, &cdataSpace->gctrSpace, pPDATAPadded, PDATALength, pKey, cdataSpace->ctrBlock, pCDATA);
+}
+
+/**
+ * @brief   starts message S by hashing ADATA
+ * @param   gp              GHASH implementation, keyed with authentication subkey H
+ * @param   pADATA          pointer to array containing authentication data
+ * @param   ADATALength     length of ADATA array
+ */
+template<class OTGHASHImpl>
+void startTag(OTGHASHImpl * const gp,
+                            GGBWS::GenerateTagWorkspace * const workspace,
+                            const uint8_t *pADATA, size_t ADATALength)
+{
+    memset(workspace->S, 0, sizeof(workspace->S));
+    // lengthBuffer is borrowed for padding until the lengths are put in it.
+    GHASH(gp, workspace->lengthBuffer, pADATA, ADATALength, workspace->S);
+}
+
+/**
+ * @brief   hashes the whole blocks of a constant ADATA prefix and keeps the rest
+ * @param   gp              GHASH implementation, keyed with authentication subkey H
+ * @param   pADATAPrefix    pointer to the ADATA prefix
+ * @param   prefixLength    length of the ADATA prefix
+ * @param   prefix          filled in with the state after the prefix
+ */
+template<class OTGHASHImpl>
+void absorbADATAPrefix(OTGHASHImpl * const gp,
+                            const uint8_t *pADATAPrefix, size_t prefixLength,
+                            GCMADATAPrefix &prefix)
+{
+    memset(&prefix, 0, sizeof(prefix));
+    const size_t m = prefixLength / AES128GCM_BLOCK_SIZE;
+    gp->ghashBlocks(prefix.S, pADATAPrefix, m);
+    const uint8_t last = prefixLength & (AES128GCM_BLOCK_SIZE-1);
+    if(last) { memcpy(prefix.tail, pADATAPrefix + m*AES128GCM_BLOCK_SIZE, last); }
+    prefix.length = prefixLength;
+}
+
+/**
+ * @brief   starts message S from a precomputed ADATA prefix, hashing the rest of the ADATA
+ * @param   gp              GHASH implementation, keyed with the same subkey H as the prefix
+ * @param   prefix          state after the ADATA prefix
+ * @param   pADATA          pointer to the rest of the ADATA
+ * @param   ADATALength     length of the rest of the ADATA
+ *
+ * Gives the same S as startTag() over the whole ADATA.
+ */
+template<class OTGHASHImpl>
+void startTagWithPrefix(OTGHASHImpl * const gp,
+                            GGBWS::GenerateTagWorkspace * const workspace,
+                            const GCMADATAPrefix &prefix,
+                            const uint8_t *pADATA, size_t ADATALength)
+{
+    memcpy(workspace->S, prefix.S, sizeof(workspace->S));
+    const uint8_t tailLength = prefix.length & (AES128GCM_BLOCK_SIZE-1);
+    if(tailLength)
+        {
+        // Complete the prefix's partial block from the start of the rest.
+        const uint8_t space = AES128GCM_BLOCK_SIZE - tailLength;
+        const uint8_t fill = (ADATALength < space) ? (uint8_t)ADATALength : space;
+        memcpy(workspace->lengthBuffer, prefix.tail, tailLength);
+        if(fill) { memcpy(workspace->lengthBuffer + tailLength, pADATA, fill); }
+        memset(workspace->lengthBuffer + tailLength + fill, 0, space - fill);
+        gp->ghashBlocks(workspace->S, workspace->lengthBuffer, 1);
+        if(fill == ADATALength) { return; }
+        pADATA += fill;
+        ADATALength -= fill;
+        }
+    // lengthBuffer is borrowed for padding until the lengths are put in it.
+    GHASH(gp, workspace->lengthBuffer, pADATA, ADATALength, workspace->S);
+}
+
+/**
+ * @brief   finishes message S with the lengths and encrypts it to make the tag
+ * @param   ADATALength     length of ADATA array
+ * @param   CDATALength     length of CDATA array
+ * @param   pTag            pointer to array to store tag
+ * @param   pICB            pointer to initial counter block
+ */
+template<class OTAESImpl, class OTGHASHImpl>
+void finishTag(OTAESImpl * const ap, OTGHASHImpl * const gp,
+                            GGBWS::GenerateTagWorkspace * const workspace,
+                            const uint8_t *pKey,
+                            size_t ADATALength, size_t CDATALength,
+                            uint8_t * pTag, const uint8_t *pICB)
+{
+    // put [len(A)]64 || [len(C)]64 in lengthBuffer.
+    putBitLength(workspace->lengthBuffer, ADATALength);
+    putBitLength(workspace->lengthBuffer + 8, CDATALength);
+    gp->ghashBlocks(workspace->S, workspace->lengthBuffer, 1);
+
+    GCTRPadded(ap, &workspace->gctrSpace, workspace->S, sizeof(workspace->S), pKey, pICB, pTag);
+}
+
+/**
+ * @note    aes_gcm_ghash
+ * @brief   makes message S from ADATA and CDATA
+ * @param   pADATA          pointer to array containing authentication data
+ * @param   ADATALength     length of ADATA array
+ * @param   pCDATA          pointer to array containing encrypted data
+ * @param   CDATALength     length of CDATA array
+ * @param   gp              GHASH implementation, keyed with authentication subkey H
+ * @param   pTag            pointer to array to store tag
+ */
+template<class OTAESImpl, class OTGHASHImpl>
+void generateTag(OTAESImpl * const ap, OTGHASHImpl * const gp,
+                            GGBWS::GenerateTagWorkspace * const workspace,
+                            const uint8_t *pKey,
+                            const uint8_t *pADATA, size_t ADATALength,
+                            const uint8_t *pCDATA, size_t CDATALength,
+                            uint8_t * pTag, const uint8_t *pICB)
+{
+    /*
+     * u = 128 * ceil[len(C)/128] - len(C)
+     * v = 128 * ceil[len(A)/128] - len(A)
+     * S = GHASH_H(A || 0^v || C || 0^u || [len(A)]64 || [len(C)]64)
+     * (i.e., zero padded to block size A || C and lengths of each in bits)
+     */
+    startTag(gp, workspace, pADATA, ADATALength);
+    GHASH(gp, workspace->lengthBuffer, pCDATA, CDATALength, workspace->S);
+    finishTag(ap, gp, workspace, pKey, ADATALength, CDATALength, pTag, pICB);
+}
+
+/**
+ * @brief   encrypts PDATA to CDATA and hashes CDATA into S in one pass
+ * @param   workspace       tag workspace, already started with startTag()
+ * @param   pICB            pointer to initial counter block
+ * @param   pPDATAPadded    pointer to plain text
+ * @param   PDATALength     length of plain text (MUST BE block-size multiple)
+ * @param   pCDATA          pointer to array for cipher text; must not overlap plain text
+ *
+ * Rather than writing all of CDATA and then reading it all back to hash,
+ * works in chunks of FUSED_CHUNK_BLOCKS so each chunk of cipher text
+ * is hashed while still in cache.
+ * The AES for the next chunk is done before the GHASH of the current one,
+ * so that the two independent streams of work can overlap.
+ */
+template<class OTAESImpl, class OTGHASHImpl>
+void generateCDATAAndHashPadded(OTAESImpl * const ap, OTGHASHImpl * const gp,
+                            GGBWS::GenerateTagWorkspace * const workspace,
+                            const uint8_t *pICB, const uint8_t *pPDATAPadded, size_t PDATALength,
+                            uint8_t *pCDATA, const uint8_t *pKey)
+{
+    size_t remaining = PDATALength / AES128GCM_BLOCK_SIZE;
+    // Exit if no data to encrypt.
+    if(0 == remaining) return;
+
+    // Generate counter block J.
+    memcpy(workspace->ctrBlock, pICB, AES128GCM_BLOCK_SIZE);
+    incr32(workspace->ctrBlock);
+
+    size_t n = (remaining > FUSED_CHUNK_BLOCKS) ? FUSED_CHUNK_BLOCKS : remaining;
+    ap->ctrEncrypt(workspace->ctrBlock, pPDATAPadded, n, pKey, pCDATA);
+    for( ; ; ) {
+        const uint8_t *const toHash = pCDATA;
+        const size_t nToHash = n;
+        remaining -= n;
+        pPDATAPadded += n * AES128GCM_BLOCK_SIZE;
+        pCDATA += n * AES128GCM_BLOCK_SIZE;
+        if(0 == remaining) {
+            gp->ghashBlocks(workspace->S, toHash, nToHash);
+            return;
+        }
+        // Encrypt the next chunk, then hash this one.
+        n = (remaining > FUSED_CHUNK_BLOCKS) ? FUSED_CHUNK_BLOCKS : remaining;
+        ap->ctrEncrypt(workspace->ctrBlock, pPDATAPadded, n, pKey, pCDATA);
+        gp->ghashBlocks(workspace->S, toHash, nToHash);
+    }
+}
+
+/**
+ * @note    aes_gcm_init_hash_subkey
+ * @brief   generates authentication subkey H
+ * @param   pKey            pointer to 128 bit AES key
+ * @param   pOutput         pointer to 16 byte array put to subkey H in
+ * @note    tested arduino 1.6.5
+ */
+template<class OTAESImpl>
+void generateAuthKey(OTAESImpl * const ap, const uint8_t *pKey, uint8_t *pAuthKey)
+{
+    // original has if(aes == NULL) return NULL;
+
+    // Encrypt 128 bit block of 0s to generate authentication sub-key.
+    memset(pAuthKey, 0, AES128GCM_BLOCK_SIZE);
+    ap->blockEncrypt(pAuthKey, pKey, pAuthKey);
+}
+
+#if defined(OTAESGCM_ALLOW_UNPADDED)
+/**
+ * @brief   performs AES-GCM encryption, as for OTAES128GCM::gcmEncrypt()
+ * @param   workspace       per-message workspace, wiped before returning
+ * @retval  true if encryption successful, else false
+ */
+template<class OTAESImpl, class OTGHASHImpl>
+bool encrypt(OTAESImpl * const ap, OTGHASHImpl * const gp,
+                        GGBWS::GCMEncryptWorkspace &workspace,
+                        const uint8_t* key, const uint8_t* IV,
+                        const uint8_t* PDATA, uint8_t PDATALength,
+                        const uint8_t* ADATA, uint8_t ADATALength,
+                        uint8_t* CDATA, uint8_t *tag)
+{
+    if(NULL == CDATA) { return(false); } // DHD20161107: NULL CDATA causes crashes in subroutines.
+
+    // Check if there is input data.
+    // Fail if there is nothing to encrypt and/or authenticate.
+    if((PDATALength == 0) && (ADATALength == 0)) { return(false); }
+
+    // Compute implicit CDATA length (ie rounded up to the next block size if necessary).
+    if(PDATALength >= (uint8_t)(256U - (uint16_t)AES128GCM_BLOCK_SIZE)) { return(false); } // Too big.
+    const uint8_t CDATALength = (PDATALength + AES128GCM_BLOCK_SIZE-1) & ~(AES128GCM_BLOCK_SIZE-1);
+
+    // Expand the key once for the whole message.
+    ap->retainKeySchedule(key);
+
+    // Encrypt data.
+    generateAuthKey(ap, key, workspace.authKey);
+    gp->setAuthKey(workspace.authKey);
+    generateICB(IV, workspace.ICB);
+    // ICB is hashed with the key then XORed with PDATA to encrypt plain text.
+    generateCDATA(ap, &workspace.cdataWorkspace, workspace.ICB, PDATA, PDATALength, CDATA, key);
+
+    // Generate authentication tag.
+    generateTag(ap, gp, &workspace.tagWorkspace, key, ADATA, ADATALength, CDATA, CDATALength, tag, workspace.ICB);
+
+    // Erase workspace for security.
+    gp->clearAuthKey();
+    ap->clearKeySchedule();
+    memset(&workspace, 0, sizeof(workspace));
+
+    return(true);
+}
+#endif
+
+/**
+ * @brief   performs AES-GCM encryption on padded data, as for OTAES128GCM::gcmEncryptPadded()
+ *          but not limited to 255-byte texts
+ * @param   workspace       per-message workspace, wiped before returning
+ * @retval  true if encryption is successful, else false
+ */
+template<class OTAESImpl, class OTGHASHImpl>
+bool encryptPadded(OTAESImpl * const ap, OTGHASHImpl * const gp,
+                        GGBWS::GCMEncryptPaddedWorkspace &workspace,
+                        const uint8_t* key, const uint8_t* IV,
+                        const uint8_t* PDATAPadded, size_t PDATALength,
+                        const uint8_t* ADATA, size_t ADATALength,
+                        uint8_t* CDATA, uint8_t *tag)
+{
+    if(NULL == CDATA) { return(false); } // DHD20161107: NULL CDATA causes crashes in subroutines.
+    if(0 != (PDATALength & (AES128GCM_BLOCK_SIZE-1))) { return(false); } // Reject non-padded data.
+    if((uint64_t)PDATALength > GCM_MAX_TEXT_LENGTH) { return(false); } // Too big.
+
+    // Check if there is input data.
+    // Fail if there is nothing to encrypt and/or authenticate.
+    if((PDATALength == 0) && (ADATALength == 0)) { return(false); }
+
+    const size_t CDATALength = PDATALength;
+
+    // Expand the key once for the whole message.
+    ap->retainKeySchedule(key);
+
+    // Encrypt data.
+    generateAuthKey(ap, key, workspace.authKey);
+    gp->setAuthKey(workspace.authKey);
+    generateICB(IV, workspace.ICB);
+    // ICB is hashed with the key then XORed with PDATA to encrypt plain text,
+    // and each chunk of cipher text hashed as it is produced.
+    startTag(gp, &workspace.tagWorkspace, ADATA, ADATALength);
+    generateCDATAAndHashPadded(ap, gp, &workspace.tagWorkspace, workspace.ICB, PDATAPadded, PDATALength, CDATA, key);
+
+    // Generate authentication tag.
+    finishTag(ap, gp, &workspace.tagWorkspace, key, ADATALength, CDATALength, tag, workspace.ICB);
+
+    // Erase workspace for security.
+    gp->clearAuthKey();
+    ap->clearKeySchedule();
+    memset(&workspace, 0, sizeof(workspace));
+
+    return(true);
+}
+
+/**
+ * @brief   performs AES-GCM decryption and authentication, as for OTAES128GCM::gcmDecrypt()
+ *          but not limited to 255-byte texts
+ * @param   workspace       per-message workspace, wiped before returning
+ * @retval  true if decryption and authentication successful, else false
+ *
+ * The tag is checked before any decryption, and PDATA is only written
+ * if it matches, so a rejected message of n blocks costs 2 block encryptions
+ * (H and E(K, J0)) rather than n+2, eg 2 rather than 4 for a 32 byte frame.
+ */
+template<class OTAESImpl, class OTGHASHImpl>
+bool decrypt(OTAESImpl * const ap, OTGHASHImpl * const gp,
+                        GGBWS::GCMDecryptWorkspace &workspace,
+                        const uint8_t* key, const uint8_t* IV,
+                        const uint8_t* CDATA, size_t CDATALength,
+                        const uint8_t* ADATA, size_t ADATALength,
+                        const uint8_t* messageTag, uint8_t *PDATA)
+{
+    // Check if there is input data.
+    // Fail if there is nothing to decrypt and/or authenticate.
+    if((CDATALength == 0) && (ADATALength == 0)) { return(false); }
+
+    // Fail if the CDATA length is not a multiple of the block size.
+    if(0 != (CDATALength & (AES128GCM_BLOCK_SIZE-1))) { return(false); }
+    if((uint64_t)CDATALength > GCM_MAX_TEXT_LENGTH) { return(false); } // Too big.
+
+    // Expand the key once for the whole message.
+    ap->retainKeySchedule(key);
+
+    generateAuthKey(ap, key, workspace.authKey);
+    gp->setAuthKey(workspace.authKey);
+    generateICB(IV, workspace.ICB);
+
+    // Authenticate first, from the cipher text.
+    generateTag(ap, gp, &workspace.tagWorkspace, key, ADATA, ADATALength, CDATA, CDATALength, workspace.calculatedTag, workspace.ICB);
+    const bool success = (0 == checkTag(workspace.calculatedTag, messageTag));
+
+    // Decrypt CDATA only if authentic.
+    // ICB is hashed with the key then XORed with CDATA to decrypt cipher text.
+    if(success) { generateCDATAPadded(ap, &workspace.cdataWorkspace, workspace.ICB, CDATA, CDATALength, PDATA, key); }
+
+    // Erase workspace for security.
+    gp->clearAuthKey();
+    ap->clearKeySchedule();
+    memset(&workspace, 0, sizeof(workspace));
+
+    return(success);
+}
+
+/**
+ * @brief   computes the GMAC tag of ADATA alone, with H already set
+ * @param   S               16 byte running hash workspace
+ * @param   block           16 byte workspace for padding, lengths and J0; may be the same as pTag
+ * @param   pKey            pointer to 128 bit AES key
+ * @param   pIV             pointer to 12 byte IV
+ * @param   pADATA          pointer to authentication data
+ * @param   ADATALength     length of ADATA
+ * @param   pTag            pointer to 16 byte tag output
+ *
+ * As for generateTag() with no cipher text, so with no counter mode at all:
+ * T = E(K, J0) xor GHASH_H(A || 0^v || [len(A)]64 || [0]64).
+ */
+template<class OTAESImpl, class OTGHASHImpl>
+void gmacTag(OTAESImpl * const ap, OTGHASHImpl * const gp,
+                            uint8_t * const S, uint8_t * const block,
+                            const uint8_t *pKey, const uint8_t *pIV,
+                            const uint8_t *pADATA, size_t ADATALength,
+                            uint8_t *pTag)
+{
+    memset(S, 0, AES128GCM_BLOCK_SIZE);
+    GHASH(gp, block, pADATA, ADATALength, S);
+    putBitLength(block, ADATALength);
+    memset(block + 8, 0, 8);
+    gp->ghashBlocks(S, block, 1);
+    generateICB(pIV, block);
+    ap->blockEncrypt(block, pKey, pTag);
+    xorBlock(pTag, S);
+}
+
+/**
+ * @brief   computes a GMAC (authentication-only GCM) tag over ADATA
+ * @param   workspace       per-message workspace, wiped before returning
+ * @param   pTag            16 byte tag output; may be workspace.block
+ * @retval  true if successful, false if ADATA is empty or too long
+ *
+ * Same tag as encryptPadded() with no plain text, but with no counter mode setup,
+ * no CDATA, and a smaller workspace.
+ */
+template<class OTAESImpl, class OTGHASHImpl>
+bool gmac(OTAESImpl * const ap, OTGHASHImpl * const gp,
+                        GGBWS::GMACWorkspace &workspace,
+                        const uint8_t* key, const uint8_t* IV,
+                        const uint8_t* ADATA, size_t ADATALength,
+                        uint8_t *tag)
+{
+    // Fail if there is nothing to authenticate.
+    if(0 == ADATALength) { return(false); }
+    if((uint64_t)ADATALength > GCM_MAX_ADATA_LENGTH) { return(false); } // Too big.
+
+    // Expand the key once for H and E(K, J0).
+    ap->retainKeySchedule(key);
+    generateAuthKey(ap, key, workspace.authKey);
+    gp->setAuthKey(workspace.authKey);
+    gmacTag(ap, gp, workspace.S, workspace.block, key, IV, ADATA, ADATALength, tag);
+    gp->clearAuthKey();
+    ap->clearKeySchedule();
+    return(true);
+}
+
+/**
+ * @brief   computes a GMAC tag into the workspace and wipes the workspace
+ * @retval  true if successful, else false
+ */
+template<class OTAESImpl, class OTGHASHImpl>
+bool gmacCompute(OTAESImpl * const ap, OTGHASHImpl * const gp,
+                        GGBWS::GMACWorkspace &workspace,
+                        const uint8_t* key, const uint8_t* IV,
+                        const uint8_t* ADATA, size_t ADATALength,
+                        uint8_t *tag)
+{
+    const bool success = gmac(ap, gp, workspace, key, IV, ADATA, ADATALength, tag);
+    // Erase workspace for security.
+    memset(&workspace, 0, sizeof(workspace));
+    return(success);
+}
+
+/**
+ * @brief   verifies a GMAC tag over ADATA
+ * @retval  true iff ADATA is authentic
+ *
+ * The comparison time does not depend on where the tags differ.
+ */
+template<class OTAESImpl, class OTGHASHImpl>
+bool gmacVerify(OTAESImpl * const ap, OTGHASHImpl * const gp,
+                        GGBWS::GMACWorkspace &workspace,
+                        const uint8_t* key, const uint8_t* IV,
+                        const uint8_t* ADATA, size_t ADATALength,
+                        const uint8_t *messageTag)
+{
+    const bool success = gmac(ap, gp, workspace, key, IV, ADATA, ADATALength, workspace.block) &&
+        (0 == checkTag(workspace.block, messageTag));
+    // Erase workspace for security.
+    memset(&workspace, 0, sizeof(workspace));
+    return(success);
+}
+
+    // Counter mode over a compile-time number of whole blocks,
+    // starting at counter block J0+1 as for generateCDATAPadded().
+    // With a 96-bit IV the J0 counter field starts at 1,
+    // so only the last counter byte changes, with no carry propagation.
+    // All the blocks go to one ctrEncrypt() call,
+    // so that implementations can pipeline or interleave them.
+    // The input and output must not overlap.
+    template<uint8_t nBlocks>
+    struct CTRFixedBlocks final
+        {
+        static_assert(nBlocks <= 253, "last counter byte would wrap");
+        template<class OTAESImpl>
+        static inline void blocks(OTAESImpl * const ap, uint8_t *const pCtrBlock,
+                    const uint8_t *const pInput, const uint8_t *const pKey, uint8_t *const pOutput)
+            {
+            pCtrBlock[AES128GCM_BLOCK_SIZE - 1] = 2;
+            ap->ctrEncrypt(pCtrBlock, pInput, nBlocks, pKey, pOutput);
+            }
+        };
+
+/**
+ * @brief   puts the [len(A)]64 || [len(C)]64 block for a compile-time text length
+ * @param   p               pointer to 16 byte output
+ * @param   ADATALength     length of ADATA, at most MaxADATALength
+ *
+ * The text length half is a constant, and with the ADATA length bounded
+ * only the bottom two bytes of its half vary.
+ */
+template<uint8_t TextSize, size_t MaxADATALength>
+inline void putFixedLengths(uint8_t *const p, const size_t ADATALength)
+{
+    static_assert(MaxADATALength < 8192, "ADATA bit length must fit in 16 bits");
+    memset(p, 0, AES128GCM_BLOCK_SIZE);
+    p[6] = (uint8_t)(ADATALength >> 5);
+    p[7] = (uint8_t)(ADATALength << 3);
+    p[14] = (uint8_t)(((uint16_t)TextSize << 3) >> 8);
+    p[15] = (uint8_t)((uint16_t)TextSize << 3);
+}
+
+/**
+ * @brief   performs AES-GCM encryption of exactly TextSize bytes of plain text,
+ *          as for encryptPadded() but specialised at compile time
+ * @param   PDATA           TextSize bytes of plain text; NULL if TextSize is 0
+ * @param   ADATALength     length of ADATA, at most MaxADATALength
+ * @retval  true if encryption is successful, else false
+ *
+ * The counter mode is unrolled, the length block mostly constant,
+ * and the GHASH a fixed sequence of calls with no loops here,
+ * eg for the 32 byte OpenTRV secure frame body.
+ * TextSize 0 is GMAC over the ADATA alone.
+ */
+template<uint8_t TextSize, size_t MaxADATALength, class OTAESImpl, class OTGHASHImpl>
+bool encryptFixed(OTAESImpl * const ap, OTGHASHImpl * const gp,
+                        GGBWS::GCMEncryptPaddedWorkspace &workspace,
+                        const uint8_t* key, const uint8_t* IV,
+                        const uint8_t* PDATA,
+                        const uint8_t* ADATA, size_t ADATALength,
+                        uint8_t* CDATA, uint8_t *tag)
+{
+    static_assert(0 == (TextSize & (AES128GCM_BLOCK_SIZE-1)), "text must be whole blocks");
+    constexpr uint8_t nBlocks = TextSize / AES128GCM_BLOCK_SIZE;
+    if(NULL == CDATA) { return(false); } // As for encryptPadded().
+    if((0 != TextSize) && (NULL == PDATA)) { return(false); }
+    if(ADATALength > MaxADATALength) { return(false); }
+    // Fail if there is nothing to encrypt and/or authenticate.
+    if((0 == TextSize) && (0 == ADATALength)) { return(false); }
+    GGBWS::GenerateTagWorkspace &tw = workspace.tagWorkspace;
+
+    // Expand the key once for the whole message.
+    ap->retainKeySchedule(key);
+
+    generateAuthKey(ap, key, workspace.authKey);
+    gp->setAuthKey(workspace.authKey);
+    generateICB(IV, workspace.ICB);
+    startTag(gp, &tw, ADATA, ADATALength);
+
+    // Encrypt, then hash all of the cipher text and the lengths.
+    memcpy(tw.ctrBlock, workspace.ICB, AES128GCM_BLOCK_SIZE);
+    CTRFixedBlocks<nBlocks>::blocks(ap, tw.ctrBlock, PDATA, key, CDATA);
+    gp->ghashBlocks(tw.S, CDATA, nBlocks);
+    putFixedLengths<TextSize, MaxADATALength>(tw.lengthBuffer, ADATALength);
+    gp->ghashBlocks(tw.S, tw.lengthBuffer, 1);
+
+    // T = E(K, J0) xor S.
+    ap->blockEncrypt(workspace.ICB, key, tag);
+    xorBlock(tag, tw.S);
+
+    // Erase workspace for security.
+    gp->clearAuthKey();
+    ap->clearKeySchedule();
+    memset(&workspace, 0, sizeof(workspace));
+
+    return(true);
+}
+
+/**
+ * @brief   performs AES-GCM decryption and authentication of exactly TextSize bytes of cipher text,
+ *          as for decrypt() but specialised at compile time
+ * @param   CDATA           TextSize bytes of cipher text; NULL if TextSize is 0
+ * @param   ADATALength     length of ADATA, at most MaxADATALength
+ * @retval  true if decryption and authentication successful, else false
+ *
+ * As for decrypt() the tag is checked first and PDATA only written if it matches.
+ */
+template<uint8_t TextSize, size_t MaxADATALength, class OTAESImpl, class OTGHASHImpl>
+bool decryptFixed(OTAESImpl * const ap, OTGHASHImpl * const gp,
+                        GGBWS::GCMDecryptWorkspace &workspace,
+                        const uint8_t* key, const uint8_t* IV,
+                        const uint8_t* CDATA,
+                        const uint8_t* ADATA, size_t ADATALength,
+                        const uint8_t* messageTag, uint8_t *PDATA)
+{
+    static_assert(0 == (TextSize & (AES128GCM_BLOCK_SIZE-1)), "text must be whole blocks");
+    constexpr uint8_t nBlocks = TextSize / AES128GCM_BLOCK_SIZE;
+    if((0 != TextSize) && ((NULL == CDATA) || (NULL == PDATA))) { return(false); }
+    if(ADATALength > MaxADATALength) { return(false); }
+    // Fail if there is nothing to decrypt and/or authenticate.
+    if((0 == TextSize) && (0 == ADATALength)) { return(false); }
+    GGBWS::GenerateTagWorkspace &tw = workspace.tagWorkspace;
+
+    // Expand the key once for the whole message.
+    ap->retainKeySchedule(key);
+
+    generateAuthKey(ap, key, workspace.authKey);
+    gp->setAuthKey(workspace.authKey);
+    generateICB(IV, workspace.ICB);
+
+    // Authenticate first, from the cipher text.
+    startTag(gp, &tw, ADATA, ADATALength);
+    gp->ghashBlocks(tw.S, CDATA, nBlocks);
+    putFixedLengths<TextSize, MaxADATALength>(tw.lengthBuffer, ADATALength);
+    gp->ghashBlocks(tw.S, tw.lengthBuffer, 1);
+    ap->blockEncrypt(workspace.ICB, key, workspace.calculatedTag);
+    xorBlock(workspace.calculatedTag, tw.S);
+    const bool success = (0 == checkTag(workspace.calculatedTag, messageTag));
+
+    // Decrypt CDATA only if authentic.
+    if(success)
+        {
+        memcpy(tw.ctrBlock, workspace.ICB, AES128GCM_BLOCK_SIZE);
+        CTRFixedBlocks<nBlocks>::blocks(ap, tw.ctrBlock, CDATA, key, PDATA);
+        }
+
+    // Erase workspace for security.
+    gp->clearAuthKey();
+    ap->clearKeySchedule();
+    memset(&workspace, 0, sizeof(workspace));
+
+    return(success);
+}
+
+    }
+
+    // AES-GCM engine parameterised with the type of the underlying AES and GHASH implementations,
+    // with every call resolved at compile time, so that AES, CTR and GHASH
+    // can be inlined into one another and constants propagated;
+    // no virtual functions, so no vtable.
+    // Carries the AES and GHASH working state with it, in the workspace passed in,
+    // laid out as the AES workspace, then the GHASH workspace, then the GCM function workspace,
+    // exactly as for OTAES128GCMGenericWithWorkspace, which is a thin virtual adaptor over this.
+    // The key schedule is expanded once per message rather than once per block.
+    // Fails safely (returning false) if the workspace is too small for the function called.
+    //
+    // For security, as far as is reasonably possible:
+    //   * the OTAESImpl methods should erase private state before returning.
+    //   * the gcm function methods erase private state
+    //     (including any GHASH tables and key schedule) before returning,
+    //     except a key schedule cached with cacheKeySchedule().
+    template<class OTAESImpl = OTAESGCM::OTAES128E_default_t, class OTGHASHImpl = OTAESGCM::OTGHASH_default_t>
+    class OTAES128GCMEngine
+        {
+        public:
+            constexpr static uint8_t workspaceRequiredAES = OTAESImpl::workspaceRequired;
+            constexpr static size_t workspaceRequiredGHASH = OTGHASHImpl::workspaceRequired;
+
+            // Suitable type to hold size of workspace required.
+            typedef size_t workspacesize_t;
+
+            // Minimum and maximum size of workspace required
+            // (dependent on which function is to be called).
+            constexpr static workspacesize_t workspaceRequiredMin =
+                workspaceRequiredAES + workspaceRequiredGHASH + GGBWS::minWS;
+            constexpr static workspacesize_t workspaceRequiredMax =
+                workspaceRequiredAES + workspaceRequiredGHASH + GGBWS::maxWS;
+            // Conservatively/statically request the maximum workspace needed.
+            constexpr static workspacesize_t workspaceRequired = workspaceRequiredMax;
+            // Verify that the workspace is adequate
+            // at least for the least-demanding function.
+            // This check may be made at compile time in common cases.
+            static constexpr bool isWorkspaceSufficientMin(uint8_t *const workspace, const workspacesize_t workspaceSize)
+                { return((NULL != workspace) && (workspaceSize >= workspaceRequiredMin)); }
+            // Verify that the workspace is adequate
+            // for the most-demanding function.
+            // This check may be made at compile time in common cases.
+            static constexpr bool isWorkspaceSufficient(uint8_t *const workspace, const workspacesize_t workspaceSize)
+                { return((NULL != workspace) && (workspaceSize >= workspaceRequiredMax)); }
+
+            // Workspace sufficient for gcmEncrypt().
+            static constexpr workspacesize_t workspaceRequiredEnc = workspaceRequiredAES + workspaceRequiredGHASH + (workspacesize_t) GGBWS::gcmEncryptWorkspaceRequired;
+            // True if workspace sufficient for gcmEncrypt().
+            static constexpr bool isWorkspaceSufficientEnc(uint8_t *const workspace, const workspacesize_t workspaceSize)
+                { return((NULL != workspace) && (workspaceSize >= workspaceRequiredEnc)); }
+            // Workspace sufficient for gcmEncryptPadded().
+            static constexpr workspacesize_t workspaceRequiredEncPadded = workspaceRequiredAES + workspaceRequiredGHASH + (workspacesize_t) GGBWS::gcmEncryptPaddedWorkspaceRequired;
+            // True if workspace sufficient for gcmEncryptPadded().
+            static constexpr bool isWorkspaceSufficientEncPadded(uint8_t *const workspace, const workspacesize_t workspaceSize)
+                { return((NULL != workspace) && (workspaceSize >= workspaceRequiredEncPadded)); }
+            // Workspace sufficient for gcmDecrypt().
+            static constexpr workspacesize_t workspaceRequiredDec = workspaceRequiredAES + workspaceRequiredGHASH + (workspacesize_t) GGBWS::gcmDecryptWorkspaceRequired;
+            // True if workspace sufficient for gcmDecrypt().
+            static constexpr bool isWorkspaceSufficientDec(uint8_t *const workspace, const workspacesize_t workspaceSize)
+                { return((NULL != workspace) && (workspaceSize >= workspaceRequiredDec)); }
+            // Workspace sufficient for gmacCompute() and gmacVerify().
+            static constexpr workspacesize_t workspaceRequiredGMAC = workspaceRequiredAES + workspaceRequiredGHASH + (workspacesize_t) GGBWS::gmacWorkspaceRequired;
+            // True if workspace sufficient for gmacCompute() and gmacVerify().
+            static constexpr bool isWorkspaceSufficientGMAC(uint8_t *const workspace, const workspacesize_t workspaceSize)
+                { return((NULL != workspace) && (workspaceSize >= workspaceRequiredGMAC)); }
+
+        private:
+            OTAESImpl aes;
+            OTGHASHImpl ghash;
+            // Workspace passed in to the constructor, and its size.
+            uint8_t *const workspace;
+            const workspacesize_t workspaceSize;
+            // GCM workspace part of the workspace.
+            uint8_t *gcmWorkspace() const { return(workspace + workspaceRequiredAES + workspaceRequiredGHASH); }
+
+        public:
+            // Construct an instance, supplied with workspace.
+            // Pass the AES and GHASH support classes the leading parts of the workspace.
+            OTAES128GCMEngine(uint8_t *const workspace_, const workspacesize_t workspaceSize_)
+                : aes(workspace_, isWorkspaceSufficientMin(workspace_, workspaceSize_) ? workspaceRequiredAES : 0),
+                  ghash(workspace_ + workspaceRequiredAES, isWorkspaceSufficientMin(workspace_, workspaceSize_) ? workspaceRequiredGHASH : 0),
+                  workspace(workspace_), workspaceSize(workspaceSize_)
+                { }
+
+            // Keep the AES key schedule from one call to the next while the key bytes are unchanged,
+            // eg for a leaf node sending every frame under one key from wherever it is held;
+            // see OTAES128E::cacheKeySchedule().
+            // The schedule then stays in the workspace until wipeKeySchedule().
+            void cacheKeySchedule() { aes.OTAESImpl::cacheKeySchedule(); }
+            // Stop caching and wipe any AES key schedule; safe to call at any time.
+            void wipeKeySchedule() { aes.OTAESImpl::wipeKeySchedule(); }
+
+#if defined(OTAESGCM_ALLOW_UNPADDED)
+            // Encrypt; true iff successful.
+            // As for OTAES128GCM::gcmEncrypt().
+            bool gcmEncrypt(
+                const uint8_t* key, const uint8_t* IV,
+                const uint8_t* PDATA, uint8_t PDATALength,
+                const uint8_t* ADATA, uint8_t ADATALength,
+                uint8_t* CDATA, uint8_t *tag)
+                {
+                if(!isWorkspaceSufficientEnc(workspace, workspaceSize)) { return(false); }
+                GCMEngine::OTAES128EDirect<OTAESImpl> a(aes);
+                GCMEngine::OTGHASHDirect<OTGHASHImpl> g(ghash);
+                return(GCMEngine::encrypt(&a, &g, *(GGBWS::GCMEncryptWorkspace *)gcmWorkspace(),
+                    key, IV, PDATA, PDATALength, ADATA, ADATALength, CDATA, tag));
+                }
+#endif
+
+            // Encrypt; true if successful.
+            // As for OTAES128GCM::gcmEncryptPadded(),
+            // but not limited to 255-byte texts (up to the GCM limit of 2^36-32 bytes).
+            bool gcmEncryptPadded(
+                const uint8_t* key, const uint8_t* IV,
+                const uint8_t* PDATAPadded, size_t PDATALength,
+                const uint8_t* ADATA, size_t ADATALength,
+                uint8_t* CDATA, uint8_t *tag)
+                {
+                if(!isWorkspaceSufficientEncPadded(workspace, workspaceSize)) { return(false); }
+                GCMEngine::OTAES128EDirect<OTAESImpl> a(aes);
+                GCMEngine::OTGHASHDirect<OTGHASHImpl> g(ghash);
+                return(GCMEngine::encryptPadded(&a, &g, *(GGBWS::GCMEncryptPaddedWorkspace *)gcmWorkspace(),
+                    key, IV, PDATAPadded, PDATALength, ADATA, ADATALength, CDATA, tag));
+                }
+
+            // Decrypt; true iff successful.
+            // As for OTAES128GCM::gcmDecrypt(),
+            // but not limited to 255-byte texts.
+            bool gcmDecrypt(
+                 const uint8_t* key, const uint8_t* IV,
+                 const uint8_t* CDATA, size_t CDATALength,
+                 const uint8_t* ADATA, size_t ADATALength,
+                 const uint8_t* messageTag, uint8_t *PDATA)
+                {
+                if(!isWorkspaceSufficientDec(workspace, workspaceSize)) { return(false); }
+                GCMEngine::OTAES128EDirect<OTAESImpl> a(aes);
+                GCMEngine::OTGHASHDirect<OTGHASHImpl> g(ghash);
+                return(GCMEngine::decrypt(&a, &g, *(GGBWS::GCMDecryptWorkspace *)gcmWorkspace(),
+                    key, IV, CDATA, CDATALength, ADATA, ADATALength, messageTag, PDATA));
+                }
+
+            // Compute the GMAC tag of ADATA alone (authentication only); true if successful.
+            // Same tag as gcmEncryptPadded() with no plain text,
+            // but needs only workspaceRequiredGMAC bytes of workspace and no CDATA.
+            // Fails if ADATA is empty.
+            bool gmacCompute(
+                const uint8_t* key, const uint8_t* IV,
+                const uint8_t* ADATA, size_t ADATALength,
+                uint8_t *tag)
+                {
+                if(!isWorkspaceSufficientGMAC(workspace, workspaceSize)) { return(false); }
+                GCMEngine::OTAES128EDirect<OTAESImpl> a(aes);
+                GCMEngine::OTGHASHDirect<OTGHASHImpl> g(ghash);
+                return(GCMEngine::gmacCompute(&a, &g, *(GGBWS::GMACWorkspace *)gcmWorkspace(),
+                    key, IV, ADATA, ADATALength, tag));
+                }
+
+            // Verify the GMAC tag of ADATA; true iff authentic.
+            bool gmacVerify(
+                const uint8_t* key, const uint8_t* IV,
+                const uint8_t* ADATA, size_t ADATALength,
+                const uint8_t *messageTag)
+                {
+                if(!isWorkspaceSufficientGMAC(workspace, workspaceSize)) { return(false); }
+                GCMEngine::OTAES128EDirect<OTAESImpl> a(aes);
+                GCMEngine::OTGHASHDirect<OTGHASHImpl> g(ghash);
+                return(GCMEngine::gmacVerify(&a, &g, *(GGBWS::GMACWorkspace *)gcmWorkspace(),
+                    key, IV, ADATA, ADATALength, messageTag));
+                }
+
+            // Encrypt exactly TextSize bytes (a whole number of blocks, possibly none)
+            // with at most MaxADATALength bytes of ADATA; true if successful.
+            // Same result as gcmEncryptPadded() with PDATALength == TextSize,
+            // but with the counter mode unrolled and the length block mostly constant,
+            // eg gcmEncryptFixed<32>() for the fixed 32 byte frames.
+            template<uint8_t TextSize, size_t MaxADATALength = 255>
+            bool gcmEncryptFixed(
+                const uint8_t* key, const uint8_t* IV,
+                const uint8_t* PDATA,
+                const uint8_t* ADATA, size_t ADATALength,
+                uint8_t* CDATA, uint8_t *tag)
+                {
+                if(!isWorkspaceSufficientEncPadded(workspace, workspaceSize)) { return(false); }
+                GCMEngine::OTAES128EDirect<OTAESImpl> a(aes);
+                GCMEngine::OTGHASHDirect<OTGHASHImpl> g(ghash);
+                return(GCMEngine::encryptFixed<TextSize, MaxADATALength>(&a, &g, *(GGBWS::GCMEncryptPaddedWorkspace *)gcmWorkspace(),
+                    key, IV, PDATA, ADATA, ADATALength, CDATA, tag));
+                }
+
+            // Decrypt exactly TextSize bytes with at most MaxADATALength bytes of ADATA; true iff successful.
+            // Same result as gcmDecrypt() with CDATALength == TextSize.
+            template<uint8_t TextSize, size_t MaxADATALength = 255>
+            bool gcmDecryptFixed(
+                 const uint8_t* key, const uint8_t* IV,
+                 const uint8_t* CDATA,
+                 const uint8_t* ADATA, size_t ADATALength,
+                 const uint8_t* messageTag, uint8_t *PDATA)
+                {
+                if(!isWorkspaceSufficientDec(workspace, workspaceSize)) { return(false); }
+                GCMEngine::OTAES128EDirect<OTAESImpl> a(aes);
+                GCMEngine::OTGHASHDirect<OTGHASHImpl> g(ghash);
+                return(GCMEngine::decryptFixed<TextSize, MaxADATALength>(&a, &g, *(GGBWS::GCMDecryptWorkspace *)gcmWorkspace(),
+                    key, IV, CDATA, ADATA, ADATALength, messageTag, PDATA));
+                }
+        };
+
+
+    }
+
+#endif
@@ -0,0 +1,600 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/*
+ * Google Benchmark suite for the AES, GHASH and GCM implementations.
+ *
+ * Each benchmark reports ns/op as usual, bytes/s where meaningful,
+ * and on x86 also cycles/op and cycles/byte from the TSC.
+ * Build with optimisation (as the meson OTAESGCMBench target does),
+ * eg run as:
+ *
+ *     ./OTAESGCMBench --benchmark_filter=GCM
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <benchmark/benchmark.h>
+#include <OTAESGCM.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define OTAESGCM_BENCH_HAS_TSC
+#endif
+
+namespace
+{
+
+// Reads a cycle counter where available, else 0.
+inline uint64_t cycles()
+{
+#if defined(OTAESGCM_BENCH_HAS_TSC)
+    return(__rdtsc());
+#else
+    return(0);
+#endif
+}
+
+// Sets the counters for a finished benchmark loop.
+// bytesPerOp is the text plus authenticated text handled per iteration.
+void report(benchmark::State &state, const uint64_t startCycles, const size_t bytesPerOp)
+{
+    const double ops = (double)state.iterations();
+    if(0 != bytesPerOp) { state.SetBytesProcessed((int64_t)(state.iterations() * bytesPerOp)); }
+#if defined(OTAESGCM_BENCH_HAS_TSC)
+    const double c = (double)(cycles() - startCycles);
+    state.counters["cycles/op"] = c / ops;
+    if(0 != bytesPerOp) { state.counters["cycles/byte"] = c / (ops * bytesPerOp); }
+#else
+    (void)startCycles; (void)ops;
+#endif
+}
+
+// Fixed test inputs, large enough for any message.
+const uint8_t key[16] = { 0x29, 0x8e, 0xfa, 0x1c, 0xcf, 0x29, 0xcf, 0x62, 0xae, 0x68, 0x24, 0xbf, 0xc1, 0x95, 0x57, 0xfc };
+const uint8_t key2[16] = { 0xd4, 0xa2, 0x24, 0x88, 0xf8, 0xdd, 0x1d, 0x5c, 0x6c, 0x19, 0xa7, 0xd6, 0xca, 0x17, 0x96, 0x4c };
+const uint8_t nonce[12] = { 0x6f, 0x58, 0xa9, 0x3f, 0xe1, 0xd2, 0x07, 0xfa, 0xe4, 0xed, 0x2f, 0x6d };
+uint8_t text[256];
+uint8_t aad[256];
+
+// Sweep of padded text lengths 0..240 (the largest padded length below 256)
+// against a spread of authenticated text lengths 0..255.
+void textAndAADSizes(benchmark::internal::Benchmark *b)
+{
+    for(int textLen = 0; textLen <= 240; textLen += 16)
+        for(int aadLen : { 0, 16, 255 })
+            { if((0 != textLen) || (0 != aadLen)) { b->Args({ textLen, aadLen }); } }
+    b->ArgNames({ "text", "aad" });
+}
+
+// Single block encryption under a retained key schedule.
+template<class OTAESImpl>
+void BM_blockEncrypt(benchmark::State &state)
+{
+    uint8_t workspace[OTAESImpl::workspaceRequired];
+    OTAESImpl e(workspace, sizeof(workspace));
+    e.retainKeySchedule(key);
+    uint8_t block[16] = { };
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        e.blockEncrypt(block, key, block);
+        benchmark::DoNotOptimize(block);
+        }
+    report(state, start, sizeof(block));
+    e.clearKeySchedule();
+}
+
+// Single block encryption with the key schedule expanded every call.
+template<class OTAESImpl>
+void BM_blockEncryptUnretained(benchmark::State &state)
+{
+    uint8_t workspace[OTAESImpl::workspaceRequired];
+    OTAESImpl e(workspace, sizeof(workspace));
+    uint8_t block[16] = { };
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        e.blockEncrypt(block, key, block);
+        benchmark::DoNotOptimize(block);
+        }
+    report(state, start, sizeof(block));
+}
+
+// Several independent blocks per call under a retained key schedule, as for CTR.
+template<class OTAESImpl>
+void BM_blocksEncrypt(benchmark::State &state)
+{
+    uint8_t workspace[OTAESImpl::workspaceRequired];
+    OTAESImpl e(workspace, sizeof(workspace));
+    e.retainKeySchedule(key);
+    const size_t nBlocks = (size_t)state.range(0);
+    uint8_t blocks[16 * 16] = { };
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        e.blocksEncrypt(blocks, nBlocks, key, blocks);
+        benchmark::DoNotOptimize(blocks);
+        }
+    report(state, start, 16 * nBlocks);
+    e.clearKeySchedule();
+}
+
+// Counter mode over several blocks under a retained key schedule, as for GCM.
+template<class OTAESImpl>
+void BM_ctrEncrypt(benchmark::State &state)
+{
+    uint8_t workspace[OTAESImpl::workspaceRequired];
+    OTAESImpl e(workspace, sizeof(workspace));
+    e.retainKeySchedule(key);
+    const size_t nBlocks = (size_t)state.range(0);
+    uint8_t ctr[16] = { }, in[16 * 16] = { }, out[16 * 16];
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        e.ctrEncrypt(ctr, in, nBlocks, key, out);
+        benchmark::DoNotOptimize(out);
+        }
+    report(state, start, 16 * nBlocks);
+    e.clearKeySchedule();
+}
+
+// Key expansion alone, as retaining a schedule for a new key.
+// Alternates keys so that no expansion is skipped.
+template<class OTAESImpl>
+void BM_KeyExpansion(benchmark::State &state)
+{
+    uint8_t workspace[OTAESImpl::workspaceRequired];
+    OTAESImpl e(workspace, sizeof(workspace));
+    bool flip = false;
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        e.retainKeySchedule((flip = !flip) ? key : key2);
+        benchmark::ClobberMemory();
+        }
+    report(state, start, 0);
+    e.clearKeySchedule();
+}
+
+// Single block decryption.
+template<class OTAESImpl>
+void BM_blockDecrypt(benchmark::State &state)
+{
+    uint8_t workspace[OTAESImpl::workspaceRequired];
+    OTAESImpl d(workspace, sizeof(workspace));
+    uint8_t block[16] = { };
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        d.blockDecrypt(block, key, block);
+        benchmark::DoNotOptimize(block);
+        }
+    report(state, start, sizeof(block));
+}
+
+// GHASH of state.range(0) blocks, ie one field multiply per block.
+template<class OTGHASHImpl>
+void BM_GHASH(benchmark::State &state)
+{
+    uint8_t workspace[OTGHASHImpl::workspaceRequired];
+    OTGHASHImpl g(workspace, sizeof(workspace));
+    g.setAuthKey(key);
+    const size_t nBlocks = (size_t)state.range(0);
+    uint8_t Y[16] = { };
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        g.ghashBlocks(Y, text, nBlocks);
+        benchmark::DoNotOptimize(Y);
+        }
+    report(state, start, 16 * nBlocks);
+    g.clearAuthKey();
+}
+
+// One-shot (generic) GCM encryption, key expanded per message.
+template<class OTAESImpl, class OTGHASHImpl>
+void BM_gcmEncryptPadded(benchmark::State &state)
+{
+    typedef OTAESGCM::OTAES128GCMGenericWithWorkspace<OTAESImpl, OTGHASHImpl> t;
+    uint8_t workspace[t::workspaceRequired];
+    t gen(workspace, sizeof(workspace));
+    const uint8_t textLen = (uint8_t)state.range(0), aadLen = (uint8_t)state.range(1);
+    uint8_t ct[256], tag[16];
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        if(!gen.gcmEncryptPadded(key, nonce, textLen ? text : NULL, textLen, aadLen ? aad : NULL, aadLen, ct, tag))
+            { state.SkipWithError("encryption failed"); break; }
+        benchmark::DoNotOptimize(tag);
+        }
+    report(state, start, textLen + aadLen);
+}
+
+// One-shot (generic) GCM decryption, key expanded per message.
+template<class OTAESImpl, class OTGHASHImpl>
+void BM_gcmDecrypt(benchmark::State &state)
+{
+    typedef OTAESGCM::OTAES128GCMGenericWithWorkspace<OTAESImpl, OTGHASHImpl> t;
+    uint8_t workspace[t::workspaceRequired];
+    t gen(workspace, sizeof(workspace));
+    const uint8_t textLen = (uint8_t)state.range(0), aadLen = (uint8_t)state.range(1);
+    uint8_t ct[256], tag[16], pt[256];
+    gen.gcmEncryptPadded(key, nonce, textLen ? text : NULL, textLen, aadLen ? aad : NULL, aadLen, ct, tag);
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        if(!gen.gcmDecrypt(key, nonce, textLen ? ct : NULL, textLen, aadLen ? aad : NULL, aadLen, tag, pt))
+            { state.SkipWithError("decryption failed"); break; }
+        benchmark::DoNotOptimize(pt);
+        }
+    report(state, start, textLen + aadLen);
+}
+
+#if defined(OTAESGCM_HAS_BACKEND_REGISTRY)
+// One-shot GCM encryption with the implementations the registry selects for the policy (arg 0),
+// 128 bytes of text and 16 of authenticated data, labelled with the names selected;
+// set OTAESGCM_AES_BACKEND or OTAESGCM_GHASH_BACKEND to compare others.
+void BM_gcmEncryptPaddedRuntime(benchmark::State &state)
+{
+    typedef OTAESGCM::OTAES128GCMRuntimeWithWorkspace t;
+    uint8_t workspace[t::workspaceRequired];
+    t gen((OTAESGCM::OTAESGCMBackendPolicy)state.range(0), workspace, sizeof(workspace));
+    state.SetLabel(std::string(gen.getAESBackend().name) + "+" + gen.getGHASHBackend().name);
+    const uint8_t textLen = 128, aadLen = 16;
+    uint8_t ct[256], tag[16];
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        if(!gen.gcmEncryptPadded(key, nonce, text, textLen, aad, aadLen, ct, tag))
+            { state.SkipWithError("encryption failed"); break; }
+        benchmark::DoNotOptimize(tag);
+        }
+    report(state, start, textLen + aadLen);
+}
+
+// One-shot GCM encryption with the implementations tuned for the text length.
+void BM_gcmEncryptPaddedTuned(benchmark::State &state)
+{
+    typedef OTAESGCM::OTAES128GCMTunedWithWorkspace t;
+    // Tuning is never implicit; tune once, constant-time only as by default.
+    if(!OTAESGCM::OTAESGCMAutotuner::isTuned()) { OTAESGCM::OTAESGCMAutotuner::autotune(); }
+    uint8_t workspace[t::workspaceRequired];
+    t gen(workspace, sizeof(workspace));
+    const uint8_t textLen = (uint8_t)state.range(0), aadLen = 0;
+    const OTAESGCM::OTAES128EBackend *aes;
+    const OTAESGCM::OTGHASHBackend *ghash;
+    OTAESGCM::OTAESGCMAutotuner::select(textLen + aadLen, aes, ghash);
+    state.SetLabel(std::string(aes->name) + "+" + ghash->name);
+    uint8_t ct[256], tag[16];
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        if(!gen.gcmEncryptPadded(key, nonce, text, textLen, aad, aadLen, ct, tag))
+            { state.SkipWithError("encryption failed"); break; }
+        benchmark::DoNotOptimize(tag);
+        }
+    report(state, start, textLen + aadLen);
+}
+#endif
+
+// One-shot GCM encryption through the devirtualised engine.
+template<class OTAESImpl, class OTGHASHImpl>
+void BM_engineEncryptPadded(benchmark::State &state)
+{
+    typedef OTAESGCM::OTAES128GCMEngine<OTAESImpl, OTGHASHImpl> t;
+    uint8_t workspace[t::workspaceRequired];
+    t e(workspace, sizeof(workspace));
+    const size_t textLen = (size_t)state.range(0), aadLen = (size_t)state.range(1);
+    uint8_t ct[256], tag[16];
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        if(!e.gcmEncryptPadded(key, nonce, textLen ? text : NULL, textLen, aadLen ? aad : NULL, aadLen, ct, tag))
+            { state.SkipWithError("encryption failed"); break; }
+        benchmark::DoNotOptimize(tag);
+        }
+    report(state, start, textLen + aadLen);
+}
+
+// One-shot GCM decryption through the devirtualised engine.
+template<class OTAESImpl, class OTGHASHImpl>
+void BM_engineDecrypt(benchmark::State &state)
+{
+    typedef OTAESGCM::OTAES128GCMEngine<OTAESImpl, OTGHASHImpl> t;
+    uint8_t workspace[t::workspaceRequired];
+    t e(workspace, sizeof(workspace));
+    const size_t textLen = (size_t)state.range(0), aadLen = (size_t)state.range(1);
+    uint8_t ct[256], tag[16], pt[256];
+    e.gcmEncryptPadded(key, nonce, textLen ? text : NULL, textLen, aadLen ? aad : NULL, aadLen, ct, tag);
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        if(!e.gcmDecrypt(key, nonce, textLen ? ct : NULL, textLen, aadLen ? aad : NULL, aadLen, tag, pt))
+            { state.SkipWithError("decryption failed"); break; }
+        benchmark::DoNotOptimize(pt);
+        }
+    report(state, start, textLen + aadLen);
+}
+
+// Fixed 32-byte-text GCM encryption through the specialised engine kernel.
+template<class OTAESImpl, class OTGHASHImpl>
+void BM_engineEncryptFixed32(benchmark::State &state)
+{
+    typedef OTAESGCM::OTAES128GCMEngine<OTAESImpl, OTGHASHImpl> t;
+    uint8_t workspace[t::workspaceRequired];
+    t e(workspace, sizeof(workspace));
+    const size_t aadLen = (size_t)state.range(0);
+    uint8_t ct[32], tag[16];
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        if(!e.template gcmEncryptFixed<32>(key, nonce, text, aadLen ? aad : NULL, aadLen, ct, tag))
+            { state.SkipWithError("encryption failed"); break; }
+        benchmark::DoNotOptimize(tag);
+        }
+    report(state, start, 32 + aadLen);
+}
+
+// Fixed 32-byte-text GCM encryption with the key schedule cached across frames.
+template<class OTAESImpl, class OTGHASHImpl>
+void BM_engineEncryptFixed32Cached(benchmark::State &state)
+{
+    typedef OTAESGCM::OTAES128GCMEngine<OTAESImpl, OTGHASHImpl> t;
+    uint8_t workspace[t::workspaceRequired];
+    t e(workspace, sizeof(workspace));
+    e.cacheKeySchedule();
+    const size_t aadLen = (size_t)state.range(0);
+    uint8_t ct[32], tag[16];
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        if(!e.template gcmEncryptFixed<32>(key, nonce, text, aadLen ? aad : NULL, aadLen, ct, tag))
+            { state.SkipWithError("encryption failed"); break; }
+        benchmark::DoNotOptimize(tag);
+        }
+    report(state, start, 32 + aadLen);
+    e.wipeKeySchedule();
+}
+
+// Fixed 32-byte-text GCM decryption through the specialised engine kernel.
+template<class OTAESImpl, class OTGHASHImpl>
+void BM_engineDecryptFixed32(benchmark::State &state)
+{
+    typedef OTAESGCM::OTAES128GCMEngine<OTAESImpl, OTGHASHImpl> t;
+    uint8_t workspace[t::workspaceRequired];
+    t e(workspace, sizeof(workspace));
+    const size_t aadLen = (size_t)state.range(0);
+    uint8_t ct[32], tag[16], pt[32];
+    e.template gcmEncryptFixed<32>(key, nonce, text, aadLen ? aad : NULL, aadLen, ct, tag);
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        if(!e.template gcmDecryptFixed<32>(key, nonce, ct, aadLen ? aad : NULL, aadLen, tag, pt))
+            { state.SkipWithError("decryption failed"); break; }
+        benchmark::DoNotOptimize(pt);
+        }
+    report(state, start, 32 + aadLen);
+}
+
+// Authentication-only GMAC through the engine, to compare with gcmEncryptPadded with no text.
+template<class OTAESImpl, class OTGHASHImpl>
+void BM_engineGMAC(benchmark::State &state)
+{
+    typedef OTAESGCM::OTAES128GCMEngine<OTAESImpl, OTGHASHImpl> t;
+    uint8_t workspace[t::workspaceRequiredGMAC];
+    t e(workspace, sizeof(workspace));
+    const size_t aadLen = (size_t)state.range(0);
+    uint8_t tag[16];
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        if(!e.gmacCompute(key, nonce, aad, aadLen, tag))
+            { state.SkipWithError("GMAC failed"); break; }
+        benchmark::DoNotOptimize(tag);
+        }
+    report(state, start, aadLen);
+}
+
+// Keyed GCM encryption, key-dependent state computed once.
+template<class OTAESImpl, class OTGHASHImpl>
+void BM_keyedGcmEncryptPadded(benchmark::State &state)
+{
+    typedef OTAESGCM::OTAES128GCMKeyedWithWorkspace<OTAESImpl, OTGHASHImpl> t;
+    uint8_t workspace[t::workspaceRequired];
+    t gen(workspace, sizeof(workspace));
+    gen.setKey(key);
+    const size_t textLen = (size_t)state.range(0), aadLen = (size_t)state.range(1);
+    uint8_t ct[256], tag[16];
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        if(!gen.gcmEncryptPadded(nonce, textLen ? text : NULL, textLen, aadLen ? aad : NULL, aadLen, ct, tag))
+            { state.SkipWithError("encryption failed"); break; }
+        benchmark::DoNotOptimize(tag);
+        }
+    report(state, start, textLen + aadLen);
+    gen.clearKey();
+}
+
+// Keyed GCM decryption, key-dependent state computed once.
+template<class OTAESImpl, class OTGHASHImpl>
+void BM_keyedGcmDecrypt(benchmark::State &state)
+{
+    typedef OTAESGCM::OTAES128GCMKeyedWithWorkspace<OTAESImpl, OTGHASHImpl> t;
+    uint8_t workspace[t::workspaceRequired];
+    t gen(workspace, sizeof(workspace));
+    gen.setKey(key);
+    const size_t textLen = (size_t)state.range(0), aadLen = (size_t)state.range(1);
+    uint8_t ct[256], tag[16], pt[256];
+    gen.gcmEncryptPadded(nonce, textLen ? text : NULL, textLen, aadLen ? aad : NULL, aadLen, ct, tag);
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        if(!gen.gcmDecrypt(nonce, textLen ? ct : NULL, textLen, aadLen ? aad : NULL, aadLen, tag, pt))
+            { state.SkipWithError("decryption failed"); break; }
+        benchmark::DoNotOptimize(pt);
+        }
+    report(state, start, textLen + aadLen);
+    gen.clearKey();
+}
+
+// Keyed 32-byte-text GCM encryption with a precomputed ADATA prefix of the given length.
+template<class OTAESImpl, class OTGHASHImpl>
+void BM_keyedGcmEncryptPaddedPrefix(benchmark::State &state)
+{
+    typedef OTAESGCM::OTAES128GCMKeyedWithWorkspace<OTAESImpl, OTGHASHImpl> t;
+    uint8_t workspace[t::workspaceRequired];
+    t gen(workspace, sizeof(workspace));
+    gen.setKey(key);
+    const size_t aadLen = (size_t)state.range(0), prefixLen = (size_t)state.range(1);
+    OTAESGCM::GCMADATAPrefix prefix;
+    gen.computeADATAPrefix(aad, prefixLen, prefix);
+    uint8_t ct[32], tag[16];
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        if(!gen.gcmEncryptPadded(prefix, nonce, text, 32, aad + prefixLen, aadLen - prefixLen, ct, tag))
+            { state.SkipWithError("encryption failed"); break; }
+        benchmark::DoNotOptimize(tag);
+        }
+    report(state, start, 32 + aadLen);
+    gen.clearKey();
+}
+
+// The fixed 32-byte-text adaptors, with the given authenticated text length.
+void BM_fixed32BEnc(benchmark::State &state)
+{
+    uint8_t workspace[OTAESGCM::OTAES128GCMGenericWithWorkspace<>::workspaceRequired];
+    const uint8_t aadLen = (uint8_t)state.range(0);
+    uint8_t ct[32], tag[16];
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        if(!OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleEnc_DEFAULT_WITH_LWORKSPACE(workspace, sizeof(workspace),
+                key, nonce, aadLen ? aad : NULL, aadLen, text, ct, tag))
+            { state.SkipWithError("encryption failed"); break; }
+        benchmark::DoNotOptimize(tag);
+        }
+    report(state, start, 32 + aadLen);
+}
+void BM_fixed32BDec(benchmark::State &state)
+{
+    uint8_t workspace[OTAESGCM::OTAES128GCMGenericWithWorkspace<>::workspaceRequired];
+    const uint8_t aadLen = (uint8_t)state.range(0);
+    uint8_t ct[32], tag[16], pt[32];
+    OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleEnc_DEFAULT_WITH_LWORKSPACE(workspace, sizeof(workspace),
+            key, nonce, aadLen ? aad : NULL, aadLen, text, ct, tag);
+    const uint64_t start = cycles();
+    for(auto _ : state)
+        {
+        if(!OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleDec_DEFAULT_WITH_LWORKSPACE(workspace, sizeof(workspace),
+                key, nonce, aadLen ? aad : NULL, aadLen, ct, tag, pt))
+            { state.SkipWithError("decryption failed"); break; }
+        benchmark::DoNotOptimize(pt);
+        }
+    report(state, start, 32 + aadLen);
+}
+
+using namespace OTAESGCM;
+
+// AES primitives, for each implementation.
+BENCHMARK_TEMPLATE(BM_blockEncrypt, OTAES128E_AVR);
+BENCHMARK_TEMPLATE(BM_blockEncrypt, OTAES128E_TTable);
+BENCHMARK_TEMPLATE(BM_blockEncryptUnretained, OTAES128E_AVR);
+BENCHMARK_TEMPLATE(BM_blockEncryptUnretained, OTAES128E_TTable);
+BENCHMARK_TEMPLATE(BM_blockEncryptUnretained, OTAES128E_OTF);
+BENCHMARK_TEMPLATE(BM_blocksEncrypt, OTAES128E_AVR)->Arg(4)->Arg(16);
+BENCHMARK_TEMPLATE(BM_ctrEncrypt, OTAES128E_AVR)->Arg(4)->Arg(16);
+BENCHMARK_TEMPLATE(BM_blocksEncrypt, OTAES128E_TTable)->Arg(4)->Arg(16);
+BENCHMARK_TEMPLATE(BM_ctrEncrypt, OTAES128E_TTable)->Arg(4)->Arg(16);
+#if defined(OTAESGCM_HAS_BITSLICED_IMPL)
+BENCHMARK_TEMPLATE(BM_blockEncrypt, OTAES128E_BitSliced);
+BENCHMARK_TEMPLATE(BM_blockEncryptUnretained, OTAES128E_BitSliced);
+BENCHMARK_TEMPLATE(BM_blocksEncrypt, OTAES128E_BitSliced)->Arg(4)->Arg(16);
+BENCHMARK_TEMPLATE(BM_ctrEncrypt, OTAES128E_BitSliced)->Arg(4)->Arg(16);
+BENCHMARK_TEMPLATE(BM_gcmEncryptPadded, OTAES128E_BitSliced, OTGHASH_default_t)->Apply(textAndAADSizes);
+#endif
+BENCHMARK_TEMPLATE(BM_KeyExpansion, OTAES128E_AVR);
+BENCHMARK_TEMPLATE(BM_KeyExpansion, OTAES128E_TTable);
+BENCHMARK_TEMPLATE(BM_blockDecrypt, OTAES128DE_AVR);
+BENCHMARK_TEMPLATE(BM_blockDecrypt, OTAES128DE_OTF);
+#if defined(OTAESGCM_HAS_SSSE3_IMPL)
+BENCHMARK_TEMPLATE(BM_blockEncrypt, OTAES128DE_SSSE3);
+BENCHMARK_TEMPLATE(BM_blockEncryptUnretained, OTAES128DE_SSSE3);
+BENCHMARK_TEMPLATE(BM_blocksEncrypt, OTAES128DE_SSSE3)->Arg(4)->Arg(16);
+BENCHMARK_TEMPLATE(BM_ctrEncrypt, OTAES128DE_SSSE3)->Arg(4)->Arg(16);
+BENCHMARK_TEMPLATE(BM_KeyExpansion, OTAES128DE_SSSE3);
+BENCHMARK_TEMPLATE(BM_blockDecrypt, OTAES128DE_SSSE3);
+BENCHMARK_TEMPLATE(BM_gcmEncryptPadded, OTAES128DE_SSSE3, OTGHASH_default_t)->Apply(textAndAADSizes);
+#endif
+#if defined(OTAESGCM_HAS_AESNI_IMPL)
+BENCHMARK_TEMPLATE(BM_blockEncrypt, OTAES128DE_AESNI);
+BENCHMARK_TEMPLATE(BM_blockEncryptUnretained, OTAES128DE_AESNI);
+BENCHMARK_TEMPLATE(BM_blocksEncrypt, OTAES128DE_AESNI)->Arg(4)->Arg(16);
+BENCHMARK_TEMPLATE(BM_ctrEncrypt, OTAES128DE_AESNI)->Arg(4)->Arg(16);
+BENCHMARK_TEMPLATE(BM_KeyExpansion, OTAES128DE_AESNI);
+BENCHMARK_TEMPLATE(BM_blockDecrypt, OTAES128DE_AESNI);
+#endif
+
+// GHASH (field multiply per block), for each implementation.
+BENCHMARK_TEMPLATE(BM_GHASH, OTGHASH_BitSerial)->Arg(1)->Arg(2)->Arg(16);
+BENCHMARK_TEMPLATE(BM_GHASH, OTGHASH_Shoup4)->Arg(1)->Arg(2)->Arg(16);
+BENCHMARK_TEMPLATE(BM_GHASH, OTGHASH_CtMul64)->Arg(1)->Arg(2)->Arg(16);
+#if defined(OTAESGCM_HAS_PCLMUL_IMPL)
+BENCHMARK_TEMPLATE(BM_GHASH, OTGHASH_PCLMUL)->Arg(1)->Arg(2)->Arg(16);
+#endif
+
+// Whole messages, with the default (small) and fast backends.
+BENCHMARK_TEMPLATE(BM_gcmEncryptPadded, OTAES128E_default_t, OTGHASH_default_t)->Apply(textAndAADSizes);
+BENCHMARK_TEMPLATE(BM_gcmDecrypt, OTAES128E_default_t, OTGHASH_default_t)->Apply(textAndAADSizes);
+BENCHMARK_TEMPLATE(BM_gcmEncryptPadded, OTAES128E_fast_t, OTGHASH_fast_t)->Apply(textAndAADSizes);
+BENCHMARK_TEMPLATE(BM_gcmDecrypt, OTAES128E_fast_t, OTGHASH_fast_t)->Apply(textAndAADSizes);
+#if defined(OTAESGCM_HAS_BACKEND_REGISTRY)
+// Fastest, smallest and constant-time selections.
+BENCHMARK(BM_gcmEncryptPaddedRuntime)->Arg(0)->Arg(1)->Arg(2)->ArgName("policy");
+BENCHMARK(BM_gcmEncryptPaddedTuned)->Arg(32)->Arg(240)->ArgName("text");
+#endif
+BENCHMARK_TEMPLATE(BM_engineEncryptPadded, OTAES128E_default_t, OTGHASH_default_t)->Apply(textAndAADSizes);
+BENCHMARK_TEMPLATE(BM_engineDecrypt, OTAES128E_default_t, OTGHASH_default_t)->Apply(textAndAADSizes);
+BENCHMARK_TEMPLATE(BM_engineEncryptPadded, OTAES128E_fast_t, OTGHASH_fast_t)->Apply(textAndAADSizes);
+BENCHMARK_TEMPLATE(BM_engineDecrypt, OTAES128E_fast_t, OTGHASH_fast_t)->Apply(textAndAADSizes);
+BENCHMARK_TEMPLATE(BM_engineEncryptFixed32, OTAES128E_default_t, OTGHASH_default_t)->Arg(0)->Arg(16)->ArgName("aad");
+BENCHMARK_TEMPLATE(BM_engineDecryptFixed32, OTAES128E_default_t, OTGHASH_default_t)->Arg(0)->Arg(16)->ArgName("aad");
+BENCHMARK_TEMPLATE(BM_engineEncryptFixed32Cached, OTAES128E_default_t, OTGHASH_default_t)->Arg(0)->Arg(16)->ArgName("aad");
+BENCHMARK_TEMPLATE(BM_engineEncryptFixed32, OTAES128E_fast_t, OTGHASH_fast_t)->Arg(0)->Arg(16)->ArgName("aad");
+BENCHMARK_TEMPLATE(BM_engineDecryptFixed32, OTAES128E_fast_t, OTGHASH_fast_t)->Arg(0)->Arg(16)->ArgName("aad");
+BENCHMARK_TEMPLATE(BM_engineEncryptFixed32Cached, OTAES128E_fast_t, OTGHASH_fast_t)->Arg(0)->Arg(16)->ArgName("aad");
+BENCHMARK_TEMPLATE(BM_engineGMAC, OTAES128E_default_t, OTGHASH_default_t)->Arg(16)->Arg(64)->ArgName("aad");
+BENCHMARK_TEMPLATE(BM_engineGMAC, OTAES128E_fast_t, OTGHASH_fast_t)->Arg(16)->Arg(64)->ArgName("aad");
+BENCHMARK_TEMPLATE(BM_keyedGcmEncryptPadded, OTAES128E_default_t, OTGHASH_default_t)->Apply(textAndAADSizes);
+BENCHMARK_TEMPLATE(BM_keyedGcmDecrypt, OTAES128E_default_t, OTGHASH_default_t)->Apply(textAndAADSizes);
+BENCHMARK_TEMPLATE(BM_keyedGcmEncryptPadded, OTAES128E_fast_t, OTGHASH_fast_t)->Apply(textAndAADSizes);
+BENCHMARK_TEMPLATE(BM_keyedGcmDecrypt, OTAES128E_fast_t, OTGHASH_fast_t)->Apply(textAndAADSizes);
+
+BENCHMARK_TEMPLATE(BM_keyedGcmEncryptPaddedPrefix, OTAES128E_default_t, OTGHASH_default_t)->Args({ 24, 0 })->Args({ 24, 16 })->Args({ 40, 0 })->Args({ 40, 32 })->ArgNames({ "aad", "prefix" });
+BENCHMARK_TEMPLATE(BM_keyedGcmEncryptPaddedPrefix, OTAES128E_fast_t, OTGHASH_fast_t)->Args({ 24, 0 })->Args({ 24, 16 })->Args({ 40, 0 })->Args({ 40, 32 })->ArgNames({ "aad", "prefix" });
+
+// The simple fixed-size adaptors.
+BENCHMARK(BM_fixed32BEnc)->Arg(0)->Arg(16)->Arg(255)->ArgName("aad");
+BENCHMARK(BM_fixed32BDec)->Arg(0)->Arg(16)->Arg(255)->ArgName("aad");
+
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,471 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/*
+ * Tests for the AES128 block cipher implementations.
+ */
+
+#include <stdint.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include <OTAESGCM.h>
+#include "OTAESGCM_PUT.h"
+
+
+// ECB-AES128 vectors from NIST SP 800-38A 2001 ED F.1.1.
+static const uint8_t ECBkey[16] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+static const uint8_t ECBplain[4][16] = {
+    { 0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a },
+    { 0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51 },
+    { 0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef },
+    { 0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10 } };
+static const uint8_t ECBcipher[4][16] = {
+    { 0x3a, 0xd7, 0x7b, 0xb4, 0x0d, 0x7a, 0x36, 0x60, 0xa8, 0x9e, 0xca, 0xf3, 0x24, 0x66, 0xef, 0x97 },
+    { 0xf5, 0xd3, 0xd5, 0x85, 0x03, 0xb9, 0x69, 0x9d, 0xe7, 0x85, 0x89, 0x5a, 0x96, 0xfd, 0xba, 0xaf },
+    { 0x43, 0xb1, 0xcd, 0x7f, 0x59, 0x8e, 0xce, 0x23, 0x88, 0x1b, 0x00, 0xe3, 0xed, 0x03, 0x06, 0x88 },
+    { 0x7b, 0x0c, 0x78, 0x5e, 0x27, 0xe8, 0xad, 0x3f, 0x82, 0x23, 0x20, 0x71, 0x04, 0x72, 0x5d, 0xd4 } };
+
+// Check an encryption implementation against the vectors,
+// with and without a retained key schedule,
+// and that it wipes its workspace when done.
+template<class OTAESImpl>
+static void checkEncrypt()
+{
+    uint8_t workspace[OTAESImpl::workspaceRequired];
+    OTAESImpl aes(workspace, sizeof(workspace));
+    uint8_t out[16];
+    for(int i = 0; i < 4; ++i)
+        {
+        aes.blockEncrypt(ECBplain[i], ECBkey, out);
+        EXPECT_EQ(0, memcmp(ECBcipher[i], out, sizeof(out))) << i;
+        }
+    for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]); }
+    // One block in place, as gmacTag() and the default ctrEncrypt() do.
+    memcpy(out, ECBplain[0], sizeof(out));
+    aes.blockEncrypt(out, ECBkey, out);
+    EXPECT_EQ(0, memcmp(ECBcipher[0], out, sizeof(out)));
+    // Several blocks at once, in place, for every count up to all 4.
+    for(size_t n = 0; n <= 4; ++n)
+        {
+        uint8_t buf[4][16];
+        memcpy(buf, ECBplain, sizeof(buf));
+        aes.blocksEncrypt(buf[0], n, ECBkey, buf[0]);
+        EXPECT_EQ(0, memcmp(ECBcipher, buf, 16*n)) << n;
+        EXPECT_EQ(0, memcmp(ECBplain[n], buf[n], sizeof(buf) - 16*n)) << n;
+        }
+    for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]); }
+    aes.retainKeySchedule(ECBkey);
+    for(int i = 0; i < 4; ++i)
+        {
+        aes.blockEncrypt(ECBplain[i], ECBkey, out);
+        EXPECT_EQ(0, memcmp(ECBcipher[i], out, sizeof(out))) << i;
+        }
+    // Enough blocks to exercise any multi-block paths.
+    uint8_t many[4*5][16], manyOut[4*5][16];
+    for(int i = 0; i < 4*5; ++i) { memcpy(many[i], ECBplain[i % 4], 16); }
+    aes.blocksEncrypt(many[0], 4*5, ECBkey, manyOut[0]);
+    for(int i = 0; i < 4*5; ++i) { EXPECT_EQ(0, memcmp(ECBcipher[i % 4], manyOut[i], 16)) << i; }
+    aes.clearKeySchedule();
+    for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]); }
+}
+
+// Check a decryption implementation against the vectors.
+template<class OTAESImpl>
+static void checkDecrypt()
+{
+    uint8_t workspace[OTAESImpl::workspaceRequired];
+    OTAESImpl aes(workspace, sizeof(workspace));
+    uint8_t out[16];
+    for(int i = 0; i < 4; ++i)
+        {
+        aes.blockDecrypt(ECBcipher[i], ECBkey, out);
+        EXPECT_EQ(0, memcmp(ECBplain[i], out, sizeof(out))) << i;
+        }
+    // One block in place.
+    memcpy(out, ECBcipher[0], sizeof(out));
+    aes.blockDecrypt(out, ECBkey, out);
+    EXPECT_EQ(0, memcmp(ECBplain[0], out, sizeof(out)));
+    for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]); }
+}
+
+// Check that a cached key schedule is reused for equal key bytes at any address,
+// and re-expanded when the bytes change, even at the same address,
+// and that it survives clearKeySchedule() but not wipeKeySchedule().
+template<class OTAESImpl>
+static void checkCached()
+{
+    static const uint8_t otherKey[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+    uint8_t workspace[OTAESImpl::workspaceRequired];
+    OTAESImpl aes(workspace, sizeof(workspace));
+    uint8_t expectedOther[16], out[16];
+    aes.blockEncrypt(ECBplain[0], otherKey, expectedOther);
+    aes.cacheKeySchedule();
+    uint8_t key[16];
+    memcpy(key, ECBkey, sizeof(key));
+    aes.blockEncrypt(ECBplain[0], key, out);
+    EXPECT_EQ(0, memcmp(ECBcipher[0], out, sizeof(out)));
+    // Kept: disturbing the tail of the schedule shows it is not re-expanded.
+    workspace[sizeof(workspace) - 1] ^= 1;
+    aes.blockEncrypt(ECBplain[1], ECBkey, out);
+    EXPECT_NE(0, memcmp(ECBcipher[1], out, sizeof(out)));
+    workspace[sizeof(workspace) - 1] ^= 1;
+    aes.blockEncrypt(ECBplain[1], ECBkey, out);
+    EXPECT_EQ(0, memcmp(ECBcipher[1], out, sizeof(out)));
+    // Changed in place: re-expanded.
+    memcpy(key, otherKey, sizeof(key));
+    aes.blockEncrypt(ECBplain[0], key, out);
+    EXPECT_EQ(0, memcmp(expectedOther, out, sizeof(out)));
+    // Retaining and clearing while caching leaves the schedule in place.
+    aes.retainKeySchedule(ECBkey);
+    uint8_t buf[4][16];
+    aes.blocksEncrypt(ECBplain[0], 4, ECBkey, buf[0]);
+    EXPECT_EQ(0, memcmp(ECBcipher, buf, sizeof(buf)));
+    aes.clearKeySchedule();
+    bool allZero = true;
+    for(int i = sizeof(workspace); --i >= 0; ) { allZero = allZero && (0 == workspace[i]); }
+    EXPECT_FALSE(allZero);
+    aes.blockEncrypt(ECBplain[2], ECBkey, out);
+    EXPECT_EQ(0, memcmp(ECBcipher[2], out, sizeof(out)));
+    aes.wipeKeySchedule();
+    for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]); }
+    // No longer caching.
+    aes.blockEncrypt(ECBplain[3], ECBkey, out);
+    EXPECT_EQ(0, memcmp(ECBcipher[3], out, sizeof(out)));
+    for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]); }
+}
+
+TEST(AES,AVR)
+{
+    checkEncrypt<OTAESGCM::OTAES128E_AVR>();
+    checkEncrypt<OTAESGCM::OTAES128DE_AVR>();
+    checkDecrypt<OTAESGCM::OTAES128DE_AVR>();
+}
+
+TEST(AES,Cached)
+{
+    checkCached<OTAESGCM::OTAES128E_AVR>();
+    checkCached<OTAESGCM::OTAES128DE_AVR>();
+    checkCached<OTAESGCM::OTAES128E_TTable>();
+#if defined(OTAESGCM_HAS_BITSLICED_IMPL)
+    checkCached<OTAESGCM::OTAES128E_BitSliced>();
+#endif
+}
+
+// Check counter mode against blockEncrypt() of each counter block in turn,
+// for every length up to a few chunks, with the counter wrapping part way.
+template<class OTAESImpl>
+static void checkCtr()
+{
+    uint8_t workspace[OTAESImpl::workspaceRequired];
+    OTAESImpl aes(workspace, sizeof(workspace));
+    uint8_t in[19*16], out[19*16], expected[19*16];
+    for(size_t i = 0; i < sizeof(in); ++i) { in[i] = (uint8_t)(i * 29 + 3); }
+    for(size_t n = 0; n <= 19; ++n)
+        {
+        uint8_t ctr[16], ref[16];
+        memcpy(ctr, ECBplain[1], 16);
+        ctr[12] = ctr[13] = ctr[14] = 0xff; ctr[15] = 0xf9;
+        memcpy(ref, ctr, 16);
+        for(size_t b = 0; b < n; ++b)
+            {
+            aes.blockEncrypt(ref, ECBkey, expected + 16*b);
+            for(uint8_t j = 0; j < 16; ++j) { expected[16*b + j] ^= in[16*b + j]; }
+            for(uint8_t j = 16; j-- > 12; ) { if(0 != ++ref[j]) { break; } }
+            }
+        aes.ctrEncrypt(ctr, in, n, ECBkey, out);
+        EXPECT_EQ(0, memcmp(expected, out, 16*n)) << n;
+        EXPECT_EQ(0, memcmp(ref, ctr, 16)) << n;
+        }
+    for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]); }
+}
+
+TEST(AES,Ctr)
+{
+    checkCtr<OTAESGCM::OTAES128E_AVR>();
+    checkCtr<OTAESGCM::OTAES128E_TTable>();
+#if defined(OTAESGCM_HAS_BITSLICED_IMPL)
+    checkCtr<OTAESGCM::OTAES128E_BitSliced>();
+#endif
+}
+
+TEST(AES,TTable)
+{
+    checkEncrypt<OTAESGCM::OTAES128E_TTable>();
+    // Encrypting in place must work.
+    uint8_t workspace[OTAESGCM::OTAES128E_TTable::workspaceRequired];
+    OTAESGCM::OTAES128E_TTable aes(workspace, sizeof(workspace));
+    uint8_t buf[16];
+    memcpy(buf, ECBplain[0], sizeof(buf));
+    aes.blockEncrypt(buf, ECBkey, buf);
+    EXPECT_EQ(0, memcmp(ECBcipher[0], buf, sizeof(buf)));
+}
+
+#if defined(OTAESGCM_HAS_BITSLICED_IMPL)
+// Check the bitsliced implementation, including part-filled groups of blocks,
+// against the T-table one.
+TEST(AES,BitSliced)
+{
+    checkEncrypt<OTAESGCM::OTAES128E_BitSliced>();
+    uint8_t wsBS[OTAESGCM::OTAES128E_BitSliced::workspaceRequired];
+    uint8_t wsTT[OTAESGCM::OTAES128E_TTable::workspaceRequired];
+    OTAESGCM::OTAES128E_BitSliced bs(wsBS, sizeof(wsBS));
+    OTAESGCM::OTAES128E_TTable tt(wsTT, sizeof(wsTT));
+    uint32_t seed = 4;
+    for(size_t n = 1; n <= 9; ++n)
+        {
+        uint8_t key[16], in[9*16], out1[9*16], out2[9*16];
+        for(uint8_t &b : key) { seed = seed * 1103515245U + 12345U; b = (uint8_t)(seed >> 16); }
+        for(uint8_t &b : in) { seed = seed * 1103515245U + 12345U; b = (uint8_t)(seed >> 16); }
+        tt.blocksEncrypt(in, n, key, out1);
+        bs.blocksEncrypt(in, n, key, out2);
+        ASSERT_EQ(0, memcmp(out1, out2, 16*n)) << n;
+        }
+}
+
+// Check GCM with the bitsliced AES, whose CTR blocks are encrypted in groups.
+TEST(AES,GCMWithBitSliced)
+{
+    typedef OTAESGCM::OTAES128GCMGenericWithWorkspace<OTAESGCM::OTAES128E_BitSliced, OTAESGCM::OTGHASH_default_t> t;
+    typedef OTAESGCM::OTAES128GCMGenericWithWorkspace<> r;
+    std::vector<uint8_t> ws(t::workspaceRequired), wsr(r::workspaceRequired);
+    t gen(ws.data(), ws.size());
+    r ref(wsr.data(), wsr.size());
+    static const uint8_t key[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+    static const uint8_t iv[12] = { 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 1, 2 };
+    uint8_t pt[160], ct1[160], ct2[160], tag1[16], tag2[16], back[160];
+    for(size_t i = 0; i < sizeof(pt); ++i) { pt[i] = (uint8_t)(i * 7); }
+    for(size_t len = 16; len <= sizeof(pt); len += 16)
+        {
+        ASSERT_TRUE(ref.gcmEncryptPadded(key, iv, pt, len, pt, 5, ct1, tag1));
+        ASSERT_TRUE(gen.gcmEncryptPadded(key, iv, pt, len, pt, 5, ct2, tag2));
+        ASSERT_EQ(0, memcmp(ct1, ct2, len)) << len;
+        ASSERT_EQ(0, memcmp(tag1, tag2, 16)) << len;
+        ASSERT_TRUE(gen.gcmDecrypt(key, iv, ct2, len, pt, 5, tag2, back));
+        ASSERT_EQ(0, memcmp(pt, back, len)) << len;
+        }
+}
+#endif
+
+TEST(AES,OTF)
+{
+    checkEncrypt<OTAESGCM::OTAES128E_OTF>();
+    checkEncrypt<OTAESGCM::OTAES128DE_OTF>();
+    checkDecrypt<OTAESGCM::OTAES128DE_OTF>();
+    // Decrypt in place with the last round key retained, then with another key.
+    static const uint8_t otherKey[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+    uint8_t workspace[OTAESGCM::OTAES128DE_OTF::workspaceRequired];
+    OTAESGCM::OTAES128DE_OTF aes(workspace, sizeof(workspace));
+    uint8_t buf[16], other[16];
+    aes.blockEncrypt(ECBplain[0], otherKey, other);
+    aes.retainKeySchedule(ECBkey);
+    for(int i = 0; i < 4; ++i)
+        {
+        memcpy(buf, ECBcipher[i], sizeof(buf));
+        aes.blockDecrypt(buf, ECBkey, buf);
+        EXPECT_EQ(0, memcmp(ECBplain[i], buf, sizeof(buf))) << i;
+        }
+    aes.blockDecrypt(other, otherKey, buf);
+    EXPECT_EQ(0, memcmp(ECBplain[0], buf, sizeof(buf)));
+    aes.clearKeySchedule();
+    for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]); }
+    // Too little workspace must not crash.
+    OTAESGCM::OTAES128DE_OTF tooSmall(workspace, sizeof(workspace) - 1);
+    tooSmall.blockDecrypt(ECBcipher[0], ECBkey, buf);
+    tooSmall.blockEncrypt(ECBplain[0], ECBkey, buf);
+}
+
+// Check that the small implementations work under GCM in under 150 bytes of workspace.
+// NIST GCMVS vector GCMVS0 (OTAESGCM_PUT.h).
+TEST(AES,GCMVS0WithSmall)
+{
+    typedef OTAESGCM::OTAES128GCMGenericWithWorkspace<OTAESGCM::OTAES128E_small_t, OTAESGCM::OTGHASH_small_t> t;
+    static_assert(t::workspaceRequired < 150, "small GCM workspace too big");
+    uint8_t workspace[t::workspaceRequired];
+    t gen(workspace, sizeof(workspace));
+    uint8_t cipherText[16], tag[16], plain[16];
+    ASSERT_TRUE(gen.gcmEncryptPadded(VS0key, VS0nonce, VS0input, sizeof(VS0input), VS0aad, sizeof(VS0aad), cipherText, tag));
+    EXPECT_EQ(0, memcmp(VS0ct, cipherText, sizeof(VS0ct)));
+    EXPECT_EQ(0, memcmp(VS0tag, tag, sizeof(tag)));
+    ASSERT_TRUE(gen.gcmDecrypt(VS0key, VS0nonce, cipherText, sizeof(cipherText), VS0aad, sizeof(VS0aad), tag, plain));
+    EXPECT_EQ(0, memcmp(VS0input, plain, sizeof(plain)));
+}
+
+// Check that the fast implementation works under GCM.
+// NIST GCMVS vector GCMVS0 (OTAESGCM_PUT.h).
+TEST(AES,GCMVS0WithFast)
+{
+    typedef OTAESGCM::OTAES128GCMGenericWithWorkspace<OTAESGCM::OTAES128E_fast_t> t;
+    uint8_t workspace[t::workspaceRequired];
+    t gen(workspace, sizeof(workspace));
+    uint8_t cipherText[16], tag[16], plain[16];
+    ASSERT_TRUE(gen.gcmEncryptPadded(VS0key, VS0nonce, VS0input, sizeof(VS0input), VS0aad, sizeof(VS0aad), cipherText, tag));
+    EXPECT_EQ(0, memcmp(VS0ct, cipherText, sizeof(VS0ct)));
+    EXPECT_EQ(0, memcmp(VS0tag, tag, sizeof(tag)));
+    ASSERT_TRUE(gen.gcmDecrypt(VS0key, VS0nonce, cipherText, sizeof(cipherText), VS0aad, sizeof(VS0aad), tag, plain));
+    EXPECT_EQ(0, memcmp(VS0input, plain, sizeof(plain)));
+}
+
+#if defined(OTAESGCM_HAS_SSSE3_IMPL)
+// Wrapper to construct the SSSE3 implementation with its fallbacks forced.
+class OTAES128DE_SSSE3Fallback final : public OTAESGCM::OTAES128DE_SSSE3
+    {
+    public:
+        OTAES128DE_SSSE3Fallback(uint8_t *const workspace, uint8_t workspaceLen)
+          : OTAES128DE_SSSE3(workspace, workspaceLen, false) { }
+    };
+
+TEST(AES,SSSE3)
+{
+    if(!OTAESGCM::OTAES128DE_SSSE3::isAvailable()) { fputs("SSSE3 not available: testing fallback only\n", stderr); }
+    checkEncrypt<OTAESGCM::OTAES128DE_SSSE3>();
+    checkDecrypt<OTAESGCM::OTAES128DE_SSSE3>();
+    checkEncrypt<OTAES128DE_SSSE3Fallback>();
+    checkDecrypt<OTAES128DE_SSSE3Fallback>();
+    checkCtr<OTAESGCM::OTAES128DE_SSSE3>();
+    checkCtr<OTAES128DE_SSSE3Fallback>();
+}
+
+// Check that mixing keys while retaining a schedule stays correct,
+// including where an implementation and its fallbacks share the workspace.
+template<class OTAESImpl>
+static void checkRetainedMixedKeys()
+{
+    static const uint8_t otherKey[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+    uint8_t workspace[OTAESImpl::workspaceRequired];
+    OTAESImpl aes(workspace, sizeof(workspace));
+    uint8_t expectedOther[16], out[16];
+    aes.blockEncrypt(ECBplain[0], otherKey, expectedOther);
+    aes.retainKeySchedule(ECBkey);
+    aes.blockEncrypt(ECBplain[0], otherKey, out);
+    EXPECT_EQ(0, memcmp(expectedOther, out, sizeof(out)));
+    aes.blockDecrypt(ECBcipher[1], ECBkey, out);
+    EXPECT_EQ(0, memcmp(ECBplain[1], out, sizeof(out)));
+    aes.blockEncrypt(ECBplain[2], ECBkey, out);
+    EXPECT_EQ(0, memcmp(ECBcipher[2], out, sizeof(out)));
+    aes.clearKeySchedule();
+    for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]); }
+}
+
+// Check that mixing keys between encryption and decryption while caching stays correct,
+// including where an implementation and its fallbacks share the workspace.
+template<class OTAESImpl>
+static void checkCachedMixedKeys()
+{
+    static const uint8_t otherKey[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+    uint8_t workspace[OTAESImpl::workspaceRequired];
+    OTAESImpl aes(workspace, sizeof(workspace));
+    uint8_t expectedOther[16], out[16];
+    aes.blockEncrypt(ECBplain[0], otherKey, expectedOther);
+    aes.cacheKeySchedule();
+    aes.blockEncrypt(ECBplain[0], ECBkey, out);
+    EXPECT_EQ(0, memcmp(ECBcipher[0], out, sizeof(out)));
+    aes.blockDecrypt(expectedOther, otherKey, out);
+    EXPECT_EQ(0, memcmp(ECBplain[0], out, sizeof(out)));
+    aes.blockEncrypt(ECBplain[1], ECBkey, out);
+    EXPECT_EQ(0, memcmp(ECBcipher[1], out, sizeof(out)));
+    aes.blockDecrypt(ECBcipher[2], ECBkey, out);
+    EXPECT_EQ(0, memcmp(ECBplain[2], out, sizeof(out)));
+    aes.wipeKeySchedule();
+    for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]); }
+}
+
+TEST(AES,SSSE3MixedKeys)
+{
+    checkRetainedMixedKeys<OTAESGCM::OTAES128DE_SSSE3>();
+    checkRetainedMixedKeys<OTAES128DE_SSSE3Fallback>();
+    checkCached<OTAESGCM::OTAES128DE_SSSE3>();
+    checkCached<OTAES128DE_SSSE3Fallback>();
+    checkCachedMixedKeys<OTAESGCM::OTAES128DE_SSSE3>();
+    checkCachedMixedKeys<OTAES128DE_SSSE3Fallback>();
+}
+
+// Check GCM with the SSSE3 implementation against the default.
+TEST(AES,GCMWithSSSE3)
+{
+    typedef OTAESGCM::OTAES128GCMGenericWithWorkspace<OTAESGCM::OTAES128DE_SSSE3, OTAESGCM::OTGHASH_default_t> t;
+    typedef OTAESGCM::OTAES128GCMGenericWithWorkspace<> r;
+    std::vector<uint8_t> ws(t::workspaceRequired), wsr(r::workspaceRequired);
+    t gen(ws.data(), ws.size());
+    r ref(wsr.data(), wsr.size());
+    static const uint8_t key[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+    static const uint8_t iv[12] = { 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 1, 2 };
+    uint8_t pt[160], ct1[160], ct2[160], tag1[16], tag2[16], back[160];
+    for(size_t i = 0; i < sizeof(pt); ++i) { pt[i] = (uint8_t)(i * 7); }
+    for(size_t len = 16; len <= sizeof(pt); len += 16)
+        {
+        ASSERT_TRUE(ref.gcmEncryptPadded(key, iv, pt, len, pt, 5, ct1, tag1));
+        ASSERT_TRUE(gen.gcmEncryptPadded(key, iv, pt, len, pt, 5, ct2, tag2));
+        ASSERT_EQ(0, memcmp(ct1, ct2, len)) << len;
+        ASSERT_EQ(0, memcmp(tag1, tag2, 16)) << len;
+        ASSERT_TRUE(gen.gcmDecrypt(key, iv, ct2, len, pt, 5, tag2, back));
+        ASSERT_EQ(0, memcmp(pt, back, len)) << len;
+        }
+}
+#endif
+
+#if defined(OTAESGCM_HAS_AESNI_IMPL)
+// Wrapper to construct the AES-NI implementation with its SSSE3 fallback forced.
+class OTAES128DE_AESNIFallback final : public OTAESGCM::OTAES128DE_AESNI
+    {
+    public:
+        OTAES128DE_AESNIFallback(uint8_t *const workspace, uint8_t workspaceLen)
+          : OTAES128DE_AESNI(workspace, workspaceLen, false) { }
+    };
+// Wrapper to construct the AES-NI implementation with the portable fallbacks forced.
+class OTAES128DE_AESNIPortable final : public OTAESGCM::OTAES128DE_AESNI
+    {
+    public:
+        OTAES128DE_AESNIPortable(uint8_t *const workspace, uint8_t workspaceLen)
+          : OTAES128DE_AESNI(workspace, workspaceLen, false, false) { }
+    };
+
+TEST(AES,AESNI)
+{
+    if(!OTAESGCM::OTAES128DE_AESNI::isAvailable()) { fputs("AES-NI not available: testing fallback only\n", stderr); }
+    checkEncrypt<OTAESGCM::OTAES128DE_AESNI>();
+    checkDecrypt<OTAESGCM::OTAES128DE_AESNI>();
+    checkEncrypt<OTAES128DE_AESNIFallback>();
+    checkDecrypt<OTAES128DE_AESNIFallback>();
+    checkEncrypt<OTAES128DE_AESNIPortable>();
+    checkDecrypt<OTAES128DE_AESNIPortable>();
+}
+
+TEST(AES,AESNICtr)
+{
+    checkCtr<OTAESGCM::OTAES128DE_AESNI>();
+    checkCtr<OTAES128DE_AESNIFallback>();
+    checkCtr<OTAES128DE_AESNIPortable>();
+}
+
+TEST(AES,AESNIRetainedMixedKeys)
+{
+    checkRetainedMixedKeys<OTAESGCM::OTAES128DE_AESNI>();
+    checkRetainedMixedKeys<OTAES128DE_AESNIFallback>();
+    checkRetainedMixedKeys<OTAES128DE_AESNIPortable>();
+}
+
+TEST(AES,AESNICached)
+{
+    checkCached<OTAESGCM::OTAES128DE_AESNI>();
+    checkCached<OTAES128DE_AESNIFallback>();
+    checkCached<OTAES128DE_AESNIPortable>();
+    checkCachedMixedKeys<OTAESGCM::OTAES128DE_AESNI>();
+    checkCachedMixedKeys<OTAES128DE_AESNIFallback>();
+    checkCachedMixedKeys<OTAES128DE_AESNIPortable>();
+}
+#endif
@@ -0,0 +1,337 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/*
+ * Tests for the runtime registry of AES and GHASH implementations.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include <OTAESGCM.h>
+
+#if defined(OTAESGCM_HAS_BACKEND_REGISTRY)
+
+using OTAESGCM::OTAESGCMBackends;
+using OTAESGCM::OTAESGCMBackendPolicy;
+using OTAESGCM::OTAESGCMAutotuner;
+using OTAESGCM::OTAESGCMTuning;
+
+// FIPS-197 appendix C.1 AES-128 test vector.
+static const uint8_t FIPSkey[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+static const uint8_t FIPSplain[16] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+static const uint8_t FIPScipher[16] = { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a };
+
+// Every registered AES implementation encrypts (and where it can, decrypts) correctly,
+// and names are unique and found by lookup.
+TEST(BackendRegistry,AESEntries)
+{
+    ASSERT_LE(2U, OTAESGCMBackends::countAES());
+    for(size_t i = 0; i < OTAESGCMBackends::countAES(); ++i)
+        {
+        const OTAESGCM::OTAES128EBackend &b = OTAESGCMBackends::getAES(i);
+        SCOPED_TRACE(b.name);
+        EXPECT_EQ(&b, OTAESGCMBackends::findAES(b.name));
+        EXPECT_GE((size_t)OTAESGCMBackends::maxWorkspaceRequiredAES, (size_t)b.workspaceRequired);
+        std::vector<uint8_t> ws(b.workspaceRequired);
+        OTAESGCM::OTAES128EBackendStorage storage;
+        uint8_t out[16];
+        b.construct(storage, ws.data(), b.workspaceRequired)->blockEncrypt(FIPSplain, FIPSkey, out);
+        EXPECT_EQ(0, memcmp(FIPScipher, out, sizeof(out)));
+        if(NULL != b.constructDecrypt)
+            {
+            b.constructDecrypt(storage, ws.data(), b.workspaceRequired)->blockDecrypt(FIPScipher, FIPSkey, out);
+            EXPECT_EQ(0, memcmp(FIPSplain, out, sizeof(out)));
+            }
+        }
+    EXPECT_EQ(NULL, OTAESGCMBackends::findAES("nonesuch"));
+    EXPECT_EQ(NULL, OTAESGCMBackends::findAES(NULL));
+}
+
+// Every registered GHASH implementation gives the same hash.
+TEST(BackendRegistry,GHASHEntries)
+{
+    static const uint8_t H[16] = { 0x66, 0xe9, 0x4b, 0xd4, 0xef, 0x8a, 0x2c, 0x3b, 0x88, 0x4c, 0xfa, 0x59, 0xca, 0x34, 0x2b, 0x2e };
+    uint8_t X[5 * 16];
+    for(size_t i = 0; i < sizeof(X); ++i) { X[i] = (uint8_t)(i * 13 + 1); }
+    uint8_t expected[16];
+    ASSERT_LE(2U, OTAESGCMBackends::countGHASH());
+    for(size_t i = 0; i < OTAESGCMBackends::countGHASH(); ++i)
+        {
+        const OTAESGCM::OTGHASHBackend &b = OTAESGCMBackends::getGHASH(i);
+        SCOPED_TRACE(b.name);
+        EXPECT_EQ(&b, OTAESGCMBackends::findGHASH(b.name));
+        EXPECT_GE((size_t)OTAESGCMBackends::maxWorkspaceRequiredGHASH, b.workspaceRequired);
+        std::vector<uint8_t> ws(b.workspaceRequired);
+        OTAESGCM::OTGHASHBackendStorage storage;
+        OTAESGCM::OTGHASH *const g = b.construct(storage, ws.data(), b.workspaceRequired);
+        uint8_t Y[16] = { };
+        g->setAuthKey(H);
+        g->ghashBlocks(Y, X, 5);
+        g->clearAuthKey();
+        if(0 == i) { memcpy(expected, Y, sizeof(Y)); }
+        else { EXPECT_EQ(0, memcmp(expected, Y, sizeof(Y))); }
+        }
+}
+
+// Each policy picks an available implementation with the right properties.
+TEST(BackendRegistry,Select)
+{
+    ASSERT_TRUE(OTAESGCMBackends::overrideAES(NULL));
+    ASSERT_TRUE(OTAESGCMBackends::overrideGHASH(NULL));
+    const OTAESGCM::OTAES128EBackend &fastest = OTAESGCMBackends::selectAES(OTAESGCMBackendPolicy::FASTEST);
+    const OTAESGCM::OTAES128EBackend &smallest = OTAESGCMBackends::selectAES(OTAESGCMBackendPolicy::SMALLEST);
+    const OTAESGCM::OTAES128EBackend &ct = OTAESGCMBackends::selectAES(OTAESGCMBackendPolicy::CONSTANT_TIME);
+    EXPECT_TRUE(fastest.isAvailable());
+    EXPECT_TRUE(ct.constantTime);
+    for(size_t i = 0; i < OTAESGCMBackends::countAES(); ++i)
+        {
+        const OTAESGCM::OTAES128EBackend &b = OTAESGCMBackends::getAES(i);
+        if(!b.isAvailable()) { continue; }
+        EXPECT_LE(fastest.cyclesPerBlock, b.cyclesPerBlock) << b.name;
+        EXPECT_LE(smallest.workspaceRequired, b.workspaceRequired) << b.name;
+        if(b.constantTime) { EXPECT_LE(ct.cyclesPerBlock, b.cyclesPerBlock) << b.name; }
+        }
+    EXPECT_STREQ("otf", smallest.name);
+#if defined(OTAESGCM_HAS_AESNI_IMPL)
+    if(OTAESGCM::OTAES128DE_AESNI::isAvailable()) { EXPECT_STREQ("aesni", fastest.name); EXPECT_STREQ("aesni", ct.name); }
+#endif
+    EXPECT_TRUE(OTAESGCMBackends::selectGHASH(OTAESGCMBackendPolicy::CONSTANT_TIME).constantTime);
+}
+
+// Overrides take effect for all policies, except a non-constant-time one for CONSTANT_TIME.
+TEST(BackendRegistry,Override)
+{
+    const OTAESGCM::OTAES128EBackend &ct = OTAESGCMBackends::selectAES(OTAESGCMBackendPolicy::CONSTANT_TIME);
+    EXPECT_FALSE(OTAESGCMBackends::overrideAES("nonesuch"));
+    ASSERT_TRUE(OTAESGCMBackends::overrideAES("avr"));
+    EXPECT_STREQ("avr", OTAESGCMBackends::selectAES(OTAESGCMBackendPolicy::FASTEST).name);
+    EXPECT_STREQ("avr", OTAESGCMBackends::selectAES(OTAESGCMBackendPolicy::SMALLEST).name);
+    EXPECT_EQ(&ct, &OTAESGCMBackends::selectAES(OTAESGCMBackendPolicy::CONSTANT_TIME));
+    ASSERT_TRUE(OTAESGCMBackends::overrideAES("bitsliced"));
+    EXPECT_STREQ("bitsliced", OTAESGCMBackends::selectAES(OTAESGCMBackendPolicy::CONSTANT_TIME).name);
+    ASSERT_TRUE(OTAESGCMBackends::overrideAES(NULL));
+    EXPECT_EQ(&ct, &OTAESGCMBackends::selectAES(OTAESGCMBackendPolicy::CONSTANT_TIME));
+
+    ASSERT_TRUE(OTAESGCMBackends::overrideGHASH("bitserial"));
+    EXPECT_STREQ("bitserial", OTAESGCMBackends::selectGHASH(OTAESGCMBackendPolicy::FASTEST).name);
+    ASSERT_TRUE(OTAESGCMBackends::overrideGHASH(NULL));
+    EXPECT_STRNE("bitserial", OTAESGCMBackends::selectGHASH(OTAESGCMBackendPolicy::FASTEST).name);
+}
+
+// GCM over every pair of implementations matches the compile-time default.
+TEST(BackendRegistry,GCMRuntime)
+{
+    typedef OTAESGCM::OTAES128GCMGenericWithWorkspace<> r;
+    std::vector<uint8_t> wsr(r::workspaceRequired);
+    r ref(wsr.data(), wsr.size());
+    static const uint8_t iv[12] = { 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 1, 2 };
+    uint8_t pt[64], ct1[64], ct2[64], tag1[16], tag2[16], back[64];
+    for(size_t i = 0; i < sizeof(pt); ++i) { pt[i] = (uint8_t)(i * 7); }
+    ASSERT_TRUE(ref.gcmEncryptPadded(FIPSkey, iv, pt, sizeof(pt), pt, 5, ct1, tag1));
+    std::vector<uint8_t> ws(OTAESGCM::OTAES128GCMRuntimeWithWorkspace::workspaceRequired);
+    for(size_t i = 0; i < OTAESGCMBackends::countAES(); ++i)
+        {
+        for(size_t j = 0; j < OTAESGCMBackends::countGHASH(); ++j)
+            {
+            OTAESGCM::OTAES128GCMRuntimeWithWorkspace gen(OTAESGCMBackends::getAES(i), OTAESGCMBackends::getGHASH(j), ws.data(), ws.size());
+            SCOPED_TRACE(gen.getAESBackend().name);
+            SCOPED_TRACE(gen.getGHASHBackend().name);
+            ASSERT_TRUE(gen.gcmEncryptPadded(FIPSkey, iv, pt, sizeof(pt), pt, 5, ct2, tag2));
+            EXPECT_EQ(0, memcmp(ct1, ct2, sizeof(ct2)));
+            EXPECT_EQ(0, memcmp(tag1, tag2, sizeof(tag2)));
+            ASSERT_TRUE(gen.gcmDecrypt(FIPSkey, iv, ct2, sizeof(ct2), pt, 5, tag2, back));
+            EXPECT_EQ(0, memcmp(pt, back, sizeof(back)));
+            }
+        }
+    // By policy; and too small a workspace fails cleanly.
+    OTAESGCM::OTAES128GCMRuntimeWithWorkspace byPolicy(OTAESGCMBackendPolicy::CONSTANT_TIME, ws.data(), ws.size());
+    EXPECT_TRUE(byPolicy.getAESBackend().constantTime);
+    EXPECT_TRUE(byPolicy.getGHASHBackend().constantTime);
+    ASSERT_TRUE(byPolicy.gcmEncryptPadded(FIPSkey, iv, pt, sizeof(pt), pt, 5, ct2, tag2));
+    EXPECT_EQ(0, memcmp(tag1, tag2, sizeof(tag2)));
+    OTAESGCM::OTAES128GCMRuntimeWithWorkspace tooSmall(OTAESGCMBackendPolicy::FASTEST, ws.data(), ws.size() - 1);
+    EXPECT_FALSE(tooSmall.gcmEncryptPadded(FIPSkey, iv, pt, sizeof(pt), pt, 5, ct2, tag2));
+    for(size_t i = 0; i < ws.size(); ++i) { ASSERT_EQ(0, ws[i]) << i; }
+}
+
+// Until autotuned, tuned GCM uses the constant-time implementations, and does not tune itself.
+TEST(BackendRegistry,Untuned)
+{
+    // Only testable if nothing earlier in this run has autotuned.
+    if(OTAESGCMAutotuner::isTuned()) { return; }
+    std::vector<uint8_t> ws(OTAESGCM::OTAES128GCMTunedWithWorkspace::workspaceRequired);
+    OTAESGCM::OTAES128GCMTunedWithWorkspace tuned(ws.data(), ws.size());
+    uint8_t pt[32] = { }, ct[32], tag[16];
+    ASSERT_TRUE(tuned.gcmEncryptPadded(FIPSkey, FIPSkey, pt, sizeof(pt), NULL, 0, ct, tag));
+    EXPECT_FALSE(OTAESGCMAutotuner::isTuned());
+    const OTAESGCMTuning &t = OTAESGCMAutotuner::getTuning();
+    EXPECT_FALSE(OTAESGCMAutotuner::isTuned());
+    EXPECT_TRUE(t.constantTimeOnly);
+    for(uint8_t i = 0; i < OTAESGCMTuning::Lengths; ++i)
+        {
+        EXPECT_EQ(&OTAESGCMBackends::selectAES(OTAESGCMBackendPolicy::CONSTANT_TIME), t.aes[i]);
+        EXPECT_EQ(&OTAESGCMBackends::selectGHASH(OTAESGCMBackendPolicy::CONSTANT_TIME), t.ghash[i]);
+        }
+}
+
+// Autotuning picks available implementations for each length,
+// constant-time ones only unless explicitly allowed.
+TEST(BackendRegistry,Autotune)
+{
+    const OTAESGCMTuning &ct = OTAESGCMAutotuner::autotune(true);
+    EXPECT_TRUE(ct.constantTimeOnly);
+    EXPECT_FALSE(ct.fromCache);
+    for(uint8_t i = 0; i < OTAESGCMTuning::Lengths; ++i)
+        {
+        ASSERT_TRUE((NULL != ct.aes[i]) && (NULL != ct.ghash[i]));
+        EXPECT_TRUE(ct.aes[i]->isAvailable() && ct.aes[i]->constantTime) << ct.aes[i]->name;
+        EXPECT_TRUE(ct.ghash[i]->isAvailable() && ct.ghash[i]->constantTime) << ct.ghash[i]->name;
+        }
+    EXPECT_TRUE(OTAESGCMAutotuner::isTuned());
+    const OTAESGCMTuning &t = OTAESGCMAutotuner::autotune(false);
+    EXPECT_EQ(&t, &OTAESGCMAutotuner::getTuning());
+    EXPECT_FALSE(t.constantTimeOnly);
+    for(uint8_t i = 0; i < OTAESGCMTuning::Lengths; ++i)
+        {
+        ASSERT_TRUE((NULL != t.aes[i]) && (NULL != t.ghash[i]));
+        EXPECT_TRUE(t.aes[i]->isAvailable()) << t.aes[i]->name;
+        EXPECT_TRUE(t.ghash[i]->isAvailable()) << t.ghash[i]->name;
+        if(i > 0) { EXPECT_LT(OTAESGCMTuning::messageLength(i - 1), OTAESGCMTuning::messageLength(i)); }
+        }
+    // Selection by length, and overrides taking precedence.
+    const OTAESGCM::OTAES128EBackend *aes;
+    const OTAESGCM::OTGHASHBackend *ghash;
+    OTAESGCMAutotuner::select(0, aes, ghash);
+    EXPECT_EQ(t.aes[0], aes);
+    EXPECT_EQ(t.ghash[0], ghash);
+    OTAESGCMAutotuner::select(OTAESGCMTuning::messageLength(0) + 1, aes, ghash);
+    EXPECT_EQ(t.aes[1], aes);
+    OTAESGCMAutotuner::select(1 << 20, aes, ghash);
+    EXPECT_EQ(t.aes[OTAESGCMTuning::Lengths - 1], aes);
+    EXPECT_EQ(t.ghash[OTAESGCMTuning::Lengths - 1], ghash);
+    ASSERT_TRUE(OTAESGCMBackends::overrideAES("otf"));
+    OTAESGCMAutotuner::select(0, aes, ghash);
+    EXPECT_STREQ("otf", aes->name);
+    ASSERT_TRUE(OTAESGCMBackends::overrideAES(NULL));
+    // Constant-time only by default.
+    EXPECT_TRUE(OTAESGCMAutotuner::autotune().constantTimeOnly);
+}
+
+// The tuning is saved to and reloaded from a cache file, and a bad file is re-measured.
+TEST(BackendRegistry,AutotuneCacheFile)
+{
+    static const char path[] = "OTAESGCMAutotuneTest.cache";
+    remove(path);
+    const OTAESGCMTuning &t = OTAESGCMAutotuner::autotune(false, path);
+    EXPECT_FALSE(t.fromCache);
+    OTAESGCMTuning measured = t;
+    EXPECT_TRUE(OTAESGCMAutotuner::autotune(false, path).fromCache);
+    for(uint8_t i = 0; i < OTAESGCMTuning::Lengths; ++i)
+        {
+        EXPECT_EQ(measured.aes[i], t.aes[i]);
+        EXPECT_EQ(measured.ghash[i], t.ghash[i]);
+        }
+    // Tuned for constant-time only: a mismatch, so re-measured and rewritten.
+    EXPECT_FALSE(OTAESGCMAutotuner::autotune(true, path).fromCache);
+    EXPECT_TRUE(OTAESGCMAutotuner::autotune(true, path).fromCache);
+    // An unknown implementation, or a malformed file.
+    static const char *const bad[] = { "OTAESGCM autotune 1 ct=0\n32 nonesuch ctmul64\n256 otf ctmul64\n4096 otf ctmul64\n",
+                                       "OTAESGCM autotune 1 ct=0\n32 otf ctmul64\n",
+                                       "rubbish" };
+    for(const char *const b : bad)
+        {
+        FILE *const f = fopen(path, "w");
+        ASSERT_TRUE(NULL != f);
+        fputs(b, f);
+        fclose(f);
+        EXPECT_FALSE(OTAESGCMAutotuner::autotune(false, path).fromCache) << b;
+        EXPECT_TRUE(OTAESGCMAutotuner::autotune(false, path).fromCache) << b;
+        }
+    // A file naming slower implementations is used as is.
+    {
+    FILE *const f = fopen(path, "w");
+    ASSERT_TRUE(NULL != f);
+    fputs("OTAESGCM autotune 1 ct=0\n32 otf bitserial\n256 otf bitserial\n4096 bitsliced ctmul64\n", f);
+    fclose(f);
+    }
+    EXPECT_TRUE(OTAESGCMAutotuner::autotune(false, path).fromCache);
+    EXPECT_STREQ("otf", t.aes[0]->name);
+    EXPECT_STREQ("bitserial", t.ghash[1]->name);
+    EXPECT_STREQ("ctmul64", t.ghash[2]->name);
+    remove(path);
+    OTAESGCMAutotuner::autotune();
+}
+
+// Tuned one-shot and keyed GCM match the compile-time default, at each tuned length.
+TEST(BackendRegistry,GCMTuned)
+{
+    typedef OTAESGCM::OTAES128GCMGenericWithWorkspace<> r;
+    std::vector<uint8_t> wsr(r::workspaceRequired);
+    r ref(wsr.data(), wsr.size());
+    static const uint8_t iv[12] = { 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 1, 2 };
+    uint8_t pt[240], ct1[240], ct2[240], tag1[16], tag2[16], back[240];
+    for(size_t i = 0; i < sizeof(pt); ++i) { pt[i] = (uint8_t)(i * 7); }
+    std::vector<uint8_t> ws(OTAESGCM::OTAES128GCMTunedWithWorkspace::workspaceRequired);
+    OTAESGCM::OTAES128GCMTunedWithWorkspace tuned(ws.data(), ws.size());
+    typedef OTAESGCM::OTAES128GCMKeyedRuntimeWithWorkspace k;
+    std::vector<uint8_t> wsk(k::workspaceRequiredBatch);
+    for(const uint8_t len : { 16, 240 })
+        {
+        SCOPED_TRACE(len);
+        ASSERT_TRUE(ref.gcmEncryptPadded(FIPSkey, iv, pt, len, pt, 5, ct1, tag1));
+        ASSERT_TRUE(tuned.gcmEncryptPadded(FIPSkey, iv, pt, len, pt, 5, ct2, tag2));
+        EXPECT_EQ(0, memcmp(ct1, ct2, len));
+        EXPECT_EQ(0, memcmp(tag1, tag2, sizeof(tag2)));
+        ASSERT_TRUE(tuned.gcmDecrypt(FIPSkey, iv, ct2, len, pt, 5, tag2, back));
+        EXPECT_EQ(0, memcmp(pt, back, len));
+        tag2[0] ^= 1;
+        EXPECT_FALSE(tuned.gcmDecrypt(FIPSkey, iv, ct2, len, pt, 5, tag2, back));
+
+        k keyed(len + 5U, wsk.data(), wsk.size());
+        const OTAESGCM::OTAES128EBackend *aes;
+        const OTAESGCM::OTGHASHBackend *ghash;
+        OTAESGCMAutotuner::select(len + 5U, aes, ghash);
+        EXPECT_EQ(aes, &keyed.getAESBackend());
+        EXPECT_EQ(ghash, &keyed.getGHASHBackend());
+        ASSERT_TRUE(keyed.setKey(FIPSkey));
+        memset(ct2, 0, sizeof(ct2));
+        ASSERT_TRUE(keyed.gcmEncryptPadded(iv, pt, len, pt, 5, ct2, tag2));
+        EXPECT_EQ(0, memcmp(ct1, ct2, len));
+        EXPECT_EQ(0, memcmp(tag1, tag2, sizeof(tag2)));
+        ASSERT_TRUE(keyed.gcmDecrypt(iv, ct2, len, pt, 5, tag2, back));
+        EXPECT_EQ(0, memcmp(pt, back, len));
+        const OTAESGCM::GCMEncryptPaddedFrame frame = { iv, pt, len, pt, 5, ct2, tag2 };
+        memset(ct2, 0, sizeof(ct2));
+        ASSERT_TRUE(keyed.gcmEncryptPaddedBatch(&frame, 1));
+        EXPECT_EQ(0, memcmp(ct1, ct2, len));
+        EXPECT_EQ(0, memcmp(tag1, tag2, sizeof(tag2)));
+        }
+    for(size_t i = 0; i < wsk.size(); ++i) { ASSERT_EQ(0, wsk[i]) << i; }
+    // Explicitly chosen, with too small a workspace for batches.
+    k bitsliced(*OTAESGCMBackends::findAES("bitsliced"), *OTAESGCMBackends::findGHASH("ctmul64"), wsk.data(), k::workspaceRequired);
+    ASSERT_TRUE(bitsliced.setKey(FIPSkey));
+    ASSERT_TRUE(bitsliced.gcmEncryptPadded(iv, pt, 240, pt, 5, ct2, tag2));
+    EXPECT_EQ(0, memcmp(tag1, tag2, sizeof(tag2)));
+    const OTAESGCM::GCMEncryptPaddedFrame frame = { iv, pt, 240, pt, 5, ct2, tag2 };
+    EXPECT_FALSE(bitsliced.gcmEncryptPaddedBatch(&frame, 1));
+}
+
+#endif // defined(OTAESGCM_HAS_BACKEND_REGISTRY)
@@ -0,0 +1,284 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/*
+ * Tests for the devirtualised templated AES-GCM engine.
+ */
+
+#include <stdint.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include <OTAESGCM.h>
+#include "OTAESGCM_PUT.h"
+
+
+// Check the NIST vector through an engine, then a forged tag.
+template<class OTAESImpl, class OTGHASHImpl>
+static void checkVS1()
+{
+    typedef OTAESGCM::OTAES128GCMEngine<OTAESImpl, OTGHASHImpl> t;
+    std::vector<uint8_t> workspace(t::workspaceRequired, 0xff);
+    t e(workspace.data(), workspace.size());
+    uint8_t cipherText[32], tag[16], plain[32];
+    ASSERT_TRUE(e.gcmEncryptPadded(VS1key, VS1nonce, VS1input, sizeof(VS1input), VS1aad, sizeof(VS1aad), cipherText, tag));
+    EXPECT_EQ(0, memcmp(VS1ct, cipherText, sizeof(cipherText)));
+    EXPECT_EQ(0, memcmp(VS1tag, tag, sizeof(tag)));
+    ASSERT_TRUE(e.gcmDecrypt(VS1key, VS1nonce, cipherText, sizeof(cipherText), VS1aad, sizeof(VS1aad), tag, plain));
+    EXPECT_EQ(0, memcmp(VS1input, plain, sizeof(plain)));
+    tag[15] ^= 0x80;
+    memset(plain, 0, sizeof(plain));
+    EXPECT_FALSE(e.gcmDecrypt(VS1key, VS1nonce, cipherText, sizeof(cipherText), VS1aad, sizeof(VS1aad), tag, plain));
+    for(int i = sizeof(plain); --i >= 0; ) { ASSERT_EQ(0, plain[i]); }
+    // The GCM part of the workspace is wiped.
+    for(size_t i = t::workspaceRequiredAES + t::workspaceRequiredGHASH; i < t::workspaceRequiredDec; ++i) { ASSERT_EQ(0, workspace[i]); }
+}
+
+TEST(Engine,GCMVS1)
+{
+    checkVS1<OTAESGCM::OTAES128E_default_t, OTAESGCM::OTGHASH_default_t>();
+    checkVS1<OTAESGCM::OTAES128E_fast_t, OTAESGCM::OTGHASH_fast_t>();
+    checkVS1<OTAESGCM::OTAES128E_small_t, OTAESGCM::OTGHASH_small_t>();
+}
+
+// Check that the engine gives exactly the same results as the virtual adaptor
+// over a range of text and ADATA lengths, including texts over 255 bytes.
+TEST(Engine,MatchesVirtual)
+{
+    typedef OTAESGCM::OTAES128GCMEngine<> e_t;
+    typedef OTAESGCM::OTAES128GCMGenericWithWorkspace<> v_t;
+    uint8_t ews[e_t::workspaceRequired], vws[v_t::workspaceRequired];
+    e_t e(ews, sizeof(ews));
+    v_t v(vws, sizeof(vws));
+    uint8_t text[512], aad[40];
+    for(size_t i = 0; i < sizeof(text); ++i) { text[i] = (uint8_t)(i * 7 + 1); }
+    for(size_t i = 0; i < sizeof(aad); ++i) { aad[i] = (uint8_t)(i * 13 + 5); }
+    uint8_t ect[sizeof(text)], vct[sizeof(text)], back[sizeof(text)], etag[16], vtag[16];
+    for(size_t a = 0; a <= sizeof(aad); a += 9)
+        {
+        for(size_t p = 0; p < 256; p += 16)
+            {
+            if((0 == p) && (0 == a)) { continue; }
+            ASSERT_TRUE(e.gcmEncryptPadded(VS1key, VS1nonce, text, p, aad, a, ect, etag));
+            ASSERT_TRUE(v.gcmEncryptPadded(VS1key, VS1nonce, text, (uint8_t)p, aad, (uint8_t)a, vct, vtag));
+            ASSERT_EQ(0, memcmp(ect, vct, p));
+            ASSERT_EQ(0, memcmp(etag, vtag, sizeof(etag)));
+            ASSERT_TRUE(e.gcmDecrypt(VS1key, VS1nonce, ect, p, aad, a, etag, back));
+            ASSERT_EQ(0, memcmp(text, back, p));
+            }
+        }
+    // Not limited to 255 bytes.
+    ASSERT_TRUE(e.gcmEncryptPadded(VS1key, VS1nonce, text, sizeof(text), aad, sizeof(aad), ect, etag));
+    ASSERT_TRUE(e.gcmDecrypt(VS1key, VS1nonce, ect, sizeof(ect), aad, sizeof(aad), etag, back));
+    ASSERT_EQ(0, memcmp(text, back, sizeof(text)));
+}
+
+// Check that each call fails safely without enough workspace for it.
+TEST(Engine,InsufficientWorkspace)
+{
+    typedef OTAESGCM::OTAES128GCMEngine<> t;
+    static_assert(t::workspaceRequiredEncPadded < t::workspaceRequiredDec, "test assumes decryption needs more");
+    uint8_t workspace[t::workspaceRequired];
+    uint8_t cipherText[32], tag[16], plain[32];
+    {
+    t e(workspace, t::workspaceRequiredEncPadded);
+    EXPECT_TRUE(e.gcmEncryptPadded(VS1key, VS1nonce, VS1input, sizeof(VS1input), VS1aad, sizeof(VS1aad), cipherText, tag));
+    EXPECT_FALSE(e.gcmDecrypt(VS1key, VS1nonce, VS1ct, sizeof(VS1ct), VS1aad, sizeof(VS1aad), VS1tag, plain));
+    }
+    {
+    t e(workspace, t::workspaceRequiredMin - 1);
+    EXPECT_FALSE(e.gcmEncryptPadded(VS1key, VS1nonce, VS1input, sizeof(VS1input), VS1aad, sizeof(VS1aad), cipherText, tag));
+    }
+    {
+    t e(NULL, t::workspaceRequired);
+    EXPECT_FALSE(e.gcmEncryptPadded(VS1key, VS1nonce, VS1input, sizeof(VS1input), VS1aad, sizeof(VS1aad), cipherText, tag));
+    EXPECT_FALSE(e.gcmDecrypt(VS1key, VS1nonce, VS1ct, sizeof(VS1ct), VS1aad, sizeof(VS1aad), VS1tag, plain));
+    }
+}
+
+// Check the compile-time-sized kernel against the general path
+// for every ADATA length up to its bound.
+template<uint8_t TextSize, class OTAESImpl, class OTGHASHImpl>
+static void checkFixed()
+{
+    typedef OTAESGCM::OTAES128GCMEngine<OTAESImpl, OTGHASHImpl> t;
+    std::vector<uint8_t> workspace(t::workspaceRequired);
+    t e(workspace.data(), workspace.size());
+    uint8_t text[TextSize], aad[255];
+    for(size_t i = 0; i < sizeof(text); ++i) { text[i] = (uint8_t)(i * 7 + 1); }
+    for(size_t i = 0; i < sizeof(aad); ++i) { aad[i] = (uint8_t)(i * 13 + 5); }
+    uint8_t ct[TextSize], fct[TextSize], back[TextSize], tag[16], ftag[16];
+    for(size_t a = 0; a <= sizeof(aad); ++a)
+        {
+        ASSERT_TRUE(e.gcmEncryptPadded(VS1key, VS1nonce, text, TextSize, a ? aad : NULL, a, ct, tag));
+        ASSERT_TRUE(e.template gcmEncryptFixed<TextSize>(VS1key, VS1nonce, text, a ? aad : NULL, a, fct, ftag));
+        ASSERT_EQ(0, memcmp(ct, fct, sizeof(ct)));
+        ASSERT_EQ(0, memcmp(tag, ftag, sizeof(tag)));
+        ASSERT_TRUE(e.template gcmDecryptFixed<TextSize>(VS1key, VS1nonce, fct, a ? aad : NULL, a, ftag, back));
+        ASSERT_EQ(0, memcmp(text, back, sizeof(back)));
+        }
+}
+
+TEST(Engine,Fixed)
+{
+    checkFixed<32, OTAESGCM::OTAES128E_default_t, OTAESGCM::OTGHASH_default_t>();
+    checkFixed<32, OTAESGCM::OTAES128E_fast_t, OTAESGCM::OTGHASH_fast_t>();
+    checkFixed<16, OTAESGCM::OTAES128E_fast_t, OTAESGCM::OTGHASH_fast_t>();
+    checkFixed<48, OTAESGCM::OTAES128E_small_t, OTAESGCM::OTGHASH_small_t>();
+}
+
+// Check the zero-length-text (GMAC) kernel against the general path.
+TEST(Engine,Fixed0)
+{
+    typedef OTAESGCM::OTAES128GCMEngine<> t;
+    uint8_t workspace[t::workspaceRequired];
+    t e(workspace, sizeof(workspace));
+    uint8_t aad[255];
+    for(size_t i = 0; i < sizeof(aad); ++i) { aad[i] = (uint8_t)(i * 13 + 5); }
+    uint8_t ct[16], tag[16], ftag[16], pt[16];
+    EXPECT_FALSE(e.gcmEncryptFixed<0>(VS1key, VS1nonce, NULL, NULL, 0, ct, ftag));
+    EXPECT_FALSE(e.gcmDecryptFixed<0>(VS1key, VS1nonce, NULL, NULL, 0, ftag, pt));
+    for(size_t a = 1; a <= sizeof(aad); a += 7)
+        {
+        ASSERT_TRUE(e.gcmEncryptPadded(VS1key, VS1nonce, NULL, 0, aad, a, ct, tag));
+        ASSERT_TRUE(e.gcmEncryptFixed<0>(VS1key, VS1nonce, NULL, aad, a, ct, ftag));
+        ASSERT_EQ(0, memcmp(tag, ftag, sizeof(tag)));
+        ASSERT_TRUE(e.gcmDecryptFixed<0>(VS1key, VS1nonce, NULL, aad, a, ftag, pt));
+        ftag[3] ^= 4;
+        ASSERT_FALSE(e.gcmDecryptFixed<0>(VS1key, VS1nonce, NULL, aad, a, ftag, pt));
+        }
+}
+
+// Check the fixed 32 byte kernel against the NIST vector, and its failure cases.
+TEST(Engine,Fixed32VS1)
+{
+    typedef OTAESGCM::OTAES128GCMEngine<> t;
+    uint8_t workspace[t::workspaceRequired];
+    t e(workspace, sizeof(workspace));
+    uint8_t cipherText[32], tag[16], plain[32];
+    ASSERT_TRUE(e.gcmEncryptFixed<32>(VS1key, VS1nonce, VS1input, VS1aad, sizeof(VS1aad), cipherText, tag));
+    EXPECT_EQ(0, memcmp(VS1ct, cipherText, sizeof(cipherText)));
+    EXPECT_EQ(0, memcmp(VS1tag, tag, sizeof(tag)));
+    ASSERT_TRUE(e.gcmDecryptFixed<32>(VS1key, VS1nonce, VS1ct, VS1aad, sizeof(VS1aad), VS1tag, plain));
+    EXPECT_EQ(0, memcmp(VS1input, plain, sizeof(plain)));
+    // A forged tag is rejected without writing PDATA.
+    tag[0] ^= 1;
+    memset(plain, 0, sizeof(plain));
+    EXPECT_FALSE(e.gcmDecryptFixed<32>(VS1key, VS1nonce, VS1ct, VS1aad, sizeof(VS1aad), tag, plain));
+    for(int i = sizeof(plain); --i >= 0; ) { ASSERT_EQ(0, plain[i]); }
+    // ADATA over the bound, and NULL text, are rejected.
+    EXPECT_FALSE((e.gcmEncryptFixed<32, 8>(VS1key, VS1nonce, VS1input, VS1aad, sizeof(VS1aad), cipherText, tag)));
+    EXPECT_FALSE((e.gcmDecryptFixed<32, 8>(VS1key, VS1nonce, VS1ct, VS1aad, sizeof(VS1aad), VS1tag, plain)));
+    EXPECT_FALSE(e.gcmEncryptFixed<32>(VS1key, VS1nonce, NULL, VS1aad, sizeof(VS1aad), cipherText, tag));
+    EXPECT_FALSE(e.gcmDecryptFixed<32>(VS1key, VS1nonce, NULL, VS1aad, sizeof(VS1aad), VS1tag, plain));
+    // Not enough workspace to decrypt.
+    t small(workspace, t::workspaceRequiredEncPadded);
+    EXPECT_FALSE(small.gcmDecryptFixed<32>(VS1key, VS1nonce, VS1ct, VS1aad, sizeof(VS1aad), VS1tag, plain));
+}
+
+// NIST GCMVS test vector with no plain text, ie GMAC.
+//
+//Key = 77be63708971c4e240d1cb79e8d77feb
+//IV = e0e00f19fed7ba0136a797f3
+//AAD = 7a43ec1d9c0a5a78a0b16533a6213cab
+//Tag = 209fcc8d3675ed938e9c7166709dd946
+static const uint8_t GMACkey[16] = { 0x77, 0xbe, 0x63, 0x70, 0x89, 0x71, 0xc4, 0xe2, 0x40, 0xd1, 0xcb, 0x79, 0xe8, 0xd7, 0x7f, 0xeb };
+static const uint8_t GMACnonce[12] = { 0xe0, 0xe0, 0x0f, 0x19, 0xfe, 0xd7, 0xba, 0x01, 0x36, 0xa7, 0x97, 0xf3 };
+static const uint8_t GMACaad[16] = { 0x7a, 0x43, 0xec, 0x1d, 0x9c, 0x0a, 0x5a, 0x78, 0xa0, 0xb1, 0x65, 0x33, 0xa6, 0x21, 0x3c, 0xab };
+static const uint8_t GMACtag[16] = { 0x20, 0x9f, 0xcc, 0x8d, 0x36, 0x75, 0xed, 0x93, 0x8e, 0x9c, 0x71, 0x66, 0x70, 0x9d, 0xd9, 0x46 };
+
+// Check GMAC against the NIST vector and the general path, in its smaller workspace.
+template<class OTAESImpl, class OTGHASHImpl>
+static void checkGMAC()
+{
+    typedef OTAESGCM::OTAES128GCMEngine<OTAESImpl, OTGHASHImpl> t;
+    static_assert(t::workspaceRequiredGMAC < t::workspaceRequiredEncPadded, "GMAC should need less workspace");
+    std::vector<uint8_t> workspace(t::workspaceRequiredGMAC, 0xff);
+    t e(workspace.data(), workspace.size());
+    uint8_t tag[16];
+    ASSERT_TRUE(e.gmacCompute(GMACkey, GMACnonce, GMACaad, sizeof(GMACaad), tag));
+    EXPECT_EQ(0, memcmp(GMACtag, tag, sizeof(tag)));
+    EXPECT_TRUE(e.gmacVerify(GMACkey, GMACnonce, GMACaad, sizeof(GMACaad), GMACtag));
+    for(size_t i = t::workspaceRequiredAES + t::workspaceRequiredGHASH; i < workspace.size(); ++i) { ASSERT_EQ(0, workspace[i]); }
+    tag[7] ^= 0x10;
+    EXPECT_FALSE(e.gmacVerify(GMACkey, GMACnonce, GMACaad, sizeof(GMACaad), tag));
+    // Nothing to authenticate.
+    EXPECT_FALSE(e.gmacCompute(GMACkey, GMACnonce, NULL, 0, tag));
+    EXPECT_FALSE(e.gmacVerify(GMACkey, GMACnonce, NULL, 0, GMACtag));
+    // Not enough for encryption.
+    uint8_t ct[16];
+    EXPECT_FALSE(e.gcmEncryptPadded(GMACkey, GMACnonce, NULL, 0, GMACaad, sizeof(GMACaad), ct, tag));
+    // Same tags as the general path over a range of lengths.
+    std::vector<uint8_t> bigWorkspace(t::workspaceRequired);
+    t big(bigWorkspace.data(), bigWorkspace.size());
+    uint8_t aad[100], expected[16];
+    for(size_t i = 0; i < sizeof(aad); ++i) { aad[i] = (uint8_t)(i * 17 + 9); }
+    for(size_t a = 1; a <= sizeof(aad); ++a)
+        {
+        ASSERT_TRUE(big.gcmEncryptPadded(VS1key, VS1nonce, NULL, 0, aad, a, ct, expected));
+        ASSERT_TRUE(e.gmacCompute(VS1key, VS1nonce, aad, a, tag));
+        ASSERT_EQ(0, memcmp(expected, tag, sizeof(tag))) << a;
+        ASSERT_TRUE(e.gmacVerify(VS1key, VS1nonce, aad, a, expected));
+        }
+    // Too little workspace even for GMAC.
+    t tooSmall(workspace.data(), t::workspaceRequiredGMAC - 1);
+    EXPECT_FALSE(tooSmall.gmacCompute(GMACkey, GMACnonce, GMACaad, sizeof(GMACaad), tag));
+}
+
+TEST(Engine,GMAC)
+{
+    checkGMAC<OTAESGCM::OTAES128E_default_t, OTAESGCM::OTGHASH_default_t>();
+    checkGMAC<OTAESGCM::OTAES128E_fast_t, OTAESGCM::OTGHASH_fast_t>();
+    checkGMAC<OTAESGCM::OTAES128E_small_t, OTAESGCM::OTGHASH_small_t>();
+}
+
+// Check frames with a cached key schedule, including after the key is changed in place,
+// and that wiping leaves the AES part of the workspace zeroed.
+template<class OTAESImpl, class OTGHASHImpl>
+static void checkCachedKey()
+{
+    typedef OTAESGCM::OTAES128GCMEngine<OTAESImpl, OTGHASHImpl> t;
+    std::vector<uint8_t> workspace(t::workspaceRequired, 0xff);
+    t e(workspace.data(), workspace.size());
+    uint8_t key[16], cipherText[32], tag[16], otherCT[32], otherTag[16], plain[32];
+    memcpy(key, VS1key, sizeof(key));
+    key[0] ^= 1;
+    ASSERT_TRUE(e.gcmEncryptPadded(key, VS1nonce, VS1input, sizeof(VS1input), VS1aad, sizeof(VS1aad), otherCT, otherTag));
+    e.cacheKeySchedule();
+    for(int i = 0; i < 3; ++i)
+        {
+        memcpy(key, VS1key, sizeof(key));
+        ASSERT_TRUE(e.gcmEncryptPadded(key, VS1nonce, VS1input, sizeof(VS1input), VS1aad, sizeof(VS1aad), cipherText, tag));
+        EXPECT_EQ(0, memcmp(VS1ct, cipherText, sizeof(cipherText))) << i;
+        EXPECT_EQ(0, memcmp(VS1tag, tag, sizeof(tag))) << i;
+        ASSERT_TRUE(e.gcmDecrypt(VS1key, VS1nonce, cipherText, sizeof(cipherText), VS1aad, sizeof(VS1aad), tag, plain));
+        EXPECT_EQ(0, memcmp(VS1input, plain, sizeof(plain))) << i;
+        key[0] ^= 1;
+        ASSERT_TRUE(e.gcmEncryptPadded(key, VS1nonce, VS1input, sizeof(VS1input), VS1aad, sizeof(VS1aad), cipherText, tag));
+        EXPECT_EQ(0, memcmp(otherCT, cipherText, sizeof(cipherText))) << i;
+        EXPECT_EQ(0, memcmp(otherTag, tag, sizeof(tag))) << i;
+        }
+    e.wipeKeySchedule();
+    for(size_t i = 0; i < t::workspaceRequiredAES; ++i) { ASSERT_EQ(0, workspace[i]); }
+}
+
+TEST(Engine,CachedKey)
+{
+    checkCachedKey<OTAESGCM::OTAES128E_default_t, OTAESGCM::OTGHASH_default_t>();
+    checkCachedKey<OTAESGCM::OTAES128E_fast_t, OTAESGCM::OTGHASH_fast_t>();
+    checkCachedKey<OTAESGCM::OTAES128E_small_t, OTAESGCM::OTGHASH_small_t>();
+}
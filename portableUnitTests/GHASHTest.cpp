@@ -0,0 +1,220 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/*
+ * Tests for the GHASH implementations.
+ */
+
+#include <stdint.h>
+#include <gtest/gtest.h>
+#include <OTAESGCM.h>
+#include "OTAESGCM_PUT.h"
+
+
+// GCM spec (McGrew & Viega) test case 2: GHASH(H, {}, C).
+static const uint8_t TC2H[16] = { 0x66, 0xe9, 0x4b, 0xd4, 0xef, 0x8a, 0x2c, 0x3b, 0x88, 0x4c, 0xfa, 0x59, 0xca, 0x34, 0x2b, 0x2e };
+static const uint8_t TC2C[16] = { 0x03, 0x88, 0xda, 0xce, 0x60, 0xb6, 0xa3, 0x92, 0xf3, 0x28, 0xc2, 0xb9, 0x71, 0xb2, 0xfe, 0x78 };
+static const uint8_t TC2len[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x80 };
+static const uint8_t TC2GHASH[16] = { 0xf3, 0x8c, 0xbb, 0x1a, 0xd6, 0x92, 0x23, 0xdc, 0xc3, 0x45, 0x7a, 0xe5, 0xb6, 0xb0, 0xf8, 0x85 };
+
+// Check a GHASH implementation against the known value,
+// and that it wipes its workspace when done.
+template<class OTGHASHImpl>
+static void checkGHASH()
+{
+    uint8_t workspace[OTGHASHImpl::workspaceRequired];
+    memset(workspace, 0, sizeof(workspace));
+    OTGHASHImpl gh(workspace, sizeof(workspace));
+    uint8_t Y[16] = { };
+    gh.setAuthKey(TC2H);
+    gh.ghashBlocks(Y, TC2C, 1);
+    gh.ghashBlocks(Y, TC2len, 1);
+    EXPECT_EQ(0, memcmp(TC2GHASH, Y, sizeof(Y)));
+    // Hashing both blocks in one call must give the same result.
+    uint8_t both[32];
+    memcpy(both, TC2C, 16);
+    memcpy(both + 16, TC2len, 16);
+    memset(Y, 0, sizeof(Y));
+    gh.ghashBlocks(Y, both, 2);
+    EXPECT_EQ(0, memcmp(TC2GHASH, Y, sizeof(Y)));
+    gh.clearAuthKey();
+    for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]); }
+}
+
+TEST(GHASH,BitSerial)
+{
+    checkGHASH<OTAESGCM::OTGHASH_BitSerial>();
+}
+
+TEST(GHASH,Shoup4)
+{
+    checkGHASH<OTAESGCM::OTGHASH_Shoup4>();
+}
+
+// Check that the table-driven implementation matches the bit-serial one
+// over a spread of pseudo-random keys and data.
+TEST(GHASH,Shoup4MatchesBitSerial)
+{
+    uint8_t wsBS[OTAESGCM::OTGHASH_BitSerial::workspaceRequired];
+    uint8_t wsS4[OTAESGCM::OTGHASH_Shoup4::workspaceRequired];
+    OTAESGCM::OTGHASH_BitSerial bs(wsBS, sizeof(wsBS));
+    OTAESGCM::OTGHASH_Shoup4 s4(wsS4, sizeof(wsS4));
+    uint32_t seed = 1;
+    for(int n = 0; n < 50; ++n)
+        {
+        uint8_t H[16], X[64];
+        for(uint8_t &b : H) { seed = seed * 1103515245U + 12345U; b = (uint8_t)(seed >> 16); }
+        for(uint8_t &b : X) { seed = seed * 1103515245U + 12345U; b = (uint8_t)(seed >> 16); }
+        bs.setAuthKey(H);
+        s4.setAuthKey(H);
+        uint8_t Y1[16] = { }, Y2[16] = { };
+        bs.ghashBlocks(Y1, X, sizeof(X) / 16);
+        s4.ghashBlocks(Y2, X, sizeof(X) / 16);
+        ASSERT_EQ(0, memcmp(Y1, Y2, sizeof(Y1))) << n;
+        }
+}
+
+#if defined(OTAESGCM_HAS_CTMUL64_IMPL)
+TEST(GHASH,CtMul64)
+{
+    checkGHASH<OTAESGCM::OTGHASH_CtMul64>();
+}
+
+// Check the emulated carry-less multiply against the bit-serial implementation,
+// including all-ones operands which maximise the carries into the masked holes.
+TEST(GHASH,CtMul64MatchesBitSerial)
+{
+    uint8_t wsBS[OTAESGCM::OTGHASH_BitSerial::workspaceRequired];
+    uint8_t wsCT[OTAESGCM::OTGHASH_CtMul64::workspaceRequired];
+    OTAESGCM::OTGHASH_BitSerial bs(wsBS, sizeof(wsBS));
+    OTAESGCM::OTGHASH_CtMul64 ct(wsCT, sizeof(wsCT));
+    uint32_t seed = 3;
+    for(int n = 0; n < 50; ++n)
+        {
+        uint8_t H[16], Y0[16], X[5*16];
+        for(uint8_t &b : H) { seed = seed * 1103515245U + 12345U; b = (uint8_t)(seed >> 16); }
+        for(uint8_t &b : Y0) { seed = seed * 1103515245U + 12345U; b = (uint8_t)(seed >> 16); }
+        for(uint8_t &b : X) { seed = seed * 1103515245U + 12345U; b = (uint8_t)(seed >> 16); }
+        if(0 == n) { memset(H, 0xff, sizeof(H)); memset(Y0, 0xff, sizeof(Y0)); memset(X, 0xff, sizeof(X)); }
+        bs.setAuthKey(H);
+        ct.setAuthKey(H);
+        const size_t nBlocks = (size_t)(n % 6);
+        uint8_t Y1[16], Y2[16];
+        memcpy(Y1, Y0, 16);
+        memcpy(Y2, Y0, 16);
+        bs.ghashBlocks(Y1, X, nBlocks);
+        ct.ghashBlocks(Y2, X, nBlocks);
+        ASSERT_EQ(0, memcmp(Y1, Y2, sizeof(Y1))) << n;
+        }
+}
+#endif
+
+#if defined(OTAESGCM_HAS_PCLMUL_IMPL)
+// Wrapper to construct the PCLMULQDQ implementation with its fallback forced.
+class OTGHASH_PCLMULFallback final : public OTAESGCM::OTGHASH_PCLMUL
+    {
+    public:
+        OTGHASH_PCLMULFallback(uint8_t *const workspace, const size_t workspaceLen)
+          : OTGHASH_PCLMUL(workspace, workspaceLen, false) { }
+    };
+
+TEST(GHASH,PCLMUL)
+{
+    if(!OTAESGCM::OTGHASH_PCLMUL::isAvailable()) { fputs("PCLMULQDQ not available: testing fallback only\n", stderr); }
+    checkGHASH<OTAESGCM::OTGHASH_PCLMUL>();
+    checkGHASH<OTGHASH_PCLMULFallback>();
+}
+
+// Check the aggregated reduction against the bit-serial implementation
+// for every chunking of up to 2 full aggregates plus a remainder.
+TEST(GHASH,PCLMULMatchesBitSerial)
+{
+    uint8_t wsBS[OTAESGCM::OTGHASH_BitSerial::workspaceRequired];
+    uint8_t wsPC[OTAESGCM::OTGHASH_PCLMUL::workspaceRequired];
+    OTAESGCM::OTGHASH_BitSerial bs(wsBS, sizeof(wsBS));
+    OTAESGCM::OTGHASH_PCLMUL pc(wsPC, sizeof(wsPC));
+    uint32_t seed = 2;
+    for(size_t nBlocks = 0; nBlocks <= 19; ++nBlocks)
+        {
+        uint8_t H[16], Y0[16], X[19*16];
+        for(uint8_t &b : H) { seed = seed * 1103515245U + 12345U; b = (uint8_t)(seed >> 16); }
+        for(uint8_t &b : Y0) { seed = seed * 1103515245U + 12345U; b = (uint8_t)(seed >> 16); }
+        for(uint8_t &b : X) { seed = seed * 1103515245U + 12345U; b = (uint8_t)(seed >> 16); }
+        bs.setAuthKey(H);
+        pc.setAuthKey(H);
+        uint8_t Y1[16], Y2[16];
+        memcpy(Y1, Y0, 16);
+        memcpy(Y2, Y0, 16);
+        bs.ghashBlocks(Y1, X, nBlocks);
+        pc.ghashBlocks(Y2, X, nBlocks);
+        ASSERT_EQ(0, memcmp(Y1, Y2, sizeof(Y1))) << nBlocks;
+        // With fewer powers of H, for calls of any length.
+        for(size_t maxBlocks = 0; maxBlocks <= 9; ++maxBlocks)
+            {
+            pc.setAuthKeyForBlocks(H, maxBlocks);
+            memcpy(Y2, Y0, 16);
+            pc.ghashBlocks(Y2, X, nBlocks);
+            ASSERT_EQ(0, memcmp(Y1, Y2, sizeof(Y1))) << nBlocks << " " << maxBlocks;
+            }
+        }
+}
+#endif
+
+// Check GCM with the table-driven GHASH selected via the template.
+TEST(GHASH,GCMVS0WithShoup4)
+{
+    typedef OTAESGCM::OTAES128GCMGenericWithWorkspace<OTAESGCM::OTAES128E_default_t, OTAESGCM::OTGHASH_Shoup4> t;
+    uint8_t workspace[t::workspaceRequired];
+    memset(workspace, 0, sizeof(workspace));
+    t gen(workspace, sizeof(workspace));
+    uint8_t cipherText[16], tag[16], plain[16];
+    ASSERT_TRUE(gen.gcmEncryptPadded(VS0key, VS0nonce, VS0input, sizeof(VS0input), VS0aad, sizeof(VS0aad), cipherText, tag));
+    EXPECT_EQ(0, memcmp(VS0ct, cipherText, sizeof(cipherText)));
+    EXPECT_EQ(0, memcmp(VS0tag, tag, sizeof(tag)));
+    for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]) << i; }
+    ASSERT_TRUE(gen.gcmDecrypt(VS0key, VS0nonce, cipherText, sizeof(cipherText), VS0aad, sizeof(VS0aad), tag, plain));
+    EXPECT_EQ(0, memcmp(VS0input, plain, sizeof(plain)));
+    for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]) << i; }
+    // Corrupted cipher text must be rejected, without writing any plain text.
+    cipherText[5] ^= 0x80;
+    memset(plain, 0x5a, sizeof(plain));
+    ASSERT_FALSE(gen.gcmDecrypt(VS0key, VS0nonce, cipherText, sizeof(cipherText), VS0aad, sizeof(VS0aad), tag, plain));
+    for(int i = sizeof(plain); --i >= 0; ) { ASSERT_EQ(0x5a, plain[i]) << i; }
+    for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]) << i; }
+}
+
+// Check the keyed context with the fast GHASH, keyed once per key.
+TEST(GHASH,KeyedWithFast)
+{
+    typedef OTAESGCM::OTAES128GCMKeyedWithWorkspace<OTAESGCM::OTAES128E_fast_t, OTAESGCM::OTGHASH_fast_t> t;
+    uint8_t workspace[t::workspaceRequired];
+    memset(workspace, 0, sizeof(workspace));
+    t gen(workspace, sizeof(workspace));
+    ASSERT_TRUE(gen.setKey(VS0key));
+    uint8_t cipherText[16], tag[16], plain[16];
+    for(int n = 3; --n >= 0; )
+        {
+        ASSERT_TRUE(gen.gcmEncryptPadded(VS0nonce, VS0input, sizeof(VS0input), VS0aad, sizeof(VS0aad), cipherText, tag));
+        ASSERT_EQ(0, memcmp(VS0ct, cipherText, sizeof(cipherText)));
+        ASSERT_EQ(0, memcmp(VS0tag, tag, sizeof(tag)));
+        ASSERT_TRUE(gen.gcmDecrypt(VS0nonce, cipherText, sizeof(cipherText), VS0aad, sizeof(VS0aad), tag, plain));
+        ASSERT_EQ(0, memcmp(VS0input, plain, sizeof(plain)));
+        }
+    gen.clearKey();
+    for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]) << i; }
+}
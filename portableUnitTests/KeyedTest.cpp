@@ -0,0 +1,288 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/*
+ * Tests for keyed (key-schedule-retaining) AES-GCM contexts.
+ */
+
+#include <stdint.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include <OTAESGCM.h>
+#include "OTAESGCM_PUT.h"
+
+
+// Check that a retained AES key schedule gives the same results as a per-call one.
+TEST(Keyed,AESRetainedKeySchedule)
+{
+    uint8_t workspace[OTAESGCM::OTAES128DE_AVR::workspaceRequired];
+    OTAESGCM::OTAES128DE_AVR aes(workspace, sizeof(workspace));
+    uint8_t expected[16], out[16], back[16];
+    aes.blockEncrypt(VS1input, VS1key, expected);
+    for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]); }
+    aes.retainKeySchedule(VS1key);
+    for(int n = 3; --n >= 0; )
+        {
+        aes.blockEncrypt(VS1input, VS1key, out);
+        ASSERT_EQ(0, memcmp(expected, out, sizeof(out)));
+        aes.blockDecrypt(out, VS1key, back);
+        ASSERT_EQ(0, memcmp(VS1input, back, sizeof(back)));
+        }
+    // Schedule is only wiped when asked.
+    bool allZero = true;
+    for(int i = sizeof(workspace); --i >= 0; ) { allZero &= (0 == workspace[i]); }
+    ASSERT_FALSE(allZero);
+    aes.clearKeySchedule();
+    for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]); }
+}
+
+// Check the keyed context against the NIST vector, for several messages under one key.
+TEST(Keyed,GCMVS1Keyed)
+{
+    typedef OTAESGCM::OTAES128GCMKeyedWithWorkspace<> t;
+    uint8_t workspace[t::workspaceRequired];
+    memset(workspace, 0, sizeof(workspace));
+    t gen(workspace, sizeof(workspace));
+    uint8_t cipherText[32], tag[16], plain[32];
+    // Nothing can be done before a key is set.
+    ASSERT_FALSE(gen.isKeySet());
+    ASSERT_FALSE(gen.gcmEncryptPadded(VS1nonce, VS1input, sizeof(VS1input), VS1aad, sizeof(VS1aad), cipherText, tag));
+    ASSERT_FALSE(gen.setKey(NULL));
+    ASSERT_TRUE(gen.setKey(VS1key));
+    ASSERT_TRUE(gen.isKeySet());
+    for(int n = 3; --n >= 0; )
+        {
+        ASSERT_TRUE(gen.gcmEncryptPadded(VS1nonce, VS1input, sizeof(VS1input), VS1aad, sizeof(VS1aad), cipherText, tag));
+        ASSERT_EQ(0, memcmp(VS1ct, cipherText, sizeof(cipherText)));
+        ASSERT_EQ(0, memcmp(VS1tag, tag, sizeof(tag)));
+        ASSERT_TRUE(gen.gcmDecrypt(VS1nonce, cipherText, sizeof(cipherText), VS1aad, sizeof(VS1aad), tag, plain));
+        ASSERT_EQ(0, memcmp(VS1input, plain, sizeof(plain)));
+        }
+    // Tampered tag must be rejected, without writing any plain text.
+    tag[3] ^= 1;
+    memset(plain, 0x5a, sizeof(plain));
+    ASSERT_FALSE(gen.gcmDecrypt(VS1nonce, cipherText, sizeof(cipherText), VS1aad, sizeof(VS1aad), tag, plain));
+    for(int i = sizeof(plain); --i >= 0; ) { ASSERT_EQ(0x5a, plain[i]) << i; }
+    // Wiping the key wipes all the workspace.
+    gen.clearKey();
+    ASSERT_FALSE(gen.isKeySet());
+    for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]) << i; }
+    ASSERT_FALSE(gen.gcmDecrypt(VS1nonce, cipherText, sizeof(cipherText), VS1aad, sizeof(VS1aad), tag, plain));
+}
+
+// Check that a too-small workspace is rejected safely.
+TEST(Keyed,KeyedSmallWorkspace)
+{
+    typedef OTAESGCM::OTAES128GCMKeyedWithWorkspace<> t;
+    uint8_t workspace[t::workspaceRequired];
+    t gen(workspace, sizeof(workspace) - 1);
+    ASSERT_FALSE(gen.setKey(VS1key));
+    t gen0(NULL, sizeof(workspace));
+    ASSERT_FALSE(gen0.setKey(VS1key));
+}
+
+// Check that single-pass encryption with hashing agrees with
+// two-pass decryption for texts spanning several chunks,
+// and that the fast and default implementations agree.
+TEST(Keyed,FusedEncryptLongTexts)
+{
+    typedef OTAESGCM::OTAES128GCMKeyedWithWorkspace<> tD;
+    typedef OTAESGCM::OTAES128GCMKeyedWithWorkspace<OTAESGCM::OTAES128E_fast_t, OTAESGCM::OTGHASH_fast_t> tF;
+    uint8_t wsD[tD::workspaceRequired], wsF[tF::workspaceRequired];
+    tD genD(wsD, sizeof(wsD));
+    tF genF(wsF, sizeof(wsF));
+    ASSERT_TRUE(genD.setKey(VS1key));
+    ASSERT_TRUE(genF.setKey(VS1key));
+    static uint8_t input[40*16], ctD[40*16], ctF[40*16], plain[40*16];
+    uint32_t seed = 3;
+    for(uint8_t &b : input) { seed = seed * 1103515245U + 12345U; b = (uint8_t)(seed >> 16); }
+    for(size_t nBlocks = 0; nBlocks <= 40; ++nBlocks)
+        {
+        const size_t len = 16 * nBlocks;
+        uint8_t tagD[16], tagF[16];
+        ASSERT_TRUE(genD.gcmEncryptPadded(VS1nonce, input, len, VS1aad, sizeof(VS1aad), ctD, tagD));
+        ASSERT_TRUE(genF.gcmEncryptPadded(VS1nonce, input, len, VS1aad, sizeof(VS1aad), ctF, tagF));
+        ASSERT_EQ(0, memcmp(ctD, ctF, len)) << nBlocks;
+        ASSERT_EQ(0, memcmp(tagD, tagF, sizeof(tagD))) << nBlocks;
+        ASSERT_TRUE(genD.gcmDecrypt(VS1nonce, ctD, len, VS1aad, sizeof(VS1aad), tagD, plain)) << nBlocks;
+        ASSERT_EQ(0, memcmp(input, plain, len)) << nBlocks;
+        }
+    // The first two blocks match the known vector.
+    uint8_t tag[16];
+    ASSERT_TRUE(genF.gcmEncryptPadded(VS1nonce, VS1input, sizeof(VS1input), VS1aad, sizeof(VS1aad), ctF, tag));
+    ASSERT_EQ(0, memcmp(VS1ct, ctF, sizeof(VS1ct)));
+    ASSERT_EQ(0, memcmp(VS1tag, tag, sizeof(tag)));
+}
+
+// Check a 64KiB text, well beyond the 255 bytes of the original API.
+TEST(Keyed,Encrypt64KiB)
+{
+    typedef OTAESGCM::OTAES128GCMKeyedWithWorkspace<OTAESGCM::OTAES128E_fast_t, OTAESGCM::OTGHASH_fast_t> t;
+    uint8_t workspace[t::workspaceRequired];
+    t gen(workspace, sizeof(workspace));
+    ASSERT_TRUE(gen.setKey(VS1key));
+    const size_t len = 65536;
+    std::vector<uint8_t> input(len), cipherText(len), plain(len);
+    for(size_t i = 0; i < len; ++i) { input[i] = (uint8_t)(i * 7); }
+    uint8_t tag[16];
+    ASSERT_TRUE(gen.gcmEncryptPadded(VS1nonce, input.data(), len, VS1aad, sizeof(VS1aad), cipherText.data(), tag));
+    ASSERT_TRUE(gen.gcmDecrypt(VS1nonce, cipherText.data(), len, VS1aad, sizeof(VS1aad), tag, plain.data()));
+    ASSERT_TRUE(input == plain);
+    // Corrupting the last block must be detected.
+    cipherText[len-1] ^= 0x80;
+    ASSERT_FALSE(gen.gcmDecrypt(VS1nonce, cipherText.data(), len, VS1aad, sizeof(VS1aad), tag, plain.data()));
+}
+
+// Check that batch encryption matches one-at-a-time encryption
+// for batches of messages of mixed lengths, larger than the number of lanes.
+template<class OTAESImpl, class OTGHASHImpl>
+static void checkBatch()
+{
+    typedef OTAESGCM::OTAES128GCMKeyedWithWorkspace<OTAESImpl, OTGHASHImpl> t;
+    std::vector<uint8_t> workspace(t::workspaceRequiredBatch);
+    t gen(workspace.data(), workspace.size());
+    ASSERT_TRUE(gen.setKey(VS1key));
+    const size_t maxFrames = 3 * OTAESGCM::GGBWS::GCM_BATCH_LANES + 1;
+    static uint8_t input[maxFrames][20*16], ct[maxFrames][20*16], tags[maxFrames][16], nonces[maxFrames][12];
+    uint32_t seed = 4;
+    for(size_t i = 0; i < maxFrames; ++i)
+        {
+        for(uint8_t &b : input[i]) { seed = seed * 1103515245U + 12345U; b = (uint8_t)(seed >> 16); }
+        for(uint8_t &b : nonces[i]) { seed = seed * 1103515245U + 12345U; b = (uint8_t)(seed >> 16); }
+        }
+    OTAESGCM::GCMEncryptPaddedFrame frames[maxFrames];
+    for(size_t nFrames = 0; nFrames <= maxFrames; ++nFrames)
+        {
+        for(size_t i = 0; i < nFrames; ++i)
+            {
+            // Lengths 0..20 blocks; some messages have no AAD, but all have one or the other.
+            const size_t len = 16 * ((i * 7 + nFrames) % 21);
+            frames[i] = { nonces[i], input[i], len, VS1aad, ((0 == len) || (i % 3)) ? sizeof(VS1aad) : 0, ct[i], tags[i] };
+            }
+        ASSERT_TRUE(gen.gcmEncryptPaddedBatch(frames, nFrames)) << nFrames;
+        for(size_t i = 0; i < nFrames; ++i)
+            {
+            const OTAESGCM::GCMEncryptPaddedFrame &f = frames[i];
+            uint8_t expected[20*16], tag[16];
+            ASSERT_TRUE(gen.gcmEncryptPadded(f.IV, f.PDATAPadded, f.PDATALength, f.ADATA, f.ADATALength, expected, tag));
+            ASSERT_EQ(0, memcmp(expected, f.CDATA, f.PDATALength)) << nFrames << " " << i;
+            ASSERT_EQ(0, memcmp(tag, f.tag, sizeof(tag))) << nFrames << " " << i;
+            }
+        }
+    // A bad frame fails the whole batch without encrypting any.
+    memset(tags, 0, sizeof(tags));
+    frames[2].PDATALength = 15;
+    ASSERT_FALSE(gen.gcmEncryptPaddedBatch(frames, 4));
+    for(int i = 0; i < 16; ++i) { ASSERT_EQ(0, tags[0][i]); }
+    // Per-message workspace only is not enough for batches.
+    t genSmall(workspace.data(), t::workspaceRequired);
+    ASSERT_TRUE(genSmall.setKey(VS1key));
+    ASSERT_FALSE(genSmall.gcmEncryptPaddedBatch(frames, 1));
+    genSmall.clearKey();
+    // Wiping the key wipes all the workspace.
+    ASSERT_TRUE(gen.setKey(VS1key));
+    gen.clearKey();
+    for(size_t i = 0; i < workspace.size(); ++i) { ASSERT_EQ(0, workspace[i]) << i; }
+}
+
+TEST(Keyed,BatchDefault)
+{
+    checkBatch<OTAESGCM::OTAES128E_default_t, OTAESGCM::OTGHASH_default_t>();
+}
+
+TEST(Keyed,BatchFast)
+{
+    checkBatch<OTAESGCM::OTAES128E_fast_t, OTAESGCM::OTGHASH_fast_t>();
+}
+
+// Check that a precomputed ADATA prefix gives the same results as the whole ADATA,
+// for prefixes of whole and partial blocks, and every split point.
+template<class OTAESImpl, class OTGHASHImpl>
+static void checkADATAPrefix()
+{
+    typedef OTAESGCM::OTAES128GCMKeyedWithWorkspace<OTAESImpl, OTGHASHImpl> t;
+    std::vector<uint8_t> workspace(t::workspaceRequired);
+    t gen(workspace.data(), workspace.size());
+    OTAESGCM::GCMADATAPrefix prefix;
+    ASSERT_FALSE(gen.computeADATAPrefix(VS1aad, sizeof(VS1aad), prefix));
+    ASSERT_TRUE(gen.setKey(VS1key));
+    uint8_t aad[70];
+    for(size_t i = 0; i < sizeof(aad); ++i) { aad[i] = (uint8_t)(i * 11 + 3); }
+    uint8_t ct[32], pct[32], pt[32], tag[16], ptag[16];
+    for(size_t textLen = 0; textLen <= sizeof(VS1input); textLen += 32)
+        {
+        for(size_t a = 0; a <= sizeof(aad); a += 5)
+            {
+            if((0 == a) && (0 == textLen)) { continue; }
+            ASSERT_TRUE(gen.gcmEncryptPadded(VS1nonce, VS1input, textLen, a ? aad : NULL, a, ct, tag));
+            for(size_t p = 0; p <= a; ++p)
+                {
+                ASSERT_TRUE(gen.computeADATAPrefix(p ? aad : NULL, p, prefix));
+                const uint8_t *const suffix = (a > p) ? aad + p : NULL;
+                ASSERT_TRUE(gen.gcmEncryptPadded(prefix, VS1nonce, VS1input, textLen, suffix, a - p, pct, ptag));
+                ASSERT_EQ(0, memcmp(ct, pct, textLen)) << a << " " << p;
+                ASSERT_EQ(0, memcmp(tag, ptag, sizeof(tag))) << a << " " << p;
+                ASSERT_TRUE(gen.gcmDecrypt(prefix, VS1nonce, ct, textLen, suffix, a - p, tag, pt)) << a << " " << p;
+                ASSERT_EQ(0, memcmp(VS1input, pt, textLen));
+                }
+            }
+        }
+    // The NIST vector's ADATA split across prefix and suffix.
+    ASSERT_TRUE(gen.computeADATAPrefix(VS1aad, 5, prefix));
+    ASSERT_TRUE(gen.gcmDecrypt(prefix, VS1nonce, VS1ct, sizeof(VS1ct), VS1aad + 5, sizeof(VS1aad) - 5, VS1tag, pt));
+    ASSERT_EQ(0, memcmp(VS1input, pt, sizeof(pt)));
+    // A prefix is only good for the key it was computed under.
+    static const uint8_t otherKey[16] = { 1 };
+    ASSERT_TRUE(gen.setKey(otherKey));
+    ASSERT_FALSE(gen.gcmDecrypt(prefix, VS1nonce, VS1ct, sizeof(VS1ct), VS1aad + 5, sizeof(VS1aad) - 5, VS1tag, pt));
+    gen.clearKey();
+    ASSERT_FALSE(gen.gcmEncryptPadded(prefix, VS1nonce, VS1input, sizeof(VS1input), NULL, 0, pct, ptag));
+}
+
+TEST(Keyed,ADATAPrefixDefault)
+{
+    checkADATAPrefix<OTAESGCM::OTAES128E_default_t, OTAESGCM::OTGHASH_default_t>();
+}
+
+TEST(Keyed,ADATAPrefixFast)
+{
+    checkADATAPrefix<OTAESGCM::OTAES128E_fast_t, OTAESGCM::OTGHASH_fast_t>();
+}
+
+// Check keyed GMAC against the general path, reusing the retained H.
+TEST(Keyed,GMAC)
+{
+    typedef OTAESGCM::OTAES128GCMKeyedWithWorkspace<> t;
+    uint8_t workspace[t::workspaceRequired];
+    t gen(workspace, sizeof(workspace));
+    uint8_t tag[16], expected[16], ct[16];
+    ASSERT_FALSE(gen.gmacCompute(VS1nonce, VS1aad, sizeof(VS1aad), tag));
+    ASSERT_TRUE(gen.setKey(VS1key));
+    for(size_t a = 1; a <= sizeof(VS1aad); ++a)
+        {
+        ASSERT_TRUE(gen.gcmEncryptPadded(VS1nonce, NULL, 0, VS1aad, a, ct, expected));
+        ASSERT_TRUE(gen.gmacCompute(VS1nonce, VS1aad, a, tag));
+        ASSERT_EQ(0, memcmp(expected, tag, sizeof(tag))) << a;
+        ASSERT_TRUE(gen.gmacVerify(VS1nonce, VS1aad, a, expected));
+        expected[15] ^= 1;
+        ASSERT_FALSE(gen.gmacVerify(VS1nonce, VS1aad, a, expected));
+        }
+    ASSERT_FALSE(gen.gmacCompute(VS1nonce, NULL, 0, tag));
+    gen.clearKey();
+    ASSERT_FALSE(gen.gmacVerify(VS1nonce, VS1aad, sizeof(VS1aad), tag));
+}
@@ -0,0 +1,162 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/*
+ * Tests for multi-key AES and multi-key GCM decryption.
+ */
+
+#include <stdint.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include <OTAESGCM.h>
+
+
+// Fill a buffer with pseudo-random bytes.
+static void fill(uint8_t *const p, const size_t n, uint32_t &seed)
+{
+    for(size_t i = 0; i < n; ++i) { seed = seed * 1103515245U + 12345U; p[i] = (uint8_t)(seed >> 16); }
+}
+
+// Check each lane against single-key encryption for every lane mask,
+// and that the lane keys are wiped when done.
+template<class OTAESMultiKeyImpl>
+static void checkLanes()
+{
+    const uint8_t MaxLanes = OTAESGCM::OTAES128EMultiKey::MaxLanes;
+    std::vector<uint8_t> workspace(OTAESMultiKeyImpl::workspaceRequired);
+    OTAESMultiKeyImpl mk(workspace.data(), workspace.size());
+    uint8_t wsE[OTAESGCM::OTAES128E_default_t::workspaceRequired];
+    OTAESGCM::OTAES128E_default_t e(wsE, sizeof(wsE));
+    uint32_t seed = 9;
+    uint8_t keys[MaxLanes][16], in[MaxLanes*16], expected[MaxLanes*16];
+    fill(keys[0], sizeof(keys), seed);
+    for(uint8_t i = 0; i < MaxLanes; ++i) { mk.setLaneKey(i, keys[i]); }
+    for(unsigned mask = 0; mask < (1U << MaxLanes); mask += 7)
+        {
+        fill(in, sizeof(in), seed);
+        for(uint8_t i = 0; i < MaxLanes; ++i) { e.blockEncrypt(in + 16*i, keys[i], expected + 16*i); }
+        // In place.
+        mk.lanesEncrypt(in, (uint8_t)mask, in);
+        for(uint8_t i = 0; i < MaxLanes; ++i)
+            { if(0 != (mask & (1U << i))) { ASSERT_EQ(0, memcmp(expected + 16*i, in + 16*i, 16)) << mask << " " << (int)i; } }
+        }
+    // Rekeying some lanes leaves the others' keys in place.
+    for(const uint8_t lane : { 2, 6 })
+        {
+        fill(keys[lane], 16, seed);
+        mk.setLaneKey(lane, keys[lane]);
+        fill(in, sizeof(in), seed);
+        for(uint8_t i = 0; i < MaxLanes; ++i) { e.blockEncrypt(in + 16*i, keys[i], expected + 16*i); }
+        mk.lanesEncrypt(in, 0xff, in);
+        ASSERT_EQ(0, memcmp(expected, in, sizeof(in))) << (int)lane;
+        }
+    mk.clearLaneKeys();
+    for(size_t i = 0; i < workspace.size(); ++i) { ASSERT_EQ(0, workspace[i]) << i; }
+}
+
+TEST(MultiKey,LanesDefault)
+{
+    checkLanes<OTAESGCM::OTAES128EMultiKey_default_t>();
+}
+
+TEST(MultiKey,LanesFast)
+{
+    checkLanes<OTAESGCM::OTAES128EMultiKey_fast_t>();
+}
+
+#if defined(OTAESGCM_HAS_AESNI_IMPL)
+// Wrapper to construct the AES-NI implementation with its fallback forced.
+class OTAES128EMultiKey_AESNIFallback final : public OTAESGCM::OTAES128EMultiKey_AESNI
+    {
+    public:
+        OTAES128EMultiKey_AESNIFallback(uint8_t *const workspace, const size_t workspaceLen)
+          : OTAES128EMultiKey_AESNI(workspace, workspaceLen, false) { }
+    };
+
+TEST(MultiKey,LanesAESNIFallback)
+{
+    checkLanes<OTAES128EMultiKey_AESNIFallback>();
+}
+#endif
+
+// Check multi-key decryption of batches of 0..MaxFrames messages
+// each under its own key, against single-message encryption,
+// and that a tampered message is rejected without touching its plain text buffer.
+template<class OTAESMultiKeyImpl, class OTGHASHImpl>
+static void checkDecryptMultiKey()
+{
+    typedef OTAESGCM::OTAES128GCMMultiKeyDecryptWithWorkspace<OTAESMultiKeyImpl, OTGHASHImpl> t;
+    typedef OTAESGCM::OTAES128GCMGenericWithWorkspace<> g;
+    const uint8_t MaxFrames = t::MaxFrames;
+    std::vector<uint8_t> workspace(t::workspaceRequired);
+    t dec(workspace.data(), workspace.size());
+    uint8_t wsG[g::workspaceRequired];
+    g enc(wsG, sizeof(wsG));
+    static uint8_t keys[MaxFrames][16], nonces[MaxFrames][12], aad[MaxFrames][7];
+    static uint8_t input[MaxFrames][5*16], ct[MaxFrames][5*16], tags[MaxFrames][16], plain[MaxFrames][5*16];
+    uint32_t seed = 10;
+    OTAESGCM::GCMDecryptFrame frames[MaxFrames];
+    for(uint8_t nFrames = 0; nFrames <= MaxFrames; ++nFrames)
+        {
+        for(uint8_t i = 0; i < nFrames; ++i)
+            {
+            fill(keys[i], 16, seed);
+            fill(nonces[i], 12, seed);
+            fill(aad[i], sizeof(aad[i]), seed);
+            fill(input[i], sizeof(input[i]), seed);
+            // Lengths 0..5 blocks; some messages have no AAD, but all have one or the other.
+            const size_t len = 16 * ((i * 3 + nFrames) % 6);
+            const size_t alen = ((0 == len) || (i % 3)) ? sizeof(aad[i]) : 0;
+            ASSERT_TRUE(enc.gcmEncryptPadded(keys[i], nonces[i], input[i], len, aad[i], alen, ct[i], tags[i]));
+            frames[i] = { keys[i], nonces[i], ct[i], len, aad[i], alen, tags[i], plain[i] };
+            }
+        memset(plain, 0, sizeof(plain));
+        const uint8_t all = (uint8_t)((1U << nFrames) - 1);
+        ASSERT_EQ(all, dec.gcmDecryptMultiKey(frames, nFrames)) << (int)nFrames;
+        for(uint8_t i = 0; i < nFrames; ++i)
+            { ASSERT_EQ(0, memcmp(input[i], plain[i], frames[i].CDATALength)) << (int)nFrames << " " << (int)i; }
+        for(size_t i = 0; i < workspace.size(); ++i) { ASSERT_EQ(0, workspace[i]) << i; }
+        if(nFrames < 2) { continue; }
+        // Tamper with one message: only it is rejected, and its plain text is left alone.
+        const uint8_t bad = (uint8_t)(nFrames / 2);
+        tags[bad][nFrames % 16] ^= 1;
+        memset(plain, 0x5a, sizeof(plain));
+        ASSERT_EQ((uint8_t)(all & ~(1U << bad)), dec.gcmDecryptMultiKey(frames, nFrames)) << (int)nFrames;
+        for(size_t j = 0; j < sizeof(plain[bad]); ++j) { ASSERT_EQ(0x5a, plain[bad][j]); }
+        for(uint8_t i = 0; i < nFrames; ++i)
+            { if(i != bad) { ASSERT_EQ(0, memcmp(input[i], plain[i], frames[i].CDATALength)) << (int)nFrames << " " << (int)i; } }
+        tags[bad][nFrames % 16] ^= 1;
+        }
+    // An invalid message fails alone.
+    frames[1].CDATALength = 15;
+    ASSERT_EQ((uint8_t)0xfd, dec.gcmDecryptMultiKey(frames, MaxFrames));
+    // Too many messages, or too little workspace, fails all.
+    ASSERT_EQ(0, dec.gcmDecryptMultiKey(frames, MaxFrames + 1));
+    t decSmall(workspace.data(), workspace.size() - 1);
+    ASSERT_EQ(0, decSmall.gcmDecryptMultiKey(frames, 1));
+}
+
+TEST(MultiKey,DecryptDefault)
+{
+    checkDecryptMultiKey<OTAESGCM::OTAES128EMultiKey_default_t, OTAESGCM::OTGHASH_default_t>();
+}
+
+TEST(MultiKey,DecryptFast)
+{
+    checkDecryptMultiKey<OTAESGCM::OTAES128EMultiKey_fast_t, OTAESGCM::OTGHASH_fast_t>();
+}
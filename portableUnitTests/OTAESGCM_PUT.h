@@ -20,5 +20,34 @@ Author(s) / Copyright (s): Damon Hart-Davis 2018
  * OTAESGCM available external routines for Portable Unit Tests.
  */
 
+#ifndef OTAESGCM_PUT_H
+#define OTAESGCM_PUT_H
 
-/* ... crickets ... */
+#include <stdint.h>
+
+// Known-answer vectors shared by the tests.
+
+// NIST GCMVS test vector (see main.cpp GCMVS0WithWorkspace).
+static const uint8_t VS0input[16] = { 0x7b, 0x43, 0x01, 0x6a, 0x16, 0x89, 0x64, 0x97, 0xfb, 0x45, 0x7b, 0xe6, 0xd2, 0xa5, 0x41, 0x22 };
+static const uint8_t VS0key[16] = { 0xd4, 0xa2, 0x24, 0x88, 0xf8, 0xdd, 0x1d, 0x5c, 0x6c, 0x19, 0xa7, 0xd6, 0xca, 0x17, 0x96, 0x4c };
+static const uint8_t VS0nonce[12] = { 0xf3, 0xd5, 0x83, 0x7f, 0x22, 0xac, 0x1a, 0x04, 0x25, 0xe0, 0xd1, 0xd5 };
+static const uint8_t VS0aad[20] = { 0xf1, 0xc5, 0xd4, 0x24, 0xb8, 0x3f, 0x96, 0xc6, 0xad, 0x8c, 0xb2, 0x8c, 0xa0, 0xd2, 0x0e, 0x47, 0x5e, 0x02, 0x3b, 0x5a };
+static const uint8_t VS0ct[16] = { 0xc2, 0xbd, 0x67, 0xee, 0xf5, 0xe9, 0x5c, 0xac, 0x27, 0xe3, 0xb0, 0x6e, 0x30, 0x31, 0xd0, 0xa8 };
+static const uint8_t VS0tag[16] = { 0xf2, 0x3e, 0xac, 0xf9, 0xd1, 0xcd, 0xf8, 0x73, 0x77, 0x26, 0xc5, 0x86, 0x48, 0x82, 0x6e, 0x9c };
+
+// NIST GCMVS test vector (see main.cpp GCMVS1WithWorkspace).
+//
+//Key = 298efa1ccf29cf62ae6824bfc19557fc
+//IV = 6f58a93fe1d207fae4ed2f6d
+//PT = cc38bccd6bc536ad919b1395f5d63801f99f8068d65ca5ac63872daf16b93901
+//AAD = 021fafd238463973ffe80256e5b1c6b1
+//CT = dfce4e9cd291103d7fe4e63351d9e79d3dfd391e3267104658212da96521b7db
+//Tag = 542465ef599316f73a7a560509a2d9f2
+static const uint8_t VS1input[32] = { 0xcc, 0x38, 0xbc, 0xcd, 0x6b, 0xc5, 0x36, 0xad, 0x91, 0x9b, 0x13, 0x95, 0xf5, 0xd6, 0x38, 0x01, 0xf9, 0x9f, 0x80, 0x68, 0xd6, 0x5c, 0xa5, 0xac, 0x63, 0x87, 0x2d, 0xaf, 0x16, 0xb9, 0x39, 0x01 };
+static const uint8_t VS1key[16] = { 0x29, 0x8e, 0xfa, 0x1c, 0xcf, 0x29, 0xcf, 0x62, 0xae, 0x68, 0x24, 0xbf, 0xc1, 0x95, 0x57, 0xfc };
+static const uint8_t VS1nonce[12] = { 0x6f, 0x58, 0xa9, 0x3f, 0xe1, 0xd2, 0x07, 0xfa, 0xe4, 0xed, 0x2f, 0x6d };
+static const uint8_t VS1aad[16] = { 0x02, 0x1f, 0xaf, 0xd2, 0x38, 0x46, 0x39, 0x73, 0xff, 0xe8, 0x02, 0x56, 0xe5, 0xb1, 0xc6, 0xb1 };
+static const uint8_t VS1ct[32] = { 0xdf, 0xce, 0x4e, 0x9c, 0xd2, 0x91, 0x10, 0x3d, 0x7f, 0xe4, 0xe6, 0x33, 0x51, 0xd9, 0xe7, 0x9d, 0x3d, 0xfd, 0x39, 0x1e, 0x32, 0x67, 0x10, 0x46, 0x58, 0x21, 0x2d, 0xa9, 0x65, 0x21, 0xb7, 0xdb };
+static const uint8_t VS1tag[16] = { 0x54, 0x24, 0x65, 0xef, 0x59, 0x93, 0x16, 0xf7, 0x3a, 0x7a, 0x56, 0x05, 0x09, 0xa2, 0xd9, 0xf2 };
+
+#endif
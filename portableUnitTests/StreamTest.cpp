@@ -0,0 +1,151 @@
+/*
+The OpenTRV project licenses this file to you
+under the Apache Licence, Version 2.0 (the "Licence");
+you may not use this file except in compliance
+with the Licence. You may obtain a copy of the Licence at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the Licence is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied. See the Licence for the
+specific language governing permissions and limitations
+under the Licence.
+
+Author(s) / Copyright (s): OpenTRV contributors 2026
+*/
+
+/*
+ * Tests for the streaming GCM API.
+ */
+
+#include <stdint.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include <OTAESGCM.h>
+
+
+// GCM spec (McGrew & Viega) test case 4: 60-byte text and 20-byte AAD,
+// so neither is a whole number of blocks.
+static const uint8_t TC4key[16] = { 0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08 };
+static const uint8_t TC4nonce[12] = { 0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88 };
+static const uint8_t TC4input[60] = {
+    0xd9, 0x31, 0x32, 0x25, 0xf8, 0x84, 0x06, 0xe5, 0xa5, 0x59, 0x09, 0xc5, 0xaf, 0xf5, 0x26, 0x9a,
+    0x86, 0xa7, 0xa9, 0x53, 0x15, 0x34, 0xf7, 0xda, 0x2e, 0x4c, 0x30, 0x3d, 0x8a, 0x31, 0x8a, 0x72,
+    0x1c, 0x3c, 0x0c, 0x95, 0x95, 0x68, 0x09, 0x53, 0x2f, 0xcf, 0x0e, 0x24, 0x49, 0xa6, 0xb5, 0x25,
+    0xb1, 0x6a, 0xed, 0xf5, 0xaa, 0x0d, 0xe6, 0x57, 0xba, 0x63, 0x7b, 0x39 };
+static const uint8_t TC4aad[20] = { 0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef, 0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef, 0xab, 0xad, 0xda, 0xd2 };
+static const uint8_t TC4ct[60] = {
+    0x42, 0x83, 0x1e, 0xc2, 0x21, 0x77, 0x74, 0x24, 0x4b, 0x72, 0x21, 0xb7, 0x84, 0xd0, 0xd4, 0x9c,
+    0xe3, 0xaa, 0x21, 0x2f, 0x2c, 0x02, 0xa4, 0xe0, 0x35, 0xc1, 0x7e, 0x23, 0x29, 0xac, 0xa1, 0x2e,
+    0x21, 0xd5, 0x14, 0xb2, 0x54, 0x66, 0x93, 0x1c, 0x7d, 0x8f, 0x6a, 0x5a, 0xac, 0x84, 0xaa, 0x05,
+    0x1b, 0xa3, 0x0b, 0x39, 0x6a, 0x0a, 0xac, 0x97, 0x3d, 0x58, 0xe0, 0x91 };
+static const uint8_t TC4tag[16] = { 0x5b, 0xc9, 0x4f, 0xbc, 0x32, 0x21, 0xa5, 0xdb, 0x94, 0xfa, 0xe9, 0x5a, 0xe7, 0x12, 0x1a, 0x47 };
+
+// Check the known answer with the data fed in chunks of every size from 1 up,
+// and that the workspace is wiped after each message.
+template<class OTAESImpl, class OTGHASHImpl>
+static void checkTC4Chunked()
+{
+    typedef OTAESGCM::OTAES128GCMStreamWithWorkspace<OTAESImpl, OTGHASHImpl> t;
+    uint8_t workspace[t::workspaceRequired];
+    memset(workspace, 0, sizeof(workspace));
+    t s(workspace, sizeof(workspace));
+    for(size_t chunk = 1; chunk <= sizeof(TC4input) + 1; ++chunk)
+        {
+        uint8_t cipherText[sizeof(TC4input)], tag[16], plain[sizeof(TC4input)];
+        ASSERT_TRUE(s.init(TC4key, TC4nonce));
+        for(size_t i = 0; i < sizeof(TC4aad); i += chunk)
+            { ASSERT_TRUE(s.aad(TC4aad + i, std::min(chunk, sizeof(TC4aad) - i))); }
+        for(size_t i = 0; i < sizeof(TC4input); i += chunk)
+            { ASSERT_TRUE(s.encryptUpdate(TC4input + i, std::min(chunk, sizeof(TC4input) - i), cipherText + i)); }
+        ASSERT_TRUE(s.finalize(tag));
+        ASSERT_EQ(0, memcmp(TC4ct, cipherText, sizeof(TC4ct))) << chunk;
+        ASSERT_EQ(0, memcmp(TC4tag, tag, sizeof(tag))) << chunk;
+        for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]) << i; }
+
+        // Decrypt in place.
+        memcpy(plain, TC4ct, sizeof(plain));
+        ASSERT_TRUE(s.init(TC4key, TC4nonce));
+        for(size_t i = 0; i < sizeof(TC4aad); i += chunk)
+            { ASSERT_TRUE(s.aad(TC4aad + i, std::min(chunk, sizeof(TC4aad) - i))); }
+        for(size_t i = 0; i < sizeof(plain); i += chunk)
+            { ASSERT_TRUE(s.decryptUpdate(plain + i, std::min(chunk, sizeof(plain) - i), plain + i)); }
+        ASSERT_TRUE(s.verify(TC4tag));
+        ASSERT_EQ(0, memcmp(TC4input, plain, sizeof(plain))) << chunk;
+        for(int i = sizeof(workspace); --i >= 0; ) { ASSERT_EQ(0, workspace[i]) << i; }
+        }
+}
+
+TEST(Stream,TC4ChunkedDefault)
+{
+    checkTC4Chunked<OTAESGCM::OTAES128E_default_t, OTAESGCM::OTGHASH_default_t>();
+}
+
+TEST(Stream,TC4ChunkedFast)
+{
+    checkTC4Chunked<OTAESGCM::OTAES128E_fast_t, OTAESGCM::OTGHASH_fast_t>();
+}
+
+// Check rejection of bad tags, out-of-order calls and a too-small workspace.
+TEST(Stream,Misuse)
+{
+    typedef OTAESGCM::OTAES128GCMStreamWithWorkspace<> t;
+    uint8_t workspace[t::workspaceRequired];
+    t s(workspace, sizeof(workspace));
+    uint8_t out[sizeof(TC4input)], tag[16];
+    // Nothing before init().
+    ASSERT_FALSE(s.aad(TC4aad, sizeof(TC4aad)));
+    ASSERT_FALSE(s.encryptUpdate(TC4input, sizeof(TC4input), out));
+    ASSERT_FALSE(s.finalize(tag));
+    ASSERT_FALSE(s.init(NULL, TC4nonce));
+    ASSERT_FALSE(s.init(TC4key, NULL));
+    // No AAD after text.
+    ASSERT_TRUE(s.init(TC4key, TC4nonce));
+    ASSERT_TRUE(s.encryptUpdate(TC4input, 5, out));
+    ASSERT_FALSE(s.aad(TC4aad, sizeof(TC4aad)));
+    ASSERT_FALSE(s.finalize(tag)); // Failure above abandoned the message.
+    // No mixing of directions.
+    ASSERT_TRUE(s.init(TC4key, TC4nonce));
+    ASSERT_TRUE(s.encryptUpdate(TC4input, 5, out));
+    ASSERT_FALSE(s.decryptUpdate(TC4input, 5, out));
+    ASSERT_TRUE(s.init(TC4key, TC4nonce));
+    ASSERT_TRUE(s.encryptUpdate(TC4input, 5, out));
+    ASSERT_FALSE(s.verify(TC4tag));
+    // Tampered tag.
+    memcpy(tag, TC4tag, sizeof(tag));
+    tag[15] ^= 1;
+    ASSERT_TRUE(s.init(TC4key, TC4nonce));
+    ASSERT_TRUE(s.aad(TC4aad, sizeof(TC4aad)));
+    ASSERT_TRUE(s.decryptUpdate(TC4ct, sizeof(TC4ct), out));
+    ASSERT_FALSE(s.verify(tag));
+    // Workspace too small.
+    t s1(workspace, sizeof(workspace) - 1);
+    ASSERT_FALSE(s1.init(TC4key, TC4nonce));
+}
+
+// Check that a streamed message larger than the one-shot API allows
+// matches the keyed one-shot API over the same (padded) text.
+TEST(Stream,LargeMatchesKeyed)
+{
+    typedef OTAESGCM::OTAES128GCMStreamWithWorkspace<OTAESGCM::OTAES128E_fast_t, OTAESGCM::OTGHASH_fast_t> tS;
+    typedef OTAESGCM::OTAES128GCMKeyedWithWorkspace<OTAESGCM::OTAES128E_fast_t, OTAESGCM::OTGHASH_fast_t> tK;
+    uint8_t wsS[tS::workspaceRequired], wsK[tK::workspaceRequired];
+    tS s(wsS, sizeof(wsS));
+    tK k(wsK, sizeof(wsK));
+    const size_t len = 10000 * 16;
+    std::vector<uint8_t> input(len), ctS(len), ctK(len);
+    for(size_t i = 0; i < len; ++i) { input[i] = (uint8_t)(i * 31); }
+    uint8_t tagS[16], tagK[16];
+    ASSERT_TRUE(k.setKey(TC4key));
+    ASSERT_TRUE(k.gcmEncryptPadded(TC4nonce, input.data(), len, TC4aad, sizeof(TC4aad), ctK.data(), tagK));
+    ASSERT_TRUE(s.init(TC4key, TC4nonce));
+    ASSERT_TRUE(s.aad(TC4aad, sizeof(TC4aad)));
+    // Awkwardly-sized chunks.
+    for(size_t i = 0; i < len; i += 1000)
+        { ASSERT_TRUE(s.encryptUpdate(input.data() + i, std::min((size_t)1000, len - i), ctS.data() + i)); }
+    ASSERT_TRUE(s.finalize(tagS));
+    ASSERT_TRUE(ctS == ctK);
+    ASSERT_EQ(0, memcmp(tagS, tagK, sizeof(tagS)));
+}
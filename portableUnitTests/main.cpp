@@ -376,7 +376,7 @@ TEST(Main,GCMVS1ViaFixed32BTextSizeWITH_LWORKSPACE)
             input,
             cipherText, tag));
     ASSERT_FALSE(OTAESGCM::fixed32BTextSize12BNonce16BTagSimpleEnc_DEFAULT_WITH_LWORKSPACE(
-            workspace, OTAESGCM::OTAES128GCMGenericWithWorkspace<>::workspaceRequiredEnc-1,
+            workspace, OTAESGCM::OTAES128GCMGenericWithWorkspace<>::workspaceRequiredEncPadded-1,
             key, nonce,
             aad, sizeof(aad),
             input,